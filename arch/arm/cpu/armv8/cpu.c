@@ -13,6 +13,7 @@
 
 #include <common.h>
 #include <command.h>
+#include <profiler.h>
 #include <asm/system.h>
 #include <asm/secure.h>
 #include <linux/compiler.h>
@@ -44,6 +45,7 @@ int cleanup_before_linux(void)
 
 	board_cleanup_before_linux();
 
+	profiler_stop();
 	disable_interrupts();
 
 	/*
@@ -0,0 +1,608 @@
+/*
+ * (C) Copyright 2013
+ * David Feng <fenghua@phytium.com.cn>
+ *
+ * (C) Copyright 2016
+ * Alexander Graf <agraf@suse.de>
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+/*
+ * Building and changing the page tables. Nothing here touches the MMU or
+ * the caches, which cache_v8.c looks after, and the tables are only reached
+ * through the struct pgtable passed in, so test/pgtable_ut.c can run this
+ * on sandbox with page tables in ordinary memory.
+ */
+
+#include <common.h>
+#include <armv8_pgtable.h>
+
+#ifndef CONFIG_SYS_DCACHE_OFF
+
+/*
+ *  With 4k page granule, a virtual address is split into 4 lookup parts
+ *  spanning 9 bits each:
+ *
+ *    _______________________________________________
+ *   |       |       |       |       |       |       |
+ *   |   0   |  Lv0  |  Lv1  |  Lv2  |  Lv3  |  off  |
+ *   |_______|_______|_______|_______|_______|_______|
+ *     63-48   47-39   38-30   29-21   20-12   11-00
+ *
+ *             mask        page size
+ *
+ *    Lv0: FF8000000000       --
+ *    Lv1:   7FC0000000       1G
+ *    Lv2:     3FE00000       2M
+ *    Lv3:       1FF000       4K
+ *    off:          FFF
+ */
+
+u64 get_tcr(int el, u64 *pips, u64 *pva_bits)
+{
+	u64 max_addr = 0;
+	u64 ips, va_bits;
+	u64 tcr;
+	int i;
+
+	/* Find the largest address we need to support */
+	for (i = 0; mem_map[i].size || mem_map[i].attrs; i++)
+		max_addr = max(max_addr, mem_map[i].virt + mem_map[i].size);
+
+	/* Calculate the maximum physical (and thus virtual) address */
+	if (max_addr > (1ULL << 44)) {
+		ips = 5;
+		va_bits = 48;
+	} else  if (max_addr > (1ULL << 42)) {
+		ips = 4;
+		va_bits = 44;
+	} else  if (max_addr > (1ULL << 40)) {
+		ips = 3;
+		va_bits = 42;
+	} else  if (max_addr > (1ULL << 36)) {
+		ips = 2;
+		va_bits = 40;
+	} else  if (max_addr > (1ULL << 32)) {
+		ips = 1;
+		va_bits = 36;
+	} else {
+		ips = 0;
+		va_bits = 32;
+	}
+
+	if (el == 1) {
+		tcr = TCR_EL1_RSVD | (ips << 32) | TCR_EPD1_DISABLE;
+	} else if (el == 2) {
+		tcr = TCR_EL2_RSVD | (ips << 16);
+	} else {
+		tcr = TCR_EL3_RSVD | (ips << 16);
+	}
+
+	/* PTWs cacheable, inner/outer WBWA and inner shareable */
+	tcr |= TCR_TG0_4K | TCR_SHARED_INNER | TCR_ORGN_WBWA | TCR_IRGN_WBWA;
+	tcr |= TCR_T0SZ(va_bits);
+
+	if (pips)
+		*pips = ips;
+	if (pva_bits)
+		*pva_bits = va_bits;
+
+	return tcr;
+}
+
+#define MAX_PTE_ENTRIES 512
+
+static int pte_type(u64 *pte)
+{
+	return *pte & PTE_TYPE_MASK;
+}
+
+/* Returns the LSB number for a PTE on level <level> */
+static int level2shift(int level)
+{
+	/* Page is 12 bits wide, every level translates 9 bits */
+	return (12 + 9 * (3 - level));
+}
+
+static u64 *find_pte(struct pgtable *pt, u64 addr, int level)
+{
+	int start_level = 0;
+	u64 *pte;
+	u64 idx;
+	u64 va_bits;
+	int i;
+
+	debug("addr=%llx level=%d\n", addr, level);
+
+	get_tcr(0, NULL, &va_bits);
+	if (va_bits < 39)
+		start_level = 1;
+
+	if (level < start_level)
+		return NULL;
+
+	/* Walk through all page table levels to find our PTE */
+	pte = (u64 *)pt->addr;
+	for (i = start_level; i < 4; i++) {
+		idx = (addr >> level2shift(i)) & 0x1FF;
+		pte += idx;
+		debug("idx=%llx PTE %p at level %d: %llx\n", idx, pte, i, *pte);
+
+		/* Found it */
+		if (i == level)
+			return pte;
+		/* PTE is no table (either invalid or block), can't traverse */
+		if (pte_type(pte) != PTE_TYPE_TABLE)
+			return NULL;
+		/* Off to the next level */
+		pte = (u64 *)(*pte & PTE_ADDR_MASK);
+	}
+
+	/* Should never reach here */
+	return NULL;
+}
+
+/* Returns and creates a new full table (512 entries) */
+static u64 *create_table(struct pgtable *pt)
+{
+	u64 *new_table = (u64 *)pt->fillptr;
+	u64 pt_len = MAX_PTE_ENTRIES * sizeof(u64);
+
+	/* Reuse a table freed by merging it into a block, if there is one */
+	if (pt->free) {
+		new_table = (u64 *)pt->free;
+		pt->free = new_table[0];
+		memset(new_table, 0, pt_len);
+
+		return new_table;
+	}
+
+	/* Allocate MAX_PTE_ENTRIES pte entries */
+	pt->fillptr += pt_len;
+
+	if (pt->fillptr - pt->addr > pt->size)
+		panic("Insufficient RAM for page table: 0x%lx > 0x%lx. "
+		      "Please increase the size in get_page_table_size()",
+			pt->fillptr - pt->addr, pt->size);
+
+	/* Mark all entries as invalid */
+	memset(new_table, 0, pt_len);
+
+	return new_table;
+}
+
+/* Puts a table which nothing points to any more on the free list */
+static void free_table(struct pgtable *pt, u64 *table)
+{
+	table[0] = pt->free;
+	pt->free = (ulong)table;
+}
+
+static void set_pte_table(u64 *pte, u64 *table)
+{
+	/* Point *pte to the new table */
+	debug("Setting %p to addr=%p\n", pte, table);
+	*pte = PTE_TYPE_TABLE | (ulong)table;
+}
+
+/* Splits a block PTE into table with subpages spanning the old block */
+static void split_block(struct pgtable *pt, u64 *pte, int level)
+{
+	u64 old_pte = *pte;
+	u64 *new_table;
+	u64 i = 0;
+	/* level describes the parent level, we need the child ones */
+	int levelshift = level2shift(level + 1);
+
+	if (pte_type(pte) != PTE_TYPE_BLOCK)
+		panic("PTE %p (%llx) is not a block. Some driver code wants to "
+		      "modify dcache settings for an range not covered in "
+		      "mem_map.", pte, old_pte);
+
+	new_table = create_table(pt);
+	pt->splits++;
+	debug("Splitting pte %p (%llx) into %p\n", pte, old_pte, new_table);
+
+	for (i = 0; i < MAX_PTE_ENTRIES; i++) {
+		new_table[i] = old_pte | (i << levelshift);
+
+		/* Level 3 block PTEs have the table type */
+		if ((level + 1) == 3)
+			new_table[i] |= PTE_TYPE_TABLE;
+
+		debug("Setting new_table[%lld] = %llx\n", i, new_table[i]);
+	}
+
+	/* Set the new table into effect */
+	set_pte_table(pte, new_table);
+}
+
+/*
+ * Merges the table a level <level> PTE points to back into a block if its
+ * entries map one aligned, contiguous range with the same attributes
+ */
+static void merge_table(struct pgtable *pt, u64 *pte, int level)
+{
+	int childshift = level2shift(level + 1);
+	int childtype = (level + 1) == 3 ? PTE_TYPE_PAGE : PTE_TYPE_BLOCK;
+	u64 *table, first;
+	int i;
+
+	if (pte_type(pte) != PTE_TYPE_TABLE)
+		return;
+
+	table = (u64 *)(*pte & PTE_ADDR_MASK);
+	first = table[0];
+	if ((first & PTE_ADDR_MASK) & ((1ULL << level2shift(level)) - 1))
+		return;
+
+	for (i = 0; i < MAX_PTE_ENTRIES; i++) {
+		if ((table[i] & PTE_TYPE_MASK) != childtype ||
+		    table[i] != first + ((u64)i << childshift))
+			return;
+	}
+
+	debug("Merging table %p into pte %p at level %d\n", table, pte, level);
+	*pte = (first & ~PTE_TYPE_MASK) | PTE_TYPE_BLOCK;
+	free_table(pt, table);
+	pt->merges++;
+}
+
+/*
+ * Merges the tables which map any part of a range into blocks where they
+ * can be, from the smallest level up so that merges can cascade
+ */
+void pgtable_merge_region(struct pgtable *pt, u64 start, u64 size)
+{
+	u64 levelsize, addr;
+	u64 *pte;
+	int level;
+
+	for (level = 2; level > 0; level--) {
+		levelsize = 1ULL << level2shift(level);
+		for (addr = start & ~(levelsize - 1); addr < start + size;
+		     addr += levelsize) {
+			pte = find_pte(pt, addr, level);
+			if (pte)
+				merge_table(pt, pte, level);
+		}
+	}
+}
+
+/* Add one mm_region map entry to the page tables */
+static void add_map(struct pgtable *pt, struct mm_region *map)
+{
+	u64 *pte;
+	u64 virt = map->virt;
+	u64 phys = map->phys;
+	u64 size = map->size;
+	u64 attrs = map->attrs | PTE_TYPE_BLOCK | PTE_BLOCK_AF;
+	u64 blocksize;
+	int level;
+	u64 *new_table;
+
+	while (size) {
+		pte = find_pte(pt, virt, 0);
+		if (pte && (pte_type(pte) == PTE_TYPE_FAULT)) {
+			debug("Creating table for virt 0x%llx\n", virt);
+			new_table = create_table(pt);
+			set_pte_table(pte, new_table);
+		}
+
+		for (level = 1; level < 4; level++) {
+			pte = find_pte(pt, virt, level);
+			if (!pte)
+				panic("pte not found\n");
+
+			blocksize = 1ULL << level2shift(level);
+			debug("Checking if pte fits for virt=%llx size=%llx blocksize=%llx\n",
+			      virt, size, blocksize);
+			if (size >= blocksize && !(virt & (blocksize - 1))) {
+				/* Page fits, create block PTE */
+				debug("Setting PTE %p to block virt=%llx\n",
+				      pte, virt);
+				if (level == 3)
+					*pte = phys | attrs | PTE_TYPE_PAGE;
+				else
+					*pte = phys | attrs;
+				virt += blocksize;
+				phys += blocksize;
+				size -= blocksize;
+				break;
+			} else if (pte_type(pte) == PTE_TYPE_FAULT) {
+				/* Page doesn't fit, create subpages */
+				debug("Creating subtable for virt 0x%llx blksize=%llx\n",
+				      virt, blocksize);
+				new_table = create_table(pt);
+				set_pte_table(pte, new_table);
+			} else if (pte_type(pte) == PTE_TYPE_BLOCK) {
+				debug("Split block into subtable for virt 0x%llx blksize=0x%llx\n",
+				      virt, blocksize);
+				split_block(pt, pte, level);
+			}
+		}
+	}
+}
+
+enum pte_type {
+	PTE_INVAL,
+	PTE_BLOCK,
+	PTE_LEVEL,
+};
+
+/*
+ * This is a recursively called function to count the number of
+ * page tables we need to cover a particular PTE range. If you
+ * call this with level = -1 you basically get the full 48 bit
+ * coverage.
+ */
+static int count_required_pts(u64 addr, int level, u64 maxaddr)
+{
+	int levelshift = level2shift(level);
+	u64 levelsize = 1ULL << levelshift;
+	u64 levelmask = levelsize - 1;
+	u64 levelend = addr + levelsize;
+	int r = 0;
+	int i;
+	enum pte_type pte_type = PTE_INVAL;
+
+	for (i = 0; mem_map[i].size || mem_map[i].attrs; i++) {
+		struct mm_region *map = &mem_map[i];
+		u64 start = map->virt;
+		u64 end = start + map->size;
+
+		/* Check if the PTE would overlap with the map */
+		if (max(addr, start) <= min(levelend, end)) {
+			start = max(addr, start);
+			end = min(levelend, end);
+
+			/* We need a sub-pt for this level */
+			if ((start & levelmask) || (end & levelmask)) {
+				pte_type = PTE_LEVEL;
+				break;
+			}
+
+			/* Lv0 can not do block PTEs, so do levels here too */
+			if (level <= 0) {
+				pte_type = PTE_LEVEL;
+				break;
+			}
+
+			/* PTE is active, but fits into a block */
+			pte_type = PTE_BLOCK;
+		}
+	}
+
+	/*
+	 * Block PTEs at this level are already covered by the parent page
+	 * table, so we only need to count sub page tables.
+	 */
+	if (pte_type == PTE_LEVEL) {
+		int sublevel = level + 1;
+		u64 sublevelsize = 1ULL << level2shift(sublevel);
+
+		/* Account for the new sub page table ... */
+		r = 1;
+
+		/* ... and for all child page tables that one might have */
+		for (i = 0; i < MAX_PTE_ENTRIES; i++) {
+			r += count_required_pts(addr, sublevel, maxaddr);
+			addr += sublevelsize;
+
+			if (addr >= maxaddr) {
+				/*
+				 * We reached the end of address space, no need
+				 * to look any further.
+				 */
+				break;
+			}
+		}
+	}
+
+	return r;
+}
+
+/* Returns the estimated required size of all page tables */
+__weak u64 get_page_table_size(void)
+{
+	u64 one_pt = MAX_PTE_ENTRIES * sizeof(u64);
+	u64 size = 0;
+	u64 va_bits;
+	int start_level = 0;
+
+	get_tcr(0, NULL, &va_bits);
+	if (va_bits < 39)
+		start_level = 1;
+
+	/* Account for all page tables we would need to cover our memory map */
+	size = one_pt * count_required_pts(0, start_level - 1, 1ULL << va_bits);
+
+	/*
+	 * We need to duplicate our page table once to have an emergency pt to
+	 * resort to when splitting page tables later on
+	 */
+	size *= 2;
+
+	/*
+	 * We may need to split page tables later on if dcache settings change,
+	 * so reserve up to 4 (random pick) page tables for that.
+	 */
+	size += one_pt * 4;
+
+	return size;
+}
+
+/* Whether a map entry carries on where another one ends, in the same way */
+static bool can_merge_map(struct mm_region *map, struct mm_region *next)
+{
+	return next->size && next->attrs == map->attrs &&
+	       next->virt == map->virt + map->size &&
+	       next->phys == map->phys + map->size;
+}
+
+void pgtable_setup(struct pgtable *pt)
+{
+	struct mm_region map;
+	int i;
+
+	if (!pt->fillptr || !pt->addr)
+		panic("Page table pointer not setup.");
+
+	/*
+	 * Allocate the first level we're on with invalidate entries.
+	 * If the starting level is 0 (va_bits >= 39), then this is our
+	 * Lv0 page table, otherwise it's the entry Lv1 page table.
+	 */
+	create_table(pt);
+
+	/*
+	 * Now add all MMU table entries one after another to the table. Map
+	 * entries which carry on from each other are added as one, so that
+	 * they can share blocks where they meet.
+	 */
+	for (i = 0; mem_map[i].size || mem_map[i].attrs; i++) {
+		map = mem_map[i];
+		while (can_merge_map(&map, &mem_map[i + 1]))
+			map.size += mem_map[++i].size;
+		add_map(pt, &map);
+	}
+}
+
+/* Whether every block and page which maps part of a range has attrs */
+bool pgtable_region_has_attrs(struct pgtable *pt, u64 start, u64 size,
+			      u64 attrs)
+{
+	u64 end = start + size;
+	u64 *pte;
+	int level;
+
+	while (start < end) {
+		for (level = 1; level < 4; level++) {
+			pte = find_pte(pt, start, level);
+			if (!pte || pte_type(pte) == PTE_TYPE_FAULT)
+				return false;
+			if (level == 3 || pte_type(pte) == PTE_TYPE_BLOCK)
+				break;
+		}
+		if ((*pte & PMD_ATTRINDX_MASK) != attrs)
+			return false;
+
+		start = (start | ((1ULL << level2shift(level)) - 1)) + 1;
+	}
+
+	return true;
+}
+
+/* Use flag to indicate if attrs has more than d-cache attributes */
+static u64 set_one_region(struct pgtable *pt, u64 start, u64 size, u64 attrs,
+			  bool flag, int level)
+{
+	int levelshift = level2shift(level);
+	u64 levelsize = 1ULL << levelshift;
+	u64 *pte = find_pte(pt, start, level);
+	u64 offset = start & (levelsize - 1);
+
+	/*
+	 * A block which has the d-cache attributes already needs no
+	 * splitting. Other changes break the block before making it again,
+	 * so they always go through it.
+	 */
+	if (!flag && level < 3 && pte_type(pte) == PTE_TYPE_BLOCK &&
+	    (*pte & PMD_ATTRINDX_MASK) == (attrs & PMD_ATTRINDX_MASK))
+		return min(size, levelsize - offset);
+
+	/*
+	 * Can we can just modify the current level block PTE? A table
+	 * instead is followed down, so that each of its entries is changed.
+	 */
+	if (!offset && size >= levelsize &&
+	    (level == 3 || pte_type(pte) != PTE_TYPE_TABLE)) {
+		if (flag) {
+			*pte &= ~PMD_ATTRMASK;
+			*pte |= attrs & PMD_ATTRMASK;
+		} else {
+			*pte &= ~PMD_ATTRINDX_MASK;
+			*pte |= attrs & PMD_ATTRINDX_MASK;
+		}
+		debug("Set attrs=%llx pte=%p level=%d\n", attrs, pte, level);
+
+		return levelsize;
+	}
+
+	/* Unaligned or doesn't fit, maybe split block into table */
+	debug("addr=%llx level=%d pte=%p (%llx)\n", start, level, pte, *pte);
+
+	/* Maybe we need to split the block into a table */
+	if (pte_type(pte) == PTE_TYPE_BLOCK)
+		split_block(pt, pte, level);
+
+	/* And then double-check it became a table or already is one */
+	if (pte_type(pte) != PTE_TYPE_TABLE)
+		panic("PTE %p (%llx) for addr=%llx should be a table",
+		      pte, *pte, start);
+
+	/* Roll on to the next page table level */
+	return 0;
+}
+
+void pgtable_set_region(struct pgtable *pt, u64 start, u64 size, u64 attrs,
+			bool flag)
+{
+	int level;
+	u64 r;
+
+	/*
+	 * Loop through the address range until we find a page granule that fits
+	 * our alignment constraints, then set it to the new attributes
+	 */
+	while (size > 0) {
+		for (level = 1; level < 4; level++) {
+			r = set_one_region(pt, start, size, attrs, flag, level);
+			if (r) {
+				/* PTE successfully replaced */
+				size -= r;
+				start += r;
+				break;
+			}
+		}
+	}
+}
+
+/* Counts the blocks and pages a table and the tables below it map */
+static void count_blocks(u64 *table, int level, struct mmu_stats *stats)
+{
+	int i;
+
+	for (i = 0; i < MAX_PTE_ENTRIES; i++) {
+		if (pte_type(&table[i]) == PTE_TYPE_FAULT)
+			continue;
+		if (level < 3 && pte_type(&table[i]) == PTE_TYPE_TABLE)
+			count_blocks((u64 *)(table[i] & PTE_ADDR_MASK),
+				     level + 1, stats);
+		else
+			stats->blocks[level]++;
+	}
+}
+
+void pgtable_get_stats(struct pgtable *pt, struct mmu_stats *stats)
+{
+	u64 one_pt = MAX_PTE_ENTRIES * sizeof(u64);
+	u64 va_bits;
+	ulong table;
+
+	memset(stats, '\0', sizeof(*stats));
+	if (!pt->fillptr)
+		return;
+
+	stats->table_bytes = pt->fillptr - pt->addr;
+	for (table = pt->free; table; table = *(u64 *)table)
+		stats->table_bytes -= one_pt;
+	stats->splits = pt->splits;
+	stats->merges = pt->merges;
+
+	get_tcr(0, NULL, &va_bits);
+	count_blocks((u64 *)pt->addr, va_bits < 39 ? 1 : 0, stats);
+}
+
+#endif /* CONFIG_SYS_DCACHE_OFF */
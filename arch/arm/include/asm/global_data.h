@@ -42,6 +42,9 @@ struct arch_global_data {
 #if defined(CONFIG_ARM64)
 	unsigned long tlb_fillptr;
 	unsigned long tlb_emerg;
+	unsigned long tlb_free;		/* Page tables freed by merging */
+	unsigned int tlb_splits;	/* Blocks split into page tables */
+	unsigned int tlb_merges;	/* Page tables merged into blocks */
 #endif
 #endif
 #ifdef CONFIG_SYS_MEM_RESERVE_SECURE
@@ -119,9 +119,10 @@ u64 get_page_table_size(void);
 /* These constants need to be synced to the MT_ types in asm/armv8/mmu.h */
 enum dcache_option {
 	DCACHE_OFF = 0 << 2,
-	DCACHE_WRITETHROUGH = 3 << 2,
+	DCACHE_WRITETHROUGH = 5 << 2,
 	DCACHE_WRITEBACK = 4 << 2,
 	DCACHE_WRITEALLOC = 4 << 2,
+	DCACHE_NORMAL_NC = 3 << 2,
 };
 
 #define wfi()				\
@@ -14,6 +14,7 @@
 
 #include <common.h>
 #include <command.h>
+#include <console.h>
 #include <dm.h>
 #include <dm/root.h>
 #include <image.h>
@@ -94,6 +95,9 @@ static void announce_and_cleanup(int fake)
 
 	board_quiesce_devices();
 
+	/* Nothing prints from here on, send anything still buffered */
+	console_flush();
+
 	/*
 	 * Call remove function of all devices with a removal flag set.
 	 * This may be useful for last-stage operations, like cancelling
@@ -8,6 +8,7 @@
 #include <common.h>
 #include <linux/compiler.h>
 #include <efi_loader.h>
+#include <profiler.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -104,6 +105,10 @@ void do_sync(struct pt_regs *pt_regs, unsigned int esr)
 void do_irq(struct pt_regs *pt_regs, unsigned int esr)
 {
 	efi_restore_gd();
+#if CONFIG_IS_ENABLED(PROFILER)
+	if (!arch_profiler_irq(pt_regs))
+		return;
+#endif
 	printf("\"Irq\" handler, esr 0x%08x\n", esr);
 	show_regs(pt_regs);
 	panic("Resetting CPU ...\n");
@@ -0,0 +1,99 @@
+/*
+ * Sampling profiler interrupt for Tegra arm64
+ *
+ * U-Boot runs with interrupts masked and has no interrupt framework on
+ * arm64, so this drives the one interrupt it needs directly: the virtual
+ * generic timer (PPI 27) through a GICv2. While profiling, IRQs are
+ * unmasked and do_irq() hands the timer interrupt to arch_profiler_irq().
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <profiler.h>
+#include <asm/gic.h>
+#include <asm/io.h>
+#include <asm/system.h>
+#include <asm/arch/tegra.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define PROFILER_IRQ		27	/* virtual timer PPI */
+#define PROFILER_IRQ_PRIO	0xa0
+#define GIC_SPURIOUS_IRQ	1023
+
+#define CNTV_CTL_ENABLE		(1 << 0)
+#define HCR_EL2_IMO		(1 << 4)
+
+static ulong timer_ticks;	/* timer ticks between samples */
+static ulong saved_hcr;		/* HCR_EL2 before profiling, at EL2 */
+
+static void timer_rearm(void)
+{
+	asm volatile("msr cntv_tval_el0, %0" : : "r" (timer_ticks));
+}
+
+int arch_profiler_irq(struct pt_regs *regs)
+{
+	u32 iar, irq;
+
+	iar = readl(GICC_BASE + GICC_IAR);
+	irq = iar & 0x3ff;
+	if (irq == GIC_SPURIOUS_IRQ)
+		return 0;
+	if (irq != PROFILER_IRQ) {
+		writel(iar, GICC_BASE + GICC_EOIR);
+		return -ENOENT;
+	}
+
+	/* The interrupted SP is just above the saved registers */
+	profiler_sample(regs->elr, regs->regs[29], (ulong)(regs + 1),
+			gd->start_addr_sp);
+	timer_rearm();
+	writel(iar, GICC_BASE + GICC_EOIR);
+
+	return 0;
+}
+
+int arch_profiler_start(uint hz)
+{
+	ulong freq, hcr, ctl;
+	u32 prio;
+
+	freq = get_tbclk();
+	if (!hz || hz > freq)
+		return -EINVAL;
+	timer_ticks = freq / hz;
+
+	if (current_el() == 2) {
+		asm volatile("mrs %0, hcr_el2" : "=r" (saved_hcr));
+		hcr = saved_hcr | HCR_EL2_IMO;
+		asm volatile("msr hcr_el2, %0; isb" : : "r" (hcr));
+	}
+
+	prio = readl(GICD_BASE + GICD_IPRIORITYRn + (PROFILER_IRQ & ~3));
+	prio &= ~(0xff << (PROFILER_IRQ % 4 * 8));
+	prio |= PROFILER_IRQ_PRIO << (PROFILER_IRQ % 4 * 8);
+	writel(prio, GICD_BASE + GICD_IPRIORITYRn + (PROFILER_IRQ & ~3));
+	writel(1 << PROFILER_IRQ, GICD_BASE + GICD_ISENABLERn);
+	setbits_le32(GICD_BASE + GICD_CTLR, 1);
+	writel(0xf0, GICC_BASE + GICC_PMR);
+	setbits_le32(GICC_BASE + GICC_CTLR, 1);
+
+	timer_rearm();
+	ctl = CNTV_CTL_ENABLE;
+	asm volatile("msr cntv_ctl_el0, %0; isb" : : "r" (ctl));
+	asm volatile("msr daifclr, #2");
+
+	return 0;
+}
+
+void arch_profiler_stop(void)
+{
+	asm volatile("msr daifset, #2");
+	asm volatile("msr cntv_ctl_el0, %0; isb" : : "r" (0UL));
+	writel(1 << PROFILER_IRQ, GICD_BASE + GICD_ICENABLERn);
+	if (current_el() == 2)
+		asm volatile("msr hcr_el2, %0; isb" : : "r" (saved_hcr));
+}
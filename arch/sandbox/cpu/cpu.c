@@ -8,6 +8,7 @@
 #include <errno.h>
 #include <libfdt.h>
 #include <os.h>
+#include <profiler.h>
 #include <asm/io.h>
 #include <asm/state.h>
 #include <dm/root.h>
@@ -164,3 +165,15 @@ ulong timer_get_boot_us(void)
 
 	return (count - base_count) / 1000;
 }
+
+#if CONFIG_IS_ENABLED(PROFILER)
+int arch_profiler_start(uint hz)
+{
+	return os_profile_start(hz, profiler_sample);
+}
+
+void arch_profiler_stop(void)
+{
+	os_profile_stop();
+}
+#endif
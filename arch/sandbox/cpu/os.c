@@ -3,16 +3,19 @@
  * SPDX-License-Identifier:	GPL-2.0+
  */
 
+#define _GNU_SOURCE
 #include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <getopt.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <termios.h>
 #include <time.h>
+#include <ucontext.h>
 #include <unistd.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
@@ -63,6 +66,32 @@ off_t os_lseek(int fd, off_t offset, int whence)
 	return lseek(fd, offset, whence);
 }
 
+ssize_t os_pread(int fd, void *buf, size_t count, off_t offset)
+{
+	return pread(fd, buf, count, offset);
+}
+
+ssize_t os_pwrite(int fd, const void *buf, size_t count, off_t offset)
+{
+	return pwrite(fd, buf, count, offset);
+}
+
+void *os_map_file(int fd, size_t size)
+{
+	void *ptr;
+
+	ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (ptr == MAP_FAILED)
+		return NULL;
+
+	return ptr;
+}
+
+int os_unmap_file(void *ptr, size_t size)
+{
+	return munmap(ptr, size);
+}
+
 int os_open(const char *pathname, int os_flags)
 {
 	int flags;
@@ -628,3 +657,62 @@ void os_localtime(struct rtc_time *rt)
 	rt->tm_yday = tm->tm_yday;
 	rt->tm_isdst = tm->tm_isdst;
 }
+
+/* Top of the main stack, set up by the C library */
+extern void *__libc_stack_end;
+
+static os_profile_func_t os_profile_func;
+
+static void os_profile_handler(int sig, siginfo_t *info, void *con)
+{
+	ucontext_t *uc = con;
+	ulong pc, fp, sp;
+
+#if defined(__x86_64__)
+	pc = uc->uc_mcontext.gregs[REG_RIP];
+	fp = uc->uc_mcontext.gregs[REG_RBP];
+	sp = uc->uc_mcontext.gregs[REG_RSP];
+#elif defined(__aarch64__)
+	pc = uc->uc_mcontext.pc;
+	fp = uc->uc_mcontext.regs[29];
+	sp = uc->uc_mcontext.sp;
+#endif
+	os_profile_func(pc, fp, sp, (ulong)__libc_stack_end);
+}
+
+int os_profile_start(uint hz, os_profile_func_t func)
+{
+#if defined(__x86_64__) || defined(__aarch64__)
+	struct itimerval timer;
+	struct sigaction act;
+
+	if (hz > 1000000)
+		return -EINVAL;
+	os_profile_func = func;
+	memset(&act, '\0', sizeof(act));
+	act.sa_sigaction = os_profile_handler;
+	act.sa_flags = SA_SIGINFO | SA_RESTART;
+	sigemptyset(&act.sa_mask);
+	if (sigaction(SIGPROF, &act, NULL))
+		return -errno;
+
+	timer.it_interval.tv_sec = 0;
+	timer.it_interval.tv_usec = 1000000 / hz;
+	timer.it_value = timer.it_interval;
+	if (setitimer(ITIMER_PROF, &timer, NULL))
+		return -errno;
+
+	return 0;
+#else
+	return -ENOSYS;
+#endif
+}
+
+void os_profile_stop(void)
+{
+	struct itimerval timer;
+
+	memset(&timer, '\0', sizeof(timer));
+	setitimer(ITIMER_PROF, &timer, NULL);
+	signal(SIGPROF, SIG_IGN);
+}
@@ -79,4 +79,47 @@ long sandbox_i2c_rtc_get_set_base_time(struct udevice *dev, long base_time);
 
 int sandbox_usb_keyb_add_string(struct udevice *dev, const char *str);
 
+/**
+ * sandbox_udc_connect() - connect the emulated host to the gadget
+ *
+ * The host selects configuration 1, as it would after enumerating the
+ * device. Bulk IN data is dropped until sandbox_udc_host_in() is called.
+ *
+ * @return 0 if OK, -ve on error
+ */
+int sandbox_udc_connect(void);
+
+/**
+ * sandbox_udc_disconnect() - disconnect the emulated host from the gadget
+ */
+void sandbox_udc_disconnect(void);
+
+/**
+ * sandbox_udc_host_out() - send a bulk OUT transfer to the gadget
+ *
+ * The data is not copied, so @buf must stay valid until the gadget has
+ * taken it. Once the host has no more transfers to send, the gadget sees
+ * its cable as unplugged when it waits for data.
+ *
+ * @buf:	Data to send
+ * @len:	Length of the transfer in bytes
+ * @return 0 if OK, -ENOSPC if too many transfers are waiting
+ */
+int sandbox_udc_host_out(const void *buf, int len);
+
+/**
+ * sandbox_udc_host_in() - set where the host puts bulk IN data
+ *
+ * @buf:	Buffer for the data
+ * @size:	Size of @buf in bytes; the gadget waits once it is full
+ */
+void sandbox_udc_host_in(void *buf, int size);
+
+/**
+ * sandbox_udc_host_in_len() - get the bulk IN data received so far
+ *
+ * @return number of bytes put in the buffer given to sandbox_udc_host_in()
+ */
+int sandbox_udc_host_in_len(void);
+
 #endif
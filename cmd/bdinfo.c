@@ -11,6 +11,10 @@
 #include <common.h>
 #include <command.h>
 #include <linux/compiler.h>
+#ifdef CONFIG_ARM64
+#include <asm/system.h>
+#include <asm/armv8/mmu.h>
+#endif
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -299,6 +303,21 @@ int do_bdinfo(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 
 #elif defined(CONFIG_ARM)
 
+#if defined(CONFIG_ARM64) && !defined(CONFIG_SYS_DCACHE_OFF)
+static void print_mmu_stats(void)
+{
+	struct mmu_stats stats;
+
+	mmu_get_stats(&stats);
+	print_num("TLB size", gd->arch.tlb_size);
+	print_num("TLB used", stats.table_bytes);
+	printf("%-12s= %u / %u / %u\n", "1G/2M/4K map", stats.blocks[1],
+	       stats.blocks[2], stats.blocks[3]);
+	printf("%-12s= %u split, %u merged\n", "TLB tables", stats.splits,
+	       stats.merges);
+}
+#endif
+
 static int do_bdinfo(cmd_tbl_t *cmdtp, int flag, int argc,
 			char * const argv[])
 {
@@ -324,6 +343,9 @@ static int do_bdinfo(cmd_tbl_t *cmdtp, int flag, int argc,
 	print_baudrate();
 #if !(defined(CONFIG_SYS_ICACHE_OFF) && defined(CONFIG_SYS_DCACHE_OFF))
 	print_num("TLB addr", gd->arch.tlb_addr);
+#endif
+#if defined(CONFIG_ARM64) && !defined(CONFIG_SYS_DCACHE_OFF)
+	print_mmu_stats();
 #endif
 	print_num("relocaddr", gd->relocaddr);
 	print_num("reloc off", gd->reloc_off);
@@ -10,6 +10,7 @@
  */
 #include <common.h>
 #include <command.h>
+#include <console.h>
 #include <net.h>
 
 #ifdef CONFIG_CMD_GO
@@ -33,6 +34,7 @@ static int do_go(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	addr = simple_strtoul(argv[1], NULL, 16);
 
 	printf ("## Starting application at 0x%08lX ...\n", addr);
+	console_flush();
 
 	/*
 	 * pass address parameter as argv[0] (aka command name),
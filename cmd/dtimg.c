@@ -6,6 +6,9 @@
  */
 
 #include <common.h>
+#include <fdt_support.h>
+#include <lmb.h>
+#include <malloc.h>
 #include <linux/libfdt.h>
 #include <mapmem.h>
 #include <linux/types.h>
@@ -62,46 +65,196 @@ static bool dt_check_header(ulong hdr_addr)
 	return magic == DT_TABLE_MAGIC;
 }
 
+/* Fields of an entry which a lookup can match on, in dt_table_entry order */
+enum dt_field {
+	DT_FIELD_ID,
+	DT_FIELD_REV,
+	DT_FIELD_CUSTOM0,
+	DT_FIELD_COUNT = DT_FIELD_CUSTOM0 + 4,
+};
+
 /**
- * Get the address of FDT (dtb or dtbo) in memory by its id.
+ * struct dt_index_entry - Lookup fields of one table entry
  *
- * @param hdr_addr Start address of DT image
- * @param entries_offset The entries offset as reported by header
- * @param entry_size The size of an entry as reported by header
- * @param entry_count The number of entries as reported by header
- * @param id ID/sku of desired FDT in image
- * @param[out] dt_offset Contains offset of target dt if found
- * @param[out] dt_size Contains size of target dt if found
- * @param[out] e Contains target dt if found
+ * @field: id, rev and custom[] values, in CPU byte order
+ * @index: Position of the entry in the image's table
+ */
+struct dt_index_entry {
+	u32 field[DT_FIELD_COUNT];
+	u32 index;
+};
+
+/**
+ * struct dt_match - What to look for in a table entry
+ *
+ * @mask: Bit n set if field n must match
+ * @field: Values to match
+ */
+struct dt_match {
+	u32 mask;
+	u32 field[DT_FIELD_COUNT];
+};
+
+/*
+ * Index over the entries of the last image looked up, sorted by id. The
+ * table is checked and the index built once, when the header address or
+ * the header changes; a copy of the header is kept to notice that.
+ */
+static struct {
+	ulong hdr_addr;
+	struct dt_table_header hdr;
+	struct dt_index_entry *entries;
+	u32 count;
+} dt_index;
+
+static int dt_index_compar(const void *a, const void *b)
+{
+	const struct dt_index_entry *ea = a, *eb = b;
+
+	if (ea->field[DT_FIELD_ID] != eb->field[DT_FIELD_ID])
+		return ea->field[DT_FIELD_ID] < eb->field[DT_FIELD_ID] ? -1 : 1;
+
+	return ea->index < eb->index ? -1 : ea->index > eb->index;
+}
+
+/**
+ * Build, or reuse, the index over the entries of a DT image.
  *
+ * @param hdr_addr Start address of DT image
  * @return true on success or false on error
  */
-static bool dt_get_fdt_by_id(ulong hdr_addr, u32 entries_offset, u32 entry_size, u32 entry_count,
-				u32 id, u32 *dt_offset, u32 *dt_size, struct dt_table_entry **e)
+static bool dt_index_update(ulong hdr_addr)
 {
-	ulong e_addr;
-	u8 i;
+	const struct dt_table_header *hdr;
+	const u8 *table;
+	u32 count, entry_size, offset, total_size, i, j;
 
-	for (i = 0; i < entry_count; i++) {
-		e_addr = hdr_addr + entries_offset + i * entry_size;
-		(*e) = map_sysmem(e_addr, sizeof(**e));
-		*dt_offset = fdt32_to_cpu((*e)->dt_offset);
-		*dt_size = fdt32_to_cpu((*e)->dt_size);
+	hdr = map_sysmem(hdr_addr, sizeof(*hdr));
+	if (dt_index.entries && dt_index.hdr_addr == hdr_addr &&
+	    !memcmp(&dt_index.hdr, hdr, sizeof(*hdr)))
+		goto out;
 
-		if (fdt32_to_cpu((*e)->id) == id) {
-			break;
-		}
-		
-		if (i == (entry_count - 1)) {
-			eprintf("Error: id %u not found\n", id);
-			unmap_sysmem(*e);
+	count = fdt32_to_cpu(hdr->dt_entry_count);
+	entry_size = fdt32_to_cpu(hdr->dt_entry_size);
+	offset = fdt32_to_cpu(hdr->dt_entries_offset);
+	total_size = fdt32_to_cpu(hdr->total_size);
+	if (entry_size < sizeof(struct dt_table_entry)) {
+		eprintf("Error: dt_entry_size too small (%u)\n", entry_size);
+		goto err;
+	}
+
+	/* The table must fit in the image, which also bounds count */
+	if (offset > total_size || count > (total_size - offset) / entry_size) {
+		eprintf("Error: %u entries of %u bytes do not fit in the image\n",
+			count, entry_size);
+		goto err;
+	}
+
+	free(dt_index.entries);
+	dt_index.entries = calloc(count, sizeof(*dt_index.entries));
+	if (!dt_index.entries) {
+		eprintf("Error: out of memory for DT index\n");
+		goto err;
+	}
+
+	table = map_sysmem(hdr_addr + offset, count * entry_size);
+	for (i = 0; i < count; i++) {
+		const fdt32_t *e = (const fdt32_t *)(table + i * entry_size);
+		struct dt_index_entry *ent = &dt_index.entries[i];
+
+		/* The fields start after dt_size and dt_offset */
+		for (j = 0; j < DT_FIELD_COUNT; j++)
+			ent->field[j] = fdt32_to_cpu(e[2 + j]);
+		ent->index = i;
+	}
+	unmap_sysmem(table);
+	qsort(dt_index.entries, count, sizeof(*dt_index.entries),
+	      dt_index_compar);
+
+	memcpy(&dt_index.hdr, hdr, sizeof(*hdr));
+	dt_index.hdr_addr = hdr_addr;
+	dt_index.count = count;
+out:
+	unmap_sysmem(hdr);
+
+	return true;
+
+err:
+	free(dt_index.entries);
+	memset(&dt_index, '\0', sizeof(dt_index));
+	unmap_sysmem(hdr);
+
+	return false;
+}
+
+static bool dt_index_matches(const struct dt_index_entry *ent,
+			     const struct dt_match *match)
+{
+	int i;
+
+	for (i = 0; i < DT_FIELD_COUNT; i++) {
+		if ((match->mask & BIT(i)) && ent->field[i] != match->field[i])
 			return false;
-		}
 	}
 
 	return true;
 }
 
+/**
+ * Find the first entry of a DT image, in table order, matching the given
+ * fields. Lookups by id use a binary search of the index.
+ *
+ * @param hdr_addr Start address of DT image
+ * @param match Fields to match
+ * @param[out] index Contains position of the entry in the table if found
+ *
+ * @return true on success or false on error
+ */
+static bool dt_find_entry(ulong hdr_addr, const struct dt_match *match,
+			  u32 *index)
+{
+	const struct dt_index_entry *ent;
+	u32 id = match->field[DT_FIELD_ID];
+	u32 lo = 0, hi, mid, i;
+	bool found = false;
+
+	if (!dt_index_update(hdr_addr))
+		return false;
+
+	if (match->mask & BIT(DT_FIELD_ID)) {
+		hi = dt_index.count;
+		while (lo < hi) {
+			mid = (lo + hi) / 2;
+			if (dt_index.entries[mid].field[DT_FIELD_ID] < id)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+
+		/* Entries with the same id are in table order */
+		for (ent = &dt_index.entries[lo];
+		     lo < dt_index.count && ent->field[DT_FIELD_ID] == id;
+		     lo++, ent++) {
+			if (dt_index_matches(ent, match)) {
+				*index = ent->index;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	for (i = 0, ent = dt_index.entries; i < dt_index.count; i++, ent++) {
+		if (dt_index_matches(ent, match) &&
+		    (!found || ent->index < *index)) {
+			*index = ent->index;
+			found = true;
+		}
+	}
+
+	return found;
+}
+
 /**
  * Get the address of FDT (dtb or dtbo) in memory by its index in image.
  *
@@ -132,30 +285,34 @@ static bool dt_get_fdt_blob(ulong hdr_addr, u32 index, char *id_text, ulong *add
 	unmap_sysmem(hdr);
 
 	if (id_text == NULL) {
-		if (index > entry_count) {
-			eprintf("Error: index > dt_entry_count (%u > %u)\n", index,
+		if (index >= entry_count) {
+			eprintf("Error: index >= dt_entry_count (%u >= %u)\n", index,
 				entry_count);
 			return false;
 		}
-
-		e_addr = hdr_addr + entries_offset + index * entry_size;
-		e = map_sysmem(e_addr, sizeof(*e));
-		dt_offset = fdt32_to_cpu(e->dt_offset);
-		dt_size = fdt32_to_cpu(e->dt_size);
-
 	} else {
+		struct dt_match match = {
+			.mask = BIT(DT_FIELD_ID),
+			.field[DT_FIELD_ID] = *id_text,
+		};
+
 		if (entry_count <= 0) {
 			eprintf("Error: no entries found--invalid header?\n");
 			return false;
 		}
 
-		if (!dt_get_fdt_by_id(hdr_addr, entries_offset, entry_size, entry_count, *id_text, 
-				&dt_offset, &dt_size, &e)) {
+		if (!dt_find_entry(hdr_addr, &match, &index)) {
+			eprintf("Error: id %u not found\n", *id_text);
 			eprintf("Error: Failed to get dt by id\n");
 			return false;
 		}
 	}
 
+	e_addr = hdr_addr + entries_offset + index * entry_size;
+	e = map_sysmem(e_addr, sizeof(*e));
+	dt_offset = fdt32_to_cpu(e->dt_offset);
+	dt_size = fdt32_to_cpu(e->dt_size);
+
 	/* Set dt info to env */
 	env_set_hex("fdt_id", fdt32_to_cpu(e->id));
 	env_set_hex("fdt_rev", fdt32_to_cpu(e->rev));
@@ -357,9 +514,13 @@ static int dtimg_get_fdt(int argc, char * const argv[], enum cmd_dtimg_info cmd)
 			return CMD_RET_FAILURE;
 		}
 
+		if (lmb_load_check(addr, fdt_size, "dtb"))
+			return CMD_RET_FAILURE;
+
 		wbuf = map_sysmem(addr, fdt_size);
 		memcpy(wbuf, (void *)fdt_addr, fdt_size);
 		unmap_sysmem(wbuf);
+		lmb_load_add(addr, fdt_size, "dtb");
 
 		env_set_hex(argv[4], fdt_size);
 		break;
@@ -390,11 +551,162 @@ static int do_dtimg_load(cmd_tbl_t *cmdtp, int flag, int argc,
 }
 
 
+#ifdef CONFIG_OF_LIBFDT_OVERLAY
+static const char * const dt_field_names[DT_FIELD_COUNT] = {
+	"id", "rev", "custom0", "custom1", "custom2", "custom3",
+};
+
+/**
+ * Parse an entry selector: either an index, or a comma-separated list of
+ * <field>=<hex value> pairs such as "id=4e58,rev=1".
+ *
+ * @param hdr_addr Start address of DT image
+ * @param arg Selector
+ * @param[out] index Contains position of the selected entry in the table
+ *
+ * @return true on success or false on error
+ */
+static bool dt_parse_entry(ulong hdr_addr, const char *arg, u32 *index)
+{
+	struct dt_match match = { .mask = 0 };
+	const char *p = arg;
+	char *endp;
+	int i;
+
+	if (!strchr(arg, '=')) {
+		*index = simple_strtoul(arg, &endp, 0);
+		if (*endp != '\0' || !dt_index_update(hdr_addr) ||
+		    *index >= dt_index.count) {
+			eprintf("Error: Wrong index %s\n", arg);
+			return false;
+		}
+		return true;
+	}
+
+	while (*p) {
+		for (i = 0; i < DT_FIELD_COUNT; i++) {
+			int len = strlen(dt_field_names[i]);
+
+			if (!strncmp(p, dt_field_names[i], len) && p[len] == '=') {
+				p += len + 1;
+				break;
+			}
+		}
+		if (i == DT_FIELD_COUNT) {
+			eprintf("Error: Wrong selector %s\n", arg);
+			return false;
+		}
+		match.field[i] = simple_strtoul(p, &endp, 16);
+		match.mask |= BIT(i);
+		if (endp == p || (*endp && *endp != ',')) {
+			eprintf("Error: Wrong selector %s\n", arg);
+			return false;
+		}
+		p = *endp ? endp + 1 : endp;
+	}
+
+	if (!dt_find_entry(hdr_addr, &match, index)) {
+		eprintf("Error: no entry matches %s\n", arg);
+		return false;
+	}
+
+	return true;
+}
+
+static int do_dtimg_apply(cmd_tbl_t *cmdtp, int flag, int argc,
+			  char * const argv[])
+{
+	const struct dt_table_header *hdr;
+	const struct dt_table_entry *e;
+	u32 entries_offset, entry_size, index;
+	ulong hdr_addr, fdt_addr;
+	int count = argc - 3;
+	void **fdtos;
+	void *fdt;
+	char *endp;
+	int i, ret = CMD_RET_FAILURE;
+
+	if (argc < 4)
+		return CMD_RET_USAGE;
+
+	hdr_addr = simple_strtoul(argv[1], &endp, 16);
+	if (*endp != '\0') {
+		eprintf("Error: Wrong image address\n");
+		return CMD_RET_FAILURE;
+	}
+
+	if (!dt_check_header(hdr_addr)) {
+		eprintf("Error: DT image header is incorrect\n");
+		return CMD_RET_FAILURE;
+	}
+
+	fdt_addr = simple_strtoul(argv[2], &endp, 16);
+	if (*endp != '\0') {
+		eprintf("Error: Wrong FDT address\n");
+		return CMD_RET_FAILURE;
+	}
+
+	hdr = map_sysmem(hdr_addr, sizeof(*hdr));
+	entries_offset = fdt32_to_cpu(hdr->dt_entries_offset);
+	entry_size = fdt32_to_cpu(hdr->dt_entry_size);
+	unmap_sysmem(hdr);
+
+	fdt = map_sysmem(fdt_addr, 0);
+	if (fdt_check_header(fdt)) {
+		eprintf("Error: No valid FDT at %lx\n", fdt_addr);
+		goto out_unmap;
+	}
+
+	/* The overlays are modified while being applied, so use copies */
+	fdtos = calloc(count, sizeof(*fdtos));
+	if (!fdtos)
+		goto out_unmap;
+	for (i = 0; i < count; i++) {
+		const void *dt;
+		u32 dt_offset, dt_size;
+
+		if (!dt_parse_entry(hdr_addr, argv[3 + i], &index))
+			goto out;
+
+		e = map_sysmem(hdr_addr + entries_offset + index * entry_size,
+			       sizeof(*e));
+		dt_offset = fdt32_to_cpu(e->dt_offset);
+		dt_size = fdt32_to_cpu(e->dt_size);
+		unmap_sysmem(e);
+
+		fdtos[i] = malloc(dt_size);
+		if (!fdtos[i]) {
+			eprintf("Error: out of memory for overlay %s\n",
+				argv[3 + i]);
+			goto out;
+		}
+		dt = map_sysmem(hdr_addr + dt_offset, dt_size);
+		memcpy(fdtos[i], dt, dt_size);
+		unmap_sysmem(dt);
+	}
+
+	if (!fdt_overlay_apply_list(fdt, fdtos, count))
+		ret = CMD_RET_SUCCESS;
+
+out:
+	for (i = 0; i < count; i++)
+		free(fdtos[i]);
+	free(fdtos);
+out_unmap:
+	unmap_sysmem(fdt);
+
+	return ret;
+}
+#endif
+
 static cmd_tbl_t cmd_dtimg_sub[] = {
 	U_BOOT_CMD_MKENT(dump, 2, 0, do_dtimg_dump, "", ""),
 	U_BOOT_CMD_MKENT(start, 5, 0, do_dtimg_start, "", ""),
 	U_BOOT_CMD_MKENT(size, 5, 0, do_dtimg_size, "", ""),
 	U_BOOT_CMD_MKENT(load, 6, 0, do_dtimg_load, "", ""),
+#ifdef CONFIG_OF_LIBFDT_OVERLAY
+	U_BOOT_CMD_MKENT(apply, CONFIG_SYS_MAXARGS, 0, do_dtimg_apply, "", ""),
+#endif
 };
 
 static int do_dtimg(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
@@ -440,4 +752,12 @@ U_BOOT_CMD(
 	"      <addr_new>: address to load FDT\n"
 	"      <varname>: name of variable where to store size of FDT\n"
 	"      [<id>]: id of desired FDT (optional)"
+#ifdef CONFIG_OF_LIBFDT_OVERLAY
+	"\ndtimg apply <addr> <fdt_addr> <entry>...\n"
+	"    - apply overlays from the image to an FDT, in order\n"
+	"      <addr>: image address in RAM, in hex\n"
+	"      <fdt_addr>: address of the FDT to update, in hex\n"
+	"      <entry>: index of an overlay in the image, or fields to\n"
+	"        match, e.g. id=<hex>[,rev=<hex>][,custom0=<hex>]..."
+#endif
 );
@@ -0,0 +1,115 @@
+/*
+ * Read the parts of a FIT image with external data that a configuration uses
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <fs.h>
+#include <image.h>
+#include <mapmem.h>
+
+struct fitload_file {
+	const char *ifname;
+	const char *dev_part_str;
+	const char *filename;
+};
+
+static int fitload_read(struct fit_loader *ldr, ulong offset, ulong size,
+			void *buf)
+{
+	struct fitload_file *file = ldr->priv;
+	loff_t actread;
+	int ret;
+
+	/* The filesystem is closed after each access */
+	ret = fs_set_blk_dev(file->ifname, file->dev_part_str, FS_TYPE_ANY);
+	if (ret)
+		return -ENODEV;
+
+	ret = fs_read(file->filename, map_to_sysmem(buf), offset, size,
+		      &actread);
+	if (ret < 0)
+		return ret;
+	if (actread != size)
+		return -EIO;
+
+	return 0;
+}
+
+static int do_fitload(cmd_tbl_t *cmdtp, int flag, int argc,
+		      char * const argv[])
+{
+	struct fitload_file file;
+	struct fit_loader ldr;
+	const char *conf_name;
+	unsigned long time;
+	ulong addr, size;
+	char *ep;
+	int ret;
+
+	if (argc < 2)
+		return CMD_RET_USAGE;
+
+	file.ifname = argv[1];
+	file.dev_part_str = argc >= 3 ? argv[2] : NULL;
+	if (argc >= 4) {
+		addr = simple_strtoul(argv[3], &ep, 16);
+		if (ep == argv[3] || *ep != '\0')
+			return CMD_RET_USAGE;
+	} else {
+		addr = env_get_hex("loadaddr", CONFIG_SYS_LOAD_ADDR);
+	}
+	if (argc >= 5) {
+		file.filename = argv[4];
+	} else {
+		file.filename = env_get("bootfile");
+		if (!file.filename) {
+			puts("** No boot file defined **\n");
+			return CMD_RET_FAILURE;
+		}
+	}
+	conf_name = argc >= 6 ? argv[5] : NULL;
+
+	ldr.read = fitload_read;
+	ldr.priv = &file;
+
+	time = get_timer(0);
+	ret = fit_load_ext(&ldr, map_sysmem(addr, 0), conf_name, &size);
+	time = get_timer(time);
+	if (ret == -ENOEXEC) {
+		printf("Bad FIT image format\n");
+		return CMD_RET_FAILURE;
+	} else if (ret == -ENOENT) {
+		printf("Could not find configuration\n");
+		return CMD_RET_FAILURE;
+	} else if (ret) {
+		printf("Failed to read FIT image (err=%d)\n", ret);
+		return CMD_RET_FAILURE;
+	}
+
+	printf("%lu bytes read in %lu ms", size, time);
+	if (time > 0) {
+		puts(" (");
+		print_size(size / time * 1000, "/s");
+		puts(")");
+	}
+	puts("\n");
+
+	env_set_hex("fileaddr", addr);
+	env_set_hex("filesize", size);
+
+	return CMD_RET_SUCCESS;
+}
+
+U_BOOT_CMD(
+	fitload,	6,	0,	do_fitload,
+	"read the parts of a FIT image a configuration uses",
+	"<interface> [<dev[:part]> [<addr> [<filename> [<config>]]]]\n"
+	"    - Read the structure of FIT image 'filename' from partition 'part'\n"
+	"      on device type 'interface' instance 'dev' to address 'addr',\n"
+	"      then each image with external data that configuration 'config'\n"
+	"      (or the default one) uses, straight to its load address.\n"
+	"      Boot it with 'bootm <addr>#<config>'."
+);
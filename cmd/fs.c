@@ -42,6 +42,11 @@ U_BOOT_CMD(
 	"      If 'bytes' is 0 or omitted, the file is read until the end.\n"
 	"      'pos' gives the file byte position to start reading from.\n"
 	"      If 'pos' is 0 or omitted, the file is read from the start."
+#ifdef CONFIG_LMB_LOAD_MAP
+	"\n"
+	"      If 'addr' is 'auto', a free address is picked and stored\n"
+	"      in 'fileaddr'."
+#endif
 )
 
 static int do_save_wrapper(cmd_tbl_t *cmdtp, int flag, int argc,
@@ -40,6 +40,13 @@ static int do_host_save(cmd_tbl_t *cmdtp, int flag, int argc,
 static int do_host_bind(cmd_tbl_t *cmdtp, int flag, int argc,
 			   char * const argv[])
 {
+	int flags = 0;
+
+	if (argc >= 2 && !strcmp(argv[1], "-m")) {
+		flags |= HOST_BIND_MMAP;
+		argc--;
+		argv++;
+	}
 	if (argc < 2 || argc > 3)
 		return CMD_RET_USAGE;
 	char *ep;
@@ -50,7 +57,96 @@ static int do_host_bind(cmd_tbl_t *cmdtp, int flag, int argc,
 		printf("** Bad device specification %s **\n", dev_str);
 		return CMD_RET_USAGE;
 	}
-	return host_dev_bind(dev, file);
+	return host_dev_bind(dev, file, flags);
+}
+
+static int get_host_dev(const char *dev_str, struct host_block_dev **host_devp)
+{
+	char *ep;
+	int dev, ret;
+
+	dev = simple_strtoul(dev_str, &ep, 16);
+	if (*ep) {
+		printf("** Bad device specification %s **\n", dev_str);
+		return CMD_RET_USAGE;
+	}
+
+	ret = host_get_host_dev(dev, host_devp);
+	if (ret) {
+		if (ret == -ENOENT)
+			puts("Not bound to a backing file\n");
+		else if (ret == -ENODEV)
+			puts("Invalid host device number\n");
+
+		return CMD_RET_FAILURE;
+	}
+
+	return 0;
+}
+
+static int do_host_delay(cmd_tbl_t *cmdtp, int flag, int argc,
+			 char * const argv[])
+{
+	struct host_block_dev *host_dev;
+	int ret;
+
+	if (argc < 2 || argc > 4)
+		return CMD_RET_USAGE;
+
+	ret = get_host_dev(argv[1], &host_dev);
+	if (ret)
+		return ret;
+
+	if (argc == 2) {
+		if (!host_dev->overhead_ns && !host_dev->bandwidth) {
+			printf("No delay\n");
+			return 0;
+		}
+		printf("%llu us per request, ",
+		       host_dev->overhead_ns / 1000);
+		if (host_dev->bandwidth)
+			printf("%llu kB/s\n", host_dev->bandwidth / 1000);
+		else
+			printf("no bandwidth limit\n");
+		return 0;
+	}
+
+	host_dev->overhead_ns = simple_strtoull(argv[2], NULL, 10) * 1000;
+	host_dev->bandwidth = argc > 3 ?
+			      simple_strtoull(argv[3], NULL, 10) * 1000 : 0;
+
+	return 0;
+}
+
+static int do_host_stats(cmd_tbl_t *cmdtp, int flag, int argc,
+			 char * const argv[])
+{
+	struct host_block_dev *host_dev;
+	struct host_block_stats *stats;
+	int ret;
+
+	if (argc < 2 || argc > 3)
+		return CMD_RET_USAGE;
+
+	ret = get_host_dev(argv[1], &host_dev);
+	if (ret)
+		return ret;
+	stats = &host_dev->stats;
+
+	if (argc == 3) {
+		if (strcmp(argv[2], "reset"))
+			return CMD_RET_USAGE;
+		memset(stats, 0, sizeof(*stats));
+		return 0;
+	}
+
+	printf("reads:  %llu (%llu blocks)\n", stats->reads,
+	       stats->read_blocks);
+	printf("writes: %llu (%llu blocks)\n", stats->writes,
+	       stats->write_blocks);
+	printf("delay:  %llu us\n", stats->delay_ns / 1000);
+
+	return 0;
 }
 
 static int do_host_info(cmd_tbl_t *cmdtp, int flag, int argc,
@@ -145,8 +241,10 @@ static cmd_tbl_t cmd_host_sub[] = {
 	U_BOOT_CMD_MKENT(ls, 3, 0, do_host_ls, "", ""),
 	U_BOOT_CMD_MKENT(save, 6, 0, do_host_save, "", ""),
 	U_BOOT_CMD_MKENT(size, 3, 0, do_host_size, "", ""),
-	U_BOOT_CMD_MKENT(bind, 3, 0, do_host_bind, "", ""),
+	U_BOOT_CMD_MKENT(bind, 4, 0, do_host_bind, "", ""),
 	U_BOOT_CMD_MKENT(info, 3, 0, do_host_info, "", ""),
+	U_BOOT_CMD_MKENT(delay, 4, 0, do_host_delay, "", ""),
+	U_BOOT_CMD_MKENT(stats, 3, 0, do_host_stats, "", ""),
 	U_BOOT_CMD_MKENT(dev, 0, 1, do_host_dev, "", ""),
 };
 
@@ -182,8 +280,12 @@ U_BOOT_CMD(
 	"host save hostfs - <addr> <filename> <bytes> [<offset>] - "
 		"save a file to host\n"
 	"host size hostfs - <filename> - determine size of file on host\n"
-	"host bind <dev> [<filename>] - bind \"host\" device to file\n"
+	"host bind [-m] <dev> [<filename>] - bind \"host\" device to file\n"
+	"     -m: map the file into memory rather than read and write it\n"
 	"host info [<dev>]            - show device binding & info\n"
+	"host delay <dev> [<us> [<kB/s>]] - show or set the time each\n"
+	"     request takes: <us> plus the time to move the data at <kB/s>\n"
+	"host stats <dev> [reset] - show or reset device request counts\n"
 	"host dev [<dev>] - Set or retrieve the current host device\n"
 	"host commands use the \"hostfs\" device. The \"host\" device is used\n"
 	"with standard IO commands such as fatls or ext2load"
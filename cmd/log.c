@@ -21,8 +21,25 @@ static int do_log_level(cmd_tbl_t *cmdtp, int flag, int argc,
 	return 0;
 }
 
+#ifdef CONFIG_LOG_RING
+static int do_log_dump(cmd_tbl_t *cmdtp, int flag, int argc,
+		       char * const argv[])
+{
+	int ret;
+
+	ret = log_ring_dump();
+	if (ret == -ENOENT)
+		printf("No log ring\n");
+
+	return ret ? CMD_RET_FAILURE : 0;
+}
+#endif
+
 static cmd_tbl_t log_sub[] = {
 	U_BOOT_CMD_MKENT(level, CONFIG_SYS_MAXARGS, 1, do_log_level, "", ""),
+#ifdef CONFIG_LOG_RING
+	U_BOOT_CMD_MKENT(dump, 1, 1, do_log_dump, "", ""),
+#endif
 #ifdef CONFIG_LOG_TEST
 	U_BOOT_CMD_MKENT(test, 2, 1, do_log_test, "", ""),
 #endif
@@ -49,6 +66,9 @@ static int do_log(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 #ifdef CONFIG_SYS_LONGHELP
 static char log_help_text[] =
 	"level - get/set log level\n"
+#ifdef CONFIG_LOG_RING
+	"log dump - show the records in the binary log ring\n"
+#endif
 #ifdef CONFIG_LOG_TEST
 	"log test - run log tests\n"
 #endif
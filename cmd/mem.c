@@ -18,6 +18,7 @@
 #include <command.h>
 #include <console.h>
 #include <hash.h>
+#include <highwater.h>
 #include <inttypes.h>
 #include <mapmem.h>
 #include <watchdog.h>
@@ -1182,6 +1183,9 @@ static int do_mem_info(cmd_tbl_t *cmdtp, int flag, int argc,
 		       char * const argv[])
 {
 	board_show_dram(gd->ram_size);
+#ifdef CONFIG_MEM_HIGHWATER
+	highwater_show();
+#endif
 
 	return 0;
 }
@@ -0,0 +1,419 @@
+/*
+ * Memory bandwidth and latency benchmark
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <console.h>
+#include <mapmem.h>
+#include <linux/log2.h>
+#include <linux/math64.h>
+#include <linux/sizes.h>
+#include <asm/system.h>
+
+/* Shortest time a measurement may take */
+#define MEMBENCH_MIN_US		10000
+
+/* Most times a test is repeated to make up a measurement */
+#define MEMBENCH_MAX_REPS	(1 << 20)
+
+/* Distance between the pointers followed by the chase test */
+#define MEMBENCH_CHASE_STRIDE	64
+
+#define MEMBENCH_MAX_OFFSETS	8
+
+enum membench_test {
+	MEMBENCH_READ,
+	MEMBENCH_WRITE,
+	MEMBENCH_COPY,
+	MEMBENCH_CHASE,
+
+	MEMBENCH_TEST_COUNT,
+};
+
+static const char *const membench_test_names[MEMBENCH_TEST_COUNT] = {
+	"read",
+	"write",
+	"copy",
+	"chase",
+};
+
+struct membench_cache {
+	const char *name;
+	int option;
+};
+
+#if defined(CONFIG_ARM) && !defined(CONFIG_SYS_DCACHE_OFF)
+/*
+ * DCACHE_OFF maps the region as device (strongly-ordered) memory, which is
+ * not the same as normal memory without the cache, so each has its name
+ */
+static const struct membench_cache membench_caches[] = {
+	{ "wb", DCACHE_WRITEBACK },
+	{ "wt", DCACHE_WRITETHROUGH },
+#ifdef CONFIG_ARM64
+	{ "nc", DCACHE_NORMAL_NC },
+#endif
+	{ "dev", DCACHE_OFF },
+};
+
+#if defined(CONFIG_SYS_ARM_CACHE_WRITETHROUGH)
+#define MEMBENCH_CACHE_DEFAULT	DCACHE_WRITETHROUGH
+#elif defined(CONFIG_SYS_ARM_CACHE_WRITEALLOC)
+#define MEMBENCH_CACHE_DEFAULT	DCACHE_WRITEALLOC
+#else
+#define MEMBENCH_CACHE_DEFAULT	DCACHE_WRITEBACK
+#endif
+
+/* Map a region with a cache attribute, or as normal with cache NULL */
+static int membench_set_cache(ulong addr, ulong size,
+			      const struct membench_cache *cache)
+{
+	if (!dcache_status()) {
+		puts("D-cache is off\n");
+		return -EPERM;
+	}
+	if ((addr | size) & (MMU_SECTION_SIZE - 1)) {
+		printf("Address and size must be aligned to %#x\n",
+		       MMU_SECTION_SIZE);
+		return -EINVAL;
+	}
+
+	flush_dcache_range(addr, addr + size);
+	mmu_set_region_dcache_behaviour(addr, size, cache ? cache->option :
+					MEMBENCH_CACHE_DEFAULT);
+
+	return 0;
+}
+#else
+static const struct membench_cache membench_caches[0];
+
+static int membench_set_cache(ulong addr, ulong size,
+			      const struct membench_cache *cache)
+{
+	return 0;
+}
+#endif
+
+/* Sink for what the read and chase tests load, so that the loads stay */
+static volatile ulong membench_sink;
+
+static ulong membench_read(const ulong *p, ulong words)
+{
+	ulong a = 0, b = 0, c = 0, d = 0;
+
+	for (; words >= 4; words -= 4, p += 4) {
+		a += p[0];
+		b += p[1];
+		c += p[2];
+		d += p[3];
+	}
+
+	return a + b + c + d;
+}
+
+static void *membench_chase(void **p, ulong steps)
+{
+	for (; steps >= 4; steps -= 4) {
+		p = *p;
+		p = *p;
+		p = *p;
+		p = *p;
+	}
+
+	return p;
+}
+
+/*
+ * Link the cache-line sized slots of buf into a single cycle in random
+ * order (Sattolo's algorithm), so that each load depends on the one before
+ * and neither the prefetcher nor the branch predictor can help.
+ */
+static void membench_chase_init(void **buf, ulong slots)
+{
+	const ulong stride = MEMBENCH_CHASE_STRIDE / sizeof(void *);
+	ulong i, j, tmp;
+	u32 seed = 1;
+
+	for (i = 0; i < slots; i++)
+		buf[i * stride] = (void *)i;
+
+	for (i = slots - 1; i > 0; i--) {
+		seed = seed * 1103515245 + 12345;
+		j = (seed >> 8) % i;
+		tmp = (ulong)buf[i * stride];
+		buf[i * stride] = buf[j * stride];
+		buf[j * stride] = (void *)tmp;
+	}
+
+	for (i = 0; i < slots; i++)
+		buf[i * stride] = &buf[(ulong)buf[i * stride] * stride];
+}
+
+/* Run a test reps times, returning the time it took in microseconds */
+static ulong membench_run(enum membench_test test, void *buf, ulong size,
+			  ulong offset, ulong reps)
+{
+	ulong word_offset = offset & ~(sizeof(ulong) - 1);
+	ulong start, i;
+
+	start = timer_get_us();
+	for (i = 0; i < reps; i++) {
+		switch (test) {
+		case MEMBENCH_READ:
+			membench_sink += membench_read(buf + word_offset,
+						       size / sizeof(ulong));
+			break;
+		case MEMBENCH_WRITE:
+			memset(buf + offset, i, size);
+			break;
+		case MEMBENCH_COPY:
+			memcpy(buf + size + offset, buf, size);
+			break;
+		case MEMBENCH_CHASE:
+			buf = membench_chase(buf, size / MEMBENCH_CHASE_STRIDE);
+			break;
+		default:
+			break;
+		}
+	}
+	if (test == MEMBENCH_CHASE)
+		membench_sink = (ulong)buf;
+
+	return timer_get_us() - start;
+}
+
+/*
+ * Measure one test on one working set, repeating it until it takes long
+ * enough to time, and print the result as a CSV row
+ */
+static void membench_measure(enum membench_test test, const char *cache,
+			     void *buf, ulong size, ulong offset)
+{
+	ulong word_offset = offset & ~(sizeof(ulong) - 1);
+	u64 bytes, accesses;
+	ulong reps, us;
+
+	if (test == MEMBENCH_CHASE) {
+		buf += word_offset;
+		membench_chase_init(buf, size / MEMBENCH_CHASE_STRIDE);
+	}
+
+	/* Run once first so that what fits in the cache is there */
+	membench_run(test, buf, size, offset, 1);
+	for (reps = 1; ; reps *= 2) {
+		us = membench_run(test, buf, size, offset, reps);
+		if (us >= MEMBENCH_MIN_US || reps == MEMBENCH_MAX_REPS)
+			break;
+	}
+	if (!us)
+		us = 1;
+
+	bytes = (u64)reps * size;
+	if (test == MEMBENCH_CHASE)
+		accesses = (u64)reps * (size / MEMBENCH_CHASE_STRIDE);
+	else
+		accesses = bytes / sizeof(ulong);
+
+	/*
+	 * MB/s and ns per access, to one decimal place. Chase loads one word
+	 * per cache line, so it has no bandwidth to report
+	 */
+	printf("%s,%s,%lu,%lu,%lu,%lu,", membench_test_names[test], cache,
+	       size, offset, reps, us);
+	if (test != MEMBENCH_CHASE) {
+		bytes = div_u64(bytes * 10, us);
+		printf("%llu.%llu", bytes / 10, bytes % 10);
+	}
+	accesses = div64_u64((u64)us * 10000, accesses);
+	printf(",%llu.%llu\n", accesses / 10, accesses % 10);
+}
+
+/* Parse a comma-separated list of names into a bit mask of their indexes */
+static int membench_parse_names(const char *arg, const char *const names[],
+				int count, uint *maskp)
+{
+	const char *p = arg;
+	int i, len;
+
+	*maskp = 0;
+	while (*p) {
+		len = strchrnul(p, ',') - p;
+		for (i = 0; i < count; i++) {
+			if (strlen(names[i]) == len &&
+			    !strncmp(p, names[i], len))
+				break;
+		}
+		if (i == count) {
+			printf("Unknown name in '%s'\n", arg);
+			return -EINVAL;
+		}
+		*maskp |= 1 << i;
+		p += len;
+		if (*p)
+			p++;
+	}
+
+	return *maskp ? 0 : -EINVAL;
+}
+
+static int membench_parse_offsets(const char *arg, ulong offsets[],
+				  int *countp)
+{
+	const char *p = arg;
+	char *end;
+	int count = 0;
+
+	while (*p) {
+		if (count == MEMBENCH_MAX_OFFSETS)
+			return -E2BIG;
+		offsets[count++] = simple_strtoul(p, &end, 16);
+		if (end == p || (*end && *end != ','))
+			return -EINVAL;
+		p = *end ? end + 1 : end;
+	}
+	*countp = count;
+
+	return count ? 0 : -EINVAL;
+}
+
+/* Run a test on each working set and offset which fit in len bytes */
+static int membench_sweep(enum membench_test test, const char *cache,
+			  void *buf, ulong len, ulong min_size,
+			  const ulong offsets[], int noffsets)
+{
+	ulong size, used;
+	int i;
+
+	for (size = min_size; size <= len; size *= 2) {
+		/* Copy writes a second working set after the first */
+		used = test == MEMBENCH_COPY ? size * 2 : size;
+		for (i = 0; i < noffsets; i++) {
+			if (used + offsets[i] > len)
+				continue;
+			if (ctrlc())
+				return -EINTR;
+			membench_measure(test, cache, buf, size, offsets[i]);
+		}
+	}
+
+	return 0;
+}
+
+static int do_membench(cmd_tbl_t *cmdtp, int flag, int argc,
+		       char * const argv[])
+{
+	const char *cache_names[ARRAY_SIZE(membench_caches) + 1];
+	ulong offsets[MEMBENCH_MAX_OFFSETS] = { 0 };
+	ulong addr, len, min_size, max_offset;
+	int noffsets = 1, ret, c, t, i;
+	uint tests = (1 << MEMBENCH_TEST_COUNT) - 1;
+	uint caches = 0;
+	void *buf;
+
+	for (i = 0; i < ARRAY_SIZE(membench_caches); i++)
+		cache_names[i] = membench_caches[i].name;
+
+	min_size = SZ_4K;
+	while (argc > 1 && argv[1][0] == '-') {
+		if (argc < 3 || argv[1][2])
+			return CMD_RET_USAGE;
+
+		switch (argv[1][1]) {
+		case 't':
+			ret = membench_parse_names(argv[2], membench_test_names,
+						   MEMBENCH_TEST_COUNT, &tests);
+			break;
+		case 'c':
+			if (!ARRAY_SIZE(membench_caches)) {
+				puts("Cache attributes cannot be changed\n");
+				return CMD_RET_FAILURE;
+			}
+			ret = membench_parse_names(argv[2], cache_names,
+						   ARRAY_SIZE(membench_caches),
+						   &caches);
+			break;
+		case 'o':
+			ret = membench_parse_offsets(argv[2], offsets,
+						     &noffsets);
+			break;
+		case 's':
+			min_size = simple_strtoul(argv[2], NULL, 16);
+			ret = min_size >= MEMBENCH_CHASE_STRIDE * 4 &&
+			      is_power_of_2(min_size) ? 0 : -EINVAL;
+			break;
+		default:
+			return CMD_RET_USAGE;
+		}
+		if (ret)
+			return CMD_RET_USAGE;
+		argc -= 2;
+		argv += 2;
+	}
+	if (argc != 3)
+		return CMD_RET_USAGE;
+
+	addr = simple_strtoul(argv[1], NULL, 16);
+	len = simple_strtoul(argv[2], NULL, 16);
+
+	max_offset = 0;
+	for (i = 0; i < noffsets; i++)
+		max_offset = max(max_offset, offsets[i]);
+	if (len < min_size + max_offset) {
+		printf("Region too small for a %#lx byte working set\n",
+		       min_size);
+		return CMD_RET_FAILURE;
+	}
+
+	buf = map_sysmem(addr, len);
+	puts("test,cache,size,offset,reps,us,mb_per_s,ns_per_access\n");
+	for (c = caches ? 0 : -1; c < (int)ARRAY_SIZE(membench_caches); c++) {
+		if (c >= 0 && !(caches & (1 << c)))
+			continue;
+		if (c >= 0 && membench_set_cache(addr, len,
+						 &membench_caches[c])) {
+			ret = CMD_RET_FAILURE;
+			goto out;
+		}
+
+		for (t = 0; t < MEMBENCH_TEST_COUNT; t++) {
+			if (!(tests & (1 << t)))
+				continue;
+			if (membench_sweep(t, c >= 0 ? cache_names[c] : "-",
+					   buf, len, min_size, offsets,
+					   noffsets)) {
+				ret = CMD_RET_FAILURE;
+				goto out;
+			}
+		}
+	}
+	ret = CMD_RET_SUCCESS;
+
+out:
+	if (caches)
+		membench_set_cache(addr, len, NULL);
+	unmap_sysmem(buf);
+
+	return ret;
+}
+
+U_BOOT_CMD(
+	membench,	11,	0,	do_membench,
+	"memory bandwidth and latency benchmark",
+	"[-t <tests>] [-c <caches>] [-o <offsets>] [-s <min_size>] <addr> <len>\n"
+	"    - Measure memory in the region at 'addr' of 'len' bytes with\n"
+	"      working sets from 'min_size' (default 0x1000) bytes, doubling\n"
+	"      up to what fits, and print the results as CSV\n"
+	"  -t  tests to run, any of read,write,copy,chase (default all);\n"
+	"      copy uses twice the working set, chase reports the latency of\n"
+	"      dependent loads in random order and has no mb_per_s\n"
+	"  -c  cache attributes to map the region with in turn, any of\n"
+	"      wb,wt,nc (arm64 only),dev (default: leave as it is); nc is\n"
+	"      normal memory without the cache, dev is device memory\n"
+	"  -o  hex offsets from the start of the region to run at (default 0);\n"
+	"      copy applies them to its destination only, read and chase\n"
+	"      round them down to a whole word\n"
+	"The region is overwritten and must not hold U-Boot itself"
+);
@@ -8,6 +8,7 @@
 #include <common.h>
 #include <command.h>
 #include <console.h>
+#include <lmb.h>
 #include <mmc.h>
 
 static int curr_device = -1;
@@ -293,11 +294,17 @@ static int do_mmc_read(cmd_tbl_t *cmdtp, int flag,
 	if (!mmc)
 		return CMD_RET_FAILURE;
 
+	if (lmb_load_check((ulong)addr, (phys_size_t)cnt * mmc->read_bl_len,
+			   "mmc read"))
+		return CMD_RET_FAILURE;
+
 	printf("\nMMC read: dev # %d, block # %d, count %d ... ",
 	       curr_device, blk, cnt);
 
 	n = blk_dread(mmc_get_blk_desc(mmc), blk, cnt, addr);
 	printf("%d blocks read: %s\n", n, (n == cnt) ? "OK" : "ERROR");
+	lmb_load_add((ulong)addr, (phys_size_t)n * mmc->read_bl_len,
+		     "mmc read");
 
 	return (n == cnt) ? CMD_RET_SUCCESS : CMD_RET_FAILURE;
 }
@@ -215,6 +215,7 @@ static int _do_env_set(int flag, int argc, char * const argv[], int env_flag)
 	int   i, len;
 	char  *name, *value, *s;
 	ENTRY e, *ep;
+	enum malloc_tag old_tag;
 
 	debug("Initial value for argc=%d\n", argc);
 	while (argc > 1 && **(argv + 1) == '-') {
@@ -271,7 +272,9 @@ static int _do_env_set(int flag, int argc, char * const argv[], int env_flag)
 
 	e.key	= name;
 	e.data	= value;
+	old_tag = malloc_set_tag(MALLOC_TAG_ENV);
 	hsearch_r(e, ENTER, &ep, &env_htab, env_flag);
+	malloc_set_tag(old_tag);
 	free(value);
 	if (!ep) {
 		printf("## Error inserting \"%s\" variable, errno=%d\n",
@@ -997,6 +1000,8 @@ static int do_env_import(cmd_tbl_t *cmdtp, int flag,
 	int	del = 0;
 	int	crlf_is_lf = 0;
 	size_t	size;
+	enum malloc_tag old_tag;
+	int	ret;
 
 	cmd = *argv;
 
@@ -1082,8 +1087,11 @@ static int do_env_import(cmd_tbl_t *cmdtp, int flag,
 		ptr = (char *)ep->data;
 	}
 
-	if (himport_r(&env_htab, ptr, size, sep, del ? 0 : H_NOCLEAR,
-			crlf_is_lf, 0, NULL) == 0) {
+	old_tag = malloc_set_tag(MALLOC_TAG_ENV);
+	ret = himport_r(&env_htab, ptr, size, sep, del ? 0 : H_NOCLEAR,
+			crlf_is_lf, 0, NULL);
+	malloc_set_tag(old_tag);
+	if (ret == 0) {
 		pr_err("Environment import failed: errno = %d\n", errno);
 		return 1;
 	}
@@ -138,6 +138,12 @@ static int do_part_info(int argc, char * const argv[], enum cmd_part_info param)
 		err = part_get_info(desc, part, &info);
 		if (err)
 			return 1;
+#if CONFIG_IS_ENABLED(PARTITION_UUIDS)
+	} else if (uuid_str_valid(argv[2])) {
+		part = part_get_info_by_uuid(desc, argv[2], &info);
+		if (part == -1)
+			return 1;
+#endif
 	} else {
 		part = part_get_info_by_name(desc, argv[2], &info);
 		if (part == -1)
@@ -182,6 +188,32 @@ static int do_part_number(int argc, char * const argv[])
 	return do_part_info(argc, argv, CMD_PART_INFO_NUMBER);
 }
 
+#if CONFIG_IS_ENABLED(PARTITION_CACHE)
+static int do_part_cache(int argc, char * const argv[])
+{
+	struct blk_desc *desc;
+	struct part_cache_stats stats;
+
+	if (argc != 2)
+		return CMD_RET_USAGE;
+
+	if (blk_get_device_by_str(argv[0], argv[1], &desc) < 0)
+		return 1;
+
+	part_cache_get_stats(desc, &stats);
+	printf("hits: %u\n"
+	       "misses: %u\n"
+	       "invalidations: %u\n"
+	       "entries: %u\n"
+	       "table bytes: %u\n"
+	       "filesystems: %u\n",
+	       stats.hits, stats.misses, stats.invalidations, stats.entries,
+	       stats.table_size, stats.fstypes);
+
+	return 0;
+}
+#endif
+
 static int do_part(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	if (argc < 2)
@@ -197,6 +229,10 @@ static int do_part(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		return do_part_size(argc - 2, argv + 2);
 	else if (!strcmp(argv[1], "number"))
 		return do_part_number(argc - 2, argv + 2);
+#if CONFIG_IS_ENABLED(PARTITION_CACHE)
+	else if (!strcmp(argv[1], "cache"))
+		return do_part_cache(argc - 2, argv + 2);
+#endif
 
 	return CMD_RET_USAGE;
 }
@@ -222,4 +258,11 @@ U_BOOT_CMD(
 	"part number <interface> <dev> <part> <varname>\n"
 	"    - set environment variable to the partition number using the partition name\n"
 	"      part must be specified as partition name"
+#if CONFIG_IS_ENABLED(PARTITION_UUIDS)
+	"\n      part can also be given as a partition UUID for start, size and number"
+#endif
+#if CONFIG_IS_ENABLED(PARTITION_CACHE)
+	"\npart cache <interface> <dev>\n"
+	"    - show partition cache statistics of a device"
+#endif
 );
@@ -0,0 +1,86 @@
+/*
+ * Control of the sampling profiler
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <mapmem.h>
+#include <profiler.h>
+
+static int profile_save(int argc, char * const argv[])
+{
+	ulong base, buff_size, buff_ptr;
+	int needed, ret;
+	char *buff;
+
+	if (argc == 2) {
+		/* Follow on from any trace data already in the buffer */
+		base = env_get_ulong("profbase", 16, 0);
+		buff_size = env_get_ulong("profsize", 16, 0);
+		buff_ptr = env_get_ulong("profoffset", 16, 0);
+	} else if (argc == 4) {
+		base = simple_strtoul(argv[2], NULL, 16);
+		buff_size = simple_strtoul(argv[3], NULL, 16);
+		buff_ptr = 0;
+	} else {
+		return CMD_RET_USAGE;
+	}
+	if (!buff_size || buff_ptr > buff_size)
+		return CMD_RET_USAGE;
+
+	buff = map_sysmem(base, buff_size);
+	ret = profiler_save(buff + buff_ptr, buff_size - buff_ptr, &needed);
+	unmap_sysmem(buff);
+	if (ret) {
+		printf("Error: buffer too small (%#x bytes needed)\n", needed);
+		return CMD_RET_FAILURE;
+	}
+	printf("Samples dumped to %08lx, size %#x\n", base + buff_ptr, needed);
+
+	env_set_hex("profbase", base);
+	env_set_hex("profsize", buff_size);
+	env_set_hex("profoffset", buff_ptr + needed);
+
+	return 0;
+}
+
+static int do_profile(cmd_tbl_t *cmdtp, int flag, int argc,
+		      char * const argv[])
+{
+	const char *cmd = argc < 2 ? "" : argv[1];
+	uint hz;
+	int ret;
+
+	if (!strcmp(cmd, "start")) {
+		hz = argc > 2 ? simple_strtoul(argv[2], NULL, 10) :
+			CONFIG_PROFILER_HZ;
+		if (!hz)
+			return CMD_RET_USAGE;
+		ret = profiler_start(hz);
+		if (ret) {
+			printf("Cannot start profiler (err=%d)\n", ret);
+			return CMD_RET_FAILURE;
+		}
+	} else if (!strcmp(cmd, "stop")) {
+		profiler_stop();
+	} else if (!strcmp(cmd, "stats")) {
+		profiler_print_stats();
+	} else if (!strcmp(cmd, "save")) {
+		return profile_save(argc, argv);
+	} else {
+		return CMD_RET_USAGE;
+	}
+
+	return 0;
+}
+
+U_BOOT_CMD(
+	profile,	4,	1,	do_profile,
+	"sampling profiler",
+	"start [<hz>]                 - start taking samples\n"
+	"profile stop                         - stop taking samples\n"
+	"profile stats                        - display sample statistics\n"
+	"profile save [<addr> <size>]         - write samples into buffer"
+);
@@ -10,6 +10,7 @@
 
 #include <common.h>
 #include <command.h>
+#include <lmb.h>
 #include <part.h>
 
 int do_read(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
@@ -66,10 +67,15 @@ int do_read(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		return 1;
 	}
 
+	if (lmb_load_check((ulong)addr, (phys_size_t)cnt * dev_desc->blksz,
+			   "read"))
+		return 1;
+
 	if (blk_dread(dev_desc, offset + blk, cnt, addr) != cnt) {
 		printf("Error reading blocks\n");
 		return 1;
 	}
+	lmb_load_add((ulong)addr, (phys_size_t)cnt * dev_desc->blksz, "read");
 
 	return 0;
 }
@@ -16,6 +16,7 @@
 #include <dm.h>
 #include <fdtdec.h>
 #include <fs.h>
+#include <highwater.h>
 #include <i2c.h>
 #include <initcall.h>
 #include <init_helpers.h>
@@ -387,6 +388,18 @@ static int reserve_trace(void)
 	return 0;
 }
 
+static int reserve_log(void)
+{
+#ifdef CONFIG_LOG_RING
+	gd->relocaddr -= CONFIG_LOG_RING_SIZE;
+	log_ring_init(gd->relocaddr, CONFIG_LOG_RING_SIZE);
+	debug("Reserving %dk for the log ring at: %08lx\n",
+	      CONFIG_LOG_RING_SIZE >> 10, gd->relocaddr);
+#endif
+
+	return 0;
+}
+
 static int reserve_uboot(void)
 {
 	/*
@@ -841,6 +854,7 @@ static const init_fnc_t init_sequence_f[] = {
 #endif
 	reserve_video,
 	reserve_trace,
+	reserve_log,
 	reserve_uboot,
 	reserve_malloc,
 	reserve_board,
@@ -865,6 +879,9 @@ static const init_fnc_t init_sequence_f[] = {
 	fix_fdt,
 #endif
 	INIT_FUNC_WATCHDOG_RESET
+#ifdef CONFIG_MEM_HIGHWATER
+	highwater_record_f,
+#endif
 	reloc_fdt,
 	reloc_bootstage,
 	setup_reloc,
@@ -887,6 +904,7 @@ void board_init_f(ulong boot_flags)
 {
 	gd->flags = boot_flags;
 	gd->have_console = 0;
+	highwater_paint_f();
 
 	if (initcall_run_list(init_sequence_f))
 		hang();
@@ -21,6 +21,7 @@
 #include <dm.h>
 #include <environment.h>
 #include <fdtdec.h>
+#include <highwater.h>
 #include <ide.h>
 #include <initcall.h>
 #include <init_helpers.h>
@@ -654,6 +655,7 @@ static int initr_kbd(void)
 
 static int run_main_loop(void)
 {
+	highwater_record_r();
 #ifdef CONFIG_SANDBOX
 	sandbox_main_loop_init();
 #endif
@@ -886,6 +888,7 @@ void board_init_r(gd_t *new_gd, ulong dest_addr)
 	gd = new_gd;
 #endif
 	gd->flags &= ~GD_FLG_LOG_READY;
+	highwater_paint_r();
 
 #ifdef CONFIG_NEEDS_MANUAL_RELOC
 	for (i = 0; i < ARRAY_SIZE(init_sequence_r); i++)
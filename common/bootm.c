@@ -11,9 +11,11 @@
 #include <bzlib.h>
 #include <errno.h>
 #include <fdt_support.h>
+#include <highwater.h>
 #include <lmb.h>
 #include <malloc.h>
 #include <mapmem.h>
+#include <profiler.h>
 #include <asm/io.h>
 #include <linux/lzo.h>
 #include <lzma/LzmaTypes.h>
@@ -70,6 +72,8 @@ static void boot_start_lmb(bootm_headers_t *images)
 
 	arch_lmb_reserve(&images->lmb);
 	board_lmb_reserve(&images->lmb);
+	/* Keep relocated images clear of everything already loaded */
+	lmb_load_reserve(&images->lmb);
 }
 #else
 #define lmb_reserve(lmb, base, size)
@@ -252,7 +256,7 @@ int bootm_find_images(int flag, int argc, char * const argv[])
 		e_puts("Could not find a valid device tree\n");
 		return 1;
 	}
-	set_working_fdt_addr((ulong)images.ft_addr);
+	set_working_fdt_addr(map_to_sysmem(images.ft_addr));
 #endif
 
 #if IMAGE_ENABLE_FIT
@@ -500,6 +504,7 @@ ulong bootm_disable_interrupts(void)
 	 * recover from any failures any more...
 	 */
 	iflag = disable_interrupts();
+	profiler_stop();
 #ifdef CONFIG_NETCONSOLE
 	/* Stop the ethernet stack if NetConsole could have left it up */
 	eth_halt();
@@ -636,10 +641,12 @@ int do_bootm_states(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 
 		iflag = bootm_disable_interrupts();
 		ret = bootm_load_os(images, &load_end, 0);
-		if (ret == 0)
+		if (ret == 0) {
 			lmb_reserve(&images->lmb, images->os.load,
 				    (load_end - images->os.load));
-		else if (ret && ret != BOOTM_ERR_OVERLAP)
+			lmb_load_add(images->os.load,
+				     load_end - images->os.load, "kernel");
+		} else if (ret && ret != BOOTM_ERR_OVERLAP)
 			goto err;
 		else if (ret == BOOTM_ERR_OVERLAP)
 			ret = 0;
@@ -693,6 +700,7 @@ int do_bootm_states(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 		if (images->os.os == IH_OS_LINUX)
 			fixup_silent_linux();
 #endif
+		highwater_record_r();
 		ret = boot_fn(BOOTM_STATE_OS_PREP, argc, argv, images);
 	}
 
@@ -168,6 +168,18 @@ ulong bootstage_mark_code(const char *file, const char *func, int linenum)
 	return bootstage_mark_name(BOOTSTAGE_ID_ALLOC, str);
 }
 
+void bootstage_set_size(enum bootstage_id id, const char *name, ulong size)
+{
+	struct bootstage_data *data = gd->bootstage;
+	struct bootstage_record *rec = ensure_id(data, id);
+
+	if (rec) {
+		rec->time_us = size;
+		rec->name = name;
+		rec->flags = BOOTSTAGEF_SIZE;
+	}
+}
+
 uint32_t bootstage_start(enum bootstage_id id, const char *name)
 {
 	struct bootstage_data *data = gd->bootstage;
@@ -286,8 +298,9 @@ static int add_bootstages_devicetree(struct fdt_header *blob)
 				       get_record_name(buf, sizeof(buf), rec)))
 			return -EINVAL;
 
-		/* Check if this is a 'mark' or 'accum' record */
+		/* Check if this is a 'size', 'mark' or 'accum' record */
 		if (fdt_setprop_cell(blob, node,
+				rec->flags & BOOTSTAGEF_SIZE ? "size" :
 				rec->start_us ? "accum" : "mark",
 				rec->time_us))
 			return -EINVAL;
@@ -309,6 +322,7 @@ void bootstage_report(void)
 {
 	struct bootstage_data *data = gd->bootstage;
 	struct bootstage_record *rec = data->record;
+	bool size_hdr = false;
 	uint32_t prev;
 	int i;
 
@@ -322,7 +336,8 @@ void bootstage_report(void)
 	qsort(data->record, data->rec_count, sizeof(*rec), h_compare_record);
 
 	for (i = 1, rec++; i < data->rec_count; i++, rec++) {
-		if (rec->id && !rec->start_us)
+		if (rec->id && !rec->start_us &&
+		    !(rec->flags & BOOTSTAGEF_SIZE))
 			prev = print_time_record(rec, prev);
 	}
 	if (data->rec_count > RECORD_COUNT)
@@ -335,6 +350,20 @@ void bootstage_report(void)
 		if (rec->start_us)
 			prev = print_time_record(rec, -1);
 	}
+
+	for (i = 0, rec = data->record; i < data->rec_count; i++, rec++) {
+		char buf[20];
+
+		if (!(rec->flags & BOOTSTAGEF_SIZE))
+			continue;
+		if (!size_hdr) {
+			puts("\nMemory high-water marks in bytes:\n");
+			size_hdr = true;
+		}
+		printf("%11s", "");
+		print_grouped_ull(rec->time_us, BOOTSTAGE_DIGITS);
+		printf("  %s\n", get_record_name(buf, sizeof(buf), rec));
+	}
 }
 
 /**
@@ -3189,6 +3189,7 @@ static int parse_stream_outer(struct in_str *inp, int flag)
 	o_string temp=NULL_O_STRING;
 	int rcode;
 #ifdef __U_BOOT__
+	enum malloc_tag old_tag;
 	int code = 1;
 #endif
 	do {
@@ -3197,6 +3198,10 @@ static int parse_stream_outer(struct in_str *inp, int flag)
 		update_ifs_map();
 		if (!(flag & FLAG_PARSE_SEMICOLON) || (flag & FLAG_REPARSING)) mapset((uchar *)";$&|", 0);
 		inp->promptmode=1;
+#ifdef __U_BOOT__
+		/* Account the parse tree, but not the commands it runs */
+		old_tag = malloc_set_tag(MALLOC_TAG_CLI);
+#endif
 		rcode = parse_stream(&temp, &ctx, inp,
 				     flag & FLAG_CONT_ON_NEWLINE ? -1 : '\n');
 #ifdef __U_BOOT__
@@ -3214,6 +3219,7 @@ static int parse_stream_outer(struct in_str *inp, int flag)
 #ifndef __U_BOOT__
 			run_list(ctx.list_head);
 #else
+			malloc_set_tag(old_tag);
 			code = run_list(ctx.list_head);
 			if (code == -2) {	/* exit */
 				b_free(&temp);
@@ -3229,6 +3235,9 @@ static int parse_stream_outer(struct in_str *inp, int flag)
 			    flag_repeat = 0;
 #endif
 		} else {
+#ifdef __U_BOOT__
+			malloc_set_tag(old_tag);
+#endif
 			if (ctx.old_flag != 0) {
 				free(ctx.stack);
 				b_reset(&temp);
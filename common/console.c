@@ -170,6 +170,141 @@ static bool console_dev_is_serial(struct stdio_dev *sdev)
 	return is_serial;
 }
 
+#if CONFIG_IS_ENABLED(CONSOLE_BUFFER)
+/** Buffered console output ********************************************/
+
+/*
+ * Output for a device with a try_puts() method goes through a ring buffer.
+ * The device takes what it can without waiting and the rest is sent when
+ * there is room, so printing does not spin while a UART shifts out each
+ * character.
+ */
+
+/* Get the output buffer for a device, allocating it on first use */
+static struct membuff *console_outbuf(struct stdio_dev *dev)
+{
+	struct membuff *mb = dev->outbuf;
+
+	if (mb || !dev->try_puts || !(gd->flags & GD_FLG_RELOC))
+		return mb;
+
+	mb = malloc(sizeof(*mb));
+	if (!mb)
+		return NULL;
+	if (membuff_new(mb, CONFIG_CONSOLE_BUFFER_SIZE)) {
+		free(mb);
+		return NULL;
+	}
+	dev->outbuf = mb;
+
+	return mb;
+}
+
+/**
+ * console_drain() - Send buffered output to a device
+ *
+ * @dev:	Device to send output to
+ * @wait:	true to wait until everything is sent, false to send only what
+ *		the device takes without waiting
+ */
+static void console_drain(struct stdio_dev *dev, bool wait)
+{
+	struct membuff *mb = dev->outbuf;
+	char *data;
+	int len, sent;
+
+	if (!mb)
+		return;
+	while ((len = membuff_getraw(mb, -1, false, &data)) > 0) {
+		sent = dev->try_puts(dev, data, len);
+		if (sent > 0)
+			membuff_getraw(mb, sent, true, &data);
+		else if (!wait)
+			break;
+	}
+}
+
+static void console_drain_all(bool wait)
+{
+	struct list_head *head = stdio_get_list();
+	struct stdio_dev *dev;
+
+	/*
+	 * The device list is only set up by stdio_init(), and nothing is
+	 * buffered before relocation, so there is nothing to do until then
+	 */
+	if (!(gd->flags & GD_FLG_DEVINIT) || !(gd->flags & GD_FLG_RELOC))
+		return;
+
+	list_for_each_entry(dev, head, list)
+		console_drain(dev, wait);
+}
+
+/**
+ * console_dev_write() - Send output to a device through its buffer
+ *
+ * @return true if done, false if the device is not buffered and the caller
+ * should write to it directly
+ */
+static bool console_dev_write(struct stdio_dev *dev, const char *s, int len)
+{
+	struct membuff *mb = console_outbuf(dev);
+	int ret;
+
+	if (!mb)
+		return false;
+
+	/* Older output goes first */
+	console_drain(dev, false);
+	if (membuff_isempty(mb)) {
+		ret = dev->try_puts(dev, s, len);
+		if (ret > 0) {
+			s += ret;
+			len -= ret;
+		}
+	}
+	while (len) {
+		ret = membuff_put(mb, s, len);
+		s += ret;
+		len -= ret;
+		/* The buffer is full, wait for the device to make room */
+		if (len)
+			console_drain(dev, false);
+	}
+
+	return true;
+}
+
+static void console_dev_putc(struct stdio_dev *dev, const char c)
+{
+	if (!console_dev_write(dev, &c, 1))
+		dev->putc(dev, c);
+}
+
+static void console_dev_puts(struct stdio_dev *dev, const char *s)
+{
+	if (!console_dev_write(dev, s, strlen(s)))
+		dev->puts(dev, s);
+}
+
+void console_flush(void)
+{
+	console_drain_all(true);
+}
+#else
+static inline void console_drain_all(bool wait) {}
+
+static inline void console_dev_putc(struct stdio_dev *dev, const char c)
+{
+	dev->putc(dev, c);
+}
+
+static inline void console_dev_puts(struct stdio_dev *dev, const char *s)
+{
+	dev->puts(dev, s);
+}
+#endif /* CONFIG_IS_ENABLED(CONSOLE_BUFFER) */
+
 #if CONFIG_IS_ENABLED(CONSOLE_MUX)
 /** Console I/O multiplexing *******************************************/
 
@@ -223,7 +358,7 @@ static void console_putc(int file, const char c)
 	for (i = 0; i < cd_count[file]; i++) {
 		dev = console_devices[file][i];
 		if (dev->putc != NULL)
-			dev->putc(dev, c);
+			console_dev_putc(dev, c);
 	}
 }
 
@@ -235,7 +370,7 @@ static void console_puts_noserial(int file, const char *s)
 	for (i = 0; i < cd_count[file]; i++) {
 		dev = console_devices[file][i];
 		if (dev->puts != NULL && !console_dev_is_serial(dev))
-			dev->puts(dev, s);
+			console_dev_puts(dev, s);
 	}
 }
 
@@ -247,7 +382,7 @@ static void console_puts(int file, const char *s)
 	for (i = 0; i < cd_count[file]; i++) {
 		dev = console_devices[file][i];
 		if (dev->puts != NULL)
-			dev->puts(dev, s);
+			console_dev_puts(dev, s);
 	}
 }
 
@@ -268,18 +403,18 @@ static inline int console_tstc(int file)
 
 static inline void console_putc(int file, const char c)
 {
-	stdio_devices[file]->putc(stdio_devices[file], c);
+	console_dev_putc(stdio_devices[file], c);
 }
 
 static inline void console_puts_noserial(int file, const char *s)
 {
 	if (!console_dev_is_serial(stdio_devices[file]))
-		stdio_devices[file]->puts(stdio_devices[file], s);
+		console_dev_puts(stdio_devices[file], s);
 }
 
 static inline void console_puts(int file, const char *s)
 {
-	stdio_devices[file]->puts(stdio_devices[file], s);
+	console_dev_puts(stdio_devices[file], s);
 }
 
 static inline void console_doenv(int file, struct stdio_dev *dev)
@@ -323,6 +458,7 @@ int fgetc(int file)
 			 */
 			if (tstcdev != NULL)
 				return console_getc(file);
+			console_drain_all(false);
 			console_tstc(file);
 #ifdef CONFIG_WATCHDOG
 			/*
@@ -333,6 +469,8 @@ int fgetc(int file)
 #endif
 		}
 #else
+		/* Nothing is sent while we wait for input */
+		console_drain_all(true);
 		return console_getc(file);
 #endif
 	}
@@ -425,6 +563,9 @@ int tstc(void)
 	}
 #endif
 	if (gd->flags & GD_FLG_DEVINIT) {
+		/* Send what the console devices have room for */
+		console_drain_all(false);
+
 		/* Test the standard input */
 		return ftstc(stdin);
 	}
@@ -577,6 +577,7 @@ static inline void malloc_bin_reloc(void) {}
 ulong mem_malloc_start = 0;
 ulong mem_malloc_end = 0;
 ulong mem_malloc_brk = 0;
+ulong mem_malloc_brk_max = 0;
 
 void *sbrk(ptrdiff_t increment)
 {
@@ -594,6 +595,8 @@ void *sbrk(ptrdiff_t increment)
 		return (void *)MORECORE_FAILURE;
 
 	mem_malloc_brk = new;
+	if (new > mem_malloc_brk_max)
+		mem_malloc_brk_max = new;
 
 	return (void *)old;
 }
@@ -603,6 +606,7 @@ void mem_malloc_init(ulong start, ulong size)
 	mem_malloc_start = start;
 	mem_malloc_end = start + size;
 	mem_malloc_brk = start;
+	mem_malloc_brk_max = start;
 
 	debug("using memory %#lx-%#lx for malloc()\n", mem_malloc_start,
 	      mem_malloc_end);
@@ -2229,6 +2233,15 @@ size_t malloc_usable_size(mem) Void_t* mem;
 #endif
 {
   mchunkptr p;
+#if CONFIG_IS_ENABLED(MALLOC_SLAB)
+  size_t slab_size;
+#endif
+
+#if CONFIG_IS_ENABLED(MALLOC_SLAB)
+  slab_size = malloc_slab_size(mem);
+  if (slab_size)
+    return slab_size;
+#endif
   if (mem == NULL)
     return 0;
   else
@@ -2247,6 +2260,33 @@ size_t malloc_usable_size(mem) Void_t* mem;
 
 
 
+#if CONFIG_IS_ENABLED(MALLOC_SLAB)
+size_t malloc_get_free(size_t *largest)
+{
+  mbinptr b;
+  mchunkptr p;
+  INTERNAL_SIZE_T avail, sz;
+  int i;
+
+  /* The top chunk can still grow up to the end of the heap */
+  avail = chunksize(top) + (mem_malloc_end - mem_malloc_brk);
+  *largest = avail;
+  for (i = 1; i < NAV; ++i)
+  {
+    b = bin_at(i);
+    for (p = last(b); p != b; p = p->bk)
+    {
+      sz = chunksize(p);
+      avail += sz;
+      if (sz > *largest)
+	*largest = sz;
+    }
+  }
+
+  return avail;
+}
+#endif
+
 /* Utility to update current_mallinfo for malloc_stats and mallinfo() */
 
 #ifdef DEBUG
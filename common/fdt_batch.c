@@ -0,0 +1,743 @@
+/*
+ * Batched device tree edits
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <fdt_batch.h>
+#include <fdtdec.h>
+#include <malloc.h>
+
+/* Deepest node that may be edited; real trees are far shallower */
+#define FDT_BATCH_MAX_DEPTH	32
+
+/**
+ * struct fdt_batch_node - A node touched by a batch
+ *
+ * @offset: Offset of the node in the blob, or -1 if it is to be created
+ * @parent: Handle of the parent node, for nodes to be created
+ * @name: Offset of the node name in the batch data, for nodes to be created
+ */
+struct fdt_batch_node {
+	int offset;
+	int parent;
+	int name;
+};
+
+/**
+ * struct fdt_batch_prop - A property to set or delete
+ *
+ * @node: Handle of the node the property belongs to
+ * @name: Offset of the property name in the batch data
+ * @val: Offset of the value in the batch data, or -1 to delete
+ * @len: Length of the value
+ * @nameoff: Offset of the name in the new strings block, while applying
+ * @done: Property has been written out, while applying
+ */
+struct fdt_batch_prop {
+	int node;
+	int name;
+	int val;
+	int len;
+	int nameoff;
+	bool done;
+};
+
+static int batch_error(struct fdt_batch *b, int err)
+{
+	if (!b->err)
+		b->err = err;
+
+	return b->err;
+}
+
+/* Make room for one more element in a growing array */
+static int batch_grow(struct fdt_batch *b, void **arrayp, int *maxp,
+		      int count, size_t size)
+{
+	void *array;
+	int max;
+
+	if (count < *maxp)
+		return 0;
+
+	max = *maxp ? *maxp * 2 : 16;
+	array = realloc(*arrayp, max * size);
+	if (!array)
+		return batch_error(b, -FDT_ERR_NOSPACE);
+	*arrayp = array;
+	*maxp = max;
+
+	return 0;
+}
+
+/* Copy @len bytes into the batch data, optionally NUL-terminated */
+static int batch_store(struct fdt_batch *b, const void *ptr, int len,
+		       bool terminate)
+{
+	int need = len + terminate;
+	int offset = b->data_len;
+
+	while (b->data_len + need > b->data_max) {
+		int max = b->data_max ? b->data_max * 2 : 256;
+		char *data = realloc(b->data, max);
+
+		if (!data)
+			return batch_error(b, -FDT_ERR_NOSPACE);
+		b->data = data;
+		b->data_max = max;
+	}
+	if (len)
+		memcpy(b->data + offset, ptr, len);
+	if (terminate)
+		b->data[offset + len] = '\0';
+	b->data_len += need;
+
+	return offset;
+}
+
+static int batch_add_node(struct fdt_batch *b, int offset, int parent,
+			  int name)
+{
+	struct fdt_batch_node *node;
+	int ret;
+
+	ret = batch_grow(b, (void **)&b->nodes, &b->node_max, b->node_count,
+			 sizeof(*b->nodes));
+	if (ret)
+		return ret;
+	node = &b->nodes[b->node_count];
+	node->offset = offset;
+	node->parent = parent;
+	node->name = name;
+
+	return b->node_count++;
+}
+
+static int batch_find_offset(struct fdt_batch *b, int offset)
+{
+	int i;
+
+	for (i = 0; i < b->node_count; i++) {
+		if (b->nodes[i].offset == offset)
+			return i;
+	}
+
+	return -1;
+}
+
+void fdt_batch_init(struct fdt_batch *b, const void *fdt)
+{
+	memset(b, '\0', sizeof(*b));
+	b->fdt = fdt;
+	batch_add_node(b, 0, -1, -1);
+}
+
+void fdt_batch_free(struct fdt_batch *b)
+{
+	free(b->nodes);
+	free(b->props);
+	free(b->data);
+	memset(b, '\0', sizeof(*b));
+}
+
+int fdt_batch_offset(struct fdt_batch *b, int nodeoffset)
+{
+	int node;
+
+	if (b->err)
+		return b->err;
+	node = batch_find_offset(b, nodeoffset);
+	if (node >= 0)
+		return node;
+	if (!fdt_get_name(b->fdt, nodeoffset, NULL))
+		return batch_error(b, -FDT_ERR_BADOFFSET);
+
+	return batch_add_node(b, nodeoffset, -1, -1);
+}
+
+static int batch_node_namelen(struct fdt_batch *b, int parent,
+			      const char *name, int namelen)
+{
+	struct fdt_batch_node *node;
+	int offset, i;
+
+	if (b->err)
+		return b->err;
+	if (parent < 0 || parent >= b->node_count)
+		return batch_error(b, -FDT_ERR_BADOFFSET);
+
+	node = &b->nodes[parent];
+	if (node->offset >= 0) {
+		offset = fdt_subnode_offset_namelen(b->fdt, node->offset, name,
+						    namelen);
+		if (offset >= 0)
+			return fdt_batch_offset(b, offset);
+		if (offset != -FDT_ERR_NOTFOUND)
+			return batch_error(b, offset);
+	}
+
+	for (i = 0; i < b->node_count; i++) {
+		node = &b->nodes[i];
+		if (node->offset < 0 && node->parent == parent &&
+		    !strncmp(b->data + node->name, name, namelen) &&
+		    !b->data[node->name + namelen])
+			return i;
+	}
+
+	offset = batch_store(b, name, namelen, true);
+	if (offset < 0)
+		return offset;
+
+	return batch_add_node(b, -1, parent, offset);
+}
+
+int fdt_batch_node(struct fdt_batch *b, int parent, const char *name)
+{
+	return batch_node_namelen(b, parent, name, strlen(name));
+}
+
+int fdt_batch_path(struct fdt_batch *b, const char *path)
+{
+	const char *end;
+	int node = 0;
+
+	if (b->err)
+		return b->err;
+	if (*path != '/')
+		return batch_error(b, -FDT_ERR_BADPATH);
+
+	while (*path) {
+		while (*path == '/')
+			path++;
+		if (!*path)
+			break;
+		end = strchrnul(path, '/');
+		node = batch_node_namelen(b, node, path, end - path);
+		if (node < 0)
+			return node;
+		path = end;
+	}
+
+	return node;
+}
+
+static struct fdt_batch_prop *batch_find_prop(struct fdt_batch *b, int node,
+					      const char *name)
+{
+	struct fdt_batch_prop *prop;
+	int i;
+
+	for (i = 0, prop = b->props; i < b->prop_count; i++, prop++) {
+		if (prop->node == node && !strcmp(b->data + prop->name, name))
+			return prop;
+	}
+
+	return NULL;
+}
+
+static struct fdt_batch_prop *batch_prop(struct fdt_batch *b, int node,
+					 const char *name)
+{
+	struct fdt_batch_prop *prop;
+	int offset;
+
+	if (b->err)
+		return NULL;
+	if (node < 0 || node >= b->node_count) {
+		batch_error(b, -FDT_ERR_BADOFFSET);
+		return NULL;
+	}
+
+	prop = batch_find_prop(b, node, name);
+	if (prop)
+		return prop;
+
+	offset = batch_store(b, name, strlen(name), true);
+	if (offset < 0 || batch_grow(b, (void **)&b->props, &b->prop_max,
+				     b->prop_count, sizeof(*b->props)))
+		return NULL;
+	prop = &b->props[b->prop_count++];
+	prop->node = node;
+	prop->name = offset;
+	prop->val = -1;
+	prop->len = 0;
+
+	return prop;
+}
+
+int fdt_batch_setprop_node(struct fdt_batch *b, int node, const char *name,
+			   const void *val, int len)
+{
+	struct fdt_batch_prop *prop;
+	int offset;
+
+	if (len < 0)
+		return batch_error(b, -FDT_ERR_BADVALUE);
+	prop = batch_prop(b, node, name);
+	if (!prop)
+		return b->err;
+
+	/* Storing the value may move the property array; look it up after */
+	offset = batch_store(b, val, len, false);
+	if (offset < 0)
+		return offset;
+	prop = batch_find_prop(b, node, name);
+	prop->val = offset;
+	prop->len = len;
+
+	return 0;
+}
+
+int fdt_batch_delprop_node(struct fdt_batch *b, int node, const char *name)
+{
+	struct fdt_batch_prop *prop;
+
+	prop = batch_prop(b, node, name);
+	if (!prop)
+		return b->err;
+	prop->val = -1;
+	prop->len = 0;
+
+	return 0;
+}
+
+int fdt_batch_setprop(struct fdt_batch *b, const char *path, const char *name,
+		      const void *val, int len)
+{
+	int node;
+
+	node = fdt_batch_path(b, path);
+	if (node < 0)
+		return node;
+
+	return fdt_batch_setprop_node(b, node, name, val, len);
+}
+
+int fdt_batch_merge(struct fdt_batch *b, int target, const void *src,
+		    int node)
+{
+	const char *name;
+	const void *val;
+	int offset, len, ret;
+
+	fdt_for_each_property_offset(offset, src, node) {
+		val = fdt_getprop_by_offset(src, offset, &name, &len);
+		if (!val)
+			return batch_error(b, len);
+		ret = fdt_batch_setprop_node(b, target, name, val, len);
+		if (ret)
+			return ret;
+	}
+
+	fdt_for_each_subnode(offset, src, node) {
+		int sub;
+
+		name = fdt_get_name(src, offset, NULL);
+		sub = fdt_batch_node(b, target, name);
+		if (sub < 0)
+			return sub;
+		ret = fdt_batch_merge(b, sub, src, offset);
+		if (ret)
+			return ret;
+	}
+
+	return b->err;
+}
+
+/*
+ * Apply the edits one at a time with fdt_setprop() and friends, for blobs
+ * older than version 17 and for builds without CONFIG_FDT_BATCH. Adding
+ * to a node only moves what comes after it, so the existing nodes are
+ * visited from the end of the blob backwards and the offsets of those
+ * still to be visited stay valid.
+ */
+static int batch_each_props(struct fdt_batch *b, void *fdt, int node,
+			    int offset)
+{
+	struct fdt_batch_prop *prop;
+	int i, ret;
+
+	for (i = 0, prop = b->props; i < b->prop_count; i++, prop++) {
+		if (prop->node != node)
+			continue;
+		if (prop->val < 0) {
+			ret = fdt_delprop(fdt, offset, b->data + prop->name);
+			if (ret == -FDT_ERR_NOTFOUND)
+				ret = 0;
+		} else {
+			ret = fdt_setprop(fdt, offset, b->data + prop->name,
+					  b->data + prop->val, prop->len);
+		}
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+static int batch_each_new_nodes(struct fdt_batch *b, void *fdt, int parent,
+				int offset)
+{
+	struct fdt_batch_node *node;
+	int i, sub, ret;
+
+	for (i = 0; i < b->node_count; i++) {
+		node = &b->nodes[i];
+		if (node->offset >= 0 || node->parent != parent)
+			continue;
+		sub = fdt_add_subnode(fdt, offset, b->data + node->name);
+		if (sub < 0)
+			return sub;
+		ret = batch_each_props(b, fdt, i, sub) ?:
+			batch_each_new_nodes(b, fdt, i, sub);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+static int batch_apply_each(struct fdt_batch *b, void *fdt)
+{
+	int last = INT_MAX;
+	int i, node, ret;
+
+	/* The read-write functions need version 17; node offsets stay put */
+	ret = fdt_open_into(fdt, fdt, fdt_totalsize(fdt));
+	if (ret)
+		return ret;
+
+	for (;;) {
+		int offset = -1;
+
+		node = -1;
+		for (i = 0; i < b->node_count; i++) {
+			if (b->nodes[i].offset < last &&
+			    b->nodes[i].offset > offset) {
+				node = i;
+				offset = b->nodes[i].offset;
+			}
+		}
+		if (node < 0)
+			break;
+		last = offset;
+		ret = batch_each_props(b, fdt, node, offset) ?:
+			batch_each_new_nodes(b, fdt, node, offset);
+		if (ret)
+			return ret;
+	}
+	fdtdec_cache_invalidate(fdt);
+
+	return 0;
+}
+
+/**
+ * struct batch_out - Output state while applying a batch
+ *
+ * @buf: Buffer for the new blob
+ * @size: Size of @buf
+ * @pos: Current write position in @buf
+ * @strings: Size of the strings block of the source blob
+ * @extra: Number of bytes of new property names after @strings
+ */
+struct batch_out {
+	char *buf;
+	int size;
+	int pos;
+	int strings;
+	int extra;
+};
+
+static int out_write(struct batch_out *out, const void *ptr, int len)
+{
+	if (out->pos + ALIGN(len, FDT_TAGSIZE) > out->size)
+		return -FDT_ERR_NOSPACE;
+	memcpy(out->buf + out->pos, ptr, len);
+	memset(out->buf + out->pos + len, '\0', ALIGN(len, FDT_TAGSIZE) - len);
+	out->pos += ALIGN(len, FDT_TAGSIZE);
+
+	return 0;
+}
+
+static int out_tag(struct batch_out *out, uint32_t tag)
+{
+	fdt32_t val = cpu_to_fdt32(tag);
+
+	return out_write(out, &val, sizeof(val));
+}
+
+static int out_prop(struct batch_out *out, struct fdt_batch *b,
+		    struct fdt_batch_prop *prop)
+{
+	fdt32_t hdr[3];
+
+	prop->done = true;
+	if (prop->val < 0)
+		return 0;
+
+	hdr[0] = cpu_to_fdt32(FDT_PROP);
+	hdr[1] = cpu_to_fdt32(prop->len);
+	hdr[2] = cpu_to_fdt32(prop->nameoff);
+
+	return out_write(out, hdr, sizeof(hdr)) ?:
+		out_write(out, b->data + prop->val, prop->len);
+}
+
+/* Copy the unchanged part of the structure block up to @to */
+static int out_span(struct batch_out *out, const char *base, int *span,
+		    int to)
+{
+	int len = to - *span;
+
+	if (out->pos + len > out->size)
+		return -FDT_ERR_NOSPACE;
+	memcpy(out->buf + out->pos, base + *span, len);
+	out->pos += len;
+	*span = to;
+
+	return 0;
+}
+
+/* Write out the new properties of a node which have not been written yet */
+static int out_new_props(struct batch_out *out, struct fdt_batch *b, int node)
+{
+	struct fdt_batch_prop *prop;
+	int i, ret;
+
+	for (i = 0, prop = b->props; i < b->prop_count; i++, prop++) {
+		if (prop->node == node && !prop->done) {
+			ret = out_prop(out, b, prop);
+			if (ret)
+				return ret;
+		}
+	}
+
+	return 0;
+}
+
+/* Write out the nodes to be created below a node, with their contents */
+static int out_new_nodes(struct batch_out *out, struct fdt_batch *b,
+			 int parent)
+{
+	struct fdt_batch_node *node;
+	int i, ret;
+
+	for (i = 0; i < b->node_count; i++) {
+		node = &b->nodes[i];
+		if (node->offset >= 0 || node->parent != parent)
+			continue;
+		ret = out_tag(out, FDT_BEGIN_NODE) ?:
+			out_write(out, b->data + node->name,
+				  strlen(b->data + node->name) + 1) ?:
+			out_new_props(out, b, i) ?:
+			out_new_nodes(out, b, i) ?:
+			out_tag(out, FDT_END_NODE);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+static int find_string(const char *strtab, int tabsize, const char *s)
+{
+	int len = strlen(s) + 1;
+	const char *p;
+
+	for (p = strtab; p <= strtab + tabsize - len; p++) {
+		if (!memcmp(p, s, len))
+			return p - strtab;
+	}
+
+	return -1;
+}
+
+/* Work out where each property name goes in the new strings block */
+static void batch_name_offsets(struct fdt_batch *b, const void *fdt,
+			       struct batch_out *out)
+{
+	const char *strtab = fdt + fdt_off_dt_strings(fdt);
+	struct fdt_batch_prop *prop, *prev;
+	const char *name;
+	int i;
+
+	for (i = 0, prop = b->props; i < b->prop_count; i++, prop++) {
+		name = b->data + prop->name;
+		prop->done = false;
+		prop->nameoff = -1;
+
+		/* Names are often set on several nodes; reuse the lookup */
+		for (prev = b->props; prev < prop; prev++) {
+			if (prev->nameoff >= 0 &&
+			    !strcmp(b->data + prev->name, name)) {
+				prop->nameoff = prev->nameoff;
+				break;
+			}
+		}
+		if (prop->nameoff >= 0)
+			continue;
+		prop->nameoff = find_string(strtab, out->strings, name);
+		if (prop->nameoff < 0 && prop->val >= 0) {
+			prop->nameoff = out->strings + out->extra;
+			out->extra += strlen(name) + 1;
+		}
+	}
+}
+
+/* Copy the structure block, splicing in the edits */
+static int batch_out_struct(struct batch_out *out, struct fdt_batch *b,
+			    const void *fdt)
+{
+	const char *base = fdt + fdt_off_dt_struct(fdt);
+	int handles[FDT_BATCH_MAX_DEPTH];
+	int offset = 0, span = 0, next;
+	int depth = 0;
+	uint32_t tag;
+	int ret = 0;
+
+	do {
+		const struct fdt_property *fprop;
+		struct fdt_batch_prop *prop;
+		int node = depth ? handles[depth - 1] : -1;
+
+		tag = fdt_next_tag(fdt, offset, &next);
+		if (next < 0)
+			return next;
+		switch (tag) {
+		case FDT_BEGIN_NODE:
+			/* Properties must come before the first subnode */
+			if (node >= 0)
+				ret = out_span(out, base, &span, offset) ?:
+					out_new_props(out, b, node);
+			if (depth == FDT_BATCH_MAX_DEPTH)
+				return -FDT_ERR_BADSTRUCTURE;
+			handles[depth++] = batch_find_offset(b, offset);
+			break;
+		case FDT_PROP:
+			if (node < 0)
+				break;
+			fprop = fdt_get_property_by_offset(fdt, offset, NULL);
+			prop = batch_find_prop(b, node,
+				fdt_string(fdt, fdt32_to_cpu(fprop->nameoff)));
+			if (prop && !prop->done) {
+				ret = out_span(out, base, &span, offset) ?: out_prop(out, b, prop);
+				span = next;
+			}
+			break;
+		case FDT_END_NODE:
+			if (!depth)
+				return -FDT_ERR_BADSTRUCTURE;
+			if (node >= 0)
+				ret = out_span(out, base, &span, offset) ?:
+					out_new_props(out, b, node) ?:
+					out_new_nodes(out, b, node);
+			depth--;
+			break;
+		case FDT_END:
+		case FDT_NOP:
+			break;
+		default:
+			return -FDT_ERR_BADSTRUCTURE;
+		}
+		if (ret)
+			return ret;
+		offset = next;
+	} while (tag != FDT_END);
+
+	return out_span(out, base, &span, offset);
+}
+
+static int batch_apply_pass(struct fdt_batch *b, void *fdt)
+{
+	struct fdt_batch_prop *prop;
+	struct batch_out out;
+	int rsv_off, rsv_size, struct_off, strings_off;
+	int ret, i;
+
+	memset(&out, '\0', sizeof(out));
+	out.size = fdt_totalsize(fdt);
+	out.strings = fdt_size_dt_strings(fdt);
+	out.buf = malloc(out.size);
+	if (!out.buf)
+		return -FDT_ERR_NOSPACE;
+	batch_name_offsets(b, fdt, &out);
+
+	/* Header and memory reservation map, unchanged */
+	rsv_off = ALIGN(sizeof(struct fdt_header), 8);
+	rsv_size = (fdt_num_mem_rsv(fdt) + 1) *
+		sizeof(struct fdt_reserve_entry);
+	struct_off = rsv_off + rsv_size;
+	if (struct_off > out.size) {
+		ret = -FDT_ERR_NOSPACE;
+		goto out_free;
+	}
+	memcpy(out.buf, fdt, sizeof(struct fdt_header));
+	memcpy(out.buf + rsv_off, fdt + fdt_off_mem_rsvmap(fdt), rsv_size);
+	out.pos = struct_off;
+
+	ret = batch_out_struct(&out, b, fdt);
+	if (ret)
+		goto out_free;
+
+	/* Strings block: the old one followed by any new names */
+	strings_off = out.pos;
+	if (strings_off + out.strings + out.extra > out.size) {
+		ret = -FDT_ERR_NOSPACE;
+		goto out_free;
+	}
+	memcpy(out.buf + strings_off, fdt + fdt_off_dt_strings(fdt),
+	       out.strings);
+	for (i = 0, prop = b->props; i < b->prop_count; i++, prop++) {
+		const char *name = b->data + prop->name;
+
+		if (prop->val >= 0 && prop->nameoff >= out.strings)
+			strcpy(out.buf + strings_off + prop->nameoff, name);
+	}
+
+	fdt_set_off_mem_rsvmap(out.buf, rsv_off);
+	fdt_set_off_dt_struct(out.buf, struct_off);
+	fdt_set_size_dt_struct(out.buf, strings_off - struct_off);
+	fdt_set_off_dt_strings(out.buf, strings_off);
+	fdt_set_size_dt_strings(out.buf, out.strings + out.extra);
+	memcpy(fdt, out.buf, strings_off + out.strings + out.extra);
+	fdtdec_cache_invalidate(fdt);
+
+out_free:
+	free(out.buf);
+
+	return ret;
+}
+
+int fdt_batch_apply(struct fdt_batch *b, void *fdt)
+{
+	int ret;
+
+	ret = b->err;
+	if (ret)
+		goto out;
+	if (fdt != b->fdt) {
+		ret = -FDT_ERR_BADSTATE;
+		goto out;
+	}
+	ret = fdt_check_header(fdt);
+	if (ret)
+		goto out;
+	if (b->node_count == 1 && !b->prop_count)
+		goto out;
+
+	/* Without FDT_BATCH, the compiler drops the single-pass rewrite */
+	if (CONFIG_IS_ENABLED(FDT_BATCH) && fdt_version(fdt) >= 17)
+		ret = batch_apply_pass(b, fdt);
+	else
+		ret = batch_apply_each(b, fdt);
+out:
+	/* Node offsets are stale now, so start again with just the root */
+	b->node_count = min(b->node_count, 1);
+	b->prop_count = 0;
+	b->data_len = 0;
+	b->err = 0;
+
+	return ret;
+}
@@ -15,6 +15,7 @@
 #include <asm/global_data.h>
 #include <libfdt.h>
 #include <fdt_support.h>
+#include <fdt_batch.h>
 #include <exports.h>
 #include <fdtdec.h>
 
@@ -125,20 +126,20 @@ int fdt_find_or_add_subnode(void *fdt, int parentoffset, const char *name)
 
 /* rename to CONFIG_OF_STDOUT_PATH ? */
 #if defined(OF_STDOUT_PATH)
-static int fdt_fixup_stdout(void *fdt, int chosenoff)
+static int fdt_fixup_stdout(struct fdt_batch *b)
 {
-	return fdt_setprop(fdt, chosenoff, "linux,stdout-path",
-			      OF_STDOUT_PATH, strlen(OF_STDOUT_PATH) + 1);
+	return fdt_batch_setprop_string(b, "/chosen", "linux,stdout-path",
+					OF_STDOUT_PATH);
 }
 #elif defined(CONFIG_OF_STDOUT_VIA_ALIAS) && defined(CONFIG_CONS_INDEX)
-static int fdt_fixup_stdout(void *fdt, int chosenoff)
+static int fdt_fixup_stdout(struct fdt_batch *b)
 {
+	const void *fdt = b->fdt;
 	int err;
 	int aliasoff;
 	char sername[9] = { 0 };
 	const void *path;
 	int len;
-	char tmp[256]; /* long enough */
 
 	sprintf(sername, "serial%d", CONFIG_CONS_INDEX - 1);
 
@@ -154,10 +155,8 @@ static int fdt_fixup_stdout(void *fdt, int chosenoff)
 		goto noalias;
 	}
 
-	/* fdt_setprop may break "path" so we copy it to tmp buffer */
-	memcpy(tmp, path, len);
-
-	err = fdt_setprop(fdt, chosenoff, "linux,stdout-path", tmp, len);
+	/* The batch keeps its own copy of "path" */
+	err = fdt_batch_setprop(b, "/chosen", "linux,stdout-path", path, len);
 	if (err < 0)
 		printf("WARNING: could not set linux,stdout-path %s.\n",
 		       fdt_strerror(err));
@@ -171,7 +170,7 @@ noalias:
 	return 0;
 }
 #else
-static int fdt_fixup_stdout(void *fdt, int chosenoff)
+static int fdt_fixup_stdout(struct fdt_batch *b)
 {
 	return 0;
 }
@@ -186,12 +185,12 @@ static inline int fdt_setprop_uxx(void *fdt, int nodeoffset, const char *name,
 		return fdt_setprop_u32(fdt, nodeoffset, name, (uint32_t)val);
 }
 
-int fdt_root(void *fdt)
+int fdt_batch_root(struct fdt_batch *b)
 {
 	char *serial;
 	int err;
 
-	err = fdt_check_header(fdt);
+	err = fdt_check_header(b->fdt);
 	if (err < 0) {
 		printf("fdt_root: %s\n", fdt_strerror(err));
 		return err;
@@ -199,8 +198,8 @@ int fdt_root(void *fdt)
 
 	serial = env_get("serial#");
 	if (serial) {
-		err = fdt_setprop(fdt, 0, "serial-number", serial,
-				  strlen(serial) + 1);
+		err = fdt_batch_setprop_string(b, "/", "serial-number",
+					       serial);
 
 		if (err < 0) {
 			printf("WARNING: could not set serial-number %s.\n",
@@ -212,6 +211,30 @@ int fdt_root(void *fdt)
 	return 0;
 }
 
+/* Run one of the fdt_batch_...() fixups on its own */
+static int fdt_batch_one(void *fdt, const char *name,
+			 int (*fixup)(struct fdt_batch *b))
+{
+	struct fdt_batch batch;
+	int err;
+
+	fdt_batch_init(&batch, fdt);
+	err = fixup(&batch);
+	if (!err) {
+		err = fdt_batch_apply(&batch, fdt);
+		if (err < 0)
+			printf("%s: %s\n", name, fdt_strerror(err));
+	}
+	fdt_batch_free(&batch);
+
+	return err;
+}
+
+int fdt_root(void *fdt)
+{
+	return fdt_batch_one(fdt, "fdt_root", fdt_batch_root);
+}
+
 int fdt_initrd(void *fdt, ulong initrd_start, ulong initrd_end)
 {
 	int   nodeoffset;
@@ -272,27 +295,27 @@ int fdt_initrd(void *fdt, ulong initrd_start, ulong initrd_end)
 	return 0;
 }
 
-int fdt_chosen(void *fdt)
+int fdt_batch_chosen(struct fdt_batch *b)
 {
 	int   nodeoffset;
 	int   err;
 	char  *str;		/* used to set string properties */
 
-	err = fdt_check_header(fdt);
+	err = fdt_check_header(b->fdt);
 	if (err < 0) {
 		printf("fdt_chosen: %s\n", fdt_strerror(err));
 		return err;
 	}
 
 	/* find or create "/chosen" node. */
-	nodeoffset = fdt_find_or_add_subnode(fdt, 0, "chosen");
+	nodeoffset = fdt_batch_path(b, "/chosen");
 	if (nodeoffset < 0)
 		return nodeoffset;
 
 	str = env_get("bootargs");
 	if (str) {
-		err = fdt_setprop(fdt, nodeoffset, "bootargs", str,
-				  strlen(str) + 1);
+		err = fdt_batch_setprop_node(b, nodeoffset, "bootargs", str,
+					     strlen(str) + 1);
 		if (err < 0) {
 			printf("WARNING: could not set bootargs %s.\n",
 			       fdt_strerror(err));
@@ -300,7 +323,12 @@ int fdt_chosen(void *fdt)
 		}
 	}
 
-	return fdt_fixup_stdout(fdt, nodeoffset);
+	return fdt_fixup_stdout(b);
+}
+
+int fdt_chosen(void *fdt)
+{
+	return fdt_batch_one(fdt, "fdt_chosen", fdt_batch_chosen);
 }
 
 void do_fixup_by_path(void *fdt, const char *path, const char *prop,
@@ -410,6 +438,52 @@ static int fdt_pack_reg(const void *fdt, void *buf, u64 *address, u64 *size,
 	return p - (char *)buf;
 }
 
+int fdt_add_reserved_memory(void *blob, const char *basename,
+			    const char *compat, u64 start, u64 size)
+{
+	char name[64];
+	u8 reg[16];
+	int parent, node, len, err;
+
+	parent = fdt_path_offset(blob, "/reserved-memory");
+	if (parent == -FDT_ERR_NOTFOUND) {
+		parent = fdt_add_subnode(blob, 0, "reserved-memory");
+		if (parent < 0)
+			return parent;
+		err = fdt_setprop_u32(blob, parent, "#address-cells",
+				      fdt_address_cells(blob, 0));
+		if (!err)
+			err = fdt_setprop_u32(blob, parent, "#size-cells",
+					      fdt_size_cells(blob, 0));
+		if (!err)
+			err = fdt_setprop_empty(blob, parent, "ranges");
+		if (err)
+			return err;
+	}
+	if (parent < 0)
+		return parent;
+
+	snprintf(name, sizeof(name), "%s@%llx", basename,
+		 (unsigned long long)start);
+	node = fdt_subnode_offset(blob, parent, name);
+	if (node == -FDT_ERR_NOTFOUND)
+		node = fdt_add_subnode(blob, parent, name);
+	if (node < 0)
+		return node;
+
+	if (compat) {
+		err = fdt_setprop_string(blob, node, "compatible", compat);
+		if (err)
+			return err;
+	}
+	len = fdt_pack_reg(blob, reg, &start, &size, 1);
+	err = fdt_setprop(blob, node, "reg", reg, len);
+	if (err)
+		return err;
+
+	return fdt_setprop_empty(blob, node, "no-map");
+}
+
 int fdt_record_loadable(void *blob, u32 index, const char *name,
 			uintptr_t load_addr, u32 size, uintptr_t entry_point,
 			const char *type, const char *os)
@@ -454,8 +528,10 @@ int fdt_record_loadable(void *blob, u32 index, const char *name,
 #else
 #define MEMORY_BANKS_MAX 4
 #endif
-int fdt_fixup_memory_banks(void *blob, u64 start[], u64 size[], int banks)
+int fdt_batch_memory_banks(struct fdt_batch *b, u64 start[], u64 size[],
+			   int banks)
 {
+	const void *blob = b->fdt;
 	int err, nodeoffset;
 	int len;
 	u8 tmp[MEMORY_BANKS_MAX * 16]; /* Up to 64-bit address + 64-bit size */
@@ -474,12 +550,12 @@ int fdt_fixup_memory_banks(void *blob, u64 start[], u64 size[], int banks)
 	}
 
 	/* find or create "/memory" node. */
-	nodeoffset = fdt_find_or_add_subnode(blob, 0, "memory");
+	nodeoffset = fdt_batch_path(b, "/memory");
 	if (nodeoffset < 0)
 			return nodeoffset;
 
-	err = fdt_setprop(blob, nodeoffset, "device_type", "memory",
-			sizeof("memory"));
+	err = fdt_batch_setprop_node(b, nodeoffset, "device_type", "memory",
+				     sizeof("memory"));
 	if (err < 0) {
 		printf("WARNING: could not set %s %s.\n", "device_type",
 				fdt_strerror(err));
@@ -491,7 +567,7 @@ int fdt_fixup_memory_banks(void *blob, u64 start[], u64 size[], int banks)
 
 	len = fdt_pack_reg(blob, tmp, start, size, banks);
 
-	err = fdt_setprop(blob, nodeoffset, "reg", tmp, len);
+	err = fdt_batch_setprop_node(b, nodeoffset, "reg", tmp, len);
 	if (err < 0) {
 		printf("WARNING: could not set %s %s.\n",
 				"reg", fdt_strerror(err));
@@ -499,6 +575,23 @@ int fdt_fixup_memory_banks(void *blob, u64 start[], u64 size[], int banks)
 	}
 	return 0;
 }
+
+int fdt_fixup_memory_banks(void *blob, u64 start[], u64 size[], int banks)
+{
+	struct fdt_batch batch;
+	int err;
+
+	fdt_batch_init(&batch, blob);
+	err = fdt_batch_memory_banks(&batch, start, size, banks);
+	if (!err) {
+		err = fdt_batch_apply(&batch, blob);
+		if (err < 0)
+			printf("%s: %s\n", __func__, fdt_strerror(err));
+	}
+	fdt_batch_free(&batch);
+
+	return err;
+}
 #endif
 
 int fdt_fixup_memory(void *blob, u64 start, u64 size)
@@ -1713,6 +1806,122 @@ int fdt_fixup_display(void *blob, const char *path, const char *display)
 }
 
 #ifdef CONFIG_OF_LIBFDT_OVERLAY
+/*
+ * An overlay which defines no phandles and refers to no labels needs none
+ * of the fixups done by fdt_overlay_apply(), so its fragments can be
+ * merged into the base tree with a single batched rewrite instead of one
+ * fdt_setprop() per property.
+ */
+static bool fdt_overlay_is_simple(const void *fdto)
+{
+	return fdt_path_offset(fdto, "/__fixups__") == -FDT_ERR_NOTFOUND &&
+	       fdt_path_offset(fdto, "/__local_fixups__") ==
+			-FDT_ERR_NOTFOUND &&
+	       fdt_path_offset(fdto, "/__symbols__") == -FDT_ERR_NOTFOUND &&
+	       !fdt_get_max_phandle(fdto);
+}
+
+/* A node with a phandle in the base tree */
+struct fdt_phandle_ent {
+	u32 phandle;
+	int offset;
+};
+
+/* A label from the base tree's /__symbols__ node */
+struct fdt_label_ent {
+	const char *label;
+	u32 phandle;
+};
+
+/*
+ * Lookup tables for the base tree, built with one walk over the tree so
+ * that the fixups of an overlay do not each have to search it again.
+ */
+struct fdt_overlay_maps {
+	struct fdt_phandle_ent *phandles;
+	int phandle_count;
+	u32 max_phandle;
+	struct fdt_label_ent *labels;
+	int label_count;
+};
+
+static int fdt_overlay_find_phandle(struct fdt_overlay_maps *maps,
+				    u32 phandle)
+{
+	int lo = 0, hi = maps->phandle_count;
+
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+
+		if (maps->phandles[mid].phandle == phandle)
+			return maps->phandles[mid].offset;
+		if (maps->phandles[mid].phandle < phandle)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return -FDT_ERR_BADPHANDLE;
+}
+
+/*
+ * Find the node in the base tree which a fragment applies to, using the
+ * phandle map if there is one
+ */
+static int fdt_overlay_target(const void *fdt, const void *fdto,
+			      int fragment, struct fdt_overlay_maps *maps)
+{
+	const char *path;
+	u32 phandle;
+
+	phandle = fdt_getprop_u32_default_node(fdto, fragment, 0, "target", 0);
+	if (phandle) {
+		if (maps)
+			return fdt_overlay_find_phandle(maps, phandle);
+		return fdt_node_offset_by_phandle(fdt, phandle);
+	}
+
+	path = fdt_getprop(fdto, fragment, "target-path", NULL);
+	if (!path)
+		return -FDT_ERR_BADOVERLAY;
+
+	return fdt_path_offset(fdt, path);
+}
+
+static int fdt_overlay_apply_batch(void *fdt, const void *fdto)
+{
+	struct fdt_batch batch;
+	int fragment, overlay, target;
+	int err = 0;
+
+	fdt_batch_init(&batch, fdt);
+	fdt_for_each_subnode(fragment, fdto, 0) {
+		overlay = fdt_subnode_offset(fdto, fragment, "__overlay__");
+		if (overlay == -FDT_ERR_NOTFOUND)
+			continue;
+		if (overlay < 0) {
+			err = overlay;
+			break;
+		}
+
+		target = fdt_overlay_target(fdt, fdto, fragment, NULL);
+		if (target < 0) {
+			err = target;
+			break;
+		}
+
+		err = fdt_batch_merge(&batch, fdt_batch_offset(&batch, target),
+				      fdto, overlay);
+		if (err)
+			break;
+	}
+	if (!err)
+		err = fdt_batch_apply(&batch, fdt);
+	fdt_batch_free(&batch);
+
+	return err;
+}
+
 /**
  * fdt_overlay_apply_verbose - Apply an overlay with verbose error reporting
  *
@@ -1727,6 +1936,14 @@ int fdt_overlay_apply_verbose(void *fdt, void *fdto)
 	int err;
 	bool has_symbols;
 
+	if (fdt_overlay_is_simple(fdto)) {
+		err = fdt_overlay_apply_batch(fdt, fdto);
+		if (err < 0)
+			printf("failed to merge overlay: %s\n",
+			       fdt_strerror(err));
+		return err;
+	}
+
 	err = fdt_path_offset(fdt, "/__symbols__");
 	has_symbols = err >= 0;
 
@@ -1741,4 +1958,333 @@ int fdt_overlay_apply_verbose(void *fdt, void *fdto)
 	}
 	return err;
 }
+
+#ifndef CONFIG_SPL_BUILD
+static int fdt_phandle_compar(const void *a, const void *b)
+{
+	const struct fdt_phandle_ent *pa = a, *pb = b;
+
+	return pa->phandle < pb->phandle ? -1 : pa->phandle > pb->phandle;
+}
+
+static int fdt_label_compar(const void *a, const void *b)
+{
+	const struct fdt_label_ent *la = a, *lb = b;
+
+	return strcmp(la->label, lb->label);
+}
+
+static void fdt_overlay_free_maps(struct fdt_overlay_maps *maps)
+{
+	free(maps->phandles);
+	free(maps->labels);
+	memset(maps, '\0', sizeof(*maps));
+}
+
+static int fdt_overlay_build_maps(const void *fdt,
+				  struct fdt_overlay_maps *maps)
+{
+	int node, prop, count, depth = 0;
+	const char *path;
+	u32 phandle;
+
+	memset(maps, '\0', sizeof(*maps));
+
+	count = 0;
+	for (node = 0; node >= 0; node = fdt_next_node(fdt, node, &depth))
+		count++;
+	maps->phandles = malloc(count * sizeof(*maps->phandles));
+	if (!maps->phandles)
+		return -FDT_ERR_NOSPACE;
+	for (node = 0; node >= 0; node = fdt_next_node(fdt, node, &depth)) {
+		phandle = fdt_get_phandle(fdt, node);
+		if (!phandle)
+			continue;
+		maps->phandles[maps->phandle_count].phandle = phandle;
+		maps->phandles[maps->phandle_count++].offset = node;
+		maps->max_phandle = max(maps->max_phandle, phandle);
+	}
+	qsort(maps->phandles, maps->phandle_count, sizeof(*maps->phandles),
+	      fdt_phandle_compar);
+
+	node = fdt_path_offset(fdt, "/__symbols__");
+	if (node < 0)
+		return 0;
+	count = 0;
+	fdt_for_each_property_offset(prop, fdt, node)
+		count++;
+	if (!count)
+		return 0;
+	maps->labels = malloc(count * sizeof(*maps->labels));
+	if (!maps->labels)
+		return -FDT_ERR_NOSPACE;
+	fdt_for_each_property_offset(prop, fdt, node) {
+		struct fdt_label_ent *ent = &maps->labels[maps->label_count];
+
+		path = fdt_getprop_by_offset(fdt, prop, &ent->label, NULL);
+		if (!path)
+			continue;
+		ent->phandle = fdt_get_phandle(fdt, fdt_path_offset(fdt, path));
+		maps->label_count++;
+	}
+	qsort(maps->labels, maps->label_count, sizeof(*maps->labels),
+	      fdt_label_compar);
+
+	return 0;
+}
+
+static u32 fdt_overlay_find_label(struct fdt_overlay_maps *maps,
+				  const char *label)
+{
+	int lo = 0, hi = maps->label_count;
+
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		int cmp = strcmp(label, maps->labels[mid].label);
+
+		if (!cmp)
+			return maps->labels[mid].phandle;
+		if (cmp > 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return 0;
+}
+
+/* Find the cell at byte @offset of a property */
+static fdt32_t *fdt_overlay_cell(void *fdto, int node, const char *name,
+				 int namelen, u32 offset)
+{
+	char *val;
+	int len;
+
+	val = (char *)fdt_getprop_namelen(fdto, node, name, namelen, &len);
+	if (!val || offset + sizeof(fdt32_t) > len)
+		return NULL;
+
+	return (fdt32_t *)(val + offset);
+}
+
+static void fdt32_add(fdt32_t *cell, u32 delta)
+{
+	*cell = cpu_to_fdt32(fdt32_to_cpu(*cell) + delta);
+}
+
+/* Move references to the overlay's own phandles up by @delta */
+static int fdt_overlay_local_fixups(void *fdto, int node, int fixups,
+				    u32 delta)
+{
+	const fdt32_t *offsets;
+	const char *name;
+	fdt32_t *cell;
+	int prop, sub, len, i, ret;
+
+	fdt_for_each_property_offset(prop, fdto, fixups) {
+		offsets = fdt_getprop_by_offset(fdto, prop, &name, &len);
+		for (i = 0; i < len / (int)sizeof(*offsets); i++) {
+			cell = fdt_overlay_cell(fdto, node, name, strlen(name),
+						fdt32_to_cpu(offsets[i]));
+			if (!cell)
+				return -FDT_ERR_BADOVERLAY;
+			fdt32_add(cell, delta);
+		}
+	}
+
+	fdt_for_each_subnode(sub, fdto, fixups) {
+		int target;
+
+		name = fdt_get_name(fdto, sub, NULL);
+		target = fdt_subnode_offset(fdto, node, name);
+		if (target < 0)
+			return -FDT_ERR_BADOVERLAY;
+		ret = fdt_overlay_local_fixups(fdto, target, sub, delta);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+/* Move the overlay's own phandles above those of the base tree */
+static int fdt_overlay_adjust_phandles(void *fdto, u32 delta)
+{
+	int node, fixups, depth = 0;
+	fdt32_t *cell;
+
+	for (node = 0; node >= 0; node = fdt_next_node(fdto, node, &depth)) {
+		cell = fdt_overlay_cell(fdto, node, "phandle", 7, 0);
+		if (cell)
+			fdt32_add(cell, delta);
+		cell = fdt_overlay_cell(fdto, node, "linux,phandle", 13, 0);
+		if (cell)
+			fdt32_add(cell, delta);
+	}
+
+	fixups = fdt_path_offset(fdto, "/__local_fixups__");
+	if (fixups == -FDT_ERR_NOTFOUND)
+		return 0;
+	if (fixups < 0)
+		return fixups;
+
+	return fdt_overlay_local_fixups(fdto, 0, fixups, delta);
+}
+
+/* Resolve references to labels in the base tree */
+static int fdt_overlay_fixup_labels(void *fdto, struct fdt_overlay_maps *maps)
+{
+	const char *label, *ref, *end, *path_end, *name_end;
+	int fixups, prop, len, node;
+	fdt32_t *cell;
+	u32 phandle;
+
+	fixups = fdt_path_offset(fdto, "/__fixups__");
+	if (fixups == -FDT_ERR_NOTFOUND)
+		return 0;
+	if (fixups < 0)
+		return fixups;
+
+	fdt_for_each_property_offset(prop, fdto, fixups) {
+		ref = fdt_getprop_by_offset(fdto, prop, &label, &len);
+		if (!ref)
+			return len;
+		phandle = fdt_overlay_find_label(maps, label);
+		if (!phandle) {
+			printf("overlay: label '%s' not found in base tree\n",
+			       label);
+			return -FDT_ERR_NOTFOUND;
+		}
+
+		/* Each entry is "<path>:<property>:<offset>" */
+		for (end = ref + len; ref < end; ref += strlen(ref) + 1) {
+			path_end = strchr(ref, ':');
+			if (!path_end)
+				return -FDT_ERR_BADOVERLAY;
+			name_end = strchr(path_end + 1, ':');
+			if (!name_end)
+				return -FDT_ERR_BADOVERLAY;
+			node = fdt_path_offset_namelen(fdto, ref,
+						       path_end - ref);
+			if (node < 0)
+				return -FDT_ERR_BADOVERLAY;
+			cell = fdt_overlay_cell(fdto, node, path_end + 1,
+						name_end - path_end - 1,
+						simple_strtoul(name_end + 1,
+							       NULL, 10));
+			if (!cell)
+				return -FDT_ERR_BADOVERLAY;
+			*cell = cpu_to_fdt32(phandle);
+		}
+	}
+
+	return 0;
+}
+
+/* Queue the contents of each fragment, and the overlay's labels */
+static int fdt_overlay_queue(struct fdt_batch *b, const void *fdt,
+			     const void *fdto, struct fdt_overlay_maps *maps)
+{
+	const char *label, *path, *frag_end, *rest;
+	int fragment, overlay, target, symbols, prop, ret;
+	char buf[512];
+
+	fdt_for_each_subnode(fragment, fdto, 0) {
+		overlay = fdt_subnode_offset(fdto, fragment, "__overlay__");
+		if (overlay == -FDT_ERR_NOTFOUND)
+			continue;
+		if (overlay < 0)
+			return overlay;
+		target = fdt_overlay_target(fdt, fdto, fragment, maps);
+		if (target < 0)
+			return target;
+		ret = fdt_batch_merge(b, fdt_batch_offset(b, target), fdto,
+				      overlay);
+		if (ret)
+			return ret;
+	}
+
+	symbols = fdt_subnode_offset(fdto, 0, "__symbols__");
+	if (symbols == -FDT_ERR_NOTFOUND)
+		return 0;
+	if (symbols < 0)
+		return symbols;
+
+	/* "/fragment@0/__overlay__/node" becomes "<target path>/node" */
+	fdt_for_each_property_offset(prop, fdto, symbols) {
+		path = fdt_getprop_by_offset(fdto, prop, &label, NULL);
+		if (!path || *path != '/')
+			return -FDT_ERR_BADOVERLAY;
+		frag_end = strchrnul(path + 1, '/');
+		rest = frag_end + strlen("/__overlay__");
+		if (strncmp(frag_end, "/__overlay__", rest - frag_end) ||
+		    (*rest && *rest != '/'))
+			continue;
+
+		fragment = fdt_path_offset_namelen(fdto, path,
+						   frag_end - path);
+		if (fragment < 0)
+			return fragment;
+		target = fdt_overlay_target(fdt, fdto, fragment, maps);
+		if (target < 0)
+			return target;
+		ret = fdt_get_path(fdt, target, buf, sizeof(buf));
+		if (ret)
+			return ret;
+		if (*rest && !strcmp(buf, "/"))
+			*buf = '\0';
+		if (strlen(buf) + strlen(rest) >= sizeof(buf))
+			return -FDT_ERR_NOSPACE;
+		strcat(buf, rest);
+		ret = fdt_batch_setprop_string(b, "/__symbols__", label, buf);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+int fdt_overlay_apply_list(void *fdt, void * const fdtos[], int count)
+{
+	struct fdt_overlay_maps maps;
+	struct fdt_batch batch;
+	int i, ret;
+
+	for (i = 0; i < count; i++) {
+		void *fdto = fdtos[i];
+
+		ret = fdt_check_header(fdto);
+		if (ret)
+			goto err;
+
+		ret = fdt_overlay_build_maps(fdt, &maps);
+		fdt_batch_init(&batch, fdt);
+		if (!ret)
+			ret = fdt_overlay_adjust_phandles(fdto,
+							  maps.max_phandle);
+		if (!ret)
+			ret = fdt_overlay_fixup_labels(fdto, &maps);
+		if (!ret)
+			ret = fdt_overlay_queue(&batch, fdt, fdto, &maps);
+		if (!ret)
+			ret = fdt_batch_apply(&batch, fdt);
+		fdt_batch_free(&batch);
+		fdt_overlay_free_maps(&maps);
+
+		/* As with fdt_overlay_apply(), the overlay is now damaged */
+		fdt_set_magic(fdto, ~0);
+		if (ret)
+			goto err;
+	}
+
+	return 0;
+
+err:
+	printf("failed to apply overlay %d: %s\n", i, fdt_strerror(ret));
+	if (ret == -FDT_ERR_NOSPACE)
+		printf("make room with 'fdt resize'\n");
+
+	return ret;
+}
+#endif /* !CONFIG_SPL_BUILD */
 #endif
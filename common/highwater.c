@@ -0,0 +1,137 @@
+/*
+ * Heap and stack high-water marks
+ *
+ * The early heap (malloc_simple) never frees, so its current size is also
+ * its peak. The full heap's footprint is the highest break that dlmalloc
+ * has asked sbrk() for. Stack use is found by filling the unused part of
+ * the stack with a pattern at the start of each boot phase and later
+ * looking for the lowest word which no longer holds it.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <bootstage.h>
+#include <highwater.h>
+#include <malloc.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define STACK_PAINT_PATTERN	((ulong)0x5a5a5a5a5a5a5a5aULL)
+
+/* Bytes left unpainted just below the painting function's frame */
+#define STACK_PAINT_GUARD	0x400
+
+static noinline void stack_paint(ulong bottom)
+{
+	ulong top = (ulong)__builtin_frame_address(0);
+	ulong *p;
+
+	bottom = ALIGN(bottom, sizeof(ulong));
+	if (bottom >= top - STACK_PAINT_GUARD) {
+		gd->stack_top = 0;
+		gd->stack_paint_base = 0;
+		return;
+	}
+	for (p = (ulong *)bottom; (ulong)p < top - STACK_PAINT_GUARD; p++)
+		*p = STACK_PAINT_PATTERN;
+	gd->stack_top = top;
+	gd->stack_paint_base = bottom;
+}
+
+void highwater_paint_f(void)
+{
+	ulong sp = (ulong)__builtin_frame_address(0);
+	ulong bottom = sp - CONFIG_STACK_PAINT_SIZE;
+
+#if defined(CONFIG_SYS_INIT_RAM_ADDR)
+	bottom = max(bottom, (ulong)CONFIG_SYS_INIT_RAM_ADDR);
+#elif !defined(CONFIG_SANDBOX)
+	bottom = sp;
+#endif
+	gd->stack_f_used = 0;
+	stack_paint(bottom);
+}
+
+void highwater_paint_r(void)
+{
+	ulong sp = (ulong)__builtin_frame_address(0);
+
+	stack_paint(sp - CONFIG_STACK_PAINT_SIZE);
+}
+
+ulong highwater_stack_used(void)
+{
+	ulong *p = (ulong *)gd->stack_paint_base;
+
+	if (!gd->stack_top)
+		return 0;
+	while ((ulong)p < gd->stack_top && *p == STACK_PAINT_PATTERN)
+		p++;
+
+	return gd->stack_top - (ulong)p;
+}
+
+static ulong heap_f_used(void)
+{
+#if CONFIG_VAL(SYS_MALLOC_F_LEN)
+	return gd->malloc_ptr;
+#else
+	return 0;
+#endif
+}
+
+int highwater_record_f(void)
+{
+	gd->stack_f_used = highwater_stack_used();
+	if (heap_f_used())
+		bootstage_set_size(BOOTSTAGE_ID_HEAP_F, "heap_f",
+				   heap_f_used());
+	if (gd->stack_f_used)
+		bootstage_set_size(BOOTSTAGE_ID_STACK_F, "stack_f",
+				   gd->stack_f_used);
+
+	return 0;
+}
+
+void highwater_record_r(void)
+{
+	ulong stack_used = highwater_stack_used();
+
+	bootstage_set_size(BOOTSTAGE_ID_HEAP_R, "heap_r",
+			   mem_malloc_brk_max - mem_malloc_start);
+	if (stack_used)
+		bootstage_set_size(BOOTSTAGE_ID_STACK_R, "stack_r", stack_used);
+}
+
+static void show_mark(const char *name, ulong used, ulong size)
+{
+	printf("%-20s", name);
+	if (!used) {
+		puts("not recorded\n");
+		return;
+	}
+	printf("%#9lx", used);
+	if (size)
+		printf(" of %#9lx (%lu%%)", size, used * 100 / size);
+	puts("\n");
+}
+
+void highwater_show(void)
+{
+	ulong stack_used = highwater_stack_used();
+
+	highwater_record_r();
+	puts("High-water marks in bytes:\n");
+#if CONFIG_VAL(SYS_MALLOC_F_LEN)
+	show_mark("Heap (pre-reloc)", heap_f_used(), gd->malloc_limit);
+#endif
+	show_mark("Heap", mem_malloc_brk_max - mem_malloc_start,
+		  mem_malloc_end - mem_malloc_start);
+	show_mark("Stack (pre-reloc)", gd->stack_f_used, 0);
+	show_mark("Stack", stack_used, 0);
+	if (stack_used &&
+	    gd->stack_paint_base + stack_used >= gd->stack_top)
+		printf("Stack use reached the end of the painted region (%#x bytes)\n",
+		       CONFIG_STACK_PAINT_SIZE);
+}
@@ -11,6 +11,7 @@
 
 #include <common.h>
 #include <fdt_support.h>
+#include <fdt_batch.h>
 #include <errno.h>
 #include <image.h>
 #include <libfdt.h>
@@ -114,6 +115,7 @@ int boot_relocate_fdt(struct lmb *lmb, char **of_flat_tree, ulong *of_size)
 	void	*fdt_blob = *of_flat_tree;
 	void	*of_start = NULL;
 	char	*fdt_high;
+	ulong	addr = 0;
 	ulong	of_len = 0;
 	int	err;
 	int	disable_relocation = 0;
@@ -134,32 +136,33 @@ int boot_relocate_fdt(struct lmb *lmb, char **of_flat_tree, ulong *of_size)
 	/* If fdt_high is set use it to select the relocation address */
 	fdt_high = env_get("fdt_high");
 	if (fdt_high) {
-		void *desired_addr = (void *)simple_strtoul(fdt_high, NULL, 16);
+		ulong desired_addr = simple_strtoul(fdt_high, NULL, 16);
 
-		if (((ulong) desired_addr) == ~0UL) {
+		if (desired_addr == ~0UL) {
 			/* All ones means use fdt in place */
 			of_start = fdt_blob;
-			lmb_reserve(lmb, (ulong)of_start, of_len);
+			lmb_reserve(lmb, map_to_sysmem(of_start), of_len);
 			disable_relocation = 1;
 		} else if (desired_addr) {
-			of_start =
-			    (void *)(ulong) lmb_alloc_base(lmb, of_len, 0x1000,
-							   (ulong)desired_addr);
-			if (of_start == NULL) {
+			addr = lmb_alloc_base(lmb, of_len, 0x1000,
+					      desired_addr);
+			if (!addr) {
 				puts("Failed using fdt_high value for Device Tree");
 				goto error;
 			}
 		} else {
-			of_start =
-			    (void *)(ulong) lmb_alloc(lmb, of_len, 0x1000);
+			addr = lmb_alloc(lmb, of_len, 0x1000);
 		}
 	} else {
-		of_start =
-		    (void *)(ulong) lmb_alloc_base(lmb, of_len, 0x1000,
-						   env_get_bootm_mapsize()
-						   + env_get_bootm_low());
+		addr = lmb_alloc_base(lmb, of_len, 0x1000,
+				      env_get_bootm_mapsize() +
+				      env_get_bootm_low());
 	}
 
+	/* The allocations above are addresses, which sandbox must map */
+	if (addr)
+		of_start = map_sysmem(addr, of_len);
+
 	if (of_start == NULL) {
 		puts("device tree - allocation error\n");
 		goto error;
@@ -185,13 +188,14 @@ int boot_relocate_fdt(struct lmb *lmb, char **of_flat_tree, ulong *of_size)
 			fdt_error("fdt move failed");
 			goto error;
 		}
+		lmb_load_add(map_to_sysmem(of_start), of_len, "fdt");
 		puts("OK\n");
 	}
 
 	*of_flat_tree = of_start;
 	*of_size = of_len;
 
-	set_working_fdt_addr((ulong)*of_flat_tree);
+	set_working_fdt_addr(map_to_sysmem(*of_flat_tree));
 	return 0;
 
 error:
@@ -459,17 +463,23 @@ int image_setup_libfdt(bootm_headers_t *images, void *blob,
 {
 	ulong *initrd_start = &images->initrd_start;
 	ulong *initrd_end = &images->initrd_end;
+	struct fdt_batch batch;
 	int ret = -EPERM;
 	int fdt_ret;
 
-	if (fdt_root(blob) < 0) {
+	/* The root and /chosen updates are written in a single pass */
+	fdt_batch_init(&batch, blob);
+	if (fdt_batch_root(&batch) < 0) {
 		printf("ERROR: root node setup failed\n");
+		fdt_batch_free(&batch);
 		goto err;
 	}
-	if (fdt_chosen(blob) < 0) {
+	if (fdt_batch_chosen(&batch) < 0 || fdt_batch_apply(&batch, blob) < 0) {
 		printf("ERROR: /chosen node create failed\n");
+		fdt_batch_free(&batch);
 		goto err;
 	}
+	fdt_batch_free(&batch);
 	if (arch_fixup_fdt(blob) < 0) {
 		printf("ERROR: arch-specific fdt fixup failed\n");
 		goto err;
@@ -493,6 +503,11 @@ int image_setup_libfdt(bootm_headers_t *images, void *blob,
 		}
 	}
 
+	fdt_ret = log_ring_fdt_fixup(blob);
+	if (fdt_ret)
+		printf("WARNING: could not reserve log ring: %s\n",
+		       fdt_strerror(fdt_ret));
+
 	/* Delete the old LMB reservation */
 	if (lmb)
 		lmb_free(lmb, (phys_addr_t)(u32)(uintptr_t)blob,
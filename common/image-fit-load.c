@@ -0,0 +1,245 @@
+/*
+ * Reading FIT images with external data a piece at a time
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <image.h>
+#include <mapmem.h>
+#include <u-boot/crc.h>
+
+/* Most images that can be read away from the FIT */
+#define FIT_LOAD_EXT_MAX	16
+
+/*
+ * Images read away from the FIT by the last fit_load_ext(). The position and
+ * size of the data are kept as well, so that an entry is only used for the
+ * same image of the same FIT.
+ */
+static struct fit_load_ext_image {
+	int noffset;
+	int position;
+	int size;
+	const void *data;
+} fit_load_ext_images[FIT_LOAD_EXT_MAX];
+static int fit_load_ext_count;
+
+/*
+ * The FIT structure those images came from. Another FIT may be loaded to
+ * the same address later, so its size and CRC are checked before an image
+ * is used.
+ */
+static const void *fit_load_ext_fit;
+static uint fit_load_ext_size;
+static u32 fit_load_ext_crc;
+
+/* Configuration properties which name the images to read */
+static const char *const fit_load_ext_props[] = {
+	FIT_KERNEL_PROP,
+	FIT_FDT_PROP,
+	FIT_RAMDISK_PROP,
+	FIT_LOADABLE_PROP,
+	FIT_SETUP_PROP,
+	FIT_FPGA_PROP,
+};
+
+/* Get the position of the data of an image in the FIT file */
+static int fit_load_ext_position(const void *fit, int noffset, int *position,
+				 int *size)
+{
+	if (fit_image_get_data_size(fit, noffset, size))
+		return -ENOENT;
+
+	if (!fit_image_get_data_position(fit, noffset, position))
+		return 0;
+	if (fit_image_get_data_offset(fit, noffset, position))
+		return -ENOENT;
+	*position += ALIGN(fdt_totalsize(fit), 4);
+
+	return 0;
+}
+
+/* Check that fit is the FIT structure the last fit_load_ext() read */
+static bool fit_load_ext_same(const void *fit)
+{
+	return fit == fit_load_ext_fit &&
+	       fdt_totalsize(fit) == fit_load_ext_size &&
+	       crc32(0, fit, fit_load_ext_size) == fit_load_ext_crc;
+}
+
+const void *fit_load_ext_find(const void *fit, int noffset)
+{
+	struct fit_load_ext_image *img;
+	int position, size, i;
+
+	if (!fit_load_ext_count || !fit_load_ext_same(fit))
+		return NULL;
+	if (fit_load_ext_position(fit, noffset, &position, &size))
+		return NULL;
+
+	for (i = 0; i < fit_load_ext_count; i++) {
+		img = &fit_load_ext_images[i];
+		if (img->noffset == noffset && img->position == position &&
+		    img->size == size)
+			return img->data;
+	}
+
+	return NULL;
+}
+
+/* Check whether a buffer overlaps the FIT structure or an image read */
+static bool fit_load_ext_overlaps(const void *fit, ulong end, const void *buf,
+				  int size)
+{
+	const struct fit_load_ext_image *img;
+	int i;
+
+	if (buf < fit + end && buf + size > fit)
+		return true;
+	for (i = 0; i < fit_load_ext_count; i++) {
+		img = &fit_load_ext_images[i];
+		if (buf < img->data + img->size && buf + size > img->data)
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Read an image to its load address if it can be used from there, else to
+ * the end of what has been read after the FIT structure. An image whose
+ * load address overlaps the FIT structure or an image read already is
+ * read after the FIT structure too.
+ */
+static int fit_load_ext_image(struct fit_loader *ldr, void *fit, int noffset,
+			      ulong *endp, ulong *sizep)
+{
+	struct fit_load_ext_image *img;
+	int position, size, ret;
+	void *dst = NULL;
+	u8 type, comp;
+	ulong load;
+
+	/* Images held in the FIT structure have been read already */
+	if (fit_load_ext_position(fit, noffset, &position, &size))
+		return 0;
+	if (fit_load_ext_find(fit, noffset))
+		return 0;
+
+	if (fit_load_ext_count == FIT_LOAD_EXT_MAX) {
+		printf("Too many images to read from FIT (max %d)\n",
+		       FIT_LOAD_EXT_MAX);
+		return -E2BIG;
+	}
+
+	if (!fit_image_get_load(fit, noffset, &load) && load &&
+	    !fit_image_get_type(fit, noffset, &type) &&
+	    type != IH_TYPE_KERNEL_NOLOAD &&
+	    !fit_image_get_comp(fit, noffset, &comp) &&
+	    comp == IH_COMP_NONE) {
+		dst = map_sysmem(load, size);
+		if (fit_load_ext_overlaps(fit, *endp, dst, size)) {
+			debug("%s: %s: load address %lx overlaps the FIT\n",
+			      __func__, fit_get_name(fit, noffset, NULL),
+			      load);
+			dst = NULL;
+		}
+	}
+	if (!dst) {
+		dst = fit + *endp;
+		if (fit_load_ext_overlaps(fit, *endp, dst, size)) {
+			printf("No room to read image '%s' after the FIT\n",
+			       fit_get_name(fit, noffset, NULL));
+			return -ENOSPC;
+		}
+		*endp += ALIGN(size, ARCH_DMA_MINALIGN);
+	}
+
+	debug("%s: %s: %x bytes at %x to %p\n", __func__,
+	      fit_get_name(fit, noffset, NULL), size, position, dst);
+	ret = ldr->read(ldr, position, size, dst);
+	if (ret) {
+		printf("Cannot read image '%s' (err=%d)\n",
+		       fit_get_name(fit, noffset, NULL), ret);
+		return ret;
+	}
+	*sizep += size;
+
+	img = &fit_load_ext_images[fit_load_ext_count];
+	img->noffset = noffset;
+	img->position = position;
+	img->size = size;
+	img->data = dst;
+	fit_load_ext_count++;
+
+	return 0;
+}
+
+int fit_load_ext(struct fit_loader *ldr, void *fit, const char *conf_name,
+		 ulong *sizep)
+{
+	int images_noffset, conf_noffset, noffset;
+	const char *prop, *name;
+	ulong size, end;
+	int i, j, ret;
+
+	fit_load_ext_count = 0;
+	fit_load_ext_fit = NULL;
+	*sizep = 0;
+
+	/* Read the header to find the size of the FIT structure */
+	ret = ldr->read(ldr, 0, sizeof(struct fdt_header), fit);
+	if (ret)
+		return ret;
+	if (fdt_check_header(fit))
+		return -ENOEXEC;
+
+	size = fdt_totalsize(fit);
+	if (size < sizeof(struct fdt_header))
+		return -ENOEXEC;
+	ret = ldr->read(ldr, sizeof(struct fdt_header),
+			size - sizeof(struct fdt_header),
+			fit + sizeof(struct fdt_header));
+	if (ret)
+		return ret;
+	*sizep = size;
+
+	if (!fit_check_format(fit))
+		return -ENOEXEC;
+	fit_load_ext_fit = fit;
+	fit_load_ext_size = size;
+	fit_load_ext_crc = crc32(0, fit, size);
+
+	images_noffset = fdt_path_offset(fit, FIT_IMAGES_PATH);
+	conf_noffset = fit_conf_get_node(fit, conf_name);
+	if (images_noffset < 0 || conf_noffset < 0)
+		return -ENOENT;
+
+	end = ALIGN(size, ARCH_DMA_MINALIGN);
+	for (i = 0; i < ARRAY_SIZE(fit_load_ext_props); i++) {
+		prop = fit_load_ext_props[i];
+		for (j = 0; ; j++) {
+			name = fdt_stringlist_get(fit, conf_noffset, prop, j,
+						  NULL);
+			if (!name)
+				break;
+
+			noffset = fdt_subnode_offset(fit, images_noffset,
+						     name);
+			if (noffset < 0) {
+				printf("Cannot find image '%s' (%s)\n", name,
+				       fdt_strerror(noffset));
+				return -ENOENT;
+			}
+
+			ret = fit_load_ext_image(ldr, fit, noffset, &end,
+						 sizep);
+			if (ret)
+				return ret;
+		}
+	}
+
+	return 0;
+}
@@ -392,7 +392,7 @@ void fit_image_print(const void *fit, int image_noffset, const char *p)
 	fit_image_get_comp(fit, image_noffset, &comp);
 	printf("%s  Compression:  %s\n", p, genimg_get_comp_name(comp));
 
-	ret = fit_image_get_data(fit, image_noffset, &data, &size);
+	ret = fit_image_get_data_and_size(fit, image_noffset, &data, &size);
 
 #ifndef USE_HOSTCC
 	printf("%s  Data Start:   ", p);
@@ -782,6 +782,33 @@ int fit_image_get_data(const void *fit, int noffset,
 	return 0;
 }
 
+int fit_image_get_data_and_size(const void *fit, int noffset,
+				const void **data, size_t *size)
+{
+	int offset, len;
+
+	if (fit_image_get_data_position(fit, noffset, &offset)) {
+		if (fit_image_get_data_offset(fit, noffset, &offset))
+			return fit_image_get_data(fit, noffset, data, size);
+
+		/* The data follows the FIT structure, 4-byte aligned */
+		offset += (fdt_totalsize(fit) + 3) & ~3;
+	}
+
+	if (fit_image_get_data_size(fit, noffset, &len)) {
+		fit_get_debug(fit, noffset, FIT_DATA_SIZE_PROP, len);
+		*size = 0;
+		return -1;
+	}
+
+	*data = fit_load_ext_find(fit, noffset);
+	if (!*data)
+		*data = fit + offset;
+	*size = len;
+
+	return 0;
+}
+
 /**
  * Get 'data-offset' property from a given image node.
  *
@@ -1091,7 +1118,7 @@ int fit_image_verify(const void *fit, int image_noffset)
 	int ret;
 
 	/* Get image data and data length */
-	if (fit_image_get_data(fit, image_noffset, &data, &size)) {
+	if (fit_image_get_data_and_size(fit, image_noffset, &data, &size)) {
 		err_msg = "Can't get image data/size";
 		goto error;
 	}
@@ -1846,7 +1873,7 @@ int fit_image_load(bootm_headers_t *images, ulong addr,
 	bootstage_mark(bootstage_id + BOOTSTAGE_SUB_CHECK_ALL_OK);
 
 	/* get image data address and length */
-	if (fit_image_get_data(fit, noffset, &buf, &size)) {
+	if (fit_image_get_data_and_size(fit, noffset, &buf, &size)) {
 		printf("Could not find %s subimage data!\n", prop_name);
 		bootstage_error(bootstage_id + BOOTSTAGE_SUB_GET_DATA);
 		return -ENOENT;
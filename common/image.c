@@ -1208,6 +1208,7 @@ int boot_ramdisk_high(struct lmb *lmb, ulong rd_data, ulong rd_len,
 
 			memmove_wd((void *)*initrd_start,
 					(void *)rd_data, rd_len, CHUNKSZ);
+			lmb_load_add(*initrd_start, rd_len, "ramdisk");
 
 #ifdef CONFIG_MP
 			/*
@@ -0,0 +1,531 @@
+/*
+ * Binary log ring
+ *
+ * Records are stored unformatted: the format string, file and function are
+ * kept as pointers and the arguments as raw values, so a record costs little
+ * more than a copy. Formatting is done by 'log dump'.
+ *
+ * The ring lives in memory reserved at the top of DRAM and is passed to the
+ * OS in a /reserved-memory node. Pointers are stored as link addresses so
+ * that the records can be decoded offline against the u-boot ELF file. The
+ * ring is kept across a warm reset of the same U-Boot build, so the records
+ * leading up to a hang can still be dumped afterwards.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <fdt_support.h>
+#include <log.h>
+#include <mapmem.h>
+#include <version.h>
+#include <linux/ctype.h>
+#include <u-boot/crc.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define LOG_RING_MAGIC		0x474f4c55	/* "ULOG" */
+#define LOG_RING_VERSION	1
+
+#define LOG_RING_MAX_ARGS	8	/* more than this are formatted at once */
+#define LOG_RING_MAX_STR	64	/* strings are truncated to this length */
+#define LOG_RING_MAX_MSG	256	/* length limit for preformatted records */
+
+/* Records are aligned to this and there is always a gap this big */
+#define LOG_RING_ALIGN		8
+
+/* Smallest ring set up, as for the LOG_RING_SIZE range in Kconfig */
+#define LOG_RING_MIN_SIZE	0x1000
+
+/**
+ * struct log_ring - Header of the log ring, followed by the records
+ *
+ * @magic: LOG_RING_MAGIC
+ * @version: LOG_RING_VERSION
+ * @build: CRC32 of the U-Boot version string. The stored pointers are only
+ *	meaningful for this build.
+ * @size: Size of the record area in bytes
+ * @head: Offset of the next record to write
+ * @tail: Offset of the oldest record
+ * @boot: Incremented each time U-Boot starts with the ring already set up
+ * @lost: Number of records overwritten since the ring was cleared
+ * @data: Record area. A record with a @size of 0 marks the end of the
+ *	records, the next one is at offset 0.
+ */
+struct log_ring {
+	u32 magic;
+	u32 version;
+	u32 build;
+	u32 size;
+	u32 head;
+	u32 tail;
+	u32 boot;
+	u32 lost;
+	u8 data[];
+};
+
+/**
+ * struct log_ring_rec - A record in the log ring
+ *
+ * String arguments are copied to the end of the record; their @args entry
+ * holds the offset of the copy from the start of the record, or 0 for a NULL
+ * pointer.
+ *
+ * @size: Size of the record in bytes, including strings and padding
+ * @level: Log level (enum log_level_t)
+ * @nargs: Number of arguments in @args
+ * @cat: Log category (enum log_category_t)
+ * @boot: Value of the ring's boot counter when this was written
+ * @line: Line number
+ * @spare: Must be zero
+ * @time_us: Time since boot in microseconds
+ * @file: Link address of the file name
+ * @func: Link address of the function name
+ * @fmt: Link address of the format string, or 0 if the record holds a
+ *	preformatted message as its only (string) argument
+ * @args: Arguments for @fmt
+ */
+struct log_ring_rec {
+	u16 size;
+	u8 level;
+	u8 nargs;
+	u16 cat;
+	u16 boot;
+	u32 line;
+	u32 spare;
+	u64 time_us;
+	u64 file;
+	u64 func;
+	u64 fmt;
+	u64 args[];
+};
+
+/* Argument types, from the conversion and its length modifier */
+enum log_ring_arg {
+	ARG_NONE,		/* '%%' */
+	ARG_INT,
+	ARG_LONG,
+	ARG_LLONG,
+	ARG_SIZE,
+	ARG_PTR,
+	ARG_STR,
+};
+
+static u32 log_ring_build(void)
+{
+	return crc32(0, (const u8 *)version_string, strlen(version_string));
+}
+
+/*
+ * Convert between run-time and link addresses. Sandbox is not relocated, and
+ * before relocation the two are the same.
+ */
+static u64 log_ring_to_link(const void *ptr)
+{
+	ulong addr = (ulong)ptr;
+
+	if (ptr && !IS_ENABLED(CONFIG_SANDBOX) && (gd->flags & GD_FLG_RELOC))
+		addr -= gd->reloc_off;
+
+	return addr;
+}
+
+static const char *log_ring_from_link(u64 addr)
+{
+	if (addr && !IS_ENABLED(CONFIG_SANDBOX))
+		addr += gd->reloc_off;
+
+	return (const char *)(ulong)addr;
+}
+
+void log_ring_init(ulong addr, ulong size)
+{
+	struct log_ring *ring;
+	u32 data_size;
+
+	/* A ring this small would not even hold one long record */
+	if (size < LOG_RING_MIN_SIZE) {
+		gd->log_ring = NULL;
+		return;
+	}
+	ring = map_sysmem(addr, size);
+	data_size = (size - sizeof(*ring)) & ~(LOG_RING_ALIGN - 1);
+
+	if (ring->magic == LOG_RING_MAGIC &&
+	    ring->version == LOG_RING_VERSION &&
+	    ring->build == log_ring_build() && ring->size == data_size &&
+	    ring->head < data_size && ring->tail < data_size &&
+	    !(ring->head & (LOG_RING_ALIGN - 1)) &&
+	    !(ring->tail & (LOG_RING_ALIGN - 1))) {
+		ring->boot++;
+	} else {
+		memset(ring, '\0', sizeof(*ring));
+		ring->magic = LOG_RING_MAGIC;
+		ring->version = LOG_RING_VERSION;
+		ring->build = log_ring_build();
+		ring->size = data_size;
+	}
+	gd->log_ring = ring;
+}
+
+/* Drop the oldest record to make room */
+static void log_ring_drop(struct log_ring *ring)
+{
+	struct log_ring_rec *rec = (void *)ring->data + ring->tail;
+
+	if (rec->size) {
+		ring->tail += rec->size;
+		ring->lost++;
+	} else {
+		ring->tail = 0;
+	}
+	if (ring->tail >= ring->size)
+		ring->tail = 0;
+}
+
+/*
+ * Find @size contiguous bytes at the head of the ring, dropping old records
+ * as needed. The head never catches up with the tail, so head == tail means
+ * that the ring is empty. Returns NULL if the record could never fit.
+ */
+static struct log_ring_rec *log_ring_alloc(struct log_ring *ring, uint size)
+{
+	struct log_ring_rec *rec;
+	uint room;
+
+	if (size + LOG_RING_ALIGN > ring->size)
+		return NULL;
+
+	for (;;) {
+		if (ring->head >= ring->tail) {
+			room = ring->size - ring->head;
+			if (!ring->tail)
+				room -= LOG_RING_ALIGN;
+			if (room >= size)
+				break;
+			if (!ring->tail) {
+				log_ring_drop(ring);
+				continue;
+			}
+			/* Mark the end of the records and wrap */
+			if (ring->head < ring->size) {
+				rec = (void *)ring->data + ring->head;
+				rec->size = 0;
+			}
+			ring->head = 0;
+		} else {
+			room = ring->tail - ring->head - LOG_RING_ALIGN;
+			if (room >= size)
+				break;
+			log_ring_drop(ring);
+		}
+	}
+	rec = (void *)ring->data + ring->head;
+	ring->head += size;
+	if (ring->head == ring->size)
+		ring->head = 0;
+
+	return rec;
+}
+
+/**
+ * log_ring_parse() - Parse a conversion in a format string
+ *
+ * @p: Pointer to the '%' which starts the conversion
+ * @typep: Returns the argument type (enum log_ring_arg)
+ * @return pointer to the character after the conversion, or NULL if the
+ *	argument cannot be stored (e.g. '*' width or a %p extension which
+ *	must read memory now)
+ */
+static const char *log_ring_parse(const char *p, int *typep)
+{
+	int qual = ARG_INT;
+
+	for (p++; *p && strchr("-+ #0", *p); p++)
+		;
+	while (isdigit(*p))
+		p++;
+	if (*p == '.') {
+		for (p++; isdigit(*p); p++)
+			;
+	}
+	for (;; p++) {
+		if (*p == 'l')
+			qual = qual == ARG_INT ? ARG_LONG : ARG_LLONG;
+		else if (*p == 'L' || *p == 'q' || *p == 'j')
+			qual = ARG_LLONG;
+		else if (*p == 'z' || *p == 'Z' || *p == 't')
+			qual = ARG_SIZE;
+		else if (*p != 'h')
+			break;
+	}
+
+	switch (*p) {
+	case '%':
+		*typep = ARG_NONE;
+		break;
+	case 'c':
+	case 'd':
+	case 'i':
+	case 'o':
+	case 'u':
+	case 'x':
+	case 'X':
+		*typep = qual;
+		break;
+	case 's':
+		*typep = ARG_STR;
+		break;
+	case 'p':
+		if (isalnum(p[1]))
+			return NULL;
+		*typep = ARG_PTR;
+		break;
+	default:
+		return NULL;
+	}
+
+	return p + 1;
+}
+
+/**
+ * log_ring_collect() - Read the arguments of a log record
+ *
+ * @fmt: Format string
+ * @args: Arguments for @fmt
+ * @vals: Returns the argument values
+ * @strs: Returns the string for each %s argument, else NULL
+ * @return number of arguments, or -1 if they cannot be stored
+ */
+static int log_ring_collect(const char *fmt, va_list args, u64 *vals,
+			    const char **strs)
+{
+	int nargs = 0;
+	int type;
+
+	while ((fmt = strchr(fmt, '%'))) {
+		fmt = log_ring_parse(fmt, &type);
+		if (!fmt)
+			return -1;
+		if (type == ARG_NONE)
+			continue;
+		if (nargs == LOG_RING_MAX_ARGS)
+			return -1;
+		strs[nargs] = NULL;
+		switch (type) {
+		case ARG_INT:
+			vals[nargs] = va_arg(args, unsigned int);
+			break;
+		case ARG_LONG:
+			vals[nargs] = va_arg(args, unsigned long);
+			break;
+		case ARG_LLONG:
+			vals[nargs] = va_arg(args, unsigned long long);
+			break;
+		case ARG_SIZE:
+			vals[nargs] = va_arg(args, size_t);
+			break;
+		case ARG_PTR:
+			vals[nargs] = (ulong)va_arg(args, void *);
+			break;
+		case ARG_STR:
+			strs[nargs] = va_arg(args, const char *);
+			vals[nargs] = 0;
+			break;
+		}
+		nargs++;
+	}
+
+	return nargs;
+}
+
+static int log_ring_emit(struct log_device *ldev, struct log_rec *rec)
+{
+	struct log_ring *ring = gd->log_ring;
+	const char *strs[LOG_RING_MAX_ARGS];
+	u64 vals[LOG_RING_MAX_ARGS];
+	int lens[LOG_RING_MAX_ARGS];
+	char msg[LOG_RING_MAX_MSG];
+	struct log_ring_rec *out;
+	const char *fmt;
+	va_list args;
+	int nargs, i;
+	uint size, off;
+
+	if (!ring)
+		return -ENOSYS;
+
+	fmt = rec->fmt;
+	va_copy(args, *rec->args);
+	nargs = log_ring_collect(fmt, args, vals, strs);
+	va_end(args);
+	if (nargs < 0) {
+		/* Store the message itself */
+		va_copy(args, *rec->args);
+		vsnprintf(msg, sizeof(msg), fmt, args);
+		va_end(args);
+		fmt = NULL;
+		strs[0] = msg;
+		nargs = 1;
+	}
+
+	size = sizeof(*out) + nargs * sizeof(u64);
+	for (i = 0; i < nargs; i++) {
+		lens[i] = 0;
+		if (strs[i]) {
+			lens[i] = strnlen(strs[i], fmt ? LOG_RING_MAX_STR - 1 :
+					  sizeof(msg) - 1);
+			size += lens[i] + 1;
+		}
+	}
+	size = ALIGN(size, LOG_RING_ALIGN);
+
+	out = log_ring_alloc(ring, size);
+	if (!out)
+		return -ENOSPC;
+	out->size = size;
+	out->level = rec->level;
+	out->nargs = nargs;
+	out->cat = rec->cat;
+	out->boot = ring->boot;
+	out->line = rec->line;
+	out->spare = 0;
+	out->time_us = timer_get_boot_us();
+	out->file = log_ring_to_link(rec->file);
+	out->func = log_ring_to_link(rec->func);
+	out->fmt = log_ring_to_link(fmt);
+	off = sizeof(*out) + nargs * sizeof(u64);
+	for (i = 0; i < nargs; i++) {
+		out->args[i] = vals[i];
+		if (strs[i]) {
+			memcpy((char *)out + off, strs[i], lens[i]);
+			((char *)out)[off + lens[i]] = '\0';
+			out->args[i] = off;
+			off += lens[i] + 1;
+		}
+	}
+
+	return 0;
+}
+
+/* Format a record into @buf, as vsnprintf() would have done */
+static void log_ring_format(struct log_ring_rec *rec, char *buf, int size)
+{
+	const char *fmt = log_ring_from_link(rec->fmt);
+	const char *p, *end;
+	char spec[16];
+	int pos = 0;
+	int arg = 0;
+	int type;
+	u64 val;
+
+	if (!fmt) {
+		snprintf(buf, size, "%s",
+			 rec->nargs ? (char *)rec + rec->args[0] : "");
+		return;
+	}
+
+	for (p = fmt; *p && pos < size - 1; p = end) {
+		if (*p != '%') {
+			buf[pos++] = *p;
+			end = p + 1;
+			continue;
+		}
+		end = log_ring_parse(p, &type);
+		if (!end || end - p >= sizeof(spec))
+			break;
+		if (type == ARG_NONE) {
+			buf[pos++] = '%';
+			continue;
+		}
+		if (arg == rec->nargs)
+			break;
+		memcpy(spec, p, end - p);
+		spec[end - p] = '\0';
+		val = rec->args[arg++];
+		switch (type) {
+		case ARG_INT:
+			pos += snprintf(buf + pos, size - pos, spec, (uint)val);
+			break;
+		case ARG_LONG:
+			pos += snprintf(buf + pos, size - pos, spec, (ulong)val);
+			break;
+		case ARG_LLONG:
+			pos += snprintf(buf + pos, size - pos, spec, val);
+			break;
+		case ARG_SIZE:
+			pos += snprintf(buf + pos, size - pos, spec, (size_t)val);
+			break;
+		case ARG_PTR:
+			pos += snprintf(buf + pos, size - pos, spec,
+					(void *)(ulong)val);
+			break;
+		case ARG_STR:
+			pos += snprintf(buf + pos, size - pos, spec,
+					val ? (char *)rec + val : NULL);
+			break;
+		}
+	}
+	buf[min(pos, size - 1)] = '\0';
+}
+
+int log_ring_dump(void)
+{
+	struct log_ring *ring = gd->log_ring;
+	char buf[CONFIG_SYS_CBSIZE];
+	struct log_ring_rec *rec;
+	int boot = -1;
+	uint off;
+
+	if (!ring)
+		return -ENOENT;
+
+	off = ring->tail;
+	while (off != ring->head) {
+		rec = (void *)ring->data + off;
+		if (!rec->size) {
+			off = 0;
+			continue;
+		}
+		if (rec->size < sizeof(*rec) + rec->nargs * sizeof(u64) ||
+		    off + rec->size > ring->size) {
+			printf("Log ring corrupt at offset %x\n", off);
+			return -EINVAL;
+		}
+		if (rec->boot != boot) {
+			boot = rec->boot;
+			printf("--- boot %d%s ---\n", boot,
+			       boot == ring->boot ? " (current)" : "");
+		}
+		log_ring_format(rec, buf, sizeof(buf));
+		printf("[%5lu.%06lu] <%d> %s", (ulong)(rec->time_us / 1000000),
+		       (ulong)(rec->time_us % 1000000), rec->level, buf);
+		if (!*buf || buf[strlen(buf) - 1] != '\n')
+			putc('\n');
+		off += rec->size;
+		if (off >= ring->size)
+			off = 0;
+	}
+	if (ring->lost)
+		printf("(%u older records overwritten)\n", ring->lost);
+
+	return 0;
+}
+
+int log_ring_fdt_fixup(void *blob)
+{
+	struct log_ring *ring = gd->log_ring;
+
+	if (!ring)
+		return 0;
+
+	return fdt_add_reserved_memory(blob, "u-boot-log", "u-boot,log-ring",
+				       map_to_sysmem(ring),
+				       sizeof(*ring) + ring->size);
+}
+
+LOG_DRIVER(ring) = {
+	.name	= "ring",
+	.flags	= LOGDF_RAW,
+	.emit	= log_ring_emit,
+};
@@ -0,0 +1,586 @@
+/*
+ * Size-class slab front-end for dlmalloc
+ *
+ * Small allocations are served from 4 KiB pages, each holding objects of a
+ * single size class threaded on a free list. A page descriptor table
+ * covering the whole malloc() area finds the page of any pointer, so
+ * free() does not need a per-object header. Pages come from dlmalloc and
+ * go back to it once empty (one empty page per class is kept to avoid
+ * thrashing). Larger allocations go straight to dlmalloc.
+ *
+ * Every allocation is also accounted to the tag set by malloc_set_tag().
+ * Slab objects keep their tag in the page descriptor; larger blocks are
+ * recorded in a small open-addressing hash table keyed by address.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <linux/bug.h>
+#include <linux/log2.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define SLAB_PAGE_SIZE		4096
+#define SLAB_MAX_SIZE		512
+
+/* Large-block hash entries hold the address with the tag in the low bits */
+#define LARGE_TAG_MASK		7
+#define LARGE_DELETED		1
+#define LARGE_MIN_SIZE		64
+
+static const u16 slab_class_size[] = {
+	16, 32, 48, 64, 96, 128, 192, 256, 384, 512
+};
+
+#define SLAB_CLASSES		ARRAY_SIZE(slab_class_size)
+
+/* Smallest class holding each multiple of 16 bytes, up to SLAB_MAX_SIZE */
+static const u8 slab_class_of[SLAB_MAX_SIZE / 16 + 1] = {
+	0, 0, 1, 2, 3, 4, 4, 5, 5, 6, 6, 6, 6, 7, 7, 7, 7,
+	8, 8, 8, 8, 8, 8, 8, 8, 9, 9, 9, 9, 9, 9, 9, 9,
+};
+
+static const char *const malloc_tag_name[MALLOC_TAG_COUNT] = {
+	[MALLOC_TAG_OTHER]	= "other",
+	[MALLOC_TAG_DM]		= "dm",
+	[MALLOC_TAG_ENV]	= "env",
+	[MALLOC_TAG_CLI]	= "cli",
+	[MALLOC_TAG_FS]		= "fs",
+};
+
+/**
+ * struct slab_page - Descriptor for a page of slab objects
+ *
+ * @next:	Next page of this class with free objects
+ * @prev:	Previous page of this class with free objects
+ * @base:	Start of the page
+ * @free:	First free object, each holding a pointer to the next
+ * @inuse:	Number of objects allocated
+ * @cls:	Size class
+ * @listed:	true if on the class's list of pages with free objects
+ * @tags:	Tag of each object
+ */
+struct slab_page {
+	struct slab_page *next;
+	struct slab_page *prev;
+	char *base;
+	void *free;
+	u16 inuse;
+	u8 cls;
+	bool listed;
+	u8 tags[];
+};
+
+/**
+ * struct slab_class - A size class
+ *
+ * @partial:	Pages with free objects
+ * @pages:	Number of pages
+ * @empty:	Number of pages with no objects allocated
+ * @objs:	Number of objects allocated
+ */
+struct slab_class {
+	struct slab_page *partial;
+	uint pages;
+	uint empty;
+	ulong objs;
+};
+
+static struct {
+	enum malloc_tag tag;
+	struct slab_page **pages;	/* descriptor for each page, or NULL */
+	ulong base;			/* address of first page in the area */
+	ulong npages;
+	struct slab_class cls[SLAB_CLASSES];
+	ulong *large;			/* hash table of large blocks */
+	uint large_size;		/* number of entries in @large */
+	uint large_used;
+	uint large_deleted;
+	ulong internal;			/* heap bytes used by the slab code */
+	ulong slab_bytes;		/* bytes allocated from slabs */
+	struct malloc_tag_stats stats[MALLOC_TAG_COUNT];
+} slab;
+
+static inline bool slab_ready(void)
+{
+	return gd->flags & GD_FLG_FULL_MALLOC_INIT;
+}
+
+/* Heap space taken by a dlmalloc block, as counted by mallinfo() */
+static ulong chunk_bytes(void *ptr)
+{
+	return malloc_usable_size(ptr) + sizeof(size_t);
+}
+
+static void *internal_alloc(size_t align, size_t size)
+{
+	void *ptr;
+
+	ptr = align ? dlmemalign(align, size) : dlmalloc(size);
+	if (ptr)
+		slab.internal += chunk_bytes(ptr);
+
+	return ptr;
+}
+
+static void internal_free(void *ptr)
+{
+	if (ptr) {
+		slab.internal -= chunk_bytes(ptr);
+		dlfree(ptr);
+	}
+}
+
+static void tag_add(enum malloc_tag tag, ulong size)
+{
+	struct malloc_tag_stats *st = &slab.stats[tag];
+
+	st->cur += size;
+	if (st->cur > st->peak)
+		st->peak = st->cur;
+	st->live++;
+	st->allocs++;
+}
+
+static void tag_sub(enum malloc_tag tag, ulong size)
+{
+	struct malloc_tag_stats *st = &slab.stats[tag];
+
+	st->cur -= size;
+	st->live--;
+}
+
+static int slab_setup(void)
+{
+	struct slab_page **pages;
+	ulong base, npages;
+
+	base = mem_malloc_start & ~(SLAB_PAGE_SIZE - 1);
+	npages = (ALIGN(mem_malloc_end, SLAB_PAGE_SIZE) - base) /
+		SLAB_PAGE_SIZE;
+	pages = internal_alloc(0, npages * sizeof(*pages));
+	if (!pages)
+		return -ENOMEM;
+	memset(pages, '\0', npages * sizeof(*pages));
+	slab.base = base;
+	slab.npages = npages;
+	slab.pages = pages;
+
+	return 0;
+}
+
+static inline struct slab_page *slab_page_of(const void *ptr)
+{
+	ulong idx = ((ulong)ptr - slab.base) / SLAB_PAGE_SIZE;
+
+	if (idx >= slab.npages)
+		return NULL;
+
+	return slab.pages[idx];
+}
+
+static void slab_list_add(struct slab_class *sc, struct slab_page *pg)
+{
+	pg->prev = NULL;
+	pg->next = sc->partial;
+	if (pg->next)
+		pg->next->prev = pg;
+	sc->partial = pg;
+	pg->listed = true;
+}
+
+static void slab_list_del(struct slab_class *sc, struct slab_page *pg)
+{
+	if (pg->prev)
+		pg->prev->next = pg->next;
+	else
+		sc->partial = pg->next;
+	if (pg->next)
+		pg->next->prev = pg->prev;
+	pg->listed = false;
+}
+
+static struct slab_page *slab_new_page(uint cls)
+{
+	uint size = slab_class_size[cls];
+	uint count = SLAB_PAGE_SIZE / size;
+	struct slab_page *pg;
+	char *obj;
+	int i;
+
+	if (!slab.pages && slab_setup())
+		return NULL;
+	pg = internal_alloc(0, sizeof(*pg) + count);
+	if (!pg)
+		return NULL;
+	pg->base = internal_alloc(SLAB_PAGE_SIZE, SLAB_PAGE_SIZE);
+	if (!pg->base) {
+		internal_free(pg->base);
+		internal_free(pg);
+		return NULL;
+	}
+	pg->free = NULL;
+	for (i = count - 1; i >= 0; i--) {
+		obj = pg->base + i * size;
+		*(void **)obj = pg->free;
+		pg->free = obj;
+	}
+	pg->inuse = 0;
+	pg->cls = cls;
+	slab.pages[((ulong)pg->base - slab.base) / SLAB_PAGE_SIZE] = pg;
+	slab_list_add(&slab.cls[cls], pg);
+	slab.cls[cls].pages++;
+	slab.cls[cls].empty++;
+
+	return pg;
+}
+
+static void *slab_alloc(uint cls)
+{
+	struct slab_class *sc = &slab.cls[cls];
+	struct slab_page *pg;
+	void *obj;
+	uint idx;
+
+	pg = sc->partial;
+	if (!pg) {
+		pg = slab_new_page(cls);
+		if (!pg)
+			return NULL;
+	}
+	obj = pg->free;
+	pg->free = *(void **)obj;
+	if (!pg->inuse++)
+		sc->empty--;
+	if (!pg->free)
+		slab_list_del(sc, pg);
+
+	idx = ((char *)obj - pg->base) / slab_class_size[cls];
+	pg->tags[idx] = slab.tag;
+	tag_add(slab.tag, slab_class_size[cls]);
+	sc->objs++;
+	slab.slab_bytes += slab_class_size[cls];
+
+	return obj;
+}
+
+static void slab_free(struct slab_page *pg, void *obj)
+{
+	struct slab_class *sc = &slab.cls[pg->cls];
+	uint size = slab_class_size[pg->cls];
+
+	tag_sub(pg->tags[((char *)obj - pg->base) / size], size);
+	sc->objs--;
+	slab.slab_bytes -= size;
+
+	*(void **)obj = pg->free;
+	pg->free = obj;
+	if (!pg->listed)
+		slab_list_add(sc, pg);
+	if (--pg->inuse)
+		return;
+
+	/* Keep one empty page per class, give the rest back */
+	if (!sc->empty) {
+		sc->empty++;
+		return;
+	}
+	slab_list_del(sc, pg);
+	slab.pages[((ulong)pg->base - slab.base) / SLAB_PAGE_SIZE] = NULL;
+	sc->pages--;
+	internal_free(pg->base);
+	internal_free(pg);
+}
+
+static inline uint large_hash(ulong addr, uint size)
+{
+	return (addr >> 4) * 0x9e3779b1UL & (size - 1);
+}
+
+static int large_resize(void)
+{
+	ulong *old = slab.large;
+	uint old_size = slab.large_size;
+	uint size, i, pos;
+
+	size = max_t(uint, LARGE_MIN_SIZE,
+		     roundup_pow_of_two(slab.large_used * 4 + 1));
+	slab.large = internal_alloc(0, size * sizeof(ulong));
+	if (!slab.large) {
+		slab.large = old;
+		return -ENOMEM;
+	}
+	memset(slab.large, '\0', size * sizeof(ulong));
+	slab.large_size = size;
+	slab.large_deleted = 0;
+	for (i = 0; i < old_size; i++) {
+		if (old[i] <= LARGE_DELETED)
+			continue;
+		pos = large_hash(old[i], size);
+		while (slab.large[pos])
+			pos = (pos + 1) & (size - 1);
+		slab.large[pos] = old[i];
+	}
+	internal_free(old);
+
+	return 0;
+}
+
+/* Record a block allocated by dlmalloc, returning it */
+static void *large_add(void *ptr)
+{
+	ulong addr = (ulong)ptr;
+	uint pos;
+
+	if (!ptr)
+		return NULL;
+	if ((slab.large_used + slab.large_deleted + 1) * 2 > slab.large_size &&
+	    large_resize())
+		return ptr;	/* not accounted, freed as untagged */
+
+	pos = large_hash(addr, slab.large_size);
+	while (slab.large[pos] > LARGE_DELETED)
+		pos = (pos + 1) & (slab.large_size - 1);
+	if (slab.large[pos] == LARGE_DELETED)
+		slab.large_deleted--;
+	slab.large[pos] = addr | slab.tag;
+	slab.large_used++;
+	tag_add(slab.tag, malloc_usable_size(ptr));
+
+	return ptr;
+}
+
+/* Forget a block allocated by dlmalloc, before it is freed or moved */
+static void large_del(void *ptr, enum malloc_tag *tagp)
+{
+	ulong addr = (ulong)ptr;
+	enum malloc_tag tag;
+	uint pos;
+
+	if (!slab.large_size)
+		return;
+	pos = large_hash(addr, slab.large_size);
+	while (slab.large[pos]) {
+		if ((slab.large[pos] & ~LARGE_TAG_MASK) == addr) {
+			tag = slab.large[pos] & LARGE_TAG_MASK;
+			tag_sub(tag, malloc_usable_size(ptr));
+			slab.large[pos] = LARGE_DELETED;
+			slab.large_used--;
+			slab.large_deleted++;
+			if (tagp)
+				*tagp = tag;
+			return;
+		}
+		pos = (pos + 1) & (slab.large_size - 1);
+	}
+}
+
+void *malloc(size_t bytes)
+{
+	void *ptr;
+
+	if (!slab_ready())
+		return dlmalloc(bytes);
+	if (bytes <= SLAB_MAX_SIZE) {
+		ptr = slab_alloc(slab_class_of[(bytes + 15) / 16]);
+		if (ptr)
+			return ptr;
+	}
+
+	return large_add(dlmalloc(bytes));
+}
+
+void free(void *mem)
+{
+	struct slab_page *pg;
+
+	if (mem && slab_ready()) {
+		pg = slab_page_of(mem);
+		if (pg) {
+			slab_free(pg, mem);
+			return;
+		}
+		large_del(mem, NULL);
+	}
+	dlfree(mem);
+}
+
+void *memalign(size_t alignment, size_t bytes)
+{
+	void *ptr;
+	uint cls;
+
+	if (!slab_ready())
+		return dlmemalign(alignment, bytes);
+
+	/* Objects of a class are aligned to any power of two dividing it */
+	if (bytes <= SLAB_MAX_SIZE && alignment <= SLAB_MAX_SIZE) {
+		for (cls = slab_class_of[(bytes + 15) / 16]; cls < SLAB_CLASSES;
+		     cls++) {
+			if (!(slab_class_size[cls] & (alignment - 1)))
+				break;
+		}
+		if (cls < SLAB_CLASSES) {
+			ptr = slab_alloc(cls);
+			if (ptr)
+				return ptr;
+		}
+	}
+
+	return large_add(dlmemalign(alignment, bytes));
+}
+
+void *calloc(size_t n, size_t elem_size)
+{
+	size_t bytes = n * elem_size;
+	void *ptr;
+
+	if (!slab_ready())
+		return dlcalloc(n, elem_size);
+	if (elem_size && bytes / elem_size != n)
+		return NULL;
+	if (bytes > SLAB_MAX_SIZE)
+		return large_add(dlcalloc(n, elem_size));
+
+	ptr = malloc(bytes);
+	if (ptr)
+		memset(ptr, '\0', bytes);
+
+	return ptr;
+}
+
+void *realloc(void *oldmem, size_t bytes)
+{
+	enum malloc_tag tag = MALLOC_TAG_OTHER, old_tag;
+	struct slab_page *pg;
+	void *ptr;
+
+	if (!slab_ready())
+		return dlrealloc(oldmem, bytes);
+	if (!oldmem)
+		return malloc(bytes);
+
+	pg = slab_page_of(oldmem);
+	if (pg) {
+		if (bytes <= slab_class_size[pg->cls])
+			return oldmem;
+		/* Keep the tag of the original allocation */
+		old_tag = slab.tag;
+		slab.tag = pg->tags[((char *)oldmem - pg->base) /
+				    slab_class_size[pg->cls]];
+		ptr = malloc(bytes);
+		slab.tag = old_tag;
+		if (ptr) {
+			memcpy(ptr, oldmem, slab_class_size[pg->cls]);
+			slab_free(pg, oldmem);
+		}
+		return ptr;
+	}
+
+	large_del(oldmem, &tag);
+	ptr = dlrealloc(oldmem, bytes);
+	old_tag = slab.tag;
+	slab.tag = tag;
+	large_add(ptr ? ptr : oldmem);
+	slab.tag = old_tag;
+
+	return ptr;
+}
+
+void *valloc(size_t bytes)
+{
+	return memalign(SLAB_PAGE_SIZE, bytes);
+}
+
+void *pvalloc(size_t bytes)
+{
+	return memalign(SLAB_PAGE_SIZE, ALIGN(bytes, SLAB_PAGE_SIZE));
+}
+
+int mallopt(int param_number, int value)
+{
+	return dlmallopt(param_number, value);
+}
+
+#ifdef CONFIG_UNIT_TEST
+/*
+ * Report slab objects rather than the pages holding them, so that leak
+ * checks see an allocation and its free() cancel out.
+ */
+struct mallinfo mallinfo(void)
+{
+	struct mallinfo info = dlmallinfo();
+
+	info.uordblks += slab.slab_bytes - slab.internal;
+
+	return info;
+}
+#endif
+
+enum malloc_tag malloc_set_tag(enum malloc_tag tag)
+{
+	enum malloc_tag old = slab.tag;
+
+	/* The tag of a large block is kept in its low address bits */
+	BUILD_BUG_ON(MALLOC_TAG_COUNT > LARGE_TAG_MASK + 1);
+	slab.tag = tag;
+
+	return old;
+}
+
+size_t malloc_slab_size(const void *mem)
+{
+	struct slab_page *pg;
+
+	if (!slab_ready())
+		return 0;
+	pg = slab_page_of(mem);
+
+	return pg ? slab_class_size[pg->cls] : 0;
+}
+
+void malloc_get_tag_stats(enum malloc_tag tag, struct malloc_tag_stats *stats)
+{
+	*stats = slab.stats[tag];
+}
+
+void malloc_print_info(void)
+{
+	ulong size = mem_malloc_end - mem_malloc_start;
+	ulong pages = 0, page_bytes, free_bytes;
+	struct malloc_tag_stats *st;
+	size_t largest;
+	int i;
+
+	free_bytes = malloc_get_free(&largest);
+	printf("Heap:  %#lx bytes, %#lx used, %#lx free, largest free %#lx\n",
+	       size, size - free_bytes, free_bytes, (ulong)largest);
+	printf("Fragmentation: %lu%%\n",
+	       free_bytes ? 100 - (ulong)((u64)largest * 100 / free_bytes) : 0);
+
+	for (i = 0; i < SLAB_CLASSES; i++)
+		pages += slab.cls[i].pages;
+	page_bytes = pages * SLAB_PAGE_SIZE;
+	printf("Slabs: %lu pages, %#lx bytes, %#lx used (%lu%%), %#lx overhead\n",
+	       pages, page_bytes, slab.slab_bytes,
+	       page_bytes ? slab.slab_bytes * 100 / page_bytes : 0,
+	       slab.internal - page_bytes);
+	printf("%6s %6s %6s %8s\n", "size", "pages", "empty", "objects");
+	for (i = 0; i < SLAB_CLASSES; i++) {
+		struct slab_class *sc = &slab.cls[i];
+
+		if (sc->pages)
+			printf("%6u %6u %6u %8lu\n", slab_class_size[i],
+			       sc->pages, sc->empty, sc->objs);
+	}
+
+	printf("\n%-8s %10s %10s %8s %8s\n", "tag", "current", "peak", "live",
+	       "allocs");
+	for (i = 0; i < MALLOC_TAG_COUNT; i++) {
+		st = &slab.stats[i];
+		printf("%-8s %#10lx %#10lx %8lu %8lu\n", malloc_tag_name[i],
+		       st->cur, st->peak, st->live, st->allocs);
+	}
+}
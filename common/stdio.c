@@ -11,6 +11,7 @@
 
 #include <config.h>
 #include <common.h>
+#include <console.h>
 #include <dm.h>
 #include <errno.h>
 #include <stdarg.h>
@@ -265,6 +266,13 @@ int stdio_deregister_dev(struct stdio_dev *dev, int force)
 			sizeof(temp_names[l]));
 	}
 
+#if CONFIG_IS_ENABLED(CONSOLE_BUFFER)
+	if (dev->outbuf) {
+		console_flush();
+		free(dev->outbuf->start);
+		free(dev->outbuf);
+	}
+#endif
 	list_del(&(dev->list));
 	free(dev);
 
@@ -907,6 +907,15 @@ __weak int usb_alloc_device(struct usb_device *udev)
 {
 	return 0;
 }
+
+/*
+ * Host controller drivers which limit the length of a single transfer
+ * override this. Callers then fall back to a conservative size.
+ */
+__weak int usb_get_max_xfer_size(struct usb_device *dev, size_t *size)
+{
+	return -ENOSYS;
+}
 #endif /* !CONFIG_DM_USB */
 
 static int usb_hub_port_reset(struct usb_device *dev, struct usb_device *hub)
@@ -477,6 +477,8 @@ static int usb_stor_BBB_reset(struct us_data *us)
 		return -1;
 	}
 
+	us->flags &= ~USB_READY;
+
 	/* long wait for reset */
 	mdelay(150);
 	debug("BBB_reset result %d: status %lX reset\n",
@@ -824,6 +826,10 @@ again:
 		return USB_STOR_TRANSPORT_FAILED;
 	}
 
+	/* The device is responding, so stop waiting after each command */
+	if (IS_ENABLED(CONFIG_USB_STORAGE_NO_CBW_DELAY))
+		us->flags |= USB_READY;
+
 	return result;
 }
 
@@ -943,31 +949,19 @@ static void usb_stor_set_max_xfer_blk(struct usb_device *udev,
 				      struct us_data *us)
 {
 	unsigned short blk;
-	size_t __maybe_unused size;
-	int __maybe_unused ret;
+	size_t size;
+	int ret;
 
-#ifndef CONFIG_DM_USB
-#ifdef CONFIG_USB_EHCI_HCD
-	/*
-	 * The U-Boot EHCI driver can handle any transfer length as long as
-	 * there is enough free heap space left, but the SCSI READ(10) and
-	 * WRITE(10) commands are limited to 65535 blocks.
-	 */
-	blk = USHRT_MAX;
-#else
-	blk = 20;
-#endif
-#else
-	ret = usb_get_max_xfer_size(udev, (size_t *)&size);
+	ret = usb_get_max_xfer_size(udev, &size);
 	if (ret < 0) {
 		/* unimplemented, let's use default 20 */
 		blk = 20;
 	} else {
+		/* SCSI READ(10) and WRITE(10) are limited to 65535 blocks */
 		if (size > USHRT_MAX * 512)
 			size = USHRT_MAX * 512;
 		blk = size / 512;
 	}
-#endif
 
 	us->max_xfer_blk = blk;
 }
@@ -1193,7 +1187,8 @@ retry_it:
 		blks -= smallblks;
 		buf_addr += srb->datalen;
 	} while (blks != 0);
-	ss->flags &= ~USB_READY;
+	if (!IS_ENABLED(CONFIG_USB_STORAGE_NO_CBW_DELAY))
+		ss->flags &= ~USB_READY;
 
 	debug("usb_read: end startblk " LBAF
 	      ", blccnt %x buffer %" PRIxPTR "\n",
@@ -1279,7 +1274,8 @@ retry_it:
 		blks -= smallblks;
 		buf_addr += srb->datalen;
 	} while (blks != 0);
-	ss->flags &= ~USB_READY;
+	if (!IS_ENABLED(CONFIG_USB_STORAGE_NO_CBW_DELAY))
+		ss->flags &= ~USB_READY;
 
 	debug("usb_write: end startblk " LBAF ", blccnt %x buffer %"
 	      PRIxPTR "\n", start, smallblks, buf_addr);
@@ -26,6 +26,18 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
+/* Ask a driver, through the cache when it handles the device's table */
+static int part_driver_get_info(struct part_driver *drv,
+				struct blk_desc *dev_desc, int part,
+				disk_partition_t *info)
+{
+#if CONFIG_IS_ENABLED(PARTITION_CACHE)
+	if (drv->part_type == dev_desc->part_type)
+		return part_cache_get_info(dev_desc, drv, part, info);
+#endif
+	return drv->get_info(dev_desc, part, info);
+}
+
 #ifdef HAVE_BLOCK_DEVICE
 static struct part_driver *part_driver_lookup_type(int part_type)
 {
@@ -222,6 +234,8 @@ void part_init(struct blk_desc *dev_desc)
 	struct part_driver *entry;
 
 	blkcache_invalidate(dev_desc->if_type, dev_desc->devnum);
+	part_cache_invalidate(dev_desc);
+	sqfs_cache_invalidate(dev_desc);
 
 	dev_desc->part_type = PART_TYPE_UNKNOWN;
 	for (entry = drv; entry != drv + n_ents; entry++) {
@@ -325,7 +339,7 @@ int part_get_info(struct blk_desc *dev_desc, int part,
 		       drv->name);
 		return -ENOSYS;
 	}
-	if (drv->get_info(dev_desc, part, info) == 0) {
+	if (part_driver_get_info(drv, dev_desc, part, info) == 0) {
 		PRINTF("## Valid %s partition found ##\n", drv->name);
 		return 0;
 	}
@@ -643,7 +657,7 @@ int part_get_info_by_name_type(struct blk_desc *dev_desc, const char *name,
 		for (i = 1; i < part_drv->max_entries; i++) {
 			if (part_type >= 0 && part_type != part_drv->part_type)
 				break;
-			ret = part_drv->get_info(dev_desc, i, info);
+			ret = part_driver_get_info(part_drv, dev_desc, i, info);
 			if (ret != 0) {
 				/* no more entries in table */
 				break;
@@ -663,6 +677,28 @@ int part_get_info_by_name(struct blk_desc *dev_desc, const char *name,
 	return part_get_info_by_name_type(dev_desc, name, info, PART_TYPE_ALL);
 }
 
+#if defined(HAVE_BLOCK_DEVICE) && CONFIG_IS_ENABLED(PARTITION_UUIDS)
+int part_get_info_by_uuid(struct blk_desc *dev_desc, const char *uuid,
+			  disk_partition_t *info)
+{
+	struct part_driver *drv;
+	int i;
+
+	drv = part_driver_lookup_type(dev_desc->part_type);
+	if (!drv)
+		return -1;
+
+	for (i = 1; i <= drv->max_entries; i++) {
+		if (part_get_info(dev_desc, i, info))
+			continue;
+		if (!strcasecmp(uuid, info->uuid))
+			return i;
+	}
+
+	return -1;
+}
+#endif
+
 void part_set_generic_name(const struct blk_desc *dev_desc,
 	int part_num, char *name)
 {
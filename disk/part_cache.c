@@ -0,0 +1,222 @@
+/*
+ * Partition table cache
+ *
+ * Looking up a partition normally reads the partition table again and, for
+ * GPT, checks the CRCs of the header and of the whole entry array. Boot
+ * scripts look up the same partitions many times over, so keep the result
+ * of each lookup per block device, along with whatever validated table the
+ * partition driver wants to keep and the filesystem type found on each of
+ * the first few partitions. Everything is dropped on a write or
+ * erase, when the device is (re)initialised and when another hardware
+ * partition is selected.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <blk.h>
+#include <fs.h>
+#include <malloc.h>
+#include <part.h>
+
+enum {
+	PART_CACHE_UNKNOWN,	/* not looked up yet */
+	PART_CACHE_PRESENT,
+	PART_CACHE_ABSENT,
+};
+
+/* Partitions 0 (whole disk) to PART_CACHE_FSTYPES - 1 have a cached type */
+#define PART_CACHE_FSTYPES	16
+
+/**
+ * struct part_cache - Cached partition table of a block device
+ *
+ * @hwpart:	Hardware partition the contents belong to
+ * @part_type:	Partition table type the contents belong to
+ * @max_entries: Number of entries in @info and @state, 0 if not allocated
+ * @info:	Information for partition n is in @info[n - 1]
+ * @state:	PART_CACHE_... state of each partition number
+ * @table:	Validated table kept by the partition driver, or NULL
+ * @table_size:	Size of @table in bytes
+ * @fstype:	FS_TYPE_... found on each partition, FS_TYPE_ANY if not known
+ * @stats:	Statistics, kept across invalidations
+ */
+struct part_cache {
+	int hwpart;
+	int part_type;
+	int max_entries;
+	disk_partition_t *info;
+	u8 *state;
+	void *table;
+	size_t table_size;
+	u8 fstype[PART_CACHE_FSTYPES];
+	struct part_cache_stats stats;
+};
+
+static bool part_cache_empty(struct part_cache *cache)
+{
+	return !cache->max_entries && !cache->table && !cache->stats.fstypes;
+}
+
+static void part_cache_drop(struct part_cache *cache)
+{
+	free(cache->info);
+	free(cache->state);
+	free(cache->table);
+	cache->info = NULL;
+	cache->state = NULL;
+	cache->table = NULL;
+	cache->max_entries = 0;
+	cache->table_size = 0;
+	memset(cache->fstype, FS_TYPE_ANY, sizeof(cache->fstype));
+	cache->stats.entries = 0;
+	cache->stats.fstypes = 0;
+}
+
+/* Get the device's cache, emptied if it no longer matches the device */
+static struct part_cache *part_cache_get(struct blk_desc *dev_desc,
+					 bool create)
+{
+	struct part_cache *cache = dev_desc->part_cache;
+
+	if (!cache) {
+		if (!create)
+			return NULL;
+		cache = calloc(1, sizeof(*cache));
+		if (!cache)
+			return NULL;
+		dev_desc->part_cache = cache;
+	} else if (cache->hwpart != dev_desc->hwpart ||
+		   cache->part_type != dev_desc->part_type) {
+		if (!part_cache_empty(cache))
+			cache->stats.invalidations++;
+		part_cache_drop(cache);
+	}
+	cache->hwpart = dev_desc->hwpart;
+	cache->part_type = dev_desc->part_type;
+
+	return cache;
+}
+
+int part_cache_get_info(struct blk_desc *dev_desc, struct part_driver *drv,
+			int part, disk_partition_t *info)
+{
+	struct part_cache *cache;
+	int ret;
+
+	cache = part_cache_get(dev_desc, true);
+	if (!cache || part < 1 || part > drv->max_entries)
+		return drv->get_info(dev_desc, part, info);
+
+	if (!cache->max_entries) {
+		cache->info = calloc(drv->max_entries, sizeof(*cache->info));
+		cache->state = calloc(drv->max_entries, sizeof(*cache->state));
+		if (!cache->info || !cache->state) {
+			part_cache_drop(cache);
+			return drv->get_info(dev_desc, part, info);
+		}
+		cache->max_entries = drv->max_entries;
+	}
+
+	switch (cache->state[part - 1]) {
+	case PART_CACHE_PRESENT:
+		cache->stats.hits++;
+		*info = cache->info[part - 1];
+		return 0;
+	case PART_CACHE_ABSENT:
+		cache->stats.hits++;
+		return -1;
+	}
+
+	cache->stats.misses++;
+	ret = drv->get_info(dev_desc, part, info);
+	if (ret) {
+		cache->state[part - 1] = PART_CACHE_ABSENT;
+	} else {
+		cache->state[part - 1] = PART_CACHE_PRESENT;
+		cache->info[part - 1] = *info;
+		cache->stats.entries++;
+	}
+
+	return ret;
+}
+
+void *part_cache_get_table(struct blk_desc *dev_desc)
+{
+	struct part_cache *cache = part_cache_get(dev_desc, false);
+
+	return cache ? cache->table : NULL;
+}
+
+int part_cache_set_table(struct blk_desc *dev_desc, void *table, size_t size)
+{
+	struct part_cache *cache = part_cache_get(dev_desc, true);
+
+	if (!cache)
+		return -ENOMEM;
+	free(cache->table);
+	cache->table = table;
+	cache->table_size = size;
+
+	return 0;
+}
+
+int part_cache_get_fstype(struct blk_desc *dev_desc, int part)
+{
+	struct part_cache *cache = part_cache_get(dev_desc, false);
+
+	if (!cache || part < 0 || part >= PART_CACHE_FSTYPES)
+		return FS_TYPE_ANY;
+
+	return cache->fstype[part];
+}
+
+void part_cache_set_fstype(struct blk_desc *dev_desc, int part, int fstype)
+{
+	struct part_cache *cache;
+
+	if (part < 0 || part >= PART_CACHE_FSTYPES)
+		return;
+	cache = part_cache_get(dev_desc, true);
+	if (!cache)
+		return;
+	if (cache->fstype[part] == FS_TYPE_ANY && fstype != FS_TYPE_ANY)
+		cache->stats.fstypes++;
+	else if (cache->fstype[part] != FS_TYPE_ANY && fstype == FS_TYPE_ANY)
+		cache->stats.fstypes--;
+	cache->fstype[part] = fstype;
+}
+
+void part_cache_get_stats(struct blk_desc *dev_desc,
+			  struct part_cache_stats *stats)
+{
+	struct part_cache *cache = part_cache_get(dev_desc, false);
+
+	if (!cache) {
+		memset(stats, '\0', sizeof(*stats));
+		return;
+	}
+	*stats = cache->stats;
+	stats->table_size = cache->table_size;
+}
+
+void part_cache_invalidate(struct blk_desc *dev_desc)
+{
+	struct part_cache *cache = dev_desc->part_cache;
+
+	if (!cache || part_cache_empty(cache))
+		return;
+	cache->stats.invalidations++;
+	part_cache_drop(cache);
+}
+
+void part_cache_remove(struct blk_desc *dev_desc)
+{
+	struct part_cache *cache = dev_desc->part_cache;
+
+	if (!cache)
+		return;
+	part_cache_drop(cache);
+	free(cache);
+	dev_desc->part_cache = NULL;
+}
@@ -47,6 +47,9 @@ static int is_gpt_valid(struct blk_desc *dev_desc, u64 lba,
 				gpt_header *pgpt_head, gpt_entry **pgpt_pte);
 static gpt_entry *alloc_read_gpt_entries(struct blk_desc *dev_desc,
 					 gpt_header *pgpt_head);
+static int find_valid_gpt(struct blk_desc *dev_desc, gpt_header *gpt_head,
+			  gpt_entry **pgpt_pte);
+static void put_gpt_pte(struct blk_desc *dev_desc, gpt_entry *gpt_pte);
 static int is_pte_valid(gpt_entry * pte);
 
 static char *print_efiname(gpt_entry *pte)
@@ -189,23 +192,13 @@ int get_disk_guid(struct blk_desc * dev_desc, char *guid)
 	unsigned char *guid_bin;
 
 	/* This function validates AND fills in the GPT header and PTE */
-	if (is_gpt_valid(dev_desc, GPT_PRIMARY_PARTITION_TABLE_LBA,
-			 gpt_head, &gpt_pte) != 1) {
-		printf("%s: *** ERROR: Invalid GPT ***\n", __func__);
-		if (is_gpt_valid(dev_desc, dev_desc->lba - 1,
-				 gpt_head, &gpt_pte) != 1) {
-			printf("%s: *** ERROR: Invalid Backup GPT ***\n",
-			       __func__);
-			return -EINVAL;
-		} else {
-			printf("%s: ***        Using Backup GPT ***\n",
-			       __func__);
-		}
-	}
+	if (find_valid_gpt(dev_desc, gpt_head, &gpt_pte) != 1)
+		return -EINVAL;
 
 	guid_bin = gpt_head->disk_guid.b;
 	uuid_bin_to_str(guid_bin, guid, UUID_STR_FORMAT_GUID);
 
+	put_gpt_pte(dev_desc, gpt_pte);
 	return 0;
 }
 
@@ -218,19 +211,8 @@ void part_print_efi(struct blk_desc *dev_desc)
 	unsigned char *uuid_bin;
 
 	/* This function validates AND fills in the GPT header and PTE */
-	if (is_gpt_valid(dev_desc, GPT_PRIMARY_PARTITION_TABLE_LBA,
-			 gpt_head, &gpt_pte) != 1) {
-		printf("%s: *** ERROR: Invalid GPT ***\n", __func__);
-		if (is_gpt_valid(dev_desc, (dev_desc->lba - 1),
-				 gpt_head, &gpt_pte) != 1) {
-			printf("%s: *** ERROR: Invalid Backup GPT ***\n",
-			       __func__);
-			return;
-		} else {
-			printf("%s: ***        Using Backup GPT ***\n",
-			       __func__);
-		}
-	}
+	if (find_valid_gpt(dev_desc, gpt_head, &gpt_pte) != 1)
+		return;
 
 	debug("%s: gpt-entry at %p\n", __func__, gpt_pte);
 
@@ -262,7 +244,7 @@ void part_print_efi(struct blk_desc *dev_desc)
 	}
 
 	/* Remember to free pte */
-	free(gpt_pte);
+	put_gpt_pte(dev_desc, gpt_pte);
 	return;
 }
 
@@ -279,25 +261,14 @@ int part_get_info_efi(struct blk_desc *dev_desc, int part,
 	}
 
 	/* This function validates AND fills in the GPT header and PTE */
-	if (is_gpt_valid(dev_desc, GPT_PRIMARY_PARTITION_TABLE_LBA,
-			gpt_head, &gpt_pte) != 1) {
-		printf("%s: *** ERROR: Invalid GPT ***\n", __func__);
-		if (is_gpt_valid(dev_desc, (dev_desc->lba - 1),
-				 gpt_head, &gpt_pte) != 1) {
-			printf("%s: *** ERROR: Invalid Backup GPT ***\n",
-			       __func__);
-			return -1;
-		} else {
-			printf("%s: ***        Using Backup GPT ***\n",
-			       __func__);
-		}
-	}
+	if (find_valid_gpt(dev_desc, gpt_head, &gpt_pte) != 1)
+		return -1;
 
 	if (part > le32_to_cpu(gpt_head->num_partition_entries) ||
 	    !is_pte_valid(&gpt_pte[part - 1])) {
 		debug("%s: *** ERROR: Invalid partition number %d ***\n",
 			__func__, part);
-		free(gpt_pte);
+		put_gpt_pte(dev_desc, gpt_pte);
 		return -1;
 	}
 
@@ -325,7 +296,7 @@ int part_get_info_efi(struct blk_desc *dev_desc, int part,
 	      info->start, info->size, info->name);
 
 	/* Remember to free pte */
-	free(gpt_pte);
+	put_gpt_pte(dev_desc, gpt_pte);
 	return 0;
 }
 
@@ -976,6 +947,77 @@ static int is_gpt_valid(struct blk_desc *dev_desc, u64 lba,
 	return 1;
 }
 
+/* A validated GPT as kept in the partition cache */
+struct gpt_cached {
+	gpt_header head;
+	gpt_entry pte[];
+};
+
+/**
+ * find_valid_gpt() - find a valid GPT, trying the backup if the primary fails
+ *
+ * gpt_head is a GPT header ptr, filled on return.
+ * pgpt_pte is a PTEs ptr, filled on return.
+ *
+ * Description: returns 1 if valid, 0 on error.
+ * With the partition cache the validated table is kept for the device, so
+ * that later calls need not read it or check its CRCs again. Release the
+ * PTEs with put_gpt_pte().
+ */
+static int find_valid_gpt(struct blk_desc *dev_desc, gpt_header *gpt_head,
+			  gpt_entry **pgpt_pte)
+{
+	struct gpt_cached *cached;
+	size_t size;
+
+	cached = part_cache_get_table(dev_desc);
+	if (cached) {
+		memcpy(gpt_head, &cached->head, sizeof(cached->head));
+		*pgpt_pte = cached->pte;
+		return 1;
+	}
+
+	if (is_gpt_valid(dev_desc, GPT_PRIMARY_PARTITION_TABLE_LBA,
+			 gpt_head, pgpt_pte) != 1) {
+		printf("%s: *** ERROR: Invalid GPT ***\n", __func__);
+		if (is_gpt_valid(dev_desc, (dev_desc->lba - 1),
+				 gpt_head, pgpt_pte) != 1) {
+			printf("%s: *** ERROR: Invalid Backup GPT ***\n",
+			       __func__);
+			return 0;
+		}
+		printf("%s: ***        Using Backup GPT ***\n", __func__);
+	}
+
+	if (!CONFIG_IS_ENABLED(PARTITION_CACHE))
+		return 1;
+
+	size = le32_to_cpu(gpt_head->num_partition_entries) *
+	       le32_to_cpu(gpt_head->sizeof_partition_entry);
+	cached = malloc(sizeof(*cached) + size);
+	if (!cached)
+		return 1;
+	memcpy(&cached->head, gpt_head, sizeof(cached->head));
+	memcpy(cached->pte, *pgpt_pte, size);
+	if (part_cache_set_table(dev_desc, cached, sizeof(*cached) + size)) {
+		free(cached);
+		return 1;
+	}
+	free(*pgpt_pte);
+	*pgpt_pte = cached->pte;
+
+	return 1;
+}
+
+/* Release PTEs from find_valid_gpt(), unless the partition cache holds them */
+static void put_gpt_pte(struct blk_desc *dev_desc, gpt_entry *gpt_pte)
+{
+	struct gpt_cached *cached = part_cache_get_table(dev_desc);
+
+	if (!cached || gpt_pte != cached->pte)
+		free(gpt_pte);
+}
+
 /**
  * alloc_read_gpt_entries(): reads partition entries from disk
  * @dev_desc
@@ -13,6 +13,7 @@
 #include <malloc.h>
 #include <sandboxblockdev.h>
 #include <linux/errno.h>
+#include <linux/math64.h>
 #include <dm/device-internal.h>
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -29,6 +30,78 @@ static struct host_block_dev *find_host_device(int dev)
 }
 #endif
 
+/* Below this much time left, a delay spins rather than sleeps */
+#define HOST_DELAY_SPIN_NS	100000
+
+/*
+ * Make a request that started at start and moved count bytes take as long
+ * as the device's latency model says. The wait is to a deadline taken
+ * from the start of the request, so the time the host needed for it is
+ * part of the delay, and the last part of the wait spins as sleeping is
+ * not that precise.
+ */
+static void host_delay(struct host_block_dev *host_dev, u64 start,
+		       u64 count)
+{
+	u64 delay, deadline, now;
+
+	if (!host_dev->overhead_ns && !host_dev->bandwidth)
+		return;
+
+	delay = host_dev->overhead_ns;
+	if (host_dev->bandwidth)
+		delay += div64_u64(count * 1000000000ULL, host_dev->bandwidth);
+	host_dev->stats.delay_ns += delay;
+
+	deadline = start + delay;
+	while ((now = os_get_nsec()) < deadline) {
+		if (deadline - now > HOST_DELAY_SPIN_NS)
+			os_usleep((deadline - now - HOST_DELAY_SPIN_NS) / 1000);
+	}
+}
+
+static long host_block_io(struct host_block_dev *host_dev,
+			  struct blk_desc *block_dev, unsigned long start,
+			  lbaint_t blkcnt, void *buffer, bool write)
+{
+	loff_t offset = (loff_t)start * block_dev->blksz;
+	loff_t len = (loff_t)blkcnt * block_dev->blksz;
+	u64 begin = os_get_nsec();
+	ssize_t ret;
+
+	if (host_dev->map) {
+		if (offset > host_dev->size) {
+			printf("ERROR: Invalid block %lx\n", start);
+			return -1;
+		}
+		len = min(len, host_dev->size - offset);
+		if (write)
+			memcpy(host_dev->map + offset, buffer, len);
+		else
+			memcpy(buffer, host_dev->map + offset, len);
+		ret = len;
+	} else if (write) {
+		ret = os_pwrite(host_dev->fd, buffer, len, offset);
+	} else {
+		ret = os_pread(host_dev->fd, buffer, len, offset);
+	}
+	if (ret < 0) {
+		printf("ERROR: Invalid block %lx\n", start);
+		return -1;
+	}
+
+	host_delay(host_dev, begin, ret);
+	if (write) {
+		host_dev->stats.writes++;
+		host_dev->stats.write_blocks += ret / block_dev->blksz;
+	} else {
+		host_dev->stats.reads++;
+		host_dev->stats.read_blocks += ret / block_dev->blksz;
+	}
+
+	return ret / block_dev->blksz;
+}
+
 #ifdef CONFIG_BLK
 static unsigned long host_block_read(struct udevice *dev,
 				     unsigned long start, lbaint_t blkcnt,
@@ -49,15 +122,8 @@ static unsigned long host_block_read(struct blk_desc *block_dev,
 		return -1;
 #endif
 
-	if (os_lseek(host_dev->fd, start * block_dev->blksz, OS_SEEK_SET) ==
-			-1) {
-		printf("ERROR: Invalid block %lx\n", start);
-		return -1;
-	}
-	ssize_t len = os_read(host_dev->fd, buffer, blkcnt * block_dev->blksz);
-	if (len >= 0)
-		return len / block_dev->blksz;
-	return -1;
+	return host_block_io(host_dev, block_dev, start, blkcnt, buffer,
+			     false);
 }
 
 #ifdef CONFIG_BLK
@@ -76,24 +142,58 @@ static unsigned long host_block_write(struct blk_desc *block_dev,
 	struct host_block_dev *host_dev = find_host_device(dev);
 #endif
 
-	if (os_lseek(host_dev->fd, start * block_dev->blksz, OS_SEEK_SET) ==
-			-1) {
-		printf("ERROR: Invalid block %lx\n", start);
-		return -1;
+	return host_block_io(host_dev, block_dev, start, blkcnt,
+			     (void *)buffer, true);
+}
+
+/* Open the backing file of a device, and map it if flags ask for it */
+static int host_dev_open(struct host_block_dev *host_dev, char *filename,
+			 int flags)
+{
+	host_dev->fd = os_open(filename, OS_O_RDWR);
+	if (host_dev->fd == -1) {
+		printf("Failed to access host backing file '%s'\n", filename);
+		return -ENOENT;
+	}
+	host_dev->size = os_lseek(host_dev->fd, 0, OS_SEEK_END);
+	host_dev->map = NULL;
+	host_dev->overhead_ns = 0;
+	host_dev->bandwidth = 0;
+	memset(&host_dev->stats, 0, sizeof(host_dev->stats));
+
+	if (flags & HOST_BIND_MMAP) {
+		host_dev->map = os_map_file(host_dev->fd, host_dev->size);
+		if (!host_dev->map) {
+			printf("Failed to map host backing file '%s'\n",
+			       filename);
+			os_close(host_dev->fd);
+			host_dev->fd = -1;
+			return -ENOMEM;
+		}
 	}
-	ssize_t len = os_write(host_dev->fd, buffer, blkcnt * block_dev->blksz);
-	if (len >= 0)
-		return len / block_dev->blksz;
-	return -1;
+
+	return 0;
+}
+
+/* Close the backing file of a device, if it has one */
+static void host_dev_close(struct host_block_dev *host_dev)
+{
+	if (host_dev->fd == -1)
+		return;
+	if (host_dev->map)
+		os_unmap_file(host_dev->map, host_dev->size);
+	host_dev->map = NULL;
+	os_close(host_dev->fd);
+	host_dev->fd = -1;
 }
 
 #ifdef CONFIG_BLK
-int host_dev_bind(int devnum, char *filename)
+int host_dev_bind(int devnum, char *filename, int flags)
 {
-	struct host_block_dev *host_dev;
+	struct host_block_dev *host_dev, file;
 	struct udevice *dev;
 	char dev_name[20], *str, *fname;
-	int ret, fd;
+	int ret;
 
 	/* Remove and unbind the old device, if any */
 	ret = blk_get_device(IF_TYPE_HOST, devnum, &dev);
@@ -121,15 +221,12 @@ int host_dev_bind(int devnum, char *filename)
 		return -ENOMEM;
 	}
 
-	fd = os_open(filename, OS_O_RDWR);
-	if (fd == -1) {
-		printf("Failed to access host backing file '%s'\n", filename);
-		ret = -ENOENT;
+	ret = host_dev_open(&file, filename, flags);
+	if (ret)
 		goto err;
-	}
 	ret = blk_create_device(gd->dm_root, "sandbox_host_blk", str,
-				IF_TYPE_HOST, devnum, 512,
-				os_lseek(fd, 0, OS_SEEK_END) / 512, &dev);
+				IF_TYPE_HOST, devnum, 512, file.size / 512,
+				&dev);
 	if (ret)
 		goto err_file;
 	ret = device_probe(dev);
@@ -139,26 +236,28 @@ int host_dev_bind(int devnum, char *filename)
 	}
 
 	host_dev = dev_get_priv(dev);
-	host_dev->fd = fd;
+	host_dev->fd = file.fd;
+	host_dev->map = file.map;
+	host_dev->size = file.size;
 	host_dev->filename = fname;
 
 	return blk_prepare_device(dev);
 err_file:
-	os_close(fd);
+	host_dev_close(&file);
 err:
 	free(fname);
 	free(str);
 	return ret;
 }
 #else
-int host_dev_bind(int dev, char *filename)
+int host_dev_bind(int dev, char *filename, int flags)
 {
 	struct host_block_dev *host_dev = find_host_device(dev);
 
 	if (!host_dev)
 		return -1;
 	if (host_dev->blk_dev.priv) {
-		os_close(host_dev->fd);
+		host_dev_close(host_dev);
 		host_dev->blk_dev.priv = NULL;
 	}
 	if (host_dev->filename)
@@ -170,18 +269,14 @@ int host_dev_bind(int dev, char *filename)
 		return 0;
 	}
 
-	host_dev->fd = os_open(host_dev->filename, OS_O_RDWR);
-	if (host_dev->fd == -1) {
-		printf("Failed to access host backing file '%s'\n",
-		       host_dev->filename);
+	if (host_dev_open(host_dev, host_dev->filename, flags))
 		return 1;
-	}
 
 	struct blk_desc *blk_dev = &host_dev->blk_dev;
 	blk_dev->if_type = IF_TYPE_HOST;
 	blk_dev->priv = host_dev;
 	blk_dev->blksz = 512;
-	blk_dev->lba = os_lseek(host_dev->fd, 0, OS_SEEK_END) / blk_dev->blksz;
+	blk_dev->lba = host_dev->size / blk_dev->blksz;
 	blk_dev->block_read = host_block_read;
 	blk_dev->block_write = host_block_write;
 	blk_dev->devnum = dev;
@@ -217,7 +312,44 @@ int host_get_dev_err(int devnum, struct blk_desc **blk_devp)
 	return 0;
 }
 
+int host_get_host_dev(int devnum, struct host_block_dev **host_devp)
+{
+	struct blk_desc *blk_dev;
+	int ret;
+
+	ret = host_get_dev_err(devnum, &blk_dev);
+	if (ret)
+		return ret;
+#ifdef CONFIG_BLK
+	*host_devp = dev_get_priv(blk_dev->bdev);
+#else
+	*host_devp = blk_dev->priv;
+#endif
+
+	return 0;
+}
+
 #ifdef CONFIG_BLK
+/* No file is attached until host_dev_bind() sets one up */
+static int host_block_probe(struct udevice *dev)
+{
+	struct host_block_dev *host_dev = dev_get_priv(dev);
+
+	host_dev->fd = -1;
+
+	return 0;
+}
+
+static int host_block_remove(struct udevice *dev)
+{
+	struct host_block_dev *host_dev = dev_get_priv(dev);
+
+	host_dev_close(host_dev);
+	free(host_dev->filename);
+
+	return 0;
+}
+
 static const struct blk_ops sandbox_host_blk_ops = {
 	.read	= host_block_read,
 	.write	= host_block_write,
@@ -227,6 +359,8 @@ U_BOOT_DRIVER(sandbox_host_blk) = {
 	.name		= "sandbox_host_blk",
 	.id		= UCLASS_BLK,
 	.ops		= &sandbox_host_blk_ops,
+	.probe		= host_block_probe,
+	.remove		= host_block_remove,
 	.priv_auto_alloc_size	= sizeof(struct host_block_dev),
 };
 #else
@@ -7,6 +7,7 @@
 #include <common.h>
 #include <dm/util.h>
 #include <libfdt.h>
+#include <malloc.h>
 #include <vsprintf.h>
 
 #ifdef CONFIG_DM_WARN
@@ -20,6 +21,17 @@ void dm_warn(const char *fmt, ...)
 }
 #endif
 
+void *dm_calloc(size_t size)
+{
+	enum malloc_tag old = malloc_set_tag(MALLOC_TAG_DM);
+	void *ptr;
+
+	ptr = calloc(1, size);
+	malloc_set_tag(old);
+
+	return ptr;
+}
+
 int list_count_items(struct list_head *head)
 {
 	struct list_head *node;
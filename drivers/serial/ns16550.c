@@ -334,6 +334,32 @@ static int ns16550_serial_putc(struct udevice *dev, const char ch)
 	return 0;
 }
 
+/*
+ * Only assume the original 16550A FIFO depth; the transmitter is empty when
+ * THRE is set so that many characters can be written without checking again
+ */
+#define NS16550_TX_FIFO_DEPTH	16
+
+static ssize_t ns16550_serial_puts(struct udevice *dev, const char *s,
+				   size_t len)
+{
+	struct NS16550 *const com_port = dev_get_priv(dev);
+	size_t i, room;
+
+	if (!(serial_in(&com_port->lsr) & UART_LSR_THRE))
+		return -EAGAIN;
+
+	room = ns16550_getfcr(com_port) & UART_FCR_FIFO_EN ?
+		NS16550_TX_FIFO_DEPTH : 1;
+	for (i = 0; i < len && i < room; i++) {
+		serial_out(s[i], &com_port->thr);
+		if (s[i] == '\n')
+			WATCHDOG_RESET();
+	}
+
+	return i;
+}
+
 static int ns16550_serial_pending(struct udevice *dev, bool input)
 {
 	struct NS16550 *const com_port = dev_get_priv(dev);
@@ -464,6 +490,7 @@ int ns16550_serial_ofdata_to_platdata(struct udevice *dev)
 
 const struct dm_serial_ops ns16550_serial_ops = {
 	.putc = ns16550_serial_putc,
+	.puts = ns16550_serial_puts,
 	.pending = ns16550_serial_pending,
 	.getc = ns16550_serial_getc,
 	.setbrg = ns16550_serial_setbrg,
@@ -280,6 +280,52 @@ static void serial_stub_puts(struct stdio_dev *sdev, const char *str)
 	_serial_puts(sdev->priv, str);
 }
 
+#if CONFIG_IS_ENABLED(CONSOLE_BUFFER)
+/*
+ * Send what the UART takes without waiting, turning '\n' into "\r\n".
+ * Returns the number of characters from @str which were consumed.
+ */
+static int serial_stub_try_puts(struct stdio_dev *sdev, const char *str,
+				int len)
+{
+	struct udevice *dev = sdev->priv;
+	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+	struct dm_serial_ops *ops = serial_get_ops(dev);
+	const char *nl;
+	int done, n, ret;
+
+	for (done = 0; done < len; done += ret) {
+		if (str[done] == '\n') {
+			if (!upriv->tx_cr) {
+				if (ops->putc(dev, '\r') == -EAGAIN)
+					break;
+				upriv->tx_cr = true;
+			}
+			n = 1;
+		} else {
+			nl = memchr(str + done, '\n', len - done);
+			n = nl ? nl - (str + done) : len - done;
+		}
+
+		/* Characters which hit an error are dropped, as in putc() */
+		if (ops->puts) {
+			ret = ops->puts(dev, str + done, n);
+			if (!ret || ret == -EAGAIN)
+				break;
+			if (ret < 0)
+				ret = n;
+		} else {
+			if (ops->putc(dev, str[done]) == -EAGAIN)
+				break;
+			ret = 1;
+		}
+		upriv->tx_cr = false;
+	}
+
+	return done;
+}
+#endif
+
 static int serial_stub_getc(struct stdio_dev *sdev)
 {
 	return _serial_getc(sdev->priv);
@@ -369,6 +415,8 @@ static int serial_post_probe(struct udevice *dev)
 		ops->getc += gd->reloc_off;
 	if (ops->putc)
 		ops->putc += gd->reloc_off;
+	if (ops->puts)
+		ops->puts += gd->reloc_off;
 	if (ops->pending)
 		ops->pending += gd->reloc_off;
 	if (ops->clear)
@@ -395,6 +443,9 @@ static int serial_post_probe(struct udevice *dev)
 	sdev.priv = dev;
 	sdev.putc = serial_stub_putc;
 	sdev.puts = serial_stub_puts;
+#if CONFIG_IS_ENABLED(CONSOLE_BUFFER)
+	sdev.try_puts = serial_stub_try_puts;
+#endif
 	sdev.getc = serial_stub_getc;
 	sdev.tstc = serial_stub_tstc;
 
@@ -244,6 +244,7 @@
 #include <malloc.h>
 #include <common.h>
 #include <console.h>
+#include <div64.h>
 #include <g_dnl.h>
 
 #include <linux/err.h>
@@ -337,6 +338,18 @@ struct fsg_common {
 	u32			residue;
 	u32			usb_amount_left;
 
+	/* Last chunk of a write, written once the status has been sent */
+	struct fsg_buffhd	*pending_bh;
+	unsigned int		pending_lun;
+	loff_t			pending_offset;
+	unsigned int		pending_amount;
+
+	/* Data moved during this session, for the report at the end */
+	u64			bytes_read;
+	u64			bytes_written;
+	ulong			io_start;
+	ulong			io_end;
+
 	unsigned int		can_stall:1;
 	unsigned int		free_storage_on_release:1;
 	unsigned int		phase_error:1;
@@ -697,6 +710,74 @@ static int sleep_thread(struct fsg_common *common)
 	return rc;
 }
 
+static void fsg_account(struct fsg_common *common, u64 *counter,
+			unsigned int bytes)
+{
+	if (!common->bytes_read && !common->bytes_written)
+		common->io_start = get_timer(0);
+	*counter += bytes;
+	common->io_end = get_timer(0);
+}
+
+/*
+ * Write out the deferred last chunk of a WRITE command. A failure is
+ * reported to the host as a deferred error on its next command.
+ */
+static int flush_pending_write(struct fsg_common *common)
+{
+	struct fsg_buffhd	*bh = common->pending_bh;
+	struct fsg_lun		*curlun;
+	unsigned int		lun, count;
+	int			rc;
+
+	if (!bh)
+		return 0;
+	common->pending_bh = NULL;
+	lun = common->pending_lun;
+	curlun = &common->luns[lun];
+	count = common->pending_amount / SECTOR_SIZE;
+
+	rc = ums[lun].write_sector(&ums[lun],
+				   common->pending_offset / SECTOR_SIZE,
+				   count, (char __user *)bh->buf);
+	bh->state = BUF_STATE_EMPTY;
+	if (rc != count) {
+		printf("deferred write of %u sectors failed\n", count);
+		curlun->sense_data = SS_WRITE_ERROR;
+		curlun->sense_data_info = common->pending_offset >> 9;
+		curlun->info_valid = 1;
+		curlun->deferred_error = 1;
+		return -EIO;
+	}
+	fsg_account(common, &common->bytes_written, common->pending_amount);
+
+	return 0;
+}
+
+/* Finish off the session and report how fast data was moved */
+static int fsg_session_end(struct fsg_common *common, int ret)
+{
+	u64 rate;
+	ulong ms;
+
+	flush_pending_write(common);
+	if (!common->bytes_read && !common->bytes_written)
+		return ret;
+
+	/* In hundredths of a MB/s */
+	ms = max(common->io_end - common->io_start, 1UL);
+	rate = lldiv(common->bytes_read + common->bytes_written, ms * 10);
+	puts("\rUMS: read ");
+	print_size(common->bytes_read, ", wrote ");
+	print_size(common->bytes_written, "");
+	printf(" in %lu.%03lu s, %llu.%02llu MB/s\n", ms / 1000, ms % 1000,
+	       lldiv(rate, 100), rate - lldiv(rate, 100) * 100);
+	common->bytes_read = 0;
+	common->bytes_written = 0;
+
+	return ret;
+}
+
 /*-------------------------------------------------------------------------*/
 
 static int do_read(struct fsg_common *common)
@@ -800,6 +881,7 @@ static int do_read(struct fsg_common *common)
 		common->residue -= nread;
 		bh->inreq->length = nread;
 		bh->state = BUF_STATE_FULL;
+		fsg_account(common, &common->bytes_read, nread);
 
 		/* If an error occurred, report it and its position */
 		if (nread < amount) {
@@ -946,6 +1028,28 @@ static int do_write(struct fsg_common *common)
 
 			amount = bh->outreq->actual;
 
+			/*
+			 * Unless the host asked for FUA, leave the last chunk
+			 * for after the status stage so that it overlaps with
+			 * the host sending the next command. Only do so when
+			 * it is the last data the host sends, as any excess is
+			 * thrown away through the same buffers.
+			 */
+			if (amount == amount_left_to_write &&
+			    amount == common->residue &&
+			    amount == bh->outreq->length && !get_some_more &&
+			    (common->cmnd[0] == SC_WRITE_6 ||
+			     !(common->cmnd[1] & 0x08))) {
+				bh->state = BUF_STATE_FULL;
+				common->pending_bh = bh;
+				common->pending_lun = common->lun;
+				common->pending_offset = file_offset;
+				common->pending_amount = amount;
+				amount_left_to_write = 0;
+				common->residue -= amount;
+				break;
+			}
+
 			/* Perform the write */
 			rc = ums[common->lun].write_sector(&ums[common->lun],
 					       file_offset / SECTOR_SIZE,
@@ -972,6 +1076,7 @@ static int do_write(struct fsg_common *common)
 			file_offset += nwritten;
 			amount_left_to_write -= nwritten;
 			common->residue -= nwritten;
+			fsg_account(common, &common->bytes_written, nwritten);
 
 			/* If an error occurred, report it and its position */
 			if (nwritten < amount) {
@@ -1129,7 +1234,7 @@ static int do_request_sense(struct fsg_common *common, struct fsg_buffhd *bh)
 	struct fsg_lun	*curlun = &common->luns[common->lun];
 	u8		*buf = (u8 *) bh->buf;
 	u32		sd, sdinfo;
-	int		valid;
+	int		valid, deferred;
 
 	/*
 	 * From the SCSI-2 spec., section 7.9 (Unit attention condition):
@@ -1158,15 +1263,21 @@ static int do_request_sense(struct fsg_common *common, struct fsg_buffhd *bh)
 		sd = SS_LOGICAL_UNIT_NOT_SUPPORTED;
 		sdinfo = 0;
 		valid = 0;
+		deferred = 0;
 	} else {
 		sd = curlun->sense_data;
+		sdinfo = curlun->sense_data_info;
 		valid = curlun->info_valid << 7;
+		deferred = curlun->deferred_error || curlun->sense_deferred;
 		curlun->sense_data = SS_NO_SENSE;
 		curlun->info_valid = 0;
+		curlun->deferred_error = 0;
+		curlun->sense_deferred = 0;
 	}
 
 	memset(buf, 0, 18);
-	buf[0] = valid | 0x70;			/* Valid, current error */
+	/* Valid, current (0x70) or deferred (0x71) error */
+	buf[0] = valid | (deferred ? 0x71 : 0x70);
 	buf[2] = SK(sd);
 	put_unaligned_be32(sdinfo, &buf[3]);	/* Sense information */
 	buf[7] = 18 - 8;			/* Additional sense length */
@@ -1281,7 +1392,7 @@ static int do_mode_sense(struct fsg_common *common, struct fsg_buffhd *bh)
 	} else {			/* SC_MODE_SENSE_10 */
 		buf[3] = (curlun->ro ? 0x80 : 0x00);		/* WP, DPOFUA */
 		buf += 8;
-		limit = 65535;		/* Should really be FSG_BUFLEN */
+		limit = min_t(u32, 65535, FSG_BUFLEN);
 	}
 
 	/* No block descriptors */
@@ -1579,6 +1690,12 @@ static int finish_reply(struct fsg_common *common)
 	/* We have processed all we want from the data the host has sent.
 	 * There may still be outstanding bulk-out requests. */
 	case DATA_DIR_FROM_HOST:
+		/*
+		 * Write any deferred chunk before its buffer can be reused;
+		 * a failure is reported on the next command.
+		 */
+		if (common->residue)
+			flush_pending_write(common);
 		if (common->residue == 0) {
 			/* Nothing to receive */
 
@@ -1747,7 +1864,18 @@ static int check_command(struct fsg_common *common, int cmnd_size,
 	if (common->lun >= 0 && common->lun < common->nluns) {
 		curlun = &common->luns[common->lun];
 		if (common->cmnd[0] != SC_REQUEST_SENSE) {
+			/*
+			 * Fail this command if a deferred write failed. The
+			 * sense data then describes that write, not this
+			 * command, until it is read.
+			 */
+			if (curlun->deferred_error) {
+				curlun->deferred_error = 0;
+				curlun->sense_deferred = 1;
+				return -EINVAL;
+			}
 			curlun->sense_data = SS_NO_SENSE;
+			curlun->sense_deferred = 0;
 			curlun->info_valid = 0;
 		}
 	} else {
@@ -2129,6 +2257,8 @@ static int get_next_command(struct fsg_common *common)
 
 	/* Wait for the next buffer to become available */
 	bh = common->next_buffhd_to_fill;
+	if (bh == common->pending_bh)
+		flush_pending_write(common);
 	while (bh->state != BUF_STATE_EMPTY) {
 		rc = sleep_thread(common);
 		if (rc)
@@ -2143,6 +2273,9 @@ static int get_next_command(struct fsg_common *common)
 		/* Don't know what to do if common->fsg is NULL */
 		return -EIO;
 
+	/* Write out the end of the last command while the CBW arrives */
+	flush_pending_write(common);
+
 	/* We will drain the buffer in software, which means we
 	 * can reuse it for the next filling.  No need to advance
 	 * next_buffhd_to_fill. */
@@ -2302,6 +2435,9 @@ static void handle_exception(struct fsg_common *common)
 	struct fsg_lun		*curlun;
 	unsigned int		exception_req_tag;
 
+	/* The host has been told the data is written, so write it */
+	flush_pending_write(common);
+
 	/* Cancel all the pending transfers */
 	if (common->fsg) {
 		for (i = 0; i < FSG_NUM_BUFFERS; ++i) {
@@ -2416,14 +2552,14 @@ int fsg_main_thread(void *common_)
 		if (!common->running) {
 			ret = sleep_thread(common);
 			if (ret)
-				return ret;
+				return fsg_session_end(common, ret);
 
 			continue;
 		}
 
 		ret = get_next_command(common);
 		if (ret)
-			return ret;
+			return fsg_session_end(common, ret);
 
 		if (!exception_in_progress(common))
 			common->state = FSG_STATE_DATA_PHASE;
@@ -2508,6 +2644,9 @@ static struct fsg_common *fsg_common_init(struct fsg_common *common,
 	}
 	common->lun = 0;
 
+	/* Partial page handling in do_read() and do_write() needs this */
+	BUILD_BUG_ON(FSG_BUFLEN % PAGE_CACHE_SIZE);
+
 	/* Data buffers cyclic list */
 	bh = common->buffhds;
 
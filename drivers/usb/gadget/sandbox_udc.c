@@ -0,0 +1,370 @@
+/*
+ * Sandbox USB device controller, with an emulated host to talk to it
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ *
+ * This lets gadget functions run on sandbox. Tests play the host: they
+ * queue bulk OUT transfers for the gadget and collect what it sends on its
+ * bulk IN endpoint. Transfers complete in usb_gadget_handle_interrupts(),
+ * which the gadget polls as it would on real hardware.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <asm/test.h>
+#include <linux/errno.h>
+#include <linux/list.h>
+#include <linux/usb/ch9.h>
+#include <linux/usb/gadget.h>
+
+#define SANDBOX_UDC_EPS		3
+#define SANDBOX_UDC_MAX_OUT	8
+#define SANDBOX_UDC_MAXPACKET	512
+
+struct sandbox_udc_ep {
+	struct usb_ep ep;
+	struct list_head queue;
+};
+
+struct sandbox_udc_req {
+	struct usb_request req;
+	struct list_head queue;
+};
+
+/* A bulk OUT transfer sent by the host */
+struct sandbox_udc_xfer {
+	const u8 *buf;
+	int len;
+};
+
+struct sandbox_udc {
+	struct usb_gadget gadget;
+	struct usb_gadget_driver *driver;
+	struct sandbox_udc_ep ep[SANDBOX_UDC_EPS];
+	bool connected;
+
+	/* Host side: OUT transfers waiting for the gadget, oldest first */
+	struct sandbox_udc_xfer out[SANDBOX_UDC_MAX_OUT];
+	int out_count;
+	/* Host side: where bulk IN data goes */
+	u8 *in_buf;
+	int in_size;
+	int in_len;
+};
+
+static struct sandbox_udc controller;
+
+static int sandbox_udc_ep_enable(struct usb_ep *ep,
+				 const struct usb_endpoint_descriptor *desc)
+{
+	return 0;
+}
+
+static void sandbox_udc_complete(struct sandbox_udc_ep *ep,
+				 struct sandbox_udc_req *req, int status)
+{
+	list_del_init(&req->queue);
+	req->req.status = status;
+	if (req->req.complete)
+		req->req.complete(&ep->ep, &req->req);
+}
+
+static void sandbox_udc_flush(struct sandbox_udc_ep *ep, int status)
+{
+	struct sandbox_udc_req *req;
+
+	while (!list_empty(&ep->queue)) {
+		req = list_first_entry(&ep->queue, struct sandbox_udc_req,
+				       queue);
+		sandbox_udc_complete(ep, req, status);
+	}
+}
+
+static int sandbox_udc_ep_disable(struct usb_ep *_ep)
+{
+	struct sandbox_udc_ep *ep = container_of(_ep, struct sandbox_udc_ep,
+						 ep);
+
+	sandbox_udc_flush(ep, -ESHUTDOWN);
+
+	return 0;
+}
+
+static struct usb_request *sandbox_udc_alloc_request(struct usb_ep *ep,
+						     gfp_t gfp_flags)
+{
+	struct sandbox_udc_req *req;
+
+	req = calloc(1, sizeof(*req));
+	if (!req)
+		return NULL;
+	INIT_LIST_HEAD(&req->queue);
+
+	return &req->req;
+}
+
+static void sandbox_udc_free_request(struct usb_ep *ep,
+				     struct usb_request *_req)
+{
+	free(container_of(_req, struct sandbox_udc_req, req));
+}
+
+static int sandbox_udc_queue(struct usb_ep *_ep, struct usb_request *_req,
+			     gfp_t gfp_flags)
+{
+	struct sandbox_udc_ep *ep = container_of(_ep, struct sandbox_udc_ep,
+						 ep);
+	struct sandbox_udc_req *req = container_of(_req, struct sandbox_udc_req,
+						   req);
+
+	if (!list_empty(&req->queue))
+		return -EBUSY;
+	if (!controller.connected)
+		return -ESHUTDOWN;
+	req->req.actual = 0;
+	req->req.status = -EINPROGRESS;
+	list_add_tail(&req->queue, &ep->queue);
+
+	return 0;
+}
+
+static int sandbox_udc_dequeue(struct usb_ep *_ep, struct usb_request *_req)
+{
+	struct sandbox_udc_ep *ep = container_of(_ep, struct sandbox_udc_ep,
+						 ep);
+	struct sandbox_udc_req *req = container_of(_req, struct sandbox_udc_req,
+						   req);
+
+	if (list_empty(&req->queue))
+		return -EINVAL;
+	sandbox_udc_complete(ep, req, -ECONNRESET);
+
+	return 0;
+}
+
+static int sandbox_udc_set_halt(struct usb_ep *ep, int value)
+{
+	return 0;
+}
+
+static struct usb_ep_ops sandbox_udc_ep_ops = {
+	.enable		= sandbox_udc_ep_enable,
+	.disable	= sandbox_udc_ep_disable,
+	.alloc_request	= sandbox_udc_alloc_request,
+	.free_request	= sandbox_udc_free_request,
+	.queue		= sandbox_udc_queue,
+	.dequeue	= sandbox_udc_dequeue,
+	.set_halt	= sandbox_udc_set_halt,
+};
+
+static struct usb_gadget_ops sandbox_udc_gadget_ops = {
+};
+
+static struct sandbox_udc controller = {
+	.gadget = {
+		.name = "sandbox_udc",
+		.ops = &sandbox_udc_gadget_ops,
+		.ep0 = &controller.ep[0].ep,
+		.speed = USB_SPEED_UNKNOWN,
+		.is_dualspeed = 1,
+	},
+	.ep[0] = {
+		.ep = {
+			.name = "ep0",
+			.ops = &sandbox_udc_ep_ops,
+			.maxpacket = 64,
+		},
+	},
+	.ep[1] = {
+		.ep = {
+			.name = "ep1in-bulk",
+			.ops = &sandbox_udc_ep_ops,
+			.maxpacket = SANDBOX_UDC_MAXPACKET,
+		},
+	},
+	.ep[2] = {
+		.ep = {
+			.name = "ep2out-bulk",
+			.ops = &sandbox_udc_ep_ops,
+			.maxpacket = SANDBOX_UDC_MAXPACKET,
+		},
+	},
+};
+
+/* Send IN data to the host, if it has room for it. Data on ep0 is dropped */
+static void sandbox_udc_send(struct sandbox_udc_ep *ep)
+{
+	struct sandbox_udc *udc = &controller;
+	struct sandbox_udc_req *req;
+	int len;
+
+	while (!list_empty(&ep->queue)) {
+		req = list_first_entry(&ep->queue, struct sandbox_udc_req,
+				       queue);
+		len = req->req.length;
+		if (ep != &udc->ep[0]) {
+			if (udc->in_len + len > udc->in_size)
+				return;
+			memcpy(udc->in_buf + udc->in_len, req->req.buf, len);
+			udc->in_len += len;
+		}
+		req->req.actual = len;
+		sandbox_udc_complete(ep, req, 0);
+	}
+}
+
+/*
+ * Receive OUT data from the host. A request completes when it is full, or
+ * when it has the end of a transfer, as a short packet ends it on the bus.
+ */
+static void sandbox_udc_recv(struct sandbox_udc_ep *ep)
+{
+	struct sandbox_udc *udc = &controller;
+	struct sandbox_udc_xfer *xfer = &udc->out[0];
+	struct sandbox_udc_req *req;
+	int len;
+
+	while (!list_empty(&ep->queue) && udc->out_count) {
+		req = list_first_entry(&ep->queue, struct sandbox_udc_req,
+				       queue);
+		len = min(xfer->len, (int)(req->req.length - req->req.actual));
+		memcpy(req->req.buf + req->req.actual, xfer->buf, len);
+		req->req.actual += len;
+		xfer->buf += len;
+		xfer->len -= len;
+		if (!xfer->len) {
+			udc->out_count--;
+			memmove(udc->out, udc->out + 1,
+				udc->out_count * sizeof(*xfer));
+		}
+		sandbox_udc_complete(ep, req, 0);
+	}
+}
+
+int usb_gadget_handle_interrupts(int index)
+{
+	struct sandbox_udc *udc = &controller;
+
+	if (!udc->connected)
+		return 0;
+	sandbox_udc_send(&udc->ep[0]);
+	sandbox_udc_send(&udc->ep[1]);
+	sandbox_udc_recv(&udc->ep[2]);
+
+	return 0;
+}
+
+/*
+ * The host unplugs the cable once it has nothing more to send, so that a
+ * gadget waiting for its next command gives up instead of waiting forever.
+ */
+int g_dnl_board_usb_cable_connected(void)
+{
+	struct sandbox_udc *udc = &controller;
+
+	return udc->connected &&
+	       (udc->out_count || list_empty(&udc->ep[2].queue));
+}
+
+int usb_gadget_register_driver(struct usb_gadget_driver *driver)
+{
+	struct sandbox_udc *udc = &controller;
+	int i, ret;
+
+	if (!driver || !driver->bind || !driver->setup)
+		return -EINVAL;
+	if (udc->driver)
+		return -EBUSY;
+
+	INIT_LIST_HEAD(&udc->gadget.ep_list);
+	for (i = 0; i < SANDBOX_UDC_EPS; i++) {
+		struct sandbox_udc_ep *ep = &udc->ep[i];
+
+		INIT_LIST_HEAD(&ep->queue);
+		ep->ep.driver_data = NULL;
+		if (i)
+			list_add_tail(&ep->ep.ep_list, &udc->gadget.ep_list);
+	}
+
+	ret = driver->bind(&udc->gadget);
+	if (ret)
+		return ret;
+	udc->driver = driver;
+
+	return 0;
+}
+
+int usb_gadget_unregister_driver(struct usb_gadget_driver *driver)
+{
+	struct sandbox_udc *udc = &controller;
+
+	if (!udc->driver || driver != udc->driver)
+		return -EINVAL;
+	sandbox_udc_disconnect();
+	driver->unbind(&udc->gadget);
+	udc->driver = NULL;
+
+	return 0;
+}
+
+int sandbox_udc_connect(void)
+{
+	struct sandbox_udc *udc = &controller;
+	struct usb_ctrlrequest ctrl = {
+		.bRequestType = USB_DIR_OUT | USB_TYPE_STANDARD |
+				USB_RECIP_DEVICE,
+		.bRequest = USB_REQ_SET_CONFIGURATION,
+		.wValue = cpu_to_le16(1),
+	};
+
+	if (!udc->driver)
+		return -ENODEV;
+	udc->connected = true;
+	udc->gadget.speed = USB_SPEED_HIGH;
+	udc->out_count = 0;
+	udc->in_len = 0;
+
+	return udc->driver->setup(&udc->gadget, &ctrl);
+}
+
+void sandbox_udc_disconnect(void)
+{
+	struct sandbox_udc *udc = &controller;
+	int i;
+
+	if (!udc->connected)
+		return;
+	udc->connected = false;
+	for (i = 0; i < SANDBOX_UDC_EPS; i++)
+		sandbox_udc_flush(&udc->ep[i], -ESHUTDOWN);
+	if (udc->driver->disconnect)
+		udc->driver->disconnect(&udc->gadget);
+	udc->gadget.speed = USB_SPEED_UNKNOWN;
+}
+
+int sandbox_udc_host_out(const void *buf, int len)
+{
+	struct sandbox_udc *udc = &controller;
+
+	if (udc->out_count == SANDBOX_UDC_MAX_OUT)
+		return -ENOSPC;
+	udc->out[udc->out_count].buf = buf;
+	udc->out[udc->out_count].len = len;
+	udc->out_count++;
+
+	return 0;
+}
+
+void sandbox_udc_host_in(void *buf, int size)
+{
+	struct sandbox_udc *udc = &controller;
+
+	udc->in_buf = buf;
+	udc->in_size = size;
+	udc->in_len = 0;
+}
+
+int sandbox_udc_host_in_len(void)
+{
+	return controller.in_len;
+}
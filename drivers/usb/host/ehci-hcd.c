@@ -1509,7 +1509,23 @@ static int _ehci_submit_int_msg(struct usb_device *dev, unsigned long pipe,
 	return result;
 }
 
+static int _ehci_get_max_xfer_size(size_t *size)
+{
+	/*
+	 * EHCD can handle any transfer length as long as there is enough
+	 * free heap space left, hence set the theoretical max number here.
+	 */
+	*size = SIZE_MAX;
+
+	return 0;
+}
+
 #ifndef CONFIG_DM_USB
+int usb_get_max_xfer_size(struct usb_device *dev, size_t *size)
+{
+	return _ehci_get_max_xfer_size(size);
+}
+
 int submit_bulk_msg(struct usb_device *dev, unsigned long pipe,
 			    void *buffer, int length)
 {
@@ -1598,13 +1614,7 @@ static int ehci_destroy_int_queue(struct udevice *dev, struct usb_device *udev,
 
 static int ehci_get_max_xfer_size(struct udevice *dev, size_t *size)
 {
-	/*
-	 * EHCD can handle any transfer length as long as there is enough
-	 * free heap space left, hence set the theoretical max number here.
-	 */
-	*size = SIZE_MAX;
-
-	return 0;
+	return _ehci_get_max_xfer_size(size);
 }
 
 int ehci_register(struct udevice *dev, struct ehci_hccr *hccr,
@@ -1257,7 +1257,26 @@ static int xhci_lowlevel_stop(struct xhci_ctrl *ctrl)
 	return 0;
 }
 
+static int _xhci_get_max_xfer_size(size_t *size)
+{
+	/*
+	 * xHCD allocates one segment which includes 64 TRBs for each endpoint
+	 * and the last TRB in this segment is configured as a link TRB to form
+	 * a TRB ring. Each TRB can transfer up to 64K bytes, however data
+	 * buffers referenced by transfer TRBs shall not span 64KB boundaries.
+	 * Hence the maximum number of TRBs we can use in one transfer is 62.
+	 */
+	*size = (TRBS_PER_SEGMENT - 2) * TRB_MAX_BUFF_SIZE;
+
+	return 0;
+}
+
 #ifndef CONFIG_DM_USB
+int usb_get_max_xfer_size(struct usb_device *udev, size_t *size)
+{
+	return _xhci_get_max_xfer_size(size);
+}
+
 int submit_control_msg(struct usb_device *udev, unsigned long pipe,
 		       void *buffer, int length, struct devrequest *setup)
 {
@@ -1459,16 +1478,7 @@ static int xhci_update_hub_device(struct udevice *dev, struct usb_device *udev)
 
 static int xhci_get_max_xfer_size(struct udevice *dev, size_t *size)
 {
-	/*
-	 * xHCD allocates one segment which includes 64 TRBs for each endpoint
-	 * and the last TRB in this segment is configured as a link TRB to form
-	 * a TRB ring. Each TRB can transfer up to 64K bytes, however data
-	 * buffers referenced by transfer TRBs shall not span 64KB boundaries.
-	 * Hence the maximum number of TRBs we can use in one transfer is 62.
-	 */
-	*size = (TRBS_PER_SEGMENT - 2) * TRB_MAX_BUFF_SIZE;
-
-	return 0;
+	return _xhci_get_max_xfer_size(size);
 }
 
 int xhci_register(struct udevice *dev, struct xhci_hccr *hccr,
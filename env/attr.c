@@ -11,6 +11,7 @@
 #include <linux/linux_string.h>
 #else
 #include <common.h>
+#include <search.h>
 #include <slre.h>
 #endif
 
@@ -111,6 +112,9 @@ int env_attr_walk(const char *attr_list,
 }
 
 #if defined(CONFIG_REGEX)
+/* Characters with a meaning to slre; a name without any matches literally */
+#define REGEX_SPECIAL_CHARS	"^$.[]()\\*+?|"
+
 struct regex_callback_priv {
 	const char *searched_for;
 	char *regex;
@@ -123,41 +127,47 @@ static int regex_callback(const char *name, const char *attributes, void *priv)
 	struct regex_callback_priv *cbp = (struct regex_callback_priv *)priv;
 	struct slre slre;
 	char regex[strlen(name) + 3];
+	int match;
 
 	/* Require the whole string to be described by the regex */
 	sprintf(regex, "^%s$", name);
-	if (slre_compile(&slre, regex)) {
+	if (!strpbrk(name, REGEX_SPECIAL_CHARS)) {
+		/* Most names are literal, so don't pay for compiling them */
+		match = !strcmp(name, cbp->searched_for);
+	} else if (slre_compile(&slre, regex)) {
 		struct cap caps[slre.num_caps + 2];
 
-		if (slre_match(&slre, cbp->searched_for,
-			       strlen(cbp->searched_for), caps)) {
-			free(cbp->regex);
-			if (!attributes) {
-				retval = -EINVAL;
-				goto done;
-			}
-			cbp->regex = malloc(strlen(regex) + 1);
-			if (cbp->regex) {
-				strcpy(cbp->regex, regex);
-			} else {
-				retval = -ENOMEM;
-				goto done;
-			}
-
-			free(cbp->attributes);
-			cbp->attributes = malloc(strlen(attributes) + 1);
-			if (cbp->attributes) {
-				strcpy(cbp->attributes, attributes);
-			} else {
-				retval = -ENOMEM;
-				free(cbp->regex);
-				cbp->regex = NULL;
-				goto done;
-			}
-		}
+		match = slre_match(&slre, cbp->searched_for,
+				   strlen(cbp->searched_for), caps);
 	} else {
 		printf("Error compiling regex: %s\n", slre.err_str);
-		retval = -EINVAL;
+		return -EINVAL;
+	}
+
+	if (match) {
+		free(cbp->regex);
+		if (!attributes) {
+			retval = -EINVAL;
+			goto done;
+		}
+		cbp->regex = malloc(strlen(regex) + 1);
+		if (cbp->regex) {
+			strcpy(cbp->regex, regex);
+		} else {
+			retval = -ENOMEM;
+			goto done;
+		}
+
+		free(cbp->attributes);
+		cbp->attributes = malloc(strlen(attributes) + 1);
+		if (cbp->attributes) {
+			strcpy(cbp->attributes, attributes);
+		} else {
+			retval = -ENOMEM;
+			free(cbp->regex);
+			cbp->regex = NULL;
+			goto done;
+		}
 	}
 done:
 	return retval;
@@ -308,3 +318,74 @@ int env_attr_lookup(const char *attr_list, const char *name, char *attributes)
 	return -ENOENT;
 }
 #endif
+
+#ifndef USE_HOSTCC
+struct walk_htab_priv {
+	struct hsearch_data *htab;
+	void (*callback)(ENTRY *entry, const char *attributes);
+};
+
+#if defined(CONFIG_REGEX)
+/* hwalk_r() has no private data, so the element being matched is kept here */
+static struct {
+	struct slre slre;
+	const char *attributes;
+	void (*callback)(ENTRY *entry, const char *attributes);
+} walk_regex;
+
+static int walk_regex_callback(ENTRY *entry)
+{
+	struct cap caps[walk_regex.slre.num_caps + 2];
+
+	if (slre_match(&walk_regex.slre, entry->key, strlen(entry->key), caps))
+		walk_regex.callback(entry, walk_regex.attributes);
+
+	return 0;
+}
+#endif
+
+static int walk_htab_callback(const char *name, const char *attributes,
+	void *priv)
+{
+	struct walk_htab_priv *whp = (struct walk_htab_priv *)priv;
+	ENTRY e, *ep;
+
+#if defined(CONFIG_REGEX)
+	if (strpbrk(name, REGEX_SPECIAL_CHARS)) {
+		char regex[strlen(name) + 3];
+
+		/* Compile once and try every variable in the table */
+		sprintf(regex, "^%s$", name);
+		if (!slre_compile(&walk_regex.slre, regex)) {
+			printf("Error compiling regex: %s\n",
+			       walk_regex.slre.err_str);
+			return -EINVAL;
+		}
+		walk_regex.attributes = attributes;
+		walk_regex.callback = whp->callback;
+
+		return hwalk_r(whp->htab, walk_regex_callback);
+	}
+#endif
+
+	e.key = name;
+	e.data = NULL;
+	e.callback = NULL;
+	hsearch_r(e, FIND, &ep, whp->htab, 0);
+	if (ep)
+		whp->callback(ep, attributes);
+
+	return 0;
+}
+
+int env_attr_walk_htab(const char *attr_list, struct hsearch_data *htab,
+	void (*callback)(ENTRY *entry, const char *attributes))
+{
+	struct walk_htab_priv priv;
+
+	priv.htab = htab;
+	priv.callback = callback;
+
+	return env_attr_walk(attr_list, walk_htab_callback, &priv);
+}
+#endif
@@ -76,6 +76,39 @@ void env_callback_init(ENTRY *var_entry)
 	}
 }
 
+static void init_callback(ENTRY *entry, const char *attributes)
+{
+	struct env_clbk_tbl *clbkp = NULL;
+
+	if (attributes != NULL && strlen(attributes))
+		clbkp = find_env_callback(attributes);
+	if (clbkp == NULL)
+		entry->callback = NULL;
+	else
+#if defined(CONFIG_NEEDS_MANUAL_RELOC)
+		entry->callback = clbkp->callback + gd->reloc_off;
+#else
+		entry->callback = clbkp->callback;
+#endif
+}
+
+/*
+ * Look for callbacks for every variable of a newly populated table
+ * This gives the same result as calling env_callback_init() on each of them
+ * but walks the lists once, with the ".callbacks" var applied last so that
+ * it takes precedence over the static list.
+ */
+void env_callback_init_table(struct hsearch_data *htab)
+{
+	if (first_call) {
+		callback_list = env_get(ENV_CALLBACK_VAR);
+		first_call = 0;
+	}
+
+	env_attr_walk_htab(ENV_CALLBACK_LIST_STATIC, htab, init_callback);
+	env_attr_walk_htab(callback_list, htab, init_callback);
+}
+
 /*
  * Called on each existing env var prior to the blanket update since removing
  * a callback association should remove its callback.
@@ -9,6 +9,7 @@
  */
 
 #include <common.h>
+#include <bootstage.h>
 #include <command.h>
 #include <environment.h>
 #include <linux/stddef.h>
@@ -61,7 +62,9 @@ char *env_get_default(const char *name)
 
 void set_default_env(const char *s)
 {
+	enum malloc_tag old_tag;
 	int flags = 0;
+	int ret;
 
 	if (sizeof(default_environment) > ENV_SIZE) {
 		puts("*** Error - default environment is too large\n\n");
@@ -81,9 +84,17 @@ void set_default_env(const char *s)
 		puts("Using default environment\n\n");
 	}
 
-	if (himport_r(&env_htab, (char *)default_environment,
-			sizeof(default_environment), '\0', flags, 0,
-			0, NULL) == 0)
+	old_tag = malloc_set_tag(MALLOC_TAG_ENV);
+	bootstage_start(BOOTSTAGE_ID_ACCUM_ENV, "env_default");
+#if CONFIG_IS_ENABLED(ENV_DEFAULT_HASHED)
+	ret = himport_prebuilt_r(&env_htab, &env_default_hashed, flags);
+#else
+	ret = himport_r(&env_htab, (char *)default_environment,
+			sizeof(default_environment), '\0', flags, 0, 0, NULL);
+#endif
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_ENV);
+	malloc_set_tag(old_tag);
+	if (ret == 0)
 		pr_err("Environment import failed: errno = %d\n", errno);
 
 	gd->flags |= GD_FLG_ENV_READY;
@@ -94,13 +105,20 @@ void set_default_env(const char *s)
 /* [re]set individual variables to their value in the default environment */
 int set_default_vars(int nvars, char * const vars[])
 {
+	enum malloc_tag old_tag;
+	int ret;
+
 	/*
 	 * Special use-case: import from default environment
 	 * (and use \0 as a separator)
 	 */
-	return himport_r(&env_htab, (const char *)default_environment,
-				sizeof(default_environment), '\0',
-				H_NOCLEAR | H_INTERACTIVE, 0, nvars, vars);
+	old_tag = malloc_set_tag(MALLOC_TAG_ENV);
+	ret = himport_r(&env_htab, (const char *)default_environment,
+			sizeof(default_environment), '\0',
+			H_NOCLEAR | H_INTERACTIVE, 0, nvars, vars);
+	malloc_set_tag(old_tag);
+
+	return ret;
 }
 
 /*
@@ -110,6 +128,8 @@ int set_default_vars(int nvars, char * const vars[])
 int env_import(const char *buf, int check)
 {
 	env_t *ep = (env_t *)buf;
+	enum malloc_tag old_tag;
+	int ret;
 
 	if (check) {
 		uint32_t crc;
@@ -122,8 +142,11 @@ int env_import(const char *buf, int check)
 		}
 	}
 
-	if (himport_r(&env_htab, (char *)ep->data, ENV_SIZE, '\0', 0, 0,
-			0, NULL)) {
+	old_tag = malloc_set_tag(MALLOC_TAG_ENV);
+	ret = himport_r(&env_htab, (char *)ep->data, ENV_SIZE, '\0', 0, 0, 0,
+			NULL);
+	malloc_set_tag(old_tag);
+	if (ret) {
 		gd->flags |= GD_FLG_ENV_READY;
 		return 1;
 	}
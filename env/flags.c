@@ -437,6 +437,30 @@ void env_flags_init(ENTRY *var_entry)
 		var_entry->flags = env_parse_flags_to_bin(flags);
 }
 
+static void init_flags(ENTRY *entry, const char *attributes)
+{
+	if (attributes == NULL || strlen(attributes) == 0)
+		entry->flags = 0;
+	else
+		entry->flags = env_parse_flags_to_bin(attributes);
+}
+
+/*
+ * Look for flags for every variable of a newly populated table
+ * As env_callback_init_table(), the ".flags" var is applied after the static
+ * list so that it takes precedence.
+ */
+void env_flags_init_table(struct hsearch_data *htab)
+{
+	if (first_call) {
+		flags_list = env_get(ENV_FLAGS_VAR);
+		first_call = 0;
+	}
+
+	env_attr_walk_htab(ENV_FLAGS_LIST_STATIC, htab, init_flags);
+	env_attr_walk_htab(flags_list, htab, init_flags);
+}
+
 /*
  * Called on each existing env var prior to the blanket update since removing
  * a flag in the flag list should remove its flags.
@@ -0,0 +1,289 @@
+/*
+ * Lay out the default environment as a ready-made hash table
+ *
+ * This runs on the build host. It parses default_environment[] the way
+ * himport_r() does and places each variable in the slot that hsearch_r()
+ * would pick in a freshly created table, then writes the result as C source
+ * for himport_prebuilt_r(). The parsing, table size and probing here must
+ * match lib/hashtable.c.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+/* Pull in the current config to define the default environment */
+#include <linux/kconfig.h>
+
+#ifndef __ASSEMBLY__
+#define __ASSEMBLY__ /* get only #defines from config.h */
+#include <config.h>
+#undef	__ASSEMBLY__
+#else
+#include <config.h>
+#endif
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <linux/stringify.h>
+
+#define DEFAULT_ENV_INSTANCE_STATIC
+#include <env_default.h>
+
+#ifndef	CONFIG_ENV_MIN_ENTRIES	/* minimum number of entries */
+#define	CONFIG_ENV_MIN_ENTRIES 64
+#endif
+#ifndef	CONFIG_ENV_MAX_ENTRIES	/* maximum number of entries */
+#define	CONFIG_ENV_MAX_ENTRIES 512
+#endif
+
+struct slot {
+	int used;
+	unsigned int order;	/* when the slot was last filled */
+	const char *key;
+	const char *data;
+};
+
+static struct slot *table;
+static unsigned int table_size;
+static unsigned int filled;
+static unsigned int next_order;
+
+static void fail(const char *msg, const char *name)
+{
+	fprintf(stderr, "gen_envhash: %s: %s\n", msg, name);
+	exit(1);
+}
+
+static int isprime(unsigned int number)
+{
+	unsigned int div = 3;
+
+	while (div * div < number && number % div != 0)
+		div += 2;
+
+	return number % div != 0;
+}
+
+/* As hcreate_r() */
+static void create(size_t nel)
+{
+	nel |= 1;
+	while (!isprime(nel))
+		nel += 2;
+
+	table_size = nel;
+	table = calloc(table_size + 1, sizeof(*table));
+	if (!table)
+		fail("out of memory", "table");
+}
+
+/* As hsearch_r(), returning the slot found or (if @enter) created */
+static struct slot *search(const char *key, int enter)
+{
+	unsigned int len = strlen(key);
+	unsigned int hval, hval2, count, idx;
+	unsigned int first_deleted = 0;
+
+	/*
+	 * The target may not agree with the host on whether char is signed,
+	 * so keep to keys where it makes no difference to the hash
+	 */
+	for (count = 0; count < len; count++) {
+		if (key[count] & 0x80)
+			fail("variable name is not ASCII", key);
+	}
+
+	hval = len;
+	count = len;
+	while (count-- > 0) {
+		hval <<= 4;
+		hval += key[count];
+	}
+
+	hval %= table_size;
+	if (hval == 0)
+		++hval;
+	idx = hval;
+
+	if (table[idx].used) {
+		if (table[idx].used == -1 && !first_deleted)
+			first_deleted = idx;
+		if (table[idx].used == hval && !strcmp(key, table[idx].key))
+			return &table[idx];
+
+		hval2 = 1 + hval % (table_size - 2);
+		do {
+			if (idx <= hval2)
+				idx = table_size + idx - hval2;
+			else
+				idx -= hval2;
+			if (idx == hval)
+				break;
+			if (table[idx].used == hval &&
+			    !strcmp(key, table[idx].key))
+				return &table[idx];
+		} while (table[idx].used);
+	}
+
+	if (!enter)
+		return NULL;
+	if (filled == table_size)
+		fail("hash table full", key);
+	if (first_deleted)
+		idx = first_deleted;
+
+	table[idx].used = hval;
+	table[idx].order = next_order++;
+	table[idx].key = key;
+	table[idx].data = NULL;
+	filled++;
+
+	return &table[idx];
+}
+
+/* As himport_r() with sep == '\0' and an empty table */
+static void import(char *data, size_t size)
+{
+	char *sp, *dp = data, *name, *value;
+	struct slot *slot;
+	int nent;
+
+	nent = CONFIG_ENV_MIN_ENTRIES + size / 8;
+	if (nent > CONFIG_ENV_MAX_ENTRIES)
+		nent = CONFIG_ENV_MAX_ENTRIES;
+	create(nent);
+
+	if (!size)
+		return;
+	do {
+		while (isblank(*dp))
+			++dp;
+
+		if (*dp == '#') {
+			while (*dp)
+				++dp;
+			++dp;
+			continue;
+		}
+
+		for (name = dp; *dp != '=' && *dp; ++dp)
+			;
+
+		/* "name" and "name=" delete the variable */
+		if (*dp == '\0' || *(dp + 1) == '\0') {
+			if (*dp == '=')
+				*dp++ = '\0';
+			*dp++ = '\0';
+
+			slot = search(name, 0);
+			if (slot) {
+				slot->used = -1;
+				slot->key = NULL;
+				slot->data = NULL;
+				filled--;
+			}
+			continue;
+		}
+		*dp++ = '\0';
+
+		for (value = sp = dp; *dp; ++dp) {
+			if ((*dp == '\\') && *(dp + 1))
+				++dp;
+			*sp++ = *dp;
+		}
+		*sp++ = '\0';
+		++dp;
+
+		if (*name == 0)
+			fail("empty variable name", value);
+
+		slot = search(name, 1);
+		slot->data = value;
+	} while ((dp < data + size) && *dp);
+}
+
+static void print_string(const char *str)
+{
+	const unsigned char *p;
+
+	putchar('"');
+	for (p = (const unsigned char *)str; *p; p++) {
+		if (*p == '"' || *p == '\\' || *p == '?')
+			printf("\\%c", *p);
+		else if (isprint(*p))
+			putchar(*p);
+		else
+			printf("\\%03o", *p);
+	}
+	printf("\\0\"\n");
+}
+
+static int cmp_order(const void *p1, const void *p2)
+{
+	const struct slot *s1 = *(const struct slot **)p1;
+	const struct slot *s2 = *(const struct slot **)p2;
+
+	/* Live slots in creation order, then deleted ones */
+	if ((s1->used < 0) != (s2->used < 0))
+		return s1->used < 0 ? 1 : -1;
+
+	return s1->order < s2->order ? -1 : s1->order > s2->order;
+}
+
+int main(void)
+{
+	struct slot **list;
+	unsigned int i, count, offset;
+
+	import(default_environment, sizeof(default_environment));
+
+	list = calloc(table_size, sizeof(*list));
+	if (!list)
+		fail("out of memory", "list");
+	for (i = 1, count = 0; i <= table_size; i++) {
+		if (table[i].used)
+			list[count++] = &table[i];
+	}
+	qsort(list, count, sizeof(*list), cmp_order);
+
+	printf("/* Generated by gen_envhash from the default environment */\n\n");
+	printf("#include <common.h>\n");
+	printf("#include <environment.h>\n\n");
+
+	printf("static const char strings[] =\n");
+	for (i = 0; i < count; i++) {
+		if (list[i]->used < 0)
+			continue;
+		printf("\t");
+		print_string(list[i]->key);
+		printf("\t");
+		print_string(list[i]->data);
+	}
+	printf("\t\"\";\n\n");
+
+	printf("static const struct hprebuilt_entry entries[] = {\n");
+	for (i = 0, offset = 0; i < count; i++) {
+		struct slot *slot = list[i];
+		unsigned int key = 0, data = 0;
+
+		if (slot->used >= 0) {
+			key = offset;
+			data = key + strlen(slot->key) + 1;
+			offset = data + strlen(slot->data) + 1;
+		}
+		printf("\t{ %u, %d, %u, %u },\n", (unsigned int)(slot - table),
+		       slot->used, key, data);
+	}
+	printf("};\n\n");
+
+	printf("const struct hprebuilt env_default_hashed = {\n");
+	printf("\t.size\t\t= %u,\n", table_size);
+	printf("\t.count\t\t= ARRAY_SIZE(entries),\n");
+	printf("\t.entries\t= entries,\n");
+	printf("\t.strings\t= strings,\n");
+	printf("\t.strings_size\t= sizeof(strings),\n");
+	printf("};\n");
+
+	return 0;
+}
@@ -75,6 +75,39 @@ static int readdir_callback(const struct btrfs_root *root,
 	return 0;
 }
 
+/*
+ * The filesystem is probed again for every command. Cached tree nodes and
+ * extents are kept from one probe to the next as long as it is the same
+ * filesystem, at the same place and unchanged since, which its generation
+ * tells.
+ */
+static struct {
+	struct blk_desc *desc;
+	lbaint_t start;
+	u8 fsid[BTRFS_FSID_SIZE];
+	u64 generation;
+} cached_fs;
+
+static void btrfs_check_caches(bool valid)
+{
+	if (valid && cached_fs.desc == btrfs_blk_desc &&
+	    cached_fs.start == btrfs_part_info->start &&
+	    !memcmp(cached_fs.fsid, btrfs_info.sb.fsid, BTRFS_FSID_SIZE) &&
+	    cached_fs.generation == btrfs_info.sb.generation)
+		return;
+
+	btrfs_tree_node_cache_drop();
+	btrfs_extent_cache_drop();
+
+	memset(&cached_fs, 0, sizeof(cached_fs));
+	if (valid) {
+		cached_fs.desc = btrfs_blk_desc;
+		cached_fs.start = btrfs_part_info->start;
+		memcpy(cached_fs.fsid, btrfs_info.sb.fsid, BTRFS_FSID_SIZE);
+		cached_fs.generation = btrfs_info.sb.generation;
+	}
+}
+
 int btrfs_probe(struct blk_desc *fs_dev_desc, disk_partition_t *fs_partition)
 {
 	btrfs_blk_desc = fs_dev_desc;
@@ -83,8 +116,11 @@ int btrfs_probe(struct blk_desc *fs_dev_desc, disk_partition_t *fs_partition)
 	memset(&btrfs_info, 0, sizeof(btrfs_info));
 
 	btrfs_hash_init();
-	if (btrfs_read_superblock())
+	if (btrfs_read_superblock()) {
+		btrfs_check_caches(false);
 		return -1;
+	}
+	btrfs_check_caches(true);
 
 	if (btrfs_chunk_map_init()) {
 		printf("%s: failed to init chunk map\n", __func__);
@@ -159,12 +195,12 @@ int btrfs_size(const char *file, loff_t *size)
 
 	if (inr == -1ULL) {
 		printf("Cannot lookup file %s\n", file);
-		return 1;
+		return -1;
 	}
 
 	if (type != BTRFS_FT_REG_FILE) {
 		printf("Not a regular file: %s\n", file);
-		return 1;
+		return -1;
 	}
 
 	*size = inode.size;
@@ -184,12 +220,12 @@ int btrfs_read(const char *file, void *buf, loff_t offset, loff_t len,
 
 	if (inr == -1ULL) {
 		printf("Cannot lookup file %s\n", file);
-		return 1;
+		return -1;
 	}
 
 	if (type != BTRFS_FT_REG_FILE) {
 		printf("Not a regular file: %s\n", file);
-		return 1;
+		return -1;
 	}
 
 	if (!len)
@@ -201,7 +237,7 @@ int btrfs_read(const char *file, void *buf, loff_t offset, loff_t len,
 	rd = btrfs_file_read(&root, inr, offset, len, buf);
 	if (rd == -1ULL) {
 		printf("An error occured while reading file %s\n", file);
-		return 1;
+		return -1;
 	}
 
 	*actread = rd;
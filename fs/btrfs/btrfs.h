@@ -48,6 +48,9 @@ int btrfs_chunk_map_init(void);
 void btrfs_chunk_map_exit(void);
 int btrfs_read_chunk_tree(void);
 
+/* ctree.c */
+void btrfs_tree_node_cache_drop(void);
+
 /* compression.c */
 u32 btrfs_decompress(u8 type, const char *, u32, char *, u32);
 
@@ -80,6 +83,7 @@ u64 btrfs_file_read(const struct btrfs_root *, u64, u64, u64, char *);
 u64 btrfs_get_default_subvol_objectid(void);
 
 /* extent-io.c */
+void btrfs_extent_cache_drop(void);
 u64 btrfs_read_extent_inline(struct btrfs_path *,
 			      struct btrfs_file_extent_item *, u64, u64,
 			      char *);
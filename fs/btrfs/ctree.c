@@ -8,6 +8,7 @@
 
 #include "btrfs.h"
 #include <malloc.h>
+#include <linux/list.h>
 
 int btrfs_comp_keys(struct btrfs_key *a, struct btrfs_key *b)
 {
@@ -114,44 +115,184 @@ void btrfs_free_path(struct btrfs_path *p)
 	clear_path(p);
 }
 
-static int read_tree_node(u64 physical, union btrfs_tree_node **buf)
+/*
+ * Tree nodes read recently are kept, converted to CPU byte order, keyed by
+ * their logical address. Searches start from the same roots and interior
+ * nodes over and over, so these are mostly found here. Each path still
+ * gets its own copy of a node, as callers convert leaf items in place.
+ * The nodes are kept across mounts of the same, unchanged filesystem, see
+ * btrfs_probe().
+ */
+struct tree_node_cache_item {
+	struct rb_node node;
+	struct list_head lru;
+	u64 logical;
+	unsigned long size;
+	union btrfs_tree_node *buf;
+};
+
+static struct rb_root tree_nodes = RB_ROOT;
+static LIST_HEAD(tree_nodes_lru);
+static unsigned int tree_nodes_count;
+
+static struct tree_node_cache_item *tree_node_cache_find(u64 logical)
+{
+	struct rb_node *node = tree_nodes.rb_node;
+
+	while (node) {
+		struct tree_node_cache_item *item;
+
+		item = rb_entry(node, struct tree_node_cache_item, node);
+
+		if (logical < item->logical)
+			node = node->rb_left;
+		else if (logical > item->logical)
+			node = node->rb_right;
+		else
+			return item;
+	}
+
+	return NULL;
+}
+
+static void tree_node_cache_remove(struct tree_node_cache_item *item)
+{
+	rb_erase(&item->node, &tree_nodes);
+	list_del(&item->lru);
+	tree_nodes_count--;
+	free(item);
+}
+
+static void tree_node_cache_insert(struct tree_node_cache_item *item)
 {
-	struct btrfs_header hdr;
-	unsigned long size, offset = sizeof(hdr);
+	struct list_head *lru = &tree_nodes_lru;
+	struct rb_node **new, *prnt = NULL;
+
+	/* Make room by dropping the least recently used node */
+	if (tree_nodes_count >= CONFIG_BTRFS_TREE_NODE_CACHE)
+		tree_node_cache_remove(list_last_entry(lru,
+				struct tree_node_cache_item, lru));
+
+	new = &tree_nodes.rb_node;
+	while (*new) {
+		struct tree_node_cache_item *this;
+
+		this = rb_entry(*new, struct tree_node_cache_item, node);
+
+		prnt = *new;
+		if (item->logical < this->logical)
+			new = &((*new)->rb_left);
+		else
+			new = &((*new)->rb_right);
+	}
+
+	rb_link_node(&item->node, prnt, new);
+	rb_insert_color(&item->node, &tree_nodes);
+	list_add(&item->lru, lru);
+	tree_nodes_count++;
+}
+
+void btrfs_tree_node_cache_drop(void)
+{
+	struct tree_node_cache_item *item, *tmp;
+
+	list_for_each_entry_safe(item, tmp, &tree_nodes_lru, lru)
+		free(item);
+	tree_nodes = RB_ROOT;
+	INIT_LIST_HEAD(&tree_nodes_lru);
+	tree_nodes_count = 0;
+}
+
+/* Read a whole tree node with one device read and convert it */
+static struct tree_node_cache_item *read_tree_node_uncached(u64 logical)
+{
+	u32 nodesize = btrfs_info.sb.nodesize;
+	struct tree_node_cache_item *item, *tmp;
 	union btrfs_tree_node *res;
+	unsigned long size;
+	u64 physical;
 	u32 i;
 
-	if (!btrfs_devread(physical, sizeof(hdr), &hdr))
-		return -1;
+	physical = btrfs_map_logical_to_physical(logical);
+	if (physical == -1ULL)
+		return NULL;
 
-	btrfs_header_to_cpu(&hdr);
+	item = malloc(sizeof(*item) + nodesize);
+	if (!item) {
+		debug("%s: malloc failed\n", __func__);
+		return NULL;
+	}
+	res = (union btrfs_tree_node *)(item + 1);
 
-	if (hdr.level)
-		size = sizeof(struct btrfs_node)
-		       + hdr.nritems * sizeof(struct btrfs_key_ptr);
-	else
-		size = btrfs_info.sb.nodesize;
+	if (!btrfs_devread(physical, nodesize, res))
+		goto err;
 
-	res = malloc(size);
-	if (!res) {
-		debug("%s: malloc failed\n", __func__);
-		return -1;
+	btrfs_header_to_cpu(&res->header);
+	if (res->header.bytenr != logical) {
+		printf("%s: tree block at %llu claims to be at %llu\n",
+		       __func__, logical, res->header.bytenr);
+		goto err;
 	}
 
-	if (!btrfs_devread(physical + offset, size - offset,
-			   ((u8 *) res) + offset)) {
-		free(res);
-		return -1;
+	if (res->header.level)
+		size = sizeof(struct btrfs_node)
+		       + res->header.nritems * sizeof(struct btrfs_key_ptr);
+	else
+		size = sizeof(struct btrfs_leaf)
+		       + res->header.nritems * sizeof(struct btrfs_item);
+	if (size > nodesize) {
+		printf("%s: too many items in tree block at %llu\n",
+		       __func__, logical);
+		goto err;
 	}
 
-	res->header = hdr;
-	if (hdr.level)
-		for (i = 0; i < hdr.nritems; ++i)
+	if (res->header.level) {
+		for (i = 0; i < res->header.nritems; ++i)
 			btrfs_key_ptr_to_cpu(&res->node.ptrs[i]);
-	else
-		for (i = 0; i < hdr.nritems; ++i)
+
+		/* Nodes hold no item data, so keep only the pointers */
+		tmp = realloc(item, sizeof(*item) + size);
+		if (tmp)
+			item = tmp;
+		else
+			size = nodesize;
+	} else {
+		for (i = 0; i < res->header.nritems; ++i)
 			btrfs_item_to_cpu(&res->leaf.items[i]);
+		size = nodesize;
+	}
 
+	item->logical = logical;
+	item->size = size;
+	item->buf = (union btrfs_tree_node *)(item + 1);
+
+	return item;
+err:
+	free(item);
+	return NULL;
+}
+
+static int read_tree_node(u64 logical, union btrfs_tree_node **buf)
+{
+	struct tree_node_cache_item *item;
+	union btrfs_tree_node *res;
+
+	item = tree_node_cache_find(logical);
+	if (item) {
+		list_move(&item->lru, &tree_nodes_lru);
+	} else {
+		item = read_tree_node_uncached(logical);
+		if (!item)
+			return -1;
+		tree_node_cache_insert(item);
+	}
+
+	res = malloc(item->size);
+	if (!res) {
+		debug("%s: malloc failed\n", __func__);
+		return -1;
+	}
+	memcpy(res, item->buf, item->size);
 	*buf = res;
 
 	return 0;
@@ -162,7 +303,7 @@ int btrfs_search_tree(const struct btrfs_root *root, struct btrfs_key *key,
 {
 	u8 lvl, prev_lvl;
 	int i, slot, ret;
-	u64 logical, physical;
+	u64 logical;
 	union btrfs_tree_node *buf;
 
 	clear_path(p);
@@ -170,11 +311,7 @@ int btrfs_search_tree(const struct btrfs_root *root, struct btrfs_key *key,
 	logical = root->bytenr;
 
 	for (i = 0; i < BTRFS_MAX_LEVEL; ++i) {
-		physical = btrfs_map_logical_to_physical(logical);
-		if (physical == -1ULL)
-			goto err;
-
-		if (read_tree_node(physical, &buf))
+		if (read_tree_node(logical, &buf))
 			goto err;
 
 		lvl = buf->header.level;
@@ -236,15 +373,11 @@ static int jump_leaf(struct btrfs_path *path, int dir)
 	from_level = level;
 
 	while (level >= 0) {
-		u64 logical, physical;
+		u64 logical;
 
 		slot = p.slots[level + 1];
 		logical = p.nodes[level + 1]->node.ptrs[slot].blockptr;
-		physical = btrfs_map_logical_to_physical(logical);
-		if (physical == -1ULL)
-			goto err;
-
-		if (read_tree_node(physical, &p.nodes[level]))
+		if (read_tree_node(logical, &p.nodes[level]))
 			goto err;
 
 		if (dir > 0)
@@ -281,7 +414,7 @@ int btrfs_next_slot(struct btrfs_path *p)
 {
 	struct btrfs_leaf *leaf = &p->nodes[0]->leaf;
 
-	if (p->slots[0] >= leaf->header.nritems)
+	if (p->slots[0] + 1 >= leaf->header.nritems)
 		return jump_leaf(p, 1);
 
 	p->slots[0]++;
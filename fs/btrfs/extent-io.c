@@ -61,15 +61,101 @@ err:
 	return -1ULL;
 }
 
+/*
+ * Compressed extents can only be decompressed as a whole. Reads wanting
+ * part of one, such as a file loaded in pieces, would decompress the same
+ * extent over and over, so the most recently used ones are kept, most
+ * recent first, keyed by the logical address of the compressed data. Like
+ * tree nodes, they are kept across mounts of the same, unchanged
+ * filesystem.
+ */
+struct extent_cache_entry {
+	u64 bytenr;
+	u32 len;
+	char *data;
+};
+
+static struct extent_cache_entry extent_cache[CONFIG_BTRFS_EXTENT_CACHE];
+
+void btrfs_extent_cache_drop(void)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(extent_cache); ++i)
+		free(extent_cache[i].data);
+	memset(extent_cache, 0, sizeof(extent_cache));
+}
+
+/* Read and decompress a whole extent, of extent->ram_bytes bytes */
+static int read_compressed_extent(struct btrfs_file_extent_item *extent,
+				  u64 physical, char *dbuf)
+{
+	u32 clen = extent->disk_num_bytes, dlen = extent->ram_bytes, res;
+	char *cbuf;
+
+	cbuf = malloc(clen);
+	if (!cbuf)
+		return -1;
+
+	if (!btrfs_devread(physical, clen, cbuf)) {
+		free(cbuf);
+		return -1;
+	}
+
+	res = btrfs_decompress(extent->compression, cbuf, clen, dbuf, dlen);
+	free(cbuf);
+	if (res == -1)
+		return -1;
+
+	/* Data past what was compressed reads as zeroes */
+	if (res < dlen)
+		memset(dbuf + res, 0, dlen - res);
+
+	return 0;
+}
+
+/* Get the decompressed contents of an extent, from the cache if possible */
+static const char *get_compressed_extent(struct btrfs_file_extent_item *extent,
+					 u64 physical)
+{
+	struct extent_cache_entry entry;
+	int i, last = ARRAY_SIZE(extent_cache) - 1;
+
+	for (i = 0; i < last; ++i) {
+		if (extent_cache[i].bytenr == extent->disk_bytenr &&
+		    extent_cache[i].len == extent->ram_bytes)
+			break;
+	}
+
+	entry = extent_cache[i];
+	if (entry.bytenr != extent->disk_bytenr ||
+	    entry.len != extent->ram_bytes) {
+		/* Not cached, so reuse the least recently used entry */
+		free(entry.data);
+		entry.bytenr = extent->disk_bytenr;
+		entry.len = extent->ram_bytes;
+		entry.data = malloc(entry.len);
+		if (!entry.data ||
+		    read_compressed_extent(extent, physical, entry.data)) {
+			free(entry.data);
+			memset(&extent_cache[i], 0, sizeof(entry));
+			return NULL;
+		}
+	}
+
+	memmove(&extent_cache[1], &extent_cache[0], i * sizeof(entry));
+	extent_cache[0] = entry;
+
+	return entry.data;
+}
+
 u64 btrfs_read_extent_reg(struct btrfs_path *path,
 			  struct btrfs_file_extent_item *extent, u64 offset,
 			  u64 size, char *out)
 {
-	u64 physical, clen, dlen, orig_size = size;
-	u32 res;
-	char *cbuf, *dbuf;
+	u64 physical, dlen, orig_size = size;
+	const char *dbuf;
 
-	clen = extent->disk_num_bytes;
 	dlen = extent->num_bytes;
 
 	if (offset > dlen)
@@ -90,31 +176,25 @@ u64 btrfs_read_extent_reg(struct btrfs_path *path,
 		return size;
 	}
 
-	cbuf = malloc(dlen > size ? clen + dlen : clen);
-	if (!cbuf)
-		return -1ULL;
+	/* The file's data starts extent->offset bytes into the extent */
+	offset += extent->offset;
 
-	if (dlen > orig_size)
-		dbuf = cbuf + clen;
-	else
-		dbuf = out;
+	/* Decompress straight into the buffer if it can take all of it */
+	if (!offset && extent->ram_bytes <= orig_size) {
+		if (read_compressed_extent(extent, physical, out))
+			return -1ULL;
 
-	if (!btrfs_devread(physical, clen, cbuf))
-		goto err;
+		return size;
+	}
 
-	res = btrfs_decompress(extent->compression, cbuf, clen, dbuf, dlen);
-	if (res == -1)
-		goto err;
+	if (offset + size > extent->ram_bytes)
+		return -1ULL;
 
-	if (dlen > orig_size)
-		memcpy(out, dbuf + offset, size);
-	else
-		memmove(out, dbuf + offset, size);
+	dbuf = get_compressed_extent(extent, physical);
+	if (!dbuf)
+		return -1ULL;
 
-	free(cbuf);
-	return res;
+	memcpy(out, dbuf + offset, size);
 
-err:
-	free(cbuf);
-	return -1ULL;
+	return size;
 }
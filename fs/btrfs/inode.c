@@ -333,7 +333,9 @@ u64 btrfs_file_read(const struct btrfs_root *root, u64 inr, u64 offset,
 	if (btrfs_search_tree(root, &key, &path))
 		return -1ULL;
 
-	if (btrfs_comp_keys(&key, btrfs_path_leaf_key(&path)) < 0) {
+	/* The search may end past the last item of a leaf */
+	if (path.slots[0] >= path.nodes[0]->leaf.header.nritems ||
+	    btrfs_comp_keys(&key, btrfs_path_leaf_key(&path)) < 0) {
 		if (btrfs_prev_slot(&path))
 			goto out;
 
@@ -341,6 +343,8 @@ u64 btrfs_file_read(const struct btrfs_root *root, u64 inr, u64 offset,
 			goto out;
 	}
 
+	/* The first extent is read from where offset falls within it */
+	offset -= btrfs_path_leaf_key(&path)->offset;
 	rd_all = 0;
 
 	do {
@@ -2005,13 +2005,349 @@ void ext4fs_close(void)
 	ext4fs_reinit_global();
 }
 
+/*
+ * Read block @blk of directory @dir into @buf, which has room for one
+ * filesystem block. Returns the number of bytes read, or -1 on error.
+ */
+static int ext4fs_read_dir_block(struct ext2fs_node *dir, uint32_t blk,
+				 char *buf)
+{
+	int blksz = EXT2_BLOCK_SIZE(dir->data);
+	loff_t actread;
+
+	if (ext4fs_read_file(dir, (loff_t)blk * blksz, blksz, buf,
+			     &actread) < 0)
+		return -1;
+
+	return actread;
+}
+
+/* Get the FILETYPE_... of an entry, reading its inode if necessary */
+static int ext4fs_dirent_type(struct ext2fs_node *node,
+			      const struct ext2_dirent *dirent)
+{
+	uint16_t mode;
+
+	switch (dirent->filetype) {
+	case FILETYPE_DIRECTORY:
+	case FILETYPE_SYMLINK:
+	case FILETYPE_REG:
+		return dirent->filetype;
+	case FILETYPE_UNKNOWN:
+		break;
+	default:
+		return FILETYPE_UNKNOWN;
+	}
+
+	if (!node->inode_read) {
+		if (!ext4fs_read_inode(node->data, node->ino, &node->inode))
+			return -1;
+		node->inode_read = 1;
+	}
+	mode = le16_to_cpu(node->inode.mode) & FILETYPE_INO_MASK;
+	if (mode == FILETYPE_INO_DIRECTORY)
+		return FILETYPE_DIRECTORY;
+	if (mode == FILETYPE_INO_SYMLINK)
+		return FILETYPE_SYMLINK;
+	if (mode == FILETYPE_INO_REG)
+		return FILETYPE_REG;
+
+	return FILETYPE_UNKNOWN;
+}
+
+/* Print one entry as 'ls' does */
+static int ext4fs_list_dirent(struct ext2fs_node *diro,
+			      const struct ext2_dirent *dirent)
+{
+	const char *filename = (const char *)(dirent + 1);
+	struct ext2fs_node node = {
+		.data = diro->data,
+		.ino = le32_to_cpu(dirent->inode),
+	};
+	int type;
+
+	if (!ext4fs_read_inode(node.data, node.ino, &node.inode))
+		return -1;
+	node.inode_read = 1;
+	type = ext4fs_dirent_type(&node, dirent);
+
+	switch (type) {
+	case FILETYPE_DIRECTORY:
+		printf("<DIR> ");
+		break;
+	case FILETYPE_SYMLINK:
+		printf("<SYM> ");
+		break;
+	case FILETYPE_REG:
+		printf("      ");
+		break;
+	default:
+		printf("< ? > ");
+		break;
+	}
+	printf("%10u %.*s\n", le32_to_cpu(node.inode.size), dirent->namelen,
+	       filename);
+
+	return 0;
+}
+
+/*
+ * Go through the entries of one directory block held in @buf, looking for
+ * @name or, if it is NULL, listing them all. Returns 1 if @name was found,
+ * 0 if not and -1 on error.
+ */
+static int ext4fs_iterate_dir_block(struct ext2fs_node *diro, const char *buf,
+				    unsigned int len, char *name,
+				    struct ext2fs_node **fnode, int *ftype)
+{
+	unsigned int namelen = name ? strlen(name) : 0;
+	unsigned int pos, direntlen;
+
+	for (pos = 0; pos + sizeof(struct ext2_dirent) <= len;
+	     pos += direntlen) {
+		const struct ext2_dirent *dirent = (const void *)(buf + pos);
+		struct ext2fs_node *fdiro;
+		int type;
+
+		direntlen = le16_to_cpu(dirent->direntlen);
+		if (direntlen < sizeof(*dirent) + dirent->namelen ||
+		    pos + direntlen > len) {
+			printf("Failed to iterate over directory %s\n", name);
+			return -1;
+		}
+
+		/* Skip unused and deleted entries */
+		if (!dirent->namelen || !dirent->inode)
+			continue;
+
+#ifdef DEBUG
+		printf("iterate >%.*s<\n", dirent->namelen,
+		       (const char *)(dirent + 1));
+#endif /* of DEBUG */
+		if (!name) {
+			if (ext4fs_list_dirent(diro, dirent))
+				return -1;
+			continue;
+		}
+
+		if (dirent->namelen != namelen ||
+		    memcmp(dirent + 1, name, namelen))
+			continue;
+
+		fdiro = zalloc(sizeof(struct ext2fs_node));
+		if (!fdiro)
+			return -1;
+		fdiro->data = diro->data;
+		fdiro->ino = le32_to_cpu(dirent->inode);
+		type = ext4fs_dirent_type(fdiro, dirent);
+		if (type < 0) {
+			free(fdiro);
+			return -1;
+		}
+		*ftype = type;
+		*fnode = fdiro;
+
+		return 1;
+	}
+
+	return 0;
+}
+
+/*
+ * Deepest hash tree, counting index levels below the root: one, or two
+ * with the largedir feature
+ */
+#define EXT4_DX_MAX_LEVELS	2
+
+/* Where struct dx_root_info lies in block 0, after "." and ".." */
+#define EXT4_DX_ROOT_INFO	24
+
+/* Position in one index block of a hash tree */
+struct dx_frame {
+	char *buf;			/* the block */
+	struct dx_entry *entries;	/* its index entries */
+	unsigned int count;		/* number of entries */
+	unsigned int at;		/* entry being followed */
+};
+
+static uint32_t dx_get_block(const struct dx_entry *entry)
+{
+	return le32_to_cpu(entry->block) & 0x0fffffff;
+}
+
+/* Set up @frame for the index entries at @offset in its block */
+static int dx_set_entries(struct dx_frame *frame, unsigned int offset,
+			  unsigned int blksz)
+{
+	struct dx_countlimit *countlimit;
+	unsigned int limit;
+
+	if (offset + sizeof(*countlimit) > blksz)
+		return -1;
+	countlimit = (struct dx_countlimit *)(frame->buf + offset);
+	limit = le16_to_cpu(countlimit->limit);
+	frame->entries = (struct dx_entry *)countlimit;
+	frame->count = le16_to_cpu(countlimit->count);
+	frame->at = 0;
+	if (!frame->count || frame->count > limit ||
+	    offset + limit * sizeof(struct dx_entry) > blksz)
+		return -1;
+
+	return 0;
+}
+
+/* Find the last entry in @frame covering hashes up to @hash */
+static void dx_search(struct dx_frame *frame, uint32_t hash)
+{
+	unsigned int lo = 1, hi = frame->count;
+
+	/* The first entry has no hash and covers everything below the next */
+	while (lo < hi) {
+		unsigned int mid = lo + (hi - lo) / 2;
+
+		if (le32_to_cpu(frame->entries[mid].hash) > hash)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	frame->at = lo - 1;
+}
+
+/*
+ * Read the index blocks below @frames[level] down to the last level. With
+ * @search the entries for @hash are followed, otherwise the first ones.
+ */
+static int dx_descend(struct ext2fs_node *diro, struct dx_frame *frames,
+		      unsigned int level, unsigned int levels, uint32_t hash,
+		      bool search)
+{
+	unsigned int blksz = EXT2_BLOCK_SIZE(diro->data);
+	struct dx_frame *frame;
+	uint32_t blk;
+
+	for (; level < levels; level++) {
+		frame = &frames[level];
+		blk = dx_get_block(&frame->entries[frame->at]);
+		if (ext4fs_read_dir_block(diro, blk, frame[1].buf) != blksz)
+			return -1;
+		/* Skip the empty directory entry covering the block */
+		if (dx_set_entries(&frame[1], sizeof(struct ext2_dirent),
+				   blksz))
+			return -1;
+		if (search)
+			dx_search(&frame[1], hash);
+	}
+
+	return 0;
+}
+
+/*
+ * Move to the next leaf block if it may hold more names with @hash, which
+ * happens when a run of names with the same hash was split. Returns 1 if
+ * there is such a block, 0 if not and -1 on error.
+ */
+static int dx_next_leaf(struct ext2fs_node *diro, struct dx_frame *frames,
+			unsigned int levels, uint32_t hash)
+{
+	struct dx_frame *frame;
+	int level;
+
+	for (level = levels; level >= 0; level--) {
+		if (frames[level].at + 1 < frames[level].count)
+			break;
+	}
+	if (level < 0)
+		return 0;
+
+	/* The low bit of the hash marks a continued run */
+	frame = &frames[level];
+	if ((le32_to_cpu(frame->entries[frame->at + 1].hash) & ~1) != hash)
+		return 0;
+	frame->at++;
+	if (dx_descend(diro, frames, level, levels, hash, false))
+		return -1;
+
+	return 1;
+}
+
+/*
+ * Look up @name in a hash tree (dir_index) directory by following its
+ * index to the leaf block holding the name's hash. Returns 1 if found, 0
+ * if not and -1 if the index cannot be used, in which case the caller
+ * should search the whole directory instead.
+ */
+static int ext4fs_dx_find(struct ext2fs_node *diro, char *name,
+			  struct ext2fs_node **fnode, int *ftype)
+{
+	struct ext2_sblock *sblock = &diro->data->sblock;
+	unsigned int blksz = EXT2_BLOCK_SIZE(diro->data);
+	struct dx_frame frames[EXT4_DX_MAX_LEVELS + 1];
+	unsigned int levels, max_levels, i;
+	struct dx_root_info *info;
+	char *buf, *leaf;
+	int version, len, found = 0, ret = -1;
+	uint32_t hash;
+
+	buf = malloc((EXT4_DX_MAX_LEVELS + 2) * blksz);
+	if (!buf)
+		return -1;
+	for (i = 0; i <= EXT4_DX_MAX_LEVELS; i++)
+		frames[i].buf = buf + i * blksz;
+	leaf = buf + (EXT4_DX_MAX_LEVELS + 1) * blksz;
+
+	if (ext4fs_read_dir_block(diro, 0, frames[0].buf) != blksz)
+		goto out;
+	info = (struct dx_root_info *)(frames[0].buf + EXT4_DX_ROOT_INFO);
+	levels = info->indirect_levels;
+	/* The height of the tree, as in Linux's ext4_dir_htree_level() */
+	max_levels = le32_to_cpu(sblock->feature_incompat) &
+		     EXT4_FEATURE_INCOMPAT_LARGEDIR ? 3 : 2;
+	if (info->reserved_zero || levels >= max_levels)
+		goto out;
+
+	version = info->hash_version;
+	if (version <= DX_HASH_TEA &&
+	    (le32_to_cpu(sblock->flags) & EXT2_FLAGS_UNSIGNED_HASH))
+		version += DX_HASH_LEGACY_UNSIGNED;
+	if (ext4fs_dirhash(name, strlen(name), version, sblock->hash_seed,
+			   &hash))
+		goto out;
+
+	if (dx_set_entries(&frames[0], EXT4_DX_ROOT_INFO + info->info_length,
+			   blksz))
+		goto out;
+	dx_search(&frames[0], hash);
+	if (dx_descend(diro, frames, 0, levels, hash, true))
+		goto out;
+
+	for (;;) {
+		struct dx_frame *frame = &frames[levels];
+		uint32_t blk = dx_get_block(&frame->entries[frame->at]);
+
+		len = ext4fs_read_dir_block(diro, blk, leaf);
+		if (len < 0)
+			break;
+		found = ext4fs_iterate_dir_block(diro, leaf, len, name, fnode,
+						 ftype);
+		if (found || dx_next_leaf(diro, frames, levels, hash) <= 0)
+			break;
+	}
+
+	/* Once the index has been followed, an error means not found */
+	ret = found > 0;
+out:
+	free(buf);
+
+	return ret;
+}
+
 int ext4fs_iterate_dir(struct ext2fs_node *dir, char *name,
 				struct ext2fs_node **fnode, int *ftype)
 {
-	unsigned int fpos = 0;
-	int status;
-	loff_t actread;
 	struct ext2fs_node *diro = (struct ext2fs_node *) dir;
+	uint32_t blk, blocks;
+	int status;
+	char *buf;
 
 #ifdef DEBUG
 	if (name != NULL)
@@ -2022,122 +2358,34 @@ int ext4fs_iterate_dir(struct ext2fs_node *dir, char *name,
 		if (status == 0)
 			return 0;
 	}
-	/* Search the file.  */
-	while (fpos < le32_to_cpu(diro->inode.size)) {
-		struct ext2_dirent dirent;
-
-		status = ext4fs_read_file(diro, fpos,
-					   sizeof(struct ext2_dirent),
-					   (char *)&dirent, &actread);
-		if (status < 0)
-			return 0;
-
-		if (dirent.direntlen == 0) {
-			printf("Failed to iterate over directory %s\n", name);
-			return 0;
-		}
-
-		if (dirent.namelen != 0) {
-			char filename[dirent.namelen + 1];
-			struct ext2fs_node *fdiro;
-			int type = FILETYPE_UNKNOWN;
-
-			status = ext4fs_read_file(diro,
-						  fpos +
-						  sizeof(struct ext2_dirent),
-						  dirent.namelen, filename,
-						  &actread);
-			if (status < 0)
-				return 0;
-
-			fdiro = zalloc(sizeof(struct ext2fs_node));
-			if (!fdiro)
-				return 0;
-
-			fdiro->data = diro->data;
-			fdiro->ino = le32_to_cpu(dirent.inode);
-
-			filename[dirent.namelen] = '\0';
+	if (!fnode || !ftype)
+		name = NULL;
+
+	/* Follow the hash tree index, if any, to the right block */
+	if (name && (le32_to_cpu(diro->inode.flags) & EXT4_INDEX_FL)) {
+		status = ext4fs_dx_find(diro, name, fnode, ftype);
+		if (status >= 0)
+			return status;
+		debug("Hash tree index of %s not usable\n", name);
+	}
 
-			if (dirent.filetype != FILETYPE_UNKNOWN) {
-				fdiro->inode_read = 0;
+	/* Search the file, a block at a time */
+	buf = malloc(EXT2_BLOCK_SIZE(diro->data));
+	if (!buf)
+		return 0;
+	blocks = DIV_ROUND_UP(le32_to_cpu(diro->inode.size),
+			      EXT2_BLOCK_SIZE(diro->data));
+	for (blk = 0, status = 0; blk < blocks && !status; blk++) {
+		int len = ext4fs_read_dir_block(diro, blk, buf);
 
-				if (dirent.filetype == FILETYPE_DIRECTORY)
-					type = FILETYPE_DIRECTORY;
-				else if (dirent.filetype == FILETYPE_SYMLINK)
-					type = FILETYPE_SYMLINK;
-				else if (dirent.filetype == FILETYPE_REG)
-					type = FILETYPE_REG;
-			} else {
-				status = ext4fs_read_inode(diro->data,
-							   le32_to_cpu
-							   (dirent.inode),
-							   &fdiro->inode);
-				if (status == 0) {
-					free(fdiro);
-					return 0;
-				}
-				fdiro->inode_read = 1;
-
-				if ((le16_to_cpu(fdiro->inode.mode) &
-				     FILETYPE_INO_MASK) ==
-				    FILETYPE_INO_DIRECTORY) {
-					type = FILETYPE_DIRECTORY;
-				} else if ((le16_to_cpu(fdiro->inode.mode)
-					    & FILETYPE_INO_MASK) ==
-					   FILETYPE_INO_SYMLINK) {
-					type = FILETYPE_SYMLINK;
-				} else if ((le16_to_cpu(fdiro->inode.mode)
-					    & FILETYPE_INO_MASK) ==
-					   FILETYPE_INO_REG) {
-					type = FILETYPE_REG;
-				}
-			}
-#ifdef DEBUG
-			printf("iterate >%s<\n", filename);
-#endif /* of DEBUG */
-			if ((name != NULL) && (fnode != NULL)
-			    && (ftype != NULL)) {
-				if (strcmp(filename, name) == 0) {
-					*ftype = type;
-					*fnode = fdiro;
-					return 1;
-				}
-			} else {
-				if (fdiro->inode_read == 0) {
-					status = ext4fs_read_inode(diro->data,
-								 le32_to_cpu(
-								 dirent.inode),
-								 &fdiro->inode);
-					if (status == 0) {
-						free(fdiro);
-						return 0;
-					}
-					fdiro->inode_read = 1;
-				}
-				switch (type) {
-				case FILETYPE_DIRECTORY:
-					printf("<DIR> ");
-					break;
-				case FILETYPE_SYMLINK:
-					printf("<SYM> ");
-					break;
-				case FILETYPE_REG:
-					printf("      ");
-					break;
-				default:
-					printf("< ? > ");
-					break;
-				}
-				printf("%10u %s\n",
-				       le32_to_cpu(fdiro->inode.size),
-					filename);
-			}
-			free(fdiro);
-		}
-		fpos += le16_to_cpu(dirent.direntlen);
+		if (len < 0)
+			break;
+		status = ext4fs_iterate_dir_block(diro, buf, len, name, fnode,
+						  ftype);
 	}
-	return 0;
+	free(buf);
+
+	return status > 0;
 }
 
 static char *ext4fs_read_symlink(struct ext2fs_node *node)
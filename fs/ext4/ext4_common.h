@@ -57,6 +57,19 @@ int ext4fs_find_file(const char *path, struct ext2fs_node *rootnode,
 int ext4fs_iterate_dir(struct ext2fs_node *dir, char *name,
 			struct ext2fs_node **fnode, int *ftype);
 
+/**
+ * ext4fs_dirhash() - Hash a name as a hash tree directory does
+ *
+ * @name:	Name, which need not be nul-terminated
+ * @len:	Length of @name
+ * @version:	DX_HASH_... hash function
+ * @seed:	Hash seed from the superblock
+ * @hashp:	Returns the hash
+ * @return 0 if OK, -EINVAL if @version is not known
+ */
+int ext4fs_dirhash(const char *name, int len, int version,
+		   const __le32 seed[4], uint32_t *hashp);
+
 #if defined(CONFIG_EXT4_WRITE)
 uint32_t ext4fs_div_roundup(uint32_t size, uint32_t n);
 uint16_t ext4fs_checksum_update(unsigned int i);
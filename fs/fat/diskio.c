@@ -10,6 +10,7 @@
 #include <common.h>
 #include <fat.h>
 #include <linux/ctype.h>
+#include <malloc.h>
 #include <memalign.h>
 #include <part.h>
 #include "diskio.h"
@@ -18,6 +19,18 @@
 extern struct blk_desc *ff_dev;
 extern disk_partition_t *ff_part;
 
+/* Allocate a bounce buffer for sectors, accounted to filesystems */
+static void *disk_bounce_alloc(UINT count)
+{
+	enum malloc_tag old = malloc_set_tag(MALLOC_TAG_FS);
+	void *buf;
+
+	buf = malloc_cache_aligned(count * ff_dev->blksz);
+	malloc_set_tag(old);
+
+	return buf;
+}
+
 /*-----------------------------------------------------------------------*/
 /* Get Drive Status                                                      */
 /*-----------------------------------------------------------------------*/
@@ -55,7 +68,7 @@ DRESULT disk_read (
 	debug("%s(sector=%d, count=%u)\n", __func__, sector, count);
 
 	if (sector % 8)
-		buf = malloc_cache_aligned(count * ff_dev->blksz);
+		buf = disk_bounce_alloc(count);
 	else
 		buf = (void *)buff;
 
@@ -90,7 +103,7 @@ DRESULT disk_write (
 	debug("%s(sector=%d, count=%u)\n", __func__, sector, count);
 
 	if (sector % 8) {
-		buf = malloc_cache_aligned(count * ff_dev->blksz);
+		buf = disk_bounce_alloc(count);
 		memcpy(buf, buff, count * ff_dev->blksz);
 	} else
 		buf = (void *)buff;
@@ -19,7 +19,13 @@ void* ff_memalloc (	/* Returns pointer to the allocated memory block (null if no
 	UINT msize		/* Number of bytes to allocate */
 )
 {
-	return malloc_cache_aligned(msize);	/* Allocate a new memory block with POSIX API */
+	enum malloc_tag old = malloc_set_tag(MALLOC_TAG_FS);
+	void *ptr;
+
+	ptr = malloc_cache_aligned(msize);	/* Allocate a new memory block with POSIX API */
+	malloc_set_tag(old);
+
+	return ptr;
 }
 
 
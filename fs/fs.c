@@ -8,6 +8,7 @@
 #include <errno.h>
 #include <common.h>
 #include <mapmem.h>
+#include <memalign.h>
 #include <part.h>
 #include <ext4fs.h>
 #include <fat.h>
@@ -15,9 +16,12 @@
 #include <sandboxfs.h>
 #include <ubifs_uboot.h>
 #include <btrfs.h>
+#include <squashfs.h>
 #include <asm/io.h>
 #include <div64.h>
+#include <lmb.h>
 #include <linux/math64.h>
+#include <asm/unaligned.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -235,6 +239,22 @@ static struct fstype_info fstypes[] = {
 		.uuid = btrfs_uuid,
 		.opendir = fs_opendir_unsupported,
 	},
+#endif
+#ifdef CONFIG_FS_SQUASHFS
+	{
+		.fstype = FS_TYPE_SQUASHFS,
+		.name = "squashfs",
+		.null_dev_desc_ok = false,
+		.probe = sqfs_probe,
+		.close = sqfs_close,
+		.ls = sqfs_ls,
+		.exists = sqfs_exists,
+		.size = sqfs_size,
+		.read = sqfs_read,
+		.write = fs_write_unsupported,
+		.uuid = fs_uuid_unsupported,
+		.opendir = fs_opendir_unsupported,
+	},
 #endif
 	{
 		.fstype = FS_TYPE_ANY,
@@ -266,12 +286,125 @@ static struct fstype_info *fs_get_info(int fstype)
 	return info;
 }
 
-int fs_set_blk_dev(const char *ifname, const char *dev_part_str, int fstype)
+/* Bytes at the start of a partition which fs_sniff() reads */
+#define FS_SNIFF_SIZE		2048
+/* Largest block size fs_sniff() handles */
+#define FS_SNIFF_MAX_BLKSZ	4096
+
+#define FS_SNIFF_EXT_MAGIC	(1024 + 0x38)	/* s_magic in the superblock */
+#define FS_SNIFF_BTRFS_MAGIC	(0x10000 + 0x40) /* magic in the superblock */
+#define FS_SNIFF_BTRFS_SIG	"_BHRfS_M"
+#define FS_SNIFF_SQUASHFS_SIG	"hsqs"	/* magic at the start */
+
+/*
+ * Signatures are checked in fstypes[] order so that the result is the
+ * filesystem that probing each in turn would find. The FAT and exFAT boot
+ * sector and the ext2/3/4 superblock all lie in the first FS_SNIFF_SIZE
+ * bytes, which are read at once; btrfs keeps its superblock at 64KiB so
+ * needs a second read, made only if nothing else matched.
+ */
+int fs_sniff(struct blk_desc *desc, disk_partition_t *part)
+{
+	ALLOC_CACHE_ALIGN_BUFFER(u8, buf, FS_SNIFF_MAX_BLKSZ);
+	lbaint_t count;
+
+	if (!desc->blksz || desc->blksz > FS_SNIFF_MAX_BLKSZ)
+		return FS_TYPE_ANY;
+	count = DIV_ROUND_UP(FS_SNIFF_SIZE, desc->blksz);
+	if (part->size < count ||
+	    blk_dread(desc, part->start, count, buf) != count)
+		return FS_TYPE_ANY;
+
+#ifdef CONFIG_FS_FAT
+	/* The checks made by FatFs' check_fs() */
+	if (get_unaligned_le16(buf + 510) == 0xaa55) {
+		if (!memcmp(buf, "\xeb\x76\x90" "EXFAT   ", 11))
+			return FS_TYPE_FAT;
+		if ((buf[0] == 0xe9 || buf[0] == 0xeb || buf[0] == 0xe8) &&
+		    (!memcmp(buf + 0x36, "FAT", 3) ||
+		     !memcmp(buf + 0x52, "FAT32", 5)))
+			return FS_TYPE_FAT;
+	}
+#endif
+#ifdef CONFIG_FS_EXT4
+	if (get_unaligned_le16(buf + FS_SNIFF_EXT_MAGIC) == EXT2_MAGIC)
+		return FS_TYPE_EXT;
+#endif
+#ifdef CONFIG_FS_SQUASHFS
+	if (!memcmp(buf, FS_SNIFF_SQUASHFS_SIG, 4))
+		return FS_TYPE_SQUASHFS;
+#endif
+#ifdef CONFIG_FS_BTRFS
+	count = FS_SNIFF_BTRFS_MAGIC / desc->blksz;
+	if (part->size > count &&
+	    blk_dread(desc, part->start + count, 1, buf) == 1 &&
+	    !memcmp(buf + FS_SNIFF_BTRFS_MAGIC % desc->blksz,
+		    FS_SNIFF_BTRFS_SIG, 8))
+		return FS_TYPE_BTRFS;
+#endif
+
+	return FS_TYPE_ANY;
+}
+
+/*
+ * Probe the filesystem on the current device and partition, trying the
+ * type cached for the partition or else the one its signature suggests
+ * before falling back to probing each type in turn
+ */
+static int fs_probe(int part, int fstype)
 {
 	struct fstype_info *info;
-	int part, i;
+	int known = FS_TYPE_ANY;
+	int i;
+
+	if (fs_dev_desc) {
+		known = part_cache_get_fstype(fs_dev_desc, part);
+		if (known == FS_TYPE_ANY)
+			known = fs_sniff(fs_dev_desc, &fs_partition);
+		if (fstype != FS_TYPE_ANY && fstype != known)
+			known = FS_TYPE_ANY;
+	}
+	if (known != FS_TYPE_ANY) {
+		info = fs_get_info(known);
+		if (!info->probe(fs_dev_desc, &fs_partition)) {
+			fs_type = known;
+			part_cache_set_fstype(fs_dev_desc, part, known);
+			return 0;
+		}
+		part_cache_set_fstype(fs_dev_desc, part, FS_TYPE_ANY);
+	}
+
+	for (i = 0, info = fstypes; i < ARRAY_SIZE(fstypes); i++, info++) {
+		if (fstype != FS_TYPE_ANY && info->fstype != FS_TYPE_ANY &&
+		    fstype != info->fstype)
+			continue;
+
+		if (!fs_dev_desc && !info->null_dev_desc_ok)
+			continue;
+
+		/* Already tried */
+		if (known != FS_TYPE_ANY && info->fstype == known)
+			continue;
+
+		if (!info->probe(fs_dev_desc, &fs_partition)) {
+			fs_type = info->fstype;
+			if (fs_dev_desc)
+				part_cache_set_fstype(fs_dev_desc, part,
+						      fs_type);
+			return 0;
+		}
+	}
+
+	return -1;
+}
+
+int fs_set_blk_dev(const char *ifname, const char *dev_part_str, int fstype)
+{
+	int part;
 #ifdef CONFIG_NEEDS_MANUAL_RELOC
+	struct fstype_info *info;
 	static int relocated;
+	int i;
 
 	if (!relocated) {
 		for (i = 0, info = fstypes; i < ARRAY_SIZE(fstypes);
@@ -292,29 +425,17 @@ int fs_set_blk_dev(const char *ifname, const char *dev_part_str, int fstype)
 	if (part < 0)
 		return -1;
 
-	for (i = 0, info = fstypes; i < ARRAY_SIZE(fstypes); i++, info++) {
-		if (fstype != FS_TYPE_ANY && info->fstype != FS_TYPE_ANY &&
-				fstype != info->fstype)
-			continue;
-
-		if (!fs_dev_desc && !info->null_dev_desc_ok)
-			continue;
-
-		if (!info->probe(fs_dev_desc, &fs_partition)) {
-			fs_type = info->fstype;
-			fs_dev_part = part;
-			return 0;
-		}
-	}
+	if (fs_probe(part, fstype))
+		return -1;
+	fs_dev_part = part;
 
-	return -1;
+	return 0;
 }
 
 /* set current blk device w/ blk_desc + partition # */
 int fs_set_blk_dev_with_part(struct blk_desc *desc, int part)
 {
-	struct fstype_info *info;
-	int ret, i;
+	int ret;
 
 	if (part >= 1)
 		ret = part_get_info(desc, part, &fs_partition);
@@ -324,14 +445,7 @@ int fs_set_blk_dev_with_part(struct blk_desc *desc, int part)
 		return ret;
 	fs_dev_desc = desc;
 
-	for (i = 0, info = fstypes; i < ARRAY_SIZE(fstypes); i++, info++) {
-		if (!info->probe(fs_dev_desc, &fs_partition)) {
-			fs_type = info->fstype;
-			return 0;
-		}
-	}
-
-	return -1;
+	return fs_probe(part, FS_TYPE_ANY);
 }
 
 static void fs_close(void)
@@ -505,12 +619,59 @@ int do_size(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 	return 0;
 }
 
+#ifdef CONFIG_LMB_LOAD_MAP
+/*
+ * Check that a file may be loaded to *addrp, or for 'load ... auto' pick a
+ * free, aligned address for it. The size lookup closes the filesystem, so
+ * reopen it for the read that follows.
+ */
+static int load_check_addr(const char *ifname, const char *dev_part_str,
+			   int fstype, const char *filename, loff_t pos,
+			   loff_t bytes, bool auto_addr, unsigned long *addrp)
+{
+	const char *name = strrchr(filename, '/');
+	loff_t size = bytes;
+	phys_addr_t addr;
+
+	name = name ? name + 1 : filename;
+	if (!size) {
+		if (fs_size(filename, &size) < 0) {
+			printf("** File not found %s **\n", filename);
+			return -ENOENT;
+		}
+		size -= pos;
+		if (fs_set_blk_dev(ifname, dev_part_str, fstype))
+			return -ENODEV;
+	}
+
+	if (!auto_addr)
+		return size > 0 ? lmb_load_check(*addrp, size, name) : 0;
+
+	addr = lmb_load_alloc(size, CONFIG_LMB_LOAD_ALIGN);
+	if (!addr) {
+		printf("** No free memory to load %s (%llu bytes) **\n",
+		       filename, size);
+		return -ENOMEM;
+	}
+	*addrp = addr;
+
+	return 0;
+}
+#endif
+
+/* 'load ... auto' picks the load address from the load map */
+static bool load_addr_auto(const char *arg)
+{
+	return IS_ENABLED(CONFIG_LMB_LOAD_MAP) && !strcmp(arg, "auto");
+}
+
 int do_load(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 		int fstype)
 {
 	unsigned long addr;
 	const char *addr_str;
 	const char *filename;
+	const char *name;
 	loff_t bytes;
 	loff_t pos;
 	loff_t len_read;
@@ -528,7 +689,7 @@ int do_load(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 
 	if (argc >= 4) {
 		addr = simple_strtoul(argv[3], &ep, 16);
-		if (ep == argv[3] || *ep != '\0')
+		if ((ep == argv[3] || *ep != '\0') && !load_addr_auto(argv[3]))
 			return CMD_RET_USAGE;
 	} else {
 		addr_str = env_get("loadaddr");
@@ -555,12 +716,24 @@ int do_load(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 	else
 		pos = 0;
 
+#ifdef CONFIG_LMB_LOAD_MAP
+	if (load_check_addr(argv[1], (argc >= 3) ? argv[2] : NULL, fstype,
+			    filename, pos, bytes,
+			    argc >= 4 && load_addr_auto(argv[3]), &addr)) {
+		fs_close();
+		return 1;
+	}
+#endif
+
 	time = get_timer(0);
 	ret = fs_read(filename, addr, pos, bytes, &len_read);
 	time = get_timer(time);
 	if (ret < 0)
 		return 1;
 
+	name = strrchr(filename, '/');
+	lmb_load_add(addr, len_read, name ? name + 1 : filename);
+
 	printf("%llu bytes read in %lu ms", len_read, time);
 	if (time > 0) {
 		puts(" (");
@@ -0,0 +1,277 @@
+/*
+ * SquashFS filesystem implementation for U-Boot
+ *
+ * Device access and the metadata and block caches
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include "squashfs.h"
+#include <malloc.h>
+#include <memalign.h>
+#include <asm/unaligned.h>
+
+/*
+ * Decompressed blocks are kept in two caches, each an array ordered from
+ * the most to the least recently used entry, with the least recently used
+ * one reused once the cache is full. The metadata cache holds blocks of
+ * the inode, directory and fragment tables, which every lookup goes
+ * through from the root directory down. The block cache holds fragment
+ * blocks, shared by the tails of many small files, and data blocks of
+ * which only part was read. The caches are kept across mounts of the same
+ * filesystem, see sqfs_probe().
+ */
+struct sqfs_cache_entry {
+	u64 address;		/* of the block on the device */
+	u64 next;		/* of the block which follows it */
+	u32 len;		/* of the decompressed data */
+	u8 *data;
+};
+
+struct sqfs_cache {
+	struct sqfs_cache_entry **entries;
+	unsigned int count;
+	unsigned int max;
+};
+
+#define SQFS_NO_ADDRESS		(~0ULL)
+
+static struct sqfs_cache_entry *meta_entries[CONFIG_SQUASHFS_METADATA_CACHE];
+static struct sqfs_cache meta_cache = {
+	.entries = meta_entries,
+	.max = CONFIG_SQUASHFS_METADATA_CACHE,
+};
+
+static struct sqfs_cache_entry *block_entries[CONFIG_SQUASHFS_FRAGMENT_CACHE];
+static struct sqfs_cache block_cache = {
+	.entries = block_entries,
+	.max = CONFIG_SQUASHFS_FRAGMENT_CACHE,
+};
+
+/* Compressed data blocks are read here before being decompressed */
+static u8 *read_buf;
+static u32 read_buf_size;
+
+int sqfs_devread(u64 address, u32 len, void *buf)
+{
+	struct blk_desc *desc = sqfs_info.desc;
+
+	if (address + len > le64_to_cpu(sqfs_info.sb.bytes_used)) {
+		printf("%s: read beyond the end of the filesystem\n", __func__);
+		return -EIO;
+	}
+
+	if (!fs_devread(desc, sqfs_info.part, address >> desc->log2blksz,
+			address & (desc->blksz - 1), len, buf))
+		return -EIO;
+
+	return 0;
+}
+
+static struct sqfs_cache_entry *cache_find(struct sqfs_cache *cache,
+					   u64 address)
+{
+	struct sqfs_cache_entry *entry;
+	unsigned int i;
+
+	for (i = 0; i < cache->count; i++) {
+		entry = cache->entries[i];
+		if (entry->address != address)
+			continue;
+
+		memmove(&cache->entries[1], &cache->entries[0],
+			i * sizeof(entry));
+		cache->entries[0] = entry;
+		return entry;
+	}
+
+	return NULL;
+}
+
+/*
+ * Make room for a block of up to size bytes at the front of the cache. The
+ * entry has no address until the caller has filled it.
+ */
+static struct sqfs_cache_entry *cache_get_entry(struct sqfs_cache *cache,
+						u32 size)
+{
+	struct sqfs_cache_entry *entry;
+
+	if (cache->count < cache->max) {
+		entry = malloc(sizeof(*entry) + size);
+		if (!entry)
+			return NULL;
+		entry->data = (u8 *)(entry + 1);
+		cache->count++;
+	} else {
+		entry = cache->entries[cache->count - 1];
+	}
+
+	memmove(&cache->entries[1], &cache->entries[0],
+		(cache->count - 1) * sizeof(entry));
+	cache->entries[0] = entry;
+	entry->address = SQFS_NO_ADDRESS;
+
+	return entry;
+}
+
+static void cache_drop(struct sqfs_cache *cache)
+{
+	while (cache->count)
+		free(cache->entries[--cache->count]);
+}
+
+void sqfs_cache_drop(void)
+{
+	cache_drop(&meta_cache);
+	cache_drop(&block_cache);
+
+	free(read_buf);
+	read_buf = NULL;
+	read_buf_size = 0;
+}
+
+/* Read a metadata block, its header and data at once, and decompress it */
+static struct sqfs_cache_entry *read_meta_block(u64 address)
+{
+	ALLOC_CACHE_ALIGN_BUFFER(u8, buf, 2 + SQFS_METADATA_SIZE);
+	struct sqfs_cache_entry *entry;
+	u64 end = le64_to_cpu(sqfs_info.sb.bytes_used);
+	u32 len, size;
+	u16 header;
+
+	entry = cache_find(&meta_cache, address);
+	if (entry)
+		return entry;
+
+	if (address + 2 > end)
+		goto err;
+	len = min_t(u64, 2 + SQFS_METADATA_SIZE, end - address);
+	if (sqfs_devread(address, len, buf))
+		return NULL;
+
+	header = get_unaligned_le16(buf);
+	size = header & ~SQFS_METADATA_UNCOMPRESSED;
+	if (!size || size > SQFS_METADATA_SIZE || 2 + size > len)
+		goto err;
+
+	entry = cache_get_entry(&meta_cache, SQFS_METADATA_SIZE);
+	if (!entry)
+		return NULL;
+
+	if (header & SQFS_METADATA_UNCOMPRESSED) {
+		memcpy(entry->data, buf + 2, size);
+		entry->len = size;
+	} else {
+		entry->len = SQFS_METADATA_SIZE;
+		if (sqfs_decompress(buf + 2, size, entry->data, &entry->len))
+			return NULL;
+	}
+
+	entry->address = address;
+	entry->next = address + 2 + size;
+
+	return entry;
+err:
+	printf("%s: invalid metadata block at %llu\n", __func__, address);
+	return NULL;
+}
+
+/*
+ * Read len bytes of metadata at pos into buf, or skip them if buf is NULL,
+ * and advance pos past them.
+ */
+int sqfs_read_meta(struct sqfs_meta_pos *pos, void *buf, u32 len)
+{
+	struct sqfs_cache_entry *entry;
+	u32 n;
+
+	while (len) {
+		entry = read_meta_block(pos->block);
+		if (!entry)
+			return -EIO;
+
+		if (pos->offset >= entry->len) {
+			pos->offset -= entry->len;
+			pos->block = entry->next;
+			continue;
+		}
+
+		n = min(len, entry->len - pos->offset);
+		if (buf) {
+			memcpy(buf, entry->data + pos->offset, n);
+			buf += n;
+		}
+		pos->offset += n;
+		len -= n;
+	}
+
+	return 0;
+}
+
+int sqfs_skip_meta(struct sqfs_meta_pos *pos, u32 len)
+{
+	return sqfs_read_meta(pos, NULL, len);
+}
+
+/*
+ * Read the data or fragment block at address, with size as it is given in
+ * block lists and fragment entries, into buf, which holds *len bytes. On
+ * return *len is the size of the decompressed block.
+ */
+int sqfs_read_block(u64 address, u32 size, void *buf, u32 *len)
+{
+	u32 disk_size = size & ~SQFS_BLOCK_UNCOMPRESSED;
+
+	if (disk_size > sqfs_info.block_size) {
+		printf("%s: invalid block at %llu\n", __func__, address);
+		return -EINVAL;
+	}
+
+	if (size & SQFS_BLOCK_UNCOMPRESSED) {
+		if (disk_size > *len)
+			return -ENOSPC;
+		*len = disk_size;
+		return sqfs_devread(address, disk_size, buf);
+	}
+
+	if (read_buf_size < sqfs_info.block_size) {
+		free(read_buf);
+		read_buf = malloc_cache_aligned(sqfs_info.block_size);
+		read_buf_size = read_buf ? sqfs_info.block_size : 0;
+		if (!read_buf)
+			return -ENOMEM;
+	}
+
+	if (sqfs_devread(address, disk_size, read_buf))
+		return -EIO;
+
+	return sqfs_decompress(read_buf, disk_size, buf, len);
+}
+
+/*
+ * Get the decompressed data or fragment block at address from the block
+ * cache, reading it first if it is not there.
+ */
+const u8 *sqfs_get_block(u64 address, u32 size, u32 *len)
+{
+	struct sqfs_cache_entry *entry;
+
+	entry = cache_find(&block_cache, address);
+	if (entry) {
+		*len = entry->len;
+		return entry->data;
+	}
+
+	entry = cache_get_entry(&block_cache, sqfs_info.block_size);
+	if (!entry)
+		return NULL;
+
+	entry->len = sqfs_info.block_size;
+	if (sqfs_read_block(address, size, entry->data, &entry->len))
+		return NULL;
+	entry->address = address;
+
+	*len = entry->len;
+	return entry->data;
+}
@@ -0,0 +1,149 @@
+/*
+ * SquashFS filesystem implementation for U-Boot
+ *
+ * Block decompression
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include "squashfs.h"
+#include <linux/lzo.h>
+#include <u-boot/zlib.h>
+
+/* from zutil.h */
+#define PRESET_DICT 0x20
+
+/*
+ * One inflate state serves every zlib block, reset between blocks rather
+ * than set up for each of them. Like the block caches it is kept from one
+ * command to the next, so it is only set up on the first probe.
+ */
+static z_stream zlib_stream;
+static bool zlib_ready;
+
+static int decompress_zlib(const u8 *src, u32 srclen, u8 *dst, u32 *dstlen)
+{
+	int ret;
+
+	/*
+	 * Inflate the raw deflate data and skip the adler32 check, as
+	 * btrfs does; the blocks never use a preset dictionary.
+	 */
+	if (srclen < 2 || (src[0] & 0x0f) != Z_DEFLATED ||
+	    (src[1] & PRESET_DICT) || ((src[0] << 8) + src[1]) % 31)
+		return -EINVAL;
+
+	if (inflateReset(&zlib_stream) != Z_OK)
+		return -EINVAL;
+
+	zlib_stream.next_in = (u8 *)src + 2;
+	zlib_stream.avail_in = srclen - 2;
+	zlib_stream.next_out = dst;
+	zlib_stream.avail_out = *dstlen;
+
+	ret = inflate(&zlib_stream, Z_FINISH);
+	if (ret != Z_STREAM_END)
+		return ret == Z_BUF_ERROR ? -ENOSPC : -EINVAL;
+
+	*dstlen = zlib_stream.total_out;
+	return 0;
+}
+
+static int decompress_lzo(const u8 *src, u32 srclen, u8 *dst, u32 *dstlen)
+{
+	size_t len = *dstlen;
+
+	if (lzo1x_decompress_safe(src, srclen, dst, &len) != LZO_E_OK)
+		return -EINVAL;
+
+	*dstlen = len;
+	return 0;
+}
+
+static int decompress_lz4(const u8 *src, u32 srclen, u8 *dst, u32 *dstlen)
+{
+	size_t len = *dstlen;
+	int ret;
+
+	ret = ulz4bn(src, srclen, dst, &len);
+	if (ret)
+		return ret;
+
+	*dstlen = len;
+	return 0;
+}
+
+static int decompress_zstd(const u8 *src, u32 srclen, u8 *dst, u32 *dstlen)
+{
+	size_t len = *dstlen;
+	int ret;
+
+	ret = zstd_decompress(src, srclen, dst, &len);
+	if (ret)
+		return ret;
+
+	*dstlen = len;
+	return 0;
+}
+
+int sqfs_decompressor_init(void)
+{
+	switch (sqfs_info.compression) {
+	case SQFS_COMP_ZLIB:
+		if (zlib_ready)
+			return 0;
+		memset(&zlib_stream, 0, sizeof(zlib_stream));
+		if (inflateInit2(&zlib_stream, -MAX_WBITS) != Z_OK)
+			return -ENOMEM;
+		zlib_ready = true;
+		return 0;
+	case SQFS_COMP_LZO:
+		if (IS_ENABLED(CONFIG_LZO))
+			return 0;
+		break;
+	case SQFS_COMP_LZ4:
+		if (IS_ENABLED(CONFIG_LZ4))
+			return 0;
+		break;
+	case SQFS_COMP_ZSTD:
+		if (IS_ENABLED(CONFIG_ZSTD))
+			return 0;
+		break;
+	}
+
+	printf("%s: unsupported compression %u\n", __func__,
+	       sqfs_info.compression);
+	return -EPROTONOSUPPORT;
+}
+
+/*
+ * Decompress a metadata or data block from src into dst, which holds
+ * *dstlen bytes. On return *dstlen is the size of the decompressed block.
+ */
+int sqfs_decompress(const void *src, u32 srclen, void *dst, u32 *dstlen)
+{
+	int ret = -EPROTONOSUPPORT;
+
+	switch (sqfs_info.compression) {
+	case SQFS_COMP_ZLIB:
+		ret = decompress_zlib(src, srclen, dst, dstlen);
+		break;
+	case SQFS_COMP_LZO:
+		if (IS_ENABLED(CONFIG_LZO))
+			ret = decompress_lzo(src, srclen, dst, dstlen);
+		break;
+	case SQFS_COMP_LZ4:
+		if (IS_ENABLED(CONFIG_LZ4))
+			ret = decompress_lz4(src, srclen, dst, dstlen);
+		break;
+	case SQFS_COMP_ZSTD:
+		if (IS_ENABLED(CONFIG_ZSTD))
+			ret = decompress_zstd(src, srclen, dst, dstlen);
+		break;
+	}
+
+	if (ret)
+		printf("%s: cannot decompress block (%d)\n", __func__, ret);
+
+	return ret;
+}
@@ -0,0 +1,189 @@
+/*
+ * SquashFS filesystem implementation for U-Boot
+ *
+ * Reading regular files
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include "squashfs.h"
+#include <malloc.h>
+
+/* Block list entries read from the inode at once */
+#define SQFS_BLOCK_LIST_CHUNK	128
+/* Largest device read of consecutive uncompressed blocks */
+#define SQFS_MAX_RUN		(1 << 30)
+
+#define SQFS_FRAGMENTS_PER_BLOCK \
+	(SQFS_METADATA_SIZE / sizeof(struct sqfs_fragment_entry))
+
+static int read_fragment_entry(u32 fragment, struct sqfs_fragment_entry *entry)
+{
+	u32 count = le32_to_cpu(sqfs_info.sb.fragments);
+	struct sqfs_meta_pos pos;
+	u32 len;
+
+	if (fragment >= count)
+		return -EINVAL;
+
+	/* The table's index is small, read it all on first use */
+	if (!sqfs_info.fragment_index) {
+		len = DIV_ROUND_UP(count, SQFS_FRAGMENTS_PER_BLOCK) *
+		      sizeof(u64);
+		sqfs_info.fragment_index = malloc(len);
+		if (!sqfs_info.fragment_index)
+			return -ENOMEM;
+		if (sqfs_devread(le64_to_cpu(sqfs_info.sb.fragment_table_start),
+				 len, sqfs_info.fragment_index)) {
+			free(sqfs_info.fragment_index);
+			sqfs_info.fragment_index = NULL;
+			return -EIO;
+		}
+	}
+
+	pos.block = le64_to_cpu(sqfs_info.fragment_index[fragment /
+						SQFS_FRAGMENTS_PER_BLOCK]);
+	pos.offset = (fragment % SQFS_FRAGMENTS_PER_BLOCK) * sizeof(*entry);
+
+	return sqfs_read_meta(&pos, entry, sizeof(*entry));
+}
+
+/* Copy the part of the file's tail from from to to out of its fragment */
+static int read_tail(const struct sqfs_inode *inode, u32 from, u32 to,
+		     void *buf)
+{
+	struct sqfs_fragment_entry entry;
+	const u8 *data;
+	u32 len;
+	int ret;
+
+	ret = read_fragment_entry(inode->fragment, &entry);
+	if (ret)
+		return ret;
+
+	data = sqfs_get_block(le64_to_cpu(entry.start_block),
+			      le32_to_cpu(entry.size), &len);
+	if (!data)
+		return -EIO;
+	if ((u64)inode->frag_offset + to > len)
+		return -EINVAL;
+
+	memcpy(buf, data + inode->frag_offset + from, to - from);
+
+	return 0;
+}
+
+/*
+ * Read len bytes at offset of a regular file into buf. Blocks wanted as a
+ * whole are decompressed straight into buf, and runs of uncompressed ones
+ * are read with a single device read. Only blocks of which a part is
+ * wanted, and the fragment holding the file's tail, go through the block
+ * cache.
+ */
+int sqfs_file_read(const struct sqfs_inode *inode, u64 offset, u64 len,
+		   void *buf, u64 *actread)
+{
+	u32 block_size = sqfs_info.block_size;
+	u32 sizes[SQFS_BLOCK_LIST_CHUNK];
+	u64 nblocks, i, start, end, address;
+	u64 run_address = 0, run_len = 0;
+	struct sqfs_meta_pos pos;
+	u32 size, disk_size = 0, from, to, n;
+	u8 *dst, *run_buf = NULL;
+	const u8 *data;
+	int ret = 0;
+
+	*actread = 0;
+	if (offset >= inode->size)
+		return 0;
+	len = min(len, inode->size - offset);
+	end = offset + len;
+
+	if (inode->fragment == SQFS_INVALID_FRAG)
+		nblocks = DIV_ROUND_UP(inode->size, block_size);
+	else
+		nblocks = inode->size >> sqfs_info.block_log;
+
+	pos = inode->blocks_pos;
+	address = inode->start_block;
+
+	for (i = 0; i < nblocks; i++, address += disk_size) {
+		start = i << sqfs_info.block_log;
+		if (start >= end)
+			break;
+
+		if (!(i % SQFS_BLOCK_LIST_CHUNK)) {
+			n = min_t(u64, nblocks - i, SQFS_BLOCK_LIST_CHUNK);
+			if (sqfs_read_meta(&pos, sizes, n * sizeof(u32)))
+				return -EIO;
+		}
+		size = le32_to_cpu(sizes[i % SQFS_BLOCK_LIST_CHUNK]);
+		disk_size = size & ~SQFS_BLOCK_UNCOMPRESSED;
+
+		if (start + block_size <= offset)
+			continue;
+
+		from = max(offset, start) - start;
+		to = min3(end, start + block_size, inode->size) - start;
+		dst = buf + (start + from - offset);
+
+		/* Extend the current run of uncompressed blocks */
+		if ((size & SQFS_BLOCK_UNCOMPRESSED) && run_len &&
+		    run_address + run_len == address + from &&
+		    run_buf + run_len == dst &&
+		    run_len + to - from <= SQFS_MAX_RUN) {
+			run_len += to - from;
+			continue;
+		}
+
+		if (run_len) {
+			ret = sqfs_devread(run_address, run_len, run_buf);
+			if (ret)
+				return ret;
+			run_len = 0;
+		}
+
+		if (!size) {
+			/* A sparse block */
+			memset(dst, 0, to - from);
+		} else if (size & SQFS_BLOCK_UNCOMPRESSED) {
+			run_address = address + from;
+			run_buf = dst;
+			run_len = to - from;
+		} else if (!from && to == min_t(u64, block_size,
+					       inode->size - start)) {
+			n = to;
+			ret = sqfs_read_block(address, size, dst, &n);
+			if (!ret && n != to)
+				ret = -EINVAL;
+		} else {
+			data = sqfs_get_block(address, size, &n);
+			if (!data)
+				return -EIO;
+			if (n < to)
+				return -EINVAL;
+			memcpy(dst, data + from, to - from);
+		}
+
+		if (ret)
+			return ret;
+	}
+
+	if (run_len) {
+		ret = sqfs_devread(run_address, run_len, run_buf);
+		if (ret)
+			return ret;
+	}
+
+	start = nblocks << sqfs_info.block_log;
+	if (inode->fragment != SQFS_INVALID_FRAG && end > start) {
+		from = max(offset, start) - start;
+		to = end - start;
+		ret = read_tail(inode, from, to, buf + (start + from - offset));
+		if (ret)
+			return ret;
+	}
+
+	*actread = len;
+	return 0;
+}
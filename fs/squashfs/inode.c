@@ -0,0 +1,335 @@
+/*
+ * SquashFS filesystem implementation for U-Boot
+ *
+ * Inodes, directories and path lookup
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include "squashfs.h"
+#include <malloc.h>
+
+/* Deepest directory a path may lead to */
+#define SQFS_MAX_DEPTH		64
+
+int sqfs_read_inode(u64 ref, struct sqfs_inode *inode)
+{
+	struct sqfs_meta_pos pos;
+	struct sqfs_base_inode base;
+	union {
+		struct sqfs_dir_inode dir;
+		struct sqfs_ldir_inode ldir;
+		struct sqfs_reg_inode reg;
+		struct sqfs_lreg_inode lreg;
+		struct sqfs_symlink_inode symlink;
+	} u;
+	u16 type;
+
+	pos.block = le64_to_cpu(sqfs_info.sb.inode_table_start) +
+		    SQFS_REF_BLOCK(ref);
+	pos.offset = SQFS_REF_OFFSET(ref);
+
+	if (sqfs_read_meta(&pos, &base, sizeof(base)))
+		return -EIO;
+
+	memset(inode, 0, sizeof(*inode));
+	type = le16_to_cpu(base.inode_type);
+	inode->mode = le16_to_cpu(base.mode);
+	inode->mtime = le32_to_cpu(base.mtime);
+	inode->number = le32_to_cpu(base.inode_number);
+	inode->fragment = SQFS_INVALID_FRAG;
+
+	switch (type) {
+	case SQFS_DIR_TYPE:
+		if (sqfs_read_meta(&pos, &u.dir, sizeof(u.dir)))
+			return -EIO;
+		inode->size = le16_to_cpu(u.dir.file_size);
+		inode->dir_block = le32_to_cpu(u.dir.start_block);
+		inode->dir_offset = le16_to_cpu(u.dir.offset);
+		break;
+	case SQFS_LDIR_TYPE:
+		if (sqfs_read_meta(&pos, &u.ldir, sizeof(u.ldir)))
+			return -EIO;
+		inode->size = le32_to_cpu(u.ldir.file_size);
+		inode->dir_block = le32_to_cpu(u.ldir.start_block);
+		inode->dir_offset = le16_to_cpu(u.ldir.offset);
+		inode->index_count = le16_to_cpu(u.ldir.i_count);
+		inode->index_pos = pos;
+		break;
+	case SQFS_REG_TYPE:
+		if (sqfs_read_meta(&pos, &u.reg, sizeof(u.reg)))
+			return -EIO;
+		inode->size = le32_to_cpu(u.reg.file_size);
+		inode->start_block = le32_to_cpu(u.reg.start_block);
+		inode->fragment = le32_to_cpu(u.reg.fragment);
+		inode->frag_offset = le32_to_cpu(u.reg.offset);
+		inode->blocks_pos = pos;
+		break;
+	case SQFS_LREG_TYPE:
+		if (sqfs_read_meta(&pos, &u.lreg, sizeof(u.lreg)))
+			return -EIO;
+		inode->size = le64_to_cpu(u.lreg.file_size);
+		inode->start_block = le64_to_cpu(u.lreg.start_block);
+		inode->fragment = le32_to_cpu(u.lreg.fragment);
+		inode->frag_offset = le32_to_cpu(u.lreg.offset);
+		inode->blocks_pos = pos;
+		break;
+	case SQFS_SYMLINK_TYPE:
+	case SQFS_LSYMLINK_TYPE:
+		if (sqfs_read_meta(&pos, &u.symlink, sizeof(u.symlink)))
+			return -EIO;
+		inode->size = le32_to_cpu(u.symlink.symlink_size);
+		inode->target_pos = pos;
+		break;
+	case SQFS_BLKDEV_TYPE:
+	case SQFS_CHRDEV_TYPE:
+	case SQFS_LBLKDEV_TYPE:
+	case SQFS_LCHRDEV_TYPE:
+	case SQFS_FIFO_TYPE:
+	case SQFS_SOCKET_TYPE:
+	case SQFS_LFIFO_TYPE:
+	case SQFS_LSOCKET_TYPE:
+		break;
+	default:
+		printf("%s: unknown inode type %u\n", __func__, type);
+		return -EINVAL;
+	}
+
+	inode->type = type > SQFS_TYPES ? type - SQFS_TYPES : type;
+
+	return 0;
+}
+
+/*
+ * Start reading the entries of a directory. Given a name, the directory
+ * index of large directories is used to skip to the part of the listing
+ * where the name would be, as entries are sorted by name.
+ */
+int sqfs_dir_open(const struct sqfs_inode *dir, const char *name,
+		  struct sqfs_dir_iter *it)
+{
+	u64 table = le64_to_cpu(sqfs_info.sb.directory_table_start);
+	struct sqfs_meta_pos pos = dir->index_pos;
+	char index_name[SQFS_NAME_LEN + 1];
+	struct sqfs_dir_index index;
+	u32 i, size, skip = 0;
+	u64 block = 0;
+
+	if (dir->type != SQFS_DIR_TYPE)
+		return -ENOTDIR;
+
+	it->pos.block = table + dir->dir_block;
+	it->pos.offset = dir->dir_offset;
+	/* The size counts "." and "..", which are not stored */
+	it->remaining = dir->size > 3 ? dir->size - 3 : 0;
+	it->count = 0;
+
+	for (i = 0; name && i < dir->index_count; i++) {
+		if (sqfs_read_meta(&pos, &index, sizeof(index)))
+			return -EIO;
+
+		size = le32_to_cpu(index.size) + 1;
+		if (size > SQFS_NAME_LEN)
+			return -EINVAL;
+		if (sqfs_read_meta(&pos, index_name, size))
+			return -EIO;
+		index_name[size] = '\0';
+
+		if (strcmp(index_name, name) > 0)
+			break;
+
+		skip = le32_to_cpu(index.index);
+		block = table + le32_to_cpu(index.start_block);
+	}
+
+	if (skip) {
+		if (skip > it->remaining)
+			return -EINVAL;
+		it->pos.block = block;
+		it->pos.offset = (dir->dir_offset + skip) % SQFS_METADATA_SIZE;
+		it->remaining -= skip;
+	}
+
+	return 0;
+}
+
+/*
+ * Read the next entry of a directory. Returns 0 if there was one, 1 at the
+ * end of the directory, or a negative error.
+ */
+int sqfs_dir_next(struct sqfs_dir_iter *it, struct sqfs_dirent *ent)
+{
+	struct sqfs_dir_header header;
+	struct sqfs_dir_entry entry;
+	u32 size;
+
+	while (!it->count) {
+		if (!it->remaining)
+			return 1;
+		if (it->remaining < sizeof(header))
+			return -EINVAL;
+		if (sqfs_read_meta(&it->pos, &header, sizeof(header)))
+			return -EIO;
+		it->remaining -= sizeof(header);
+		it->count = le32_to_cpu(header.count) + 1;
+		it->start_block = le32_to_cpu(header.start_block);
+	}
+
+	if (it->remaining < sizeof(entry))
+		return -EINVAL;
+	if (sqfs_read_meta(&it->pos, &entry, sizeof(entry)))
+		return -EIO;
+
+	size = le16_to_cpu(entry.size) + 1;
+	if (size > SQFS_NAME_LEN || it->remaining < sizeof(entry) + size)
+		return -EINVAL;
+	if (sqfs_read_meta(&it->pos, ent->name, size))
+		return -EIO;
+	ent->name[size] = '\0';
+
+	ent->type = le16_to_cpu(entry.type);
+	ent->inode_ref = ((u64)it->start_block << 16) |
+			 le16_to_cpu(entry.offset);
+
+	it->remaining -= sizeof(entry) + size;
+	it->count--;
+
+	return 0;
+}
+
+/* Read the target of a symlink into target, which holds inode->size + 1 */
+int sqfs_readlink(const struct sqfs_inode *inode, char *target)
+{
+	struct sqfs_meta_pos pos = inode->target_pos;
+
+	if (sqfs_read_meta(&pos, target, inode->size))
+		return -EIO;
+	target[inode->size] = '\0';
+
+	return 0;
+}
+
+static int lookup_name(const struct sqfs_inode *dir, const char *name,
+		       u64 *ref)
+{
+	struct sqfs_dirent ent;
+	struct sqfs_dir_iter it;
+	int ret, cmp;
+
+	ret = sqfs_dir_open(dir, name, &it);
+	if (ret)
+		return ret;
+
+	while (!(ret = sqfs_dir_next(&it, &ent))) {
+		cmp = strcmp(ent.name, name);
+		if (!cmp) {
+			*ref = ent.inode_ref;
+			return 0;
+		}
+		if (cmp > 0)
+			break;
+	}
+
+	return ret < 0 ? ret : -ENOENT;
+}
+
+/*
+ * Find the inode at path, following symlinks, including one at the end of
+ * the path.
+ */
+int sqfs_lookup_path(const char *path, struct sqfs_inode *inode)
+{
+	u64 root = le64_to_cpu(sqfs_info.sb.root_inode);
+	u64 dirs[SQFS_MAX_DEPTH], ref;
+	int depth = 1, symlinks = 0, ret;
+	struct sqfs_inode child;
+	char *buf, *p, *name, *target;
+	size_t len;
+
+	buf = strdup(path);
+	if (!buf)
+		return -ENOMEM;
+
+	dirs[0] = root;
+	ret = sqfs_read_inode(root, inode);
+	p = buf;
+
+	while (!ret) {
+		while (*p == '/')
+			p++;
+		if (!*p)
+			break;
+
+		name = p;
+		while (*p && *p != '/')
+			p++;
+		if (*p)
+			*p++ = '\0';
+
+		if (inode->type != SQFS_DIR_TYPE) {
+			ret = -ENOTDIR;
+			break;
+		}
+
+		if (!strcmp(name, "."))
+			continue;
+		if (!strcmp(name, "..")) {
+			if (depth > 1)
+				depth--;
+			ret = sqfs_read_inode(dirs[depth - 1], inode);
+			continue;
+		}
+
+		ret = lookup_name(inode, name, &ref);
+		if (!ret)
+			ret = sqfs_read_inode(ref, &child);
+		if (ret)
+			break;
+
+		if (child.type == SQFS_DIR_TYPE) {
+			if (depth == SQFS_MAX_DEPTH) {
+				ret = -ENAMETOOLONG;
+				break;
+			}
+			dirs[depth++] = ref;
+			*inode = child;
+			continue;
+		}
+
+		if (child.type != SQFS_SYMLINK_TYPE) {
+			*inode = child;
+			continue;
+		}
+
+		/* Go on with the target followed by the rest of the path */
+		if (++symlinks > SQFS_MAX_SYMLINKS) {
+			ret = -ELOOP;
+			break;
+		}
+
+		len = strlen(p);
+		target = malloc(child.size + 1 + len + 1);
+		if (!target) {
+			ret = -ENOMEM;
+			break;
+		}
+		ret = sqfs_readlink(&child, target);
+		if (ret) {
+			free(target);
+			break;
+		}
+		target[child.size] = '/';
+		memcpy(target + child.size + 1, p, len + 1);
+		free(buf);
+		buf = target;
+		p = target;
+
+		if (*p == '/') {
+			depth = 1;
+			ret = sqfs_read_inode(root, inode);
+		}
+	}
+
+	free(buf);
+	return ret;
+}
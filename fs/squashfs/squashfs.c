@@ -0,0 +1,233 @@
+/*
+ * SquashFS filesystem implementation for U-Boot
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include "squashfs.h"
+#include <malloc.h>
+#include <memalign.h>
+
+struct sqfs_info sqfs_info;
+
+/*
+ * The filesystem is probed again for every command. Cached metadata and
+ * blocks are kept from one probe to the next as long as it is the same
+ * filesystem at the same place, which an identical superblock tells, and
+ * nothing was written to the device since.
+ */
+static struct {
+	struct blk_desc *desc;
+	lbaint_t start;
+	struct sqfs_super_block sb;
+} cached_fs;
+
+static void sqfs_check_caches(bool valid)
+{
+	if (valid && cached_fs.desc == sqfs_info.desc &&
+	    cached_fs.start == sqfs_info.part->start &&
+	    !memcmp(&cached_fs.sb, &sqfs_info.sb, sizeof(cached_fs.sb)))
+		return;
+
+	sqfs_cache_drop();
+
+	memset(&cached_fs, 0, sizeof(cached_fs));
+	if (valid) {
+		cached_fs.desc = sqfs_info.desc;
+		cached_fs.start = sqfs_info.part->start;
+		cached_fs.sb = sqfs_info.sb;
+	}
+}
+
+/* Forget what was cached from a device, as it was written to */
+void sqfs_cache_invalidate(struct blk_desc *dev_desc)
+{
+	if (cached_fs.desc == dev_desc)
+		sqfs_check_caches(false);
+}
+
+static int sqfs_read_superblock(void)
+{
+	ALLOC_CACHE_ALIGN_BUFFER(struct sqfs_super_block, sb, 1);
+	struct blk_desc *desc = sqfs_info.desc;
+	u64 bytes_used;
+	u16 block_log;
+
+	if (!fs_devread(desc, sqfs_info.part, 0, 0, sizeof(*sb), (char *)sb))
+		return -EIO;
+
+	if (le32_to_cpu(sb->magic) != SQFS_MAGIC)
+		return -EINVAL;
+
+	if (le16_to_cpu(sb->major) != SQFS_MAJOR ||
+	    le16_to_cpu(sb->minor) != SQFS_MINOR) {
+		printf("%s: unsupported SquashFS version %u.%u\n", __func__,
+		       le16_to_cpu(sb->major), le16_to_cpu(sb->minor));
+		return -EINVAL;
+	}
+
+	block_log = le16_to_cpu(sb->block_log);
+	bytes_used = le64_to_cpu(sb->bytes_used);
+	if (block_log < SQFS_MIN_BLOCK_LOG || block_log > SQFS_MAX_BLOCK_LOG ||
+	    le32_to_cpu(sb->block_size) != 1 << block_log ||
+	    bytes_used < sizeof(*sb) ||
+	    bytes_used > (u64)sqfs_info.part->size << desc->log2blksz) {
+		printf("%s: invalid superblock\n", __func__);
+		return -EINVAL;
+	}
+
+	sqfs_info.sb = *sb;
+	sqfs_info.block_size = 1 << block_log;
+	sqfs_info.block_log = block_log;
+	sqfs_info.compression = le16_to_cpu(sb->compression);
+
+	return 0;
+}
+
+int sqfs_probe(struct blk_desc *fs_dev_desc, disk_partition_t *fs_partition)
+{
+	memset(&sqfs_info, 0, sizeof(sqfs_info));
+	sqfs_info.desc = fs_dev_desc;
+	sqfs_info.part = fs_partition;
+
+	if (sqfs_read_superblock()) {
+		sqfs_check_caches(false);
+		return -1;
+	}
+	sqfs_check_caches(true);
+
+	if (sqfs_decompressor_init())
+		return -1;
+
+	return 0;
+}
+
+/* List an entry the way ext4 does */
+static void sqfs_print_entry(const struct sqfs_dirent *ent)
+{
+	struct sqfs_inode inode;
+
+	if (sqfs_read_inode(ent->inode_ref, &inode)) {
+		printf("%s: Cannot read inode of directory entry %s!\n",
+		       __func__, ent->name);
+		return;
+	}
+
+	switch (inode.type) {
+	case SQFS_DIR_TYPE:
+		printf("<DIR> ");
+		break;
+	case SQFS_SYMLINK_TYPE:
+		printf("<SYM> ");
+		break;
+	case SQFS_REG_TYPE:
+		printf("      ");
+		break;
+	default:
+		printf("< ? > ");
+		break;
+	}
+	printf("%10llu %s\n", inode.size, ent->name);
+}
+
+int sqfs_ls(const char *path)
+{
+	struct sqfs_inode dir;
+	struct sqfs_dirent ent;
+	struct sqfs_dir_iter it;
+	int ret;
+
+	if (sqfs_lookup_path(path, &dir)) {
+		printf("Cannot lookup path %s\n", path);
+		return 1;
+	}
+
+	if (dir.type != SQFS_DIR_TYPE) {
+		printf("Not a directory: %s\n", path);
+		return 1;
+	}
+
+	ret = sqfs_dir_open(&dir, NULL, &it);
+	while (!ret) {
+		ret = sqfs_dir_next(&it, &ent);
+		if (!ret)
+			sqfs_print_entry(&ent);
+	}
+
+	if (ret < 0) {
+		printf("An error occurred while listing directory %s\n", path);
+		return 1;
+	}
+
+	return 0;
+}
+
+int sqfs_exists(const char *file)
+{
+	struct sqfs_inode inode;
+
+	return !sqfs_lookup_path(file, &inode) &&
+	       inode.type == SQFS_REG_TYPE;
+}
+
+/* The callers of size and read check for negative errors */
+static int sqfs_lookup_file(const char *file, struct sqfs_inode *inode)
+{
+	int ret;
+
+	ret = sqfs_lookup_path(file, inode);
+	if (ret) {
+		printf("Cannot lookup file %s\n", file);
+		return ret;
+	}
+
+	if (inode->type != SQFS_REG_TYPE) {
+		printf("Not a regular file: %s\n", file);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int sqfs_size(const char *file, loff_t *size)
+{
+	struct sqfs_inode inode;
+	int ret;
+
+	ret = sqfs_lookup_file(file, &inode);
+	if (ret)
+		return ret;
+
+	*size = inode.size;
+	return 0;
+}
+
+int sqfs_read(const char *file, void *buf, loff_t offset, loff_t len,
+	      loff_t *actread)
+{
+	struct sqfs_inode inode;
+	u64 rd;
+	int ret;
+
+	ret = sqfs_lookup_file(file, &inode);
+	if (ret)
+		return ret;
+
+	if (!len)
+		len = inode.size;
+
+	ret = sqfs_file_read(&inode, offset, len, buf, &rd);
+	if (ret) {
+		printf("An error occurred while reading file %s\n", file);
+		return ret;
+	}
+
+	*actread = rd;
+	return 0;
+}
+
+void sqfs_close(void)
+{
+	free(sqfs_info.fragment_index);
+	sqfs_info.fragment_index = NULL;
+}
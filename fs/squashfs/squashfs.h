@@ -0,0 +1,240 @@
+/*
+ * SquashFS filesystem implementation for U-Boot
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __FS_SQUASHFS_H__
+#define __FS_SQUASHFS_H__
+
+#include <common.h>
+#include <fs_internal.h>
+#include <squashfs.h>
+
+#define SQFS_MAGIC			0x73717368	/* "hsqs" */
+#define SQFS_MAJOR			4
+#define SQFS_MINOR			0
+
+#define SQFS_METADATA_SIZE		8192
+#define SQFS_METADATA_UNCOMPRESSED	(1 << 15)
+#define SQFS_BLOCK_UNCOMPRESSED		(1 << 24)
+#define SQFS_MIN_BLOCK_LOG		12
+#define SQFS_MAX_BLOCK_LOG		20
+#define SQFS_NAME_LEN			256
+#define SQFS_INVALID_FRAG		0xffffffff
+#define SQFS_MAX_SYMLINKS		40
+
+/* Superblock flags */
+#define SQFS_FLAG_COMP_OPTS		0x0400
+
+/* Compressors */
+#define SQFS_COMP_ZLIB			1
+#define SQFS_COMP_LZMA			2
+#define SQFS_COMP_LZO			3
+#define SQFS_COMP_XZ			4
+#define SQFS_COMP_LZ4			5
+#define SQFS_COMP_ZSTD			6
+
+/* Inode types, the extended ones follow the basic ones by 7 */
+#define SQFS_DIR_TYPE			1
+#define SQFS_REG_TYPE			2
+#define SQFS_SYMLINK_TYPE		3
+#define SQFS_BLKDEV_TYPE		4
+#define SQFS_CHRDEV_TYPE		5
+#define SQFS_FIFO_TYPE			6
+#define SQFS_SOCKET_TYPE		7
+#define SQFS_LDIR_TYPE			8
+#define SQFS_LREG_TYPE			9
+#define SQFS_LSYMLINK_TYPE		10
+#define SQFS_LBLKDEV_TYPE		11
+#define SQFS_LCHRDEV_TYPE		12
+#define SQFS_LFIFO_TYPE			13
+#define SQFS_LSOCKET_TYPE		14
+#define SQFS_TYPES			7
+
+/* Metadata references hold the block (relative to its table) and offset */
+#define SQFS_REF_BLOCK(ref)		((ref) >> 16)
+#define SQFS_REF_OFFSET(ref)		((ref) & 0xffff)
+
+struct sqfs_super_block {
+	__le32 magic;
+	__le32 inodes;
+	__le32 mkfs_time;
+	__le32 block_size;
+	__le32 fragments;
+	__le16 compression;
+	__le16 block_log;
+	__le16 flags;
+	__le16 no_ids;
+	__le16 major;
+	__le16 minor;
+	__le64 root_inode;
+	__le64 bytes_used;
+	__le64 id_table_start;
+	__le64 xattr_id_table_start;
+	__le64 inode_table_start;
+	__le64 directory_table_start;
+	__le64 fragment_table_start;
+	__le64 export_table_start;
+} __packed;
+
+struct sqfs_base_inode {
+	__le16 inode_type;
+	__le16 mode;
+	__le16 uid;
+	__le16 guid;
+	__le32 mtime;
+	__le32 inode_number;
+} __packed;
+
+struct sqfs_dir_inode {
+	__le32 start_block;
+	__le32 nlink;
+	__le16 file_size;
+	__le16 offset;
+	__le32 parent_inode;
+} __packed;
+
+struct sqfs_ldir_inode {
+	__le32 nlink;
+	__le32 file_size;
+	__le32 start_block;
+	__le32 parent_inode;
+	__le16 i_count;
+	__le16 offset;
+	__le32 xattr;
+	/* followed by i_count struct sqfs_dir_index */
+} __packed;
+
+struct sqfs_dir_index {
+	__le32 index;
+	__le32 start_block;
+	__le32 size;
+	/* followed by the name, size + 1 bytes */
+} __packed;
+
+struct sqfs_reg_inode {
+	__le32 start_block;
+	__le32 fragment;
+	__le32 offset;
+	__le32 file_size;
+	/* followed by the block list */
+} __packed;
+
+struct sqfs_lreg_inode {
+	__le64 start_block;
+	__le64 file_size;
+	__le64 sparse;
+	__le32 nlink;
+	__le32 fragment;
+	__le32 offset;
+	__le32 xattr;
+	/* followed by the block list */
+} __packed;
+
+struct sqfs_symlink_inode {
+	__le32 nlink;
+	__le32 symlink_size;
+	/* followed by the target */
+} __packed;
+
+struct sqfs_dir_header {
+	__le32 count;
+	__le32 start_block;
+	__le32 inode_number;
+} __packed;
+
+struct sqfs_dir_entry {
+	__le16 offset;
+	__le16 inode_number;
+	__le16 type;
+	__le16 size;
+	/* followed by the name, size + 1 bytes */
+} __packed;
+
+struct sqfs_fragment_entry {
+	__le64 start_block;
+	__le32 size;
+	__le32 unused;
+} __packed;
+
+/* A position in a metadata table: the block's address and an offset in it */
+struct sqfs_meta_pos {
+	u64 block;
+	u32 offset;
+};
+
+/* An inode, with the fields of its type converted to CPU byte order */
+struct sqfs_inode {
+	u16 type;		/* basic type, SQFS_DIR_TYPE... */
+	u16 mode;
+	u32 mtime;
+	u32 number;
+	u64 size;
+
+	/* directories */
+	u32 dir_block;
+	u16 dir_offset;
+	u16 index_count;
+	struct sqfs_meta_pos index_pos;
+
+	/* regular files */
+	u64 start_block;
+	u32 fragment;
+	u32 frag_offset;
+	struct sqfs_meta_pos blocks_pos;
+
+	/* symlinks */
+	struct sqfs_meta_pos target_pos;
+};
+
+struct sqfs_dirent {
+	char name[SQFS_NAME_LEN + 1];
+	u16 type;
+	u64 inode_ref;
+};
+
+struct sqfs_dir_iter {
+	struct sqfs_meta_pos pos;
+	u32 remaining;		/* bytes left in the directory listing */
+	u32 count;		/* entries left under the current header */
+	u32 start_block;	/* inode block of the current header */
+};
+
+struct sqfs_info {
+	struct blk_desc *desc;
+	disk_partition_t *part;
+	struct sqfs_super_block sb;
+	u32 block_size;
+	u16 block_log;
+	u16 compression;
+	u64 *fragment_index;
+};
+
+extern struct sqfs_info sqfs_info;
+
+/* cache.c */
+int sqfs_devread(u64 address, u32 len, void *buf);
+int sqfs_read_meta(struct sqfs_meta_pos *pos, void *buf, u32 len);
+int sqfs_skip_meta(struct sqfs_meta_pos *pos, u32 len);
+int sqfs_read_block(u64 address, u32 size, void *buf, u32 *len);
+const u8 *sqfs_get_block(u64 address, u32 size, u32 *len);
+void sqfs_cache_drop(void);
+
+/* decompress.c */
+int sqfs_decompressor_init(void);
+int sqfs_decompress(const void *src, u32 srclen, void *dst, u32 *dstlen);
+
+/* inode.c */
+int sqfs_read_inode(u64 ref, struct sqfs_inode *inode);
+int sqfs_dir_open(const struct sqfs_inode *dir, const char *name,
+		  struct sqfs_dir_iter *it);
+int sqfs_dir_next(struct sqfs_dir_iter *it, struct sqfs_dirent *ent);
+int sqfs_readlink(const struct sqfs_inode *inode, char *target);
+int sqfs_lookup_path(const char *path, struct sqfs_inode *inode);
+
+/* file.c */
+int sqfs_file_read(const struct sqfs_inode *inode, u64 offset, u64 len,
+		   void *buf, u64 *actread);
+
+#endif /* __FS_SQUASHFS_H__ */
@@ -0,0 +1,208 @@
+/*
+ * Format of the arm64 page tables, and the code which builds and changes
+ * them in memory
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ *
+ * Nothing here touches the MMU, so that the page table code can also be
+ * built and tested on sandbox. asm/armv8/mmu.h has the rest.
+ */
+
+#ifndef __ARMV8_PGTABLE_H
+#define __ARMV8_PGTABLE_H
+
+/*
+ * Memory types
+ */
+#define MT_DEVICE_NGNRNE	0
+#define MT_DEVICE_NGNRE		1
+#define MT_DEVICE_GRE		2
+#define MT_NORMAL_NC		3
+#define MT_NORMAL		4
+#define MT_NORMAL_WT		5
+
+#define MEMORY_ATTRIBUTES	((0x00 << (MT_DEVICE_NGNRNE * 8)) |	\
+				(0x04 << (MT_DEVICE_NGNRE * 8))   |	\
+				(0x0c << (MT_DEVICE_GRE * 8))     |	\
+				(0x44 << (MT_NORMAL_NC * 8))      |	\
+				(UL(0xff) << (MT_NORMAL * 8))     |	\
+				(UL(0xbb) << (MT_NORMAL_WT * 8)))
+
+/*
+ * Hardware page table definitions.
+ *
+ */
+
+#define PTE_TYPE_MASK		(3 << 0)
+#define PTE_TYPE_FAULT		(0 << 0)
+#define PTE_TYPE_TABLE		(3 << 0)
+#define PTE_TYPE_PAGE		(3 << 0)
+#define PTE_TYPE_BLOCK		(1 << 0)
+#define PTE_TYPE_VALID		(1 << 0)
+
+/* Bits of a PTE which hold the output address */
+#define PTE_ADDR_MASK		0x0000fffffffff000ULL
+
+#define PTE_TABLE_PXN		(1UL << 59)
+#define PTE_TABLE_XN		(1UL << 60)
+#define PTE_TABLE_AP		(1UL << 61)
+#define PTE_TABLE_NS		(1UL << 63)
+
+/*
+ * Block
+ */
+#define PTE_BLOCK_MEMTYPE(x)	((x) << 2)
+#define PTE_BLOCK_NS            (1 << 5)
+#define PTE_BLOCK_NON_SHARE	(0 << 8)
+#define PTE_BLOCK_OUTER_SHARE	(2 << 8)
+#define PTE_BLOCK_INNER_SHARE	(3 << 8)
+#define PTE_BLOCK_AF		(1 << 10)
+#define PTE_BLOCK_NG		(1 << 11)
+#define PTE_BLOCK_PXN		(UL(1) << 53)
+#define PTE_BLOCK_UXN		(UL(1) << 54)
+
+/*
+ * AttrIndx[2:0]
+ */
+#define PMD_ATTRINDX(t)		((t) << 2)
+#define PMD_ATTRINDX_MASK	(7 << 2)
+#define PMD_ATTRMASK		(PTE_BLOCK_PXN		| \
+				 PTE_BLOCK_UXN		| \
+				 PMD_ATTRINDX_MASK	| \
+				 PTE_TYPE_VALID)
+
+/*
+ * TCR flags.
+ */
+#define TCR_T0SZ(x)		((64 - (x)) << 0)
+#define TCR_IRGN_NC		(0 << 8)
+#define TCR_IRGN_WBWA		(1 << 8)
+#define TCR_IRGN_WT		(2 << 8)
+#define TCR_IRGN_WBNWA		(3 << 8)
+#define TCR_IRGN_MASK		(3 << 8)
+#define TCR_ORGN_NC		(0 << 10)
+#define TCR_ORGN_WBWA		(1 << 10)
+#define TCR_ORGN_WT		(2 << 10)
+#define TCR_ORGN_WBNWA		(3 << 10)
+#define TCR_ORGN_MASK		(3 << 10)
+#define TCR_SHARED_NON		(0 << 12)
+#define TCR_SHARED_OUTER	(2 << 12)
+#define TCR_SHARED_INNER	(3 << 12)
+#define TCR_TG0_4K		(0 << 14)
+#define TCR_TG0_64K		(1 << 14)
+#define TCR_TG0_16K		(2 << 14)
+#define TCR_EPD1_DISABLE	(1 << 23)
+
+#define TCR_EL1_RSVD		(1 << 31)
+#define TCR_EL2_RSVD		(1 << 31 | 1 << 23)
+#define TCR_EL3_RSVD		(1 << 31 | 1 << 23)
+
+#ifndef __ASSEMBLY__
+struct mm_region {
+	u64 virt;
+	u64 phys;
+	u64 size;
+	u64 attrs;
+};
+
+extern struct mm_region *mem_map;
+u64 get_tcr(int el, u64 *pips, u64 *pva_bits);
+u64 get_page_table_size(void);
+
+/**
+ * struct pgtable - Page tables and the memory they are allocated from
+ *
+ * @addr:	Address of the top-level table
+ * @size:	Bytes of memory for tables, from @addr
+ * @fillptr:	Address of the next table to allocate
+ * @free:	Tables freed by merging, each holding the address of the next,
+ *		or 0 if there are none
+ * @splits:	Number of blocks split into tables
+ * @merges:	Number of tables merged back into blocks
+ */
+struct pgtable {
+	ulong addr;
+	ulong size;
+	ulong fillptr;
+	ulong free;
+	uint splits;
+	uint merges;
+};
+
+/**
+ * pgtable_setup() - Build the page tables for mem_map
+ *
+ * The tables are allocated from @pt->fillptr on.
+ *
+ * @pt:		Page tables to build
+ */
+void pgtable_setup(struct pgtable *pt);
+
+/**
+ * pgtable_set_region() - Set the attributes of a range in the page tables
+ *
+ * Blocks which the range only partly covers are split into tables.
+ *
+ * @pt:		Page tables to change
+ * @start:	Start address, page-aligned
+ * @size:	Size in bytes, a multiple of the page size
+ * @attrs:	Attributes to set
+ * @flag:	true to set the PMD_ATTRMASK bits of @attrs, so also the valid
+ *		and execute-never bits; false to set only the memory type. A
+ *		block which has that memory type already is left alone
+ */
+void pgtable_set_region(struct pgtable *pt, u64 start, u64 size, u64 attrs,
+			bool flag);
+
+/**
+ * pgtable_region_has_attrs() - Check the memory type of a range
+ *
+ * @pt:		Page tables to look in
+ * @start:	Start address
+ * @size:	Size in bytes
+ * @attrs:	Memory type, as PMD_ATTRINDX()
+ * @return true if all of the range is mapped with that memory type
+ */
+bool pgtable_region_has_attrs(struct pgtable *pt, u64 start, u64 size,
+			      u64 attrs);
+
+/**
+ * pgtable_merge_region() - Merge tables back into blocks
+ *
+ * Each table which maps any part of the range, and whose entries map one
+ * contiguous range with the same attributes, is replaced by a block. Its
+ * memory is kept for the next split.
+ *
+ * @pt:		Page tables to change
+ * @start:	Start address
+ * @size:	Size in bytes
+ */
+void pgtable_merge_region(struct pgtable *pt, u64 start, u64 size);
+
+/**
+ * struct mmu_stats - How the page tables map memory
+ *
+ * @table_bytes:	Size of the page tables in use, emergency ones included
+ * @splits:		Number of blocks split into tables
+ * @merges:		Number of tables merged back into blocks
+ * @blocks:		Number of entries mapping memory at each level: 1 GiB
+ *			blocks at level 1, 2 MiB blocks at level 2 and 4 KiB
+ *			pages at level 3
+ */
+struct mmu_stats {
+	ulong table_bytes;
+	uint splits;
+	uint merges;
+	uint blocks[4];
+};
+
+/**
+ * pgtable_get_stats() - Get how page tables map memory
+ *
+ * @pt:		Page tables to look at
+ * @stats:	Returns the statistics, all zero if @pt has no tables yet
+ */
+void pgtable_get_stats(struct pgtable *pt, struct mmu_stats *stats);
+#endif
+
+#endif /* __ARMV8_PGTABLE_H */
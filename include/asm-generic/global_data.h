@@ -93,6 +93,11 @@ typedef struct global_data {
 	unsigned long malloc_limit;	/* limit address */
 	unsigned long malloc_ptr;	/* current address */
 #endif
+#ifdef CONFIG_MEM_HIGHWATER
+	unsigned long stack_top;	/* stack pointer when it was painted */
+	unsigned long stack_paint_base;	/* lowest painted stack address */
+	unsigned long stack_f_used;	/* pre-relocation stack high-water */
+#endif
 #ifdef CONFIG_PCI
 	struct pci_controller *hose;	/* PCI hose for early use */
 	phys_addr_t pci_ram_top;	/* top of region accessible to PCI */
@@ -118,6 +123,9 @@ typedef struct global_data {
 	int log_drop_count;		/* Number of dropped log messages */
 	int default_log_level;		/* For devices with no filters */
 	struct list_head log_head;	/* List of struct log_device */
+#ifdef CONFIG_LOG_RING
+	struct log_ring *log_ring;	/* Binary log ring */
+#endif
 #endif
 } gd_t;
 #endif
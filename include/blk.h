@@ -85,6 +85,9 @@ struct blk_desc {
 		uint32_t mbr_sig;	/* MBR integer signature */
 		efi_guid_t guid_sig;	/* GPT GUID Signature */
 	};
+#if CONFIG_IS_ENABLED(PARTITION_CACHE)
+	struct part_cache *part_cache;	/* see disk/part_cache.c */
+#endif
 #if CONFIG_IS_ENABLED(BLK)
 	/*
 	 * For now we have a few functions which take struct blk_desc as a
@@ -197,6 +200,39 @@ static inline void blkcache_invalidate(int iftype, int dev) {}
 
 #endif
 
+#if CONFIG_IS_ENABLED(PARTITION_CACHE)
+/**
+ * part_cache_invalidate() - discard the cached partition table of a device
+ * because of a write or device (re)initialization.
+ *
+ * @param dev_desc - block device descriptor
+ */
+void part_cache_invalidate(struct blk_desc *dev_desc);
+
+/**
+ * part_cache_remove() - free the partition cache of a device that is going
+ * away
+ *
+ * @param dev_desc - block device descriptor
+ */
+void part_cache_remove(struct blk_desc *dev_desc);
+#else
+static inline void part_cache_invalidate(struct blk_desc *dev_desc) {}
+static inline void part_cache_remove(struct blk_desc *dev_desc) {}
+#endif
+
+#if CONFIG_IS_ENABLED(FS_SQUASHFS)
+/**
+ * sqfs_cache_invalidate() - discard the SquashFS metadata and blocks cached
+ * from a device because of a write or device (re)initialization.
+ *
+ * @param dev_desc - block device descriptor
+ */
+void sqfs_cache_invalidate(struct blk_desc *dev_desc);
+#else
+static inline void sqfs_cache_invalidate(struct blk_desc *dev_desc) {}
+#endif
+
 #if CONFIG_IS_ENABLED(BLK)
 struct udevice;
 
@@ -440,6 +476,8 @@ static inline ulong blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
 			       lbaint_t blkcnt, const void *buffer)
 {
 	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
+	part_cache_invalidate(block_dev);
+	sqfs_cache_invalidate(block_dev);
 	return block_dev->block_write(block_dev, start, blkcnt, buffer);
 }
 
@@ -447,6 +485,8 @@ static inline ulong blk_derase(struct blk_desc *block_dev, lbaint_t start,
 			       lbaint_t blkcnt)
 {
 	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
+	part_cache_invalidate(block_dev);
+	sqfs_cache_invalidate(block_dev);
 	return block_dev->block_erase(block_dev, start, blkcnt);
 }
 
@@ -16,6 +16,7 @@
 enum bootstage_flags {
 	BOOTSTAGEF_ERROR	= 1 << 0,	/* Error record */
 	BOOTSTAGEF_ALLOC	= 1 << 1,	/* Allocate an id */
+	BOOTSTAGEF_SIZE		= 1 << 2,	/* Size in bytes, not a time */
 };
 
 /* bootstate sub-IDs used for kernel and ramdisk ranges */
@@ -201,6 +202,12 @@ enum bootstage_id {
 	BOOTSTATE_ID_ACCUM_DM_F,
 	BOOTSTATE_ID_ACCUM_DM_R,
 
+	BOOTSTAGE_ID_HEAP_F,
+	BOOTSTAGE_ID_STACK_F,
+	BOOTSTAGE_ID_HEAP_R,
+	BOOTSTAGE_ID_STACK_R,
+	BOOTSTAGE_ID_ACCUM_ENV,
+
 	/* a few spare for the user, from here */
 	BOOTSTAGE_ID_USER,
 	BOOTSTAGE_ID_ALLOC,
@@ -278,6 +285,19 @@ ulong bootstage_mark_name(enum bootstage_id id, const char *name);
 ulong bootstage_mark_code(const char *file, const char *func,
 			  int linenum);
 
+/**
+ * Record a size against a bootstage id
+ *
+ * This is used for memory high-water marks. Unlike a time stamp, a later
+ * call for the same id updates the value. Size records are shown in their
+ * own section of the report.
+ *
+ * @param id	Bootstage id to record this size against
+ * @param name	Textual name to display for this id in the report
+ * @param size	Size in bytes
+ */
+void bootstage_set_size(enum bootstage_id id, const char *name, ulong size);
+
 /**
  * Mark the start of a bootstage activity. The end will be marked later with
  * bootstage_accum() and at that point we accumulate the time taken. Calling
@@ -394,6 +414,11 @@ static inline ulong bootstage_mark_code(const char *file, const char *func,
 	return 0;
 }
 
+static inline void bootstage_set_size(enum bootstage_id id, const char *name,
+				      ulong size)
+{
+}
+
 static inline uint32_t bootstage_start(enum bootstage_id id, const char *name)
 {
 	return 0;
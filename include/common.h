@@ -615,6 +615,32 @@ int gzwrite(unsigned char *src, int len,
 /* lib/lz4_wrapper.c */
 int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn);
 
+/**
+ * ulz4bn() - decompress a single raw LZ4 block, without a frame around it
+ *
+ * @src:	compressed data
+ * @srcn:	number of bytes at @src
+ * @dst:	buffer for the decompressed data
+ * @dstn:	on entry, size of @dst; on success, number of bytes written
+ * @return 0 if OK, -EPROTO if the data is not valid or does not fit
+ */
+int ulz4bn(const void *src, size_t srcn, void *dst, size_t *dstn);
+
+/**
+ * zstd_decompress() - decompress a Zstandard frame
+ *
+ * Data after the end of the first frame in @src, such as padding, is
+ * ignored.
+ *
+ * @src:	compressed data
+ * @srcn:	number of bytes at @src
+ * @dst:	buffer for the decompressed data
+ * @dstn:	on entry, size of @dst; on success, number of bytes written
+ * @return 0 if OK, -ENOSPC if @dst is too small, -ENOMEM if out of
+ *	memory, -EINVAL if the data is not a valid frame
+ */
+int zstd_decompress(const void *src, size_t srcn, void *dst, size_t *dstn);
+
 /* lib/qsort.c */
 void qsort(void *base, size_t nmemb, size_t size,
 	   int(*compar)(const void *, const void *));
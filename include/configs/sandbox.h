@@ -29,6 +29,9 @@
 #define CONFIG_EXT4_WRITE
 #define CONFIG_HOST_MAX_DEVICES 4
 
+/* USB mass storage gadget, run on the sandbox device controller */
+#define CONFIG_USB_FUNCTION_MASS_STORAGE
+
 /*
  * Size of malloc() pool, before and after relocation
  */
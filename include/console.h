@@ -54,6 +54,19 @@ void console_record_reset_enable(void);
  */
 int console_announce_r(void);
 
+/**
+ * console_flush() - send all buffered console output
+ *
+ * With CONFIG_CONSOLE_BUFFER, console output may still be waiting to go out
+ * to a device. This waits until all of it is sent. It must be called before
+ * anything which stops U-Boot's console, such as jumping to an OS or reset.
+ */
+#if CONFIG_IS_ENABLED(CONSOLE_BUFFER)
+void console_flush(void);
+#else
+static inline void console_flush(void) {}
+#endif
+
 /*
  * CONSOLE multiplexing.
  */
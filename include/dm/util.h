@@ -17,6 +17,16 @@ static inline void dm_warn(const char *fmt, ...)
 
 struct list_head;
 
+/**
+ * dm_calloc() - Allocate zeroed memory for a device or uclass
+ *
+ * The memory is accounted to driver model in 'malloc info'.
+ *
+ * @size:	Number of bytes to allocate
+ * @return pointer to memory, or NULL if out of memory
+ */
+void *dm_calloc(size_t size);
+
 /**
  * list_count_items() - Count number of items in a list
  *
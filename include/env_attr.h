@@ -36,4 +36,21 @@ int env_attr_walk(const char *attr_list,
  */
 int env_attr_lookup(const char *attr_list, const char *name, char *attributes);
 
+#ifndef USE_HOSTCC
+struct entry;
+struct hsearch_data;
+
+/*
+ * env_attr_walk_htab takes as input an "attr_list" with the same form as above.
+ * For each element in turn it calls "callback" on every variable in "htab"
+ * that the element's name matches, with the element's attributes (which
+ * may be NULL). A variable matched by several elements therefore sees the
+ * one env_attr_lookup would return last. This lets a whole table be bound
+ * to its attributes with one pass over the list instead of one per variable.
+ * Returns 0 on success.
+ */
+int env_attr_walk_htab(const char *attr_list, struct hsearch_data *htab,
+	void (*callback)(struct entry *entry, const char *attributes));
+#endif
+
 #endif /* __ENV_ATTR_H__ */
@@ -82,6 +82,7 @@ struct env_clbk_tbl {
 };
 
 void env_callback_init(ENTRY *var_entry);
+void env_callback_init_table(struct hsearch_data *htab);
 
 /*
  * Define a callback that can be associated with variables.
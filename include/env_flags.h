@@ -155,6 +155,12 @@ int env_flags_validate_env_set_params(char *name, char *const val[], int count);
  */
 void env_flags_init(ENTRY *var_entry);
 
+/*
+ * When a whole table has been populated at once, initialize the flags for
+ * all of its variables.
+ */
+void env_flags_init_table(struct hsearch_data *htab);
+
 /*
  * Validate the newval for to conform with the requirements defined by its flags
  */
@@ -180,6 +180,9 @@ extern uint mmc_get_env_part(struct mmc *mmc);
 #include <env_flags.h>
 #include <search.h>
 
+/* Default environment laid out as a hash table, see env/gen_envhash.c */
+extern const struct hprebuilt env_default_hashed;
+
 /* Value for environment validity */
 enum env_valid {
 	ENV_INVALID,	/* No valid environment */
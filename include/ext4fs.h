@@ -34,6 +34,7 @@
 #define EXT4_FEATURE_RO_COMPAT_GDT_CSUM	0x0010
 #define EXT4_FEATURE_INCOMPAT_EXTENTS	0x0040
 #define EXT4_FEATURE_INCOMPAT_64BIT	0x0080
+#define EXT4_FEATURE_INCOMPAT_LARGEDIR	0x4000
 #define EXT4_INDIRECT_BLOCKS		12
 
 #define EXT4_BG_INODE_UNINIT		0x0001
@@ -78,6 +79,43 @@ struct ext4_extent_header {
 	__le32	eh_generation;	/* generation of the tree */
 };
 
+/* Superblock flags which say how directory hashes treat names */
+#define EXT2_FLAGS_SIGNED_HASH		0x0001
+#define EXT2_FLAGS_UNSIGNED_HASH	0x0002
+
+/* Hash functions of hash tree (dir_index) directories */
+#define DX_HASH_LEGACY			0
+#define DX_HASH_HALF_MD4		1
+#define DX_HASH_TEA			2
+#define DX_HASH_LEGACY_UNSIGNED		3
+#define DX_HASH_HALF_MD4_UNSIGNED	4
+#define DX_HASH_TEA_UNSIGNED		5
+
+/*
+ * Block 0 of a hash tree directory starts with the "." and ".." entries,
+ * followed by this and the root's index entries. The other index blocks
+ * hold one empty directory entry covering the block, then index entries.
+ */
+struct dx_root_info {
+	__le32	reserved_zero;
+	__u8	hash_version;	/* DX_HASH_... */
+	__u8	info_length;	/* size of this structure */
+	__u8	indirect_levels;	/* index levels below the root */
+	__u8	unused_flags;
+};
+
+/* Entries covering names whose hash is at least @hash are in @block */
+struct dx_entry {
+	__le32	hash;
+	__le32	block;		/* block in the directory */
+};
+
+/* This replaces the hash of the first entry of each index block */
+struct dx_countlimit {
+	__le16	limit;		/* entries which fit in the block */
+	__le16	count;		/* entries in use */
+};
+
 struct ext_filesystem {
 	/* Total Sector of partition */
 	uint64_t total_sect;
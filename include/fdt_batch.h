@@ -0,0 +1,208 @@
+/*
+ * Batched device tree edits
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __FDT_BATCH_H
+#define __FDT_BATCH_H
+
+#include <libfdt.h>
+
+/*
+ * Each fdt_setprop() or fdt_add_subnode() call moves the tail of the blob
+ * to open a gap. A batch instead records a list of edits against a blob
+ * and applies them all in a single pass that copies the unchanged parts
+ * of the blob verbatim and writes a freshly packed result.
+ *
+ * Nodes are named by absolute path ("/chosen", "/memory"). Nodes that do
+ * not exist yet are created, along with any missing parents, when the
+ * batch is applied. New properties are added after the existing ones and
+ * new nodes after the existing subnodes.
+ *
+ * Errors are sticky: once an edit fails every later call, including
+ * fdt_batch_apply(), returns the same error. Callers may therefore queue
+ * a series of edits and only check the result of fdt_batch_apply().
+ */
+
+struct fdt_batch_node;
+struct fdt_batch_prop;
+
+/**
+ * struct fdt_batch - A list of pending edits to a device tree blob
+ *
+ * @fdt: Blob the edits apply to
+ * @nodes: Nodes touched by the edits, the root first
+ * @node_count: Number of entries in @nodes
+ * @node_max: Allocated size of @nodes
+ * @props: Properties to set or delete
+ * @prop_count: Number of entries in @props
+ * @prop_max: Allocated size of @props
+ * @data: Storage for node names, property names and values
+ * @data_len: Number of bytes used in @data
+ * @data_max: Allocated size of @data
+ * @err: First error seen, or 0
+ */
+struct fdt_batch {
+	const void *fdt;
+	struct fdt_batch_node *nodes;
+	int node_count;
+	int node_max;
+	struct fdt_batch_prop *props;
+	int prop_count;
+	int prop_max;
+	char *data;
+	int data_len;
+	int data_max;
+	int err;
+};
+
+/**
+ * fdt_batch_init() - Start a new batch of edits
+ *
+ * @b: Batch to set up
+ * @fdt: Blob the edits will be applied to
+ */
+void fdt_batch_init(struct fdt_batch *b, const void *fdt);
+
+/**
+ * fdt_batch_free() - Release the memory used by a batch
+ *
+ * Pending edits are discarded.
+ *
+ * @b: Batch to free
+ */
+void fdt_batch_free(struct fdt_batch *b);
+
+/**
+ * fdt_batch_node() - Look up or queue the creation of a node
+ *
+ * @b: Batch to update
+ * @parent: Parent node as returned by this function, or 0 for the root
+ * @name: Name of the node, including any unit address
+ * @return node handle (>= 0) for use with fdt_batch_setprop_node(), or
+ * -FDT_ERR_... on error
+ */
+int fdt_batch_node(struct fdt_batch *b, int parent, const char *name);
+
+/**
+ * fdt_batch_path() - Look up or queue the creation of a node by path
+ *
+ * Missing nodes along the path are created too.
+ *
+ * @b: Batch to update
+ * @path: Absolute path of the node
+ * @return node handle (>= 0), or -FDT_ERR_... on error
+ */
+int fdt_batch_path(struct fdt_batch *b, const char *path);
+
+/**
+ * fdt_batch_offset() - Get the handle of a node that exists in the blob
+ *
+ * @b: Batch to update
+ * @nodeoffset: Offset of the node in the blob the batch was set up with
+ * @return node handle (>= 0), or -FDT_ERR_... on error
+ */
+int fdt_batch_offset(struct fdt_batch *b, int nodeoffset);
+
+/**
+ * fdt_batch_setprop_node() - Queue setting a property
+ *
+ * The value is copied, so the caller's buffer may be reused straight away.
+ * Setting the same property twice keeps the last value.
+ *
+ * @b: Batch to update
+ * @node: Node handle
+ * @name: Property name
+ * @val: Property value
+ * @len: Length of @val in bytes
+ * @return 0 if ok, or -FDT_ERR_... on error
+ */
+int fdt_batch_setprop_node(struct fdt_batch *b, int node, const char *name,
+			   const void *val, int len);
+
+/**
+ * fdt_batch_delprop_node() - Queue deleting a property
+ *
+ * Deleting a property which does not exist is not an error.
+ *
+ * @b: Batch to update
+ * @node: Node handle
+ * @name: Property name
+ * @return 0 if ok, or -FDT_ERR_... on error
+ */
+int fdt_batch_delprop_node(struct fdt_batch *b, int node, const char *name);
+
+/**
+ * fdt_batch_setprop() - Queue setting a property of a node given by path
+ *
+ * @b: Batch to update
+ * @path: Absolute path of the node, which is created if needed
+ * @name: Property name
+ * @val: Property value
+ * @len: Length of @val in bytes
+ * @return 0 if ok, or -FDT_ERR_... on error
+ */
+int fdt_batch_setprop(struct fdt_batch *b, const char *path, const char *name,
+		      const void *val, int len);
+
+static inline int fdt_batch_setprop_string(struct fdt_batch *b,
+					   const char *path, const char *name,
+					   const char *str)
+{
+	return fdt_batch_setprop(b, path, name, str, strlen(str) + 1);
+}
+
+static inline int fdt_batch_setprop_u32(struct fdt_batch *b, const char *path,
+					const char *name, uint32_t val)
+{
+	fdt32_t tmp = cpu_to_fdt32(val);
+
+	return fdt_batch_setprop(b, path, name, &tmp, sizeof(tmp));
+}
+
+static inline int fdt_batch_setprop_u64(struct fdt_batch *b, const char *path,
+					const char *name, uint64_t val)
+{
+	fdt64_t tmp = cpu_to_fdt64(val);
+
+	return fdt_batch_setprop(b, path, name, &tmp, sizeof(tmp));
+}
+
+/**
+ * fdt_batch_merge() - Queue merging a subtree into a node
+ *
+ * Every property of @node in @src is set on @target, and every subnode of
+ * @node is merged into the subnode of @target with the same name, which
+ * is created if needed. This is what overlay application does with the
+ * contents of each fragment.
+ *
+ * @b: Batch to update
+ * @target: Node handle to merge into
+ * @src: Blob containing the subtree
+ * @node: Offset of the subtree in @src
+ * @return 0 if ok, or -FDT_ERR_... on error
+ */
+int fdt_batch_merge(struct fdt_batch *b, int target, const void *src,
+		    int node);
+
+/**
+ * fdt_batch_apply() - Apply all queued edits
+ *
+ * The blob is rewritten in one pass and comes out packed, with its total
+ * size left unchanged so that there is room for later in-place edits. The
+ * batch is emptied and may be reused for further edits to the same blob.
+ *
+ * Blobs older than version 17, and all blobs if CONFIG_FDT_BATCH is not
+ * enabled, are instead converted to version 17 in place and edited one
+ * property at a time. A failure part way through then leaves the earlier
+ * edits in place.
+ *
+ * @b: Batch to apply
+ * @fdt: Blob the batch was set up with
+ * @return 0 if ok, -FDT_ERR_NOSPACE if the result does not fit in the
+ * blob's total size, or another -FDT_ERR_... on error
+ */
+int fdt_batch_apply(struct fdt_batch *b, void *fdt);
+
+#endif
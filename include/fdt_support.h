@@ -12,6 +12,8 @@
 
 #include <libfdt.h>
 
+struct fdt_batch;
+
 u32 fdt_getprop_u32_default_node(const void *fdt, int off, int cell,
 				const char *prop, const u32 dflt);
 u32 fdt_getprop_u32_default(const void *fdt, const char *path,
@@ -27,6 +29,14 @@ u32 fdt_getprop_u32_default(const void *fdt, const char *path,
  */
 int fdt_root(void *fdt);
 
+/**
+ * Queue the root node additions done by fdt_root() on a batch.
+ *
+ * @param b		Batch of edits to the FDT (see fdt_batch.h)
+ * @return 0 if ok, or -FDT_ERR_... on error
+ */
+int fdt_batch_root(struct fdt_batch *b);
+
 /**
  * Add chosen data the FDT before booting the OS.
  *
@@ -37,6 +47,14 @@ int fdt_root(void *fdt);
  */
 int fdt_chosen(void *fdt);
 
+/**
+ * Queue the /chosen node updates done by fdt_chosen() on a batch.
+ *
+ * @param b		Batch of edits to the FDT (see fdt_batch.h)
+ * @return 0 if ok, or -FDT_ERR_... on error
+ */
+int fdt_batch_chosen(struct fdt_batch *b);
+
 /**
  * Add initrd information to the FDT before booting the OS.
  *
@@ -95,12 +113,21 @@ int fdt_fixup_memory(void *blob, u64 start, u64 size);
  */
 #ifdef CONFIG_ARCH_FIXUP_FDT_MEMORY
 int fdt_fixup_memory_banks(void *blob, u64 start[], u64 size[], int banks);
+/* As fdt_fixup_memory_banks(), but queued on a batch of edits */
+int fdt_batch_memory_banks(struct fdt_batch *b, u64 start[], u64 size[],
+			   int banks);
 #else
 static inline int fdt_fixup_memory_banks(void *blob, u64 start[], u64 size[],
 					 int banks)
 {
 	return 0;
 }
+
+static inline int fdt_batch_memory_banks(struct fdt_batch *b, u64 start[],
+					 u64 size[], int banks)
+{
+	return 0;
+}
 #endif
 
 void fdt_fixup_ethernet(void *fdt);
@@ -133,6 +160,22 @@ void fdt_fixup_crypto_node(void *blob, int sec_rev);
 static inline void fdt_fixup_crypto_node(void *blob, int sec_rev) {}
 #endif
 
+/**
+ * fdt_add_reserved_memory() - Add a region to /reserved-memory
+ *
+ * Creates /reserved-memory if necessary, then adds (or updates) a no-map
+ * subnode named <basename>@<start> covering the region.
+ *
+ * @blob: FDT blob to update
+ * @basename: Base name of the new node
+ * @compat: Compatible string for the node, or NULL for none
+ * @start: Start address of the region
+ * @size: Size of the region in bytes
+ * @return 0 if ok, or -FDT_ERR_... on error
+ */
+int fdt_add_reserved_memory(void *blob, const char *basename,
+			    const char *compat, u64 start, u64 size);
+
 /**
  * Record information about a processed loadable in /fit-images (creating
  * /fit-images if necessary).
@@ -284,6 +327,24 @@ int fdt_setup_simplefb_node(void *fdt, int node, u64 base_address, u32 width,
 
 int fdt_overlay_apply_verbose(void *fdt, void *fdto);
 
+/**
+ * Apply a list of overlays in order.
+ *
+ * For each overlay the base tree is walked once to build maps of its
+ * phandles and /__symbols__ labels, which then serve all of the overlay's
+ * fixups, and the overlay is merged with one batched rewrite of the base
+ * tree. Later overlays may refer to labels added by earlier ones.
+ *
+ * As with fdt_overlay_apply(), the overlays are modified and must not be
+ * used afterwards.
+ *
+ * @param fdt		FDT blob to update, which must have room for the result
+ * @param fdtos		Overlays to apply
+ * @param count		Number of entries in @fdtos
+ * @return 0 if ok, or -FDT_ERR_... on error
+ */
+int fdt_overlay_apply_list(void *fdt, void * const fdtos[], int count);
+
 #endif /* ifdef CONFIG_OF_LIBFDT */
 
 #ifdef USE_HOSTCC
@@ -658,6 +658,86 @@ const char *fdtdec_get_compatible(enum fdt_compat_id id);
  */
 int fdtdec_lookup_phandle(const void *blob, int node, const char *prop_name);
 
+/**
+ * struct fdtdec_cache_stats - Statistics for the lookup caches
+ *
+ * @hits: Lookups answered from the caches
+ * @misses: Lookups which had to scan the blob
+ * @builds: Number of times the phandle table was built
+ * @invalidations: Number of times the caches were dropped
+ */
+struct fdtdec_cache_stats {
+	ulong hits;
+	ulong misses;
+	ulong builds;
+	ulong invalidations;
+};
+
+#if CONFIG_IS_ENABLED(OF_CACHE)
+/**
+ * fdtdec_node_offset_by_phandle() - Find a node by phandle, with caching
+ *
+ * This behaves like fdt_node_offset_by_phandle() but looks the phandle up
+ * in a table which is built on first use, so that repeated lookups do not
+ * each scan the whole blob. Before relocation the blob is scanned as usual.
+ *
+ * @blob:	FDT blob
+ * @phandle:	Phandle to look up
+ * @return node offset, or -FDT_ERR_... on error
+ */
+int fdtdec_node_offset_by_phandle(const void *blob, uint32_t phandle);
+
+/**
+ * fdtdec_path_offset() - Find a node by path or alias, with caching
+ *
+ * This behaves like fdt_path_offset(). Recently used paths are remembered
+ * along with the offset they resolved to.
+ *
+ * @blob:	FDT blob
+ * @path:	Full path of the node, or an alias optionally followed by a
+ *		relative path
+ * @return node offset, or -FDT_ERR_... on error
+ */
+int fdtdec_path_offset(const void *blob, const char *path);
+
+/**
+ * fdtdec_cache_invalidate() - Drop the lookup caches for a blob
+ *
+ * This must be called after changing a blob in a way which may move nodes
+ * without changing the size of its structure or strings blocks.
+ *
+ * @blob:	FDT blob which was changed, or NULL for any
+ */
+void fdtdec_cache_invalidate(const void *blob);
+
+/**
+ * fdtdec_cache_get_stats() - Read the lookup cache statistics
+ *
+ * @stats:	Returns the statistics
+ */
+void fdtdec_cache_get_stats(struct fdtdec_cache_stats *stats);
+#else
+static inline int fdtdec_node_offset_by_phandle(const void *blob,
+						uint32_t phandle)
+{
+	return fdt_node_offset_by_phandle(blob, phandle);
+}
+
+static inline int fdtdec_path_offset(const void *blob, const char *path)
+{
+	return fdt_path_offset(blob, path);
+}
+
+static inline void fdtdec_cache_invalidate(const void *blob)
+{
+}
+
+static inline void fdtdec_cache_get_stats(struct fdtdec_cache_stats *stats)
+{
+	memset(stats, '\0', sizeof(*stats));
+}
+#endif
+
 /**
  * Look up a property in a node and return its contents in an integer
  * array of given length. The property must have at least enough data for
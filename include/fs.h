@@ -14,6 +14,7 @@
 #define FS_TYPE_SANDBOX	3
 #define FS_TYPE_UBIFS	4
 #define FS_TYPE_BTRFS	5
+#define FS_TYPE_SQUASHFS	6
 
 /*
  * Tell the fs layer which block device an partition to use for future
@@ -38,6 +39,16 @@ int fs_set_blk_dev(const char *ifname, const char *dev_part_str, int fstype);
  */
 int fs_set_blk_dev_with_part(struct blk_desc *desc, int part);
 
+/*
+ * fs_sniff - Identify the filesystem on a partition from its signature
+ *
+ * Only the magic numbers are checked, so the filesystem may still fail to
+ * probe. This is used to pick the filesystem to probe first.
+ *
+ * Returns the FS_TYPE_... found, or FS_TYPE_ANY if none is recognised.
+ */
+int fs_sniff(struct blk_desc *desc, disk_partition_t *part);
+
 /*
  * Print the list of files on the partition previously set by fs_set_blk_dev(),
  * in directory "dirname".
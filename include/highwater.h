@@ -0,0 +1,60 @@
+/*
+ * Heap and stack high-water marks
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __HIGHWATER_H
+#define __HIGHWATER_H
+
+#if CONFIG_IS_ENABLED(MEM_HIGHWATER)
+/**
+ * highwater_paint_f() - Paint the stack before relocation
+ *
+ * This is called at the start of board_init_f(). Nothing is painted unless
+ * the lower bound of the stack is known (CONFIG_SYS_INIT_RAM_ADDR), or on
+ * sandbox where the stack belongs to the host.
+ */
+void highwater_paint_f(void);
+
+/**
+ * highwater_paint_r() - Paint the stack after relocation
+ *
+ * This is called at the start of board_init_r().
+ */
+void highwater_paint_r(void);
+
+/**
+ * highwater_record_f() - Record the pre-relocation high-water marks
+ *
+ * This must run before global data is copied for relocation.
+ *
+ * @return 0 (always)
+ */
+int highwater_record_f(void);
+
+/**
+ * highwater_record_r() - Update the post-relocation high-water marks
+ *
+ * The current values are stored in the bootstage records, replacing any
+ * recorded earlier.
+ */
+void highwater_record_r(void);
+
+/**
+ * highwater_stack_used() - Get the stack high-water mark of this phase
+ *
+ * @return number of bytes of stack used since it was last painted, 0 if it
+ *	was not painted
+ */
+ulong highwater_stack_used(void);
+
+/** highwater_show() - Print the heap and stack high-water marks */
+void highwater_show(void);
+#else
+static inline void highwater_paint_f(void) {}
+static inline void highwater_paint_r(void) {}
+static inline void highwater_record_r(void) {}
+#endif
+
+#endif
@@ -980,6 +980,22 @@ int fit_image_get_load(const void *fit, int noffset, ulong *load);
 int fit_image_get_entry(const void *fit, int noffset, ulong *entry);
 int fit_image_get_data(const void *fit, int noffset,
 				const void **data, size_t *size);
+
+/**
+ * fit_image_get_data_and_size() - Get the data of an image, wherever it is
+ *
+ * This finds the data of an image whether it is held in the FIT structure
+ * or placed after it, as with 'mkimage -E'. External data must follow the
+ * FIT structure in memory, unless fit_load_ext() read it elsewhere.
+ *
+ * @fit:	Pointer to the FIT image header
+ * @noffset:	Component image node offset
+ * @data:	Returns a pointer to the data
+ * @size:	Returns the size of the data in bytes
+ * @return 0 if OK, -1 if the image has no data
+ */
+int fit_image_get_data_and_size(const void *fit, int noffset,
+				const void **data, size_t *size);
 int fit_image_get_data_offset(const void *fit, int noffset, int *data_offset);
 int fit_image_get_data_position(const void *fit, int noffset,
 				int *data_position);
@@ -1000,6 +1016,7 @@ int fit_set_timestamp(void *fit, int noffset, time_t timestamp);
  * @comment:	Comment to add to signature nodes
  * @require_keys: Mark all keys as 'required'
  * @engine_id:	Engine to use for signing
+ * @jobs:	Number of threads to calculate hashes and signatures on
  *
  * Adds hash values for all component images in the FIT blob.
  * Hashes are calculated for all component images which have hash subnodes
@@ -1007,13 +1024,30 @@ int fit_set_timestamp(void *fit, int noffset, time_t timestamp);
  *
  * Also add signatures if signature nodes are present.
  *
+ * Hashes and signatures of images are kept for the next call, which
+ * should be with the same FIT after it has been given more space, until
+ * fit_free_verification_data() is called.
+ *
  * returns
  *     0, on success
  *     libfdt error code, on failure
  */
 int fit_add_verification_data(const char *keydir, void *keydest, void *fit,
 			      const char *comment, int require_keys,
-			      const char *engine_id);
+			      const char *engine_id, int jobs);
+
+/**
+ * fit_print_verification_summary() - show the time taken by each hash
+ *
+ * This lists the hashes and signatures calculated by the last call to
+ * fit_add_verification_data() with the time each took.
+ */
+void fit_print_verification_summary(void);
+
+/**
+ * fit_free_verification_data() - drop hashes kept for a FIT
+ */
+void fit_free_verification_data(void);
 
 int fit_image_verify(const void *fit, int noffset);
 int fit_config_verify(const void *fit, int conf_noffset);
@@ -1265,6 +1299,61 @@ static inline int fit_image_check_target_arch(const void *fdt, int node)
 #define fit_unsupported(msg)
 #define fit_unsupported_reset(msg)
 #endif /* CONFIG_FIT_VERBOSE */
+
+/**
+ * struct fit_loader - Reads a FIT with external data from storage
+ *
+ * @read:	Read @size bytes at @offset in the FIT into @buf. Returns 0
+ *		if OK, -ve on error
+ * @priv:	Private data for @read
+ */
+struct fit_loader {
+	int (*read)(struct fit_loader *ldr, ulong offset, ulong size,
+		    void *buf);
+	void *priv;
+};
+
+#if !defined(USE_HOSTCC) && !defined(CONFIG_SPL_BUILD) && \
+	defined(CONFIG_FIT_EXTERNAL_LOAD)
+/**
+ * fit_load_ext() - Read the parts of a FIT a configuration uses
+ *
+ * This reads the FIT structure to @fit, then the external data of each image
+ * the configuration uses. Each image with a load address, and which is not
+ * compressed, is read straight to its load address, unless that overlaps the
+ * FIT structure or an image read already; others are read one after the
+ * other following the FIT structure. The images are not verified: that is
+ * left to bootm, which finds each where it was read.
+ *
+ * @ldr:	Reads the FIT from storage
+ * @fit:	Place to put the FIT structure
+ * @conf_name:	Configuration to read the images of, NULL for the default
+ * @sizep:	Returns the number of bytes read
+ * @return 0 if OK, -ENOEXEC if this is not a FIT, -ENOENT if there is no
+ * such configuration, -E2BIG if it uses more than 16 images with external
+ * data, -ENOSPC if an image read after the FIT structure would overlap one
+ * read to its load address, other -ve value on error
+ */
+int fit_load_ext(struct fit_loader *ldr, void *fit, const char *conf_name,
+		 ulong *sizep);
+
+/**
+ * fit_load_ext_find() - Find where fit_load_ext() read an image
+ *
+ * Nothing is found once the FIT structure at @fit differs from the one
+ * fit_load_ext() read, e.g. because another FIT was loaded over it.
+ *
+ * @fit:	FIT passed to fit_load_ext()
+ * @noffset:	Component image node offset
+ * @return the image data, or NULL if it was not read away from the FIT
+ */
+const void *fit_load_ext_find(const void *fit, int noffset);
+#else
+static inline const void *fit_load_ext_find(const void *fit, int noffset)
+{
+	return NULL;
+}
+#endif
 #endif /* CONFIG_FIT */
 
 #if defined(CONFIG_ANDROID_BOOT_IMAGE)
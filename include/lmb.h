@@ -11,7 +11,12 @@
  * SPDX-License-Identifier:	GPL-2.0+
  */
 
+#ifdef CONFIG_LMB_LOAD_MAP
+/* Room for U-Boot's own regions plus every tracked image */
+#define MAX_LMB_REGIONS 16
+#else
 #define MAX_LMB_REGIONS 8
+#endif
 
 struct lmb_property {
 	phys_addr_t base;
@@ -53,6 +58,69 @@ lmb_size_bytes(struct lmb_region *type, unsigned long region_nr)
 void board_lmb_reserve(struct lmb *lmb);
 void arch_lmb_reserve(struct lmb *lmb);
 
+#ifdef CONFIG_LMB_LOAD_MAP
+/**
+ * lmb_load_check() - Check that an image may be loaded to a memory range
+ *
+ * @base:	Load address
+ * @size:	Number of bytes to load
+ * @name:	Name of the image, for messages
+ * @return 0 if OK, -EBUSY if the range overlaps memory used by U-Boot
+ */
+int lmb_load_check(phys_addr_t base, phys_size_t size, const char *name);
+
+/**
+ * lmb_load_add() - Record an image in the persistent load map
+ *
+ * Any earlier images the new one overlaps are dropped from the map, with
+ * a warning unless the new image was loaded to the same address.
+ *
+ * @base:	Load address
+ * @size:	Size of the image in bytes
+ * @name:	Name of the image, e.g. the file name
+ */
+void lmb_load_add(phys_addr_t base, phys_size_t size, const char *name);
+
+/**
+ * lmb_load_alloc() - Find free memory for an image
+ *
+ * The range returned does not overlap U-Boot or any loaded image. It is
+ * not recorded; call lmb_load_add() once the image is loaded.
+ *
+ * @size:	Size of the image in bytes
+ * @align:	Required alignment of the start address
+ * @return start address, or 0 if there is no room
+ */
+phys_addr_t lmb_load_alloc(phys_size_t size, ulong align);
+
+/**
+ * lmb_load_reserve() - Reserve all loaded images in an lmb
+ *
+ * @lmb:	lmb to update, e.g. the one used by bootm
+ */
+void lmb_load_reserve(struct lmb *lmb);
+#else
+static inline int lmb_load_check(phys_addr_t base, phys_size_t size,
+				 const char *name)
+{
+	return 0;
+}
+
+static inline void lmb_load_add(phys_addr_t base, phys_size_t size,
+				const char *name)
+{
+}
+
+static inline phys_addr_t lmb_load_alloc(phys_size_t size, ulong align)
+{
+	return 0;
+}
+
+static inline void lmb_load_reserve(struct lmb *lmb)
+{
+}
+#endif
+
 #endif /* __KERNEL__ */
 
 #endif /* _LINUX_LMB_H */
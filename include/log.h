@@ -10,6 +10,7 @@
 #ifndef __LOG_H
 #define __LOG_H
 
+#include <stdarg.h>
 #include <dm/uclass-id.h>
 #include <linux/list.h>
 
@@ -171,7 +172,10 @@ void __assert_fail(const char *assertion, const char *file, unsigned int line,
  * @file: Name of file where the log record was generated (not allocated)
  * @line: Line number where the log record was generated
  * @func: Function where the log record was generated (not allocated)
- * @msg: Log message (allocated)
+ * @fmt: printf() format string for the message (not allocated)
+ * @args: Arguments for @fmt. Drivers must use va_copy() to read them.
+ * @msg: Log message (allocated). This is NULL for drivers with the
+ *	LOGDF_RAW flag unless another driver has already needed it.
  */
 struct log_rec {
 	enum log_category_t cat;
@@ -179,18 +183,26 @@ struct log_rec {
 	const char *file;
 	int line;
 	const char *func;
+	const char *fmt;
+	va_list *args;
 	const char *msg;
 };
 
 struct log_device;
 
+enum log_driver_flags {
+	LOGDF_RAW		= 1 << 0,	/* Uses @fmt/@args, not @msg */
+};
+
 /**
  * struct log_driver - a driver which accepts and processes log records
  *
  * @name: Name of driver
+ * @flags: Flags for this driver (LOGDF_...)
  */
 struct log_driver {
 	const char *name;
+	int flags;
 	/**
 	 * emit() - emit a log record
 	 *
@@ -287,6 +299,42 @@ int log_add_filter(const char *drv_name, enum log_category_t cat_list[],
  */
 int log_remove_filter(const char *drv_name, int filter_num);
 
+#if CONFIG_IS_ENABLED(LOG_RING)
+/**
+ * log_ring_init() - Set up the binary log ring
+ *
+ * If the memory already holds a valid ring written by this U-Boot build (e.g.
+ * after a warm reset) its records are kept, otherwise the ring is cleared.
+ *
+ * @addr: Address of the memory to use
+ * @size: Size of the memory in bytes. If this is less than 4KiB no ring is
+ *	set up and records are not kept.
+ */
+void log_ring_init(ulong addr, ulong size);
+
+/**
+ * log_ring_dump() - Print the records in the binary log ring
+ *
+ * The records are formatted now, oldest first.
+ *
+ * @return 0 if OK, -ENOENT if there is no ring, -EINVAL if it is corrupt
+ */
+int log_ring_dump(void);
+
+/**
+ * log_ring_fdt_fixup() - Add the log ring to /reserved-memory for the OS
+ *
+ * @blob: Device tree to update
+ * @return 0 if OK, -ve FDT_ERR_... on error
+ */
+int log_ring_fdt_fixup(void *blob);
+#else
+static inline int log_ring_fdt_fixup(void *blob)
+{
+	return 0;
+}
+#endif
+
 #if CONFIG_IS_ENABLED(LOG)
 /**
  * log_init() - Set up the log system ready for use
@@ -882,7 +882,8 @@ void *memalign_simple(size_t alignment, size_t bytes);
 void *realloc_simple(void *ptr, size_t size);
 #else
 
-# ifdef USE_DL_PREFIX
+/* The slab front-end in malloc_slab.c provides malloc() and friends */
+# if defined(USE_DL_PREFIX) || CONFIG_IS_ENABLED(MALLOC_SLAB)
 # define cALLOc		dlcalloc
 # define fREe		dlfree
 # define mALLOc		dlmalloc
@@ -945,6 +946,20 @@ void    malloc_stats();
 int     mALLOPt();
 struct mallinfo mALLINFo();
 # endif
+#if CONFIG_IS_ENABLED(MALLOC_SLAB)
+void	*malloc(size_t bytes);
+void	free(void *mem);
+void	*realloc(void *oldmem, size_t bytes);
+void	*memalign(size_t alignment, size_t bytes);
+void	*calloc(size_t n, size_t elem_size);
+void	*valloc(size_t bytes);
+void	*pvalloc(size_t bytes);
+int	mallopt(int param_number, int value);
+#ifdef CONFIG_UNIT_TEST
+/* Only provided for leak checks, like dlmalloc's own mallinfo() */
+struct mallinfo mallinfo(void);
+#endif
+#endif
 #endif
 #pragma GCC visibility pop
 
@@ -954,9 +969,87 @@ struct mallinfo mALLINFo();
 extern ulong mem_malloc_start;
 extern ulong mem_malloc_end;
 extern ulong mem_malloc_brk;
+extern ulong mem_malloc_brk_max;	/* highest value of mem_malloc_brk */
 
 void mem_malloc_init(ulong start, ulong size);
 
+/* Subsystems which heap use is accounted to */
+enum malloc_tag {
+	MALLOC_TAG_OTHER,
+	MALLOC_TAG_DM,		/* driver model devices and their data */
+	MALLOC_TAG_ENV,		/* environment hash table and variables */
+	MALLOC_TAG_CLI,		/* command-line parser */
+	MALLOC_TAG_FS,		/* filesystems and their block buffers */
+
+	MALLOC_TAG_COUNT,
+};
+
+/**
+ * struct malloc_tag_stats - Heap use of a subsystem
+ *
+ * @cur:	Bytes currently allocated
+ * @peak:	Largest value of @cur seen
+ * @live:	Number of allocations not yet freed
+ * @allocs:	Total number of allocations made
+ */
+struct malloc_tag_stats {
+	ulong cur;
+	ulong peak;
+	ulong live;
+	ulong allocs;
+};
+
+#if CONFIG_IS_ENABLED(MALLOC_SLAB)
+/**
+ * malloc_set_tag() - Set the subsystem that allocations are accounted to
+ *
+ * Allocations keep their tag until they are freed, whoever frees them.
+ * Callers should restore the previous tag when done:
+ *
+ *	old = malloc_set_tag(MALLOC_TAG_FS);
+ *	buf = malloc(size);
+ *	malloc_set_tag(old);
+ *
+ * @tag:	Tag for following allocations
+ * @return the previous tag
+ */
+enum malloc_tag malloc_set_tag(enum malloc_tag tag);
+
+/**
+ * malloc_slab_size() - Get the usable size of a slab object
+ *
+ * @mem:	Pointer returned by malloc()
+ * @return usable size, or 0 if @mem was not allocated from a slab
+ */
+size_t malloc_slab_size(const void *mem);
+
+/**
+ * malloc_get_tag_stats() - Get the heap use of a subsystem
+ *
+ * @tag:	Subsystem to check
+ * @stats:	Returns the statistics
+ */
+void malloc_get_tag_stats(enum malloc_tag tag, struct malloc_tag_stats *stats);
+
+/** malloc_print_info() - Show heap, slab and per-subsystem usage */
+void malloc_print_info(void);
+
+/**
+ * malloc_get_free() - Get the free space in the heap
+ *
+ * This includes the space that the heap can still grow into.
+ *
+ * @largest:	Returns the size of the largest free block
+ * @return total free space in bytes
+ */
+size_t malloc_get_free(size_t *largest);
+#else
+static inline enum malloc_tag malloc_set_tag(enum malloc_tag tag)
+{
+	return MALLOC_TAG_OTHER;
+}
+#endif
+
 #ifdef __cplusplus
 };  /* end of extern "C" */
 #endif
@@ -61,6 +61,51 @@ off_t os_lseek(int fd, off_t offset, int whence);
 #define OS_SEEK_CUR	1
 #define OS_SEEK_END	2
 
+/**
+ * Access to the OS pread() system call
+ *
+ * This reads at the given offset without moving the file offset, so a
+ * random access takes a single system call.
+ *
+ * \param fd	File descriptor as returned by os_open()
+ * \param buf	Buffer to place data
+ * \param count	Number of bytes to read
+ * \param offset	File offset to read from
+ * \return number of bytes read, or -1 on error
+ */
+ssize_t os_pread(int fd, void *buf, size_t count, off_t offset);
+
+/**
+ * Access to the OS pwrite() system call
+ *
+ * \param fd	File descriptor as returned by os_open()
+ * \param buf	Buffer containing data to write
+ * \param count	Number of bytes to write
+ * \param offset	File offset to write to
+ * \return number of bytes written, or -1 on error
+ */
+ssize_t os_pwrite(int fd, const void *buf, size_t count, off_t offset);
+
+/**
+ * Map an open file into memory
+ *
+ * The mapping is shared, so writes to it end up in the file.
+ *
+ * \param fd	File descriptor as returned by os_open() with OS_O_RDWR
+ * \param size	Number of bytes to map from the start of the file
+ * \return pointer to the mapping, or NULL on error
+ */
+void *os_map_file(int fd, size_t size);
+
+/**
+ * Remove a mapping made by os_map_file()
+ *
+ * \param ptr	Pointer returned by os_map_file()
+ * \param size	Size passed to os_map_file()
+ * \return 0 if OK, -1 on error
+ */
+int os_unmap_file(void *ptr, size_t size);
+
 /**
  * Access to the OS open() system call
  *
@@ -330,4 +375,22 @@ int os_spl_to_uboot(const char *fname);
  */
 void os_localtime(struct rtc_time *rt);
 
+/* Called for each profiler sample: pc, frame pointer, stack pointer, top */
+typedef void (*os_profile_func_t)(ulong pc, ulong fp, ulong sp, ulong top);
+
+/**
+ * os_profile_start() - Start taking profiler samples
+ *
+ * This uses ITIMER_PROF, so samples are taken in proportion to the CPU time
+ * used by U-Boot rather than wall time.
+ *
+ * @hz:		Number of samples per second of CPU time
+ * @func:	Function to call (from a signal handler) for each sample
+ * @return 0 if OK, -ve on error
+ */
+int os_profile_start(uint hz, os_profile_func_t func);
+
+/** os_profile_stop() - Stop taking profiler samples */
+void os_profile_stop(void);
+
 #endif
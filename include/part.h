@@ -202,6 +202,21 @@ int part_get_info_by_name_type(struct blk_desc *dev_desc, const char *name,
 int part_get_info_by_name(struct blk_desc *dev_desc,
 			      const char *name, disk_partition_t *info);
 
+/**
+ * part_get_info_by_uuid() - Search for a partition by its UUID
+ *
+ * Unlike part_get_info_by_name() this does not stop at the first unused
+ * entry, so it finds partitions in sparse tables too.
+ *
+ * @param dev_desc - block device descriptor
+ * @param uuid - partition UUID as a string (case is ignored)
+ * @param info - returns the disk partition info
+ *
+ * @return - the partition number on match (starting on 1), -1 on no match
+ */
+int part_get_info_by_uuid(struct blk_desc *dev_desc, const char *uuid,
+			  disk_partition_t *info);
+
 /**
  * part_set_generic_name() - create generic partition like hda1 or sdb2
  *
@@ -295,6 +310,109 @@ struct part_driver {
 #define U_BOOT_PART_TYPE(__name)					\
 	ll_entry_declare(struct part_driver, __name, part_driver)
 
+/* disk/part_cache.c */
+/*
+ * statistics of the partition cache of one block device
+ */
+struct part_cache_stats {
+	unsigned int hits;		/* lookups answered from the cache */
+	unsigned int misses;		/* lookups passed to the driver */
+	unsigned int invalidations;	/* writes, rescans, hwpart changes */
+	unsigned int entries;		/* partitions known to the cache */
+	unsigned int table_size;	/* bytes held for the driver's table */
+	unsigned int fstypes;		/* partitions with a known filesystem */
+};
+
+#if CONFIG_IS_ENABLED(PARTITION_CACHE)
+/**
+ * part_cache_get_info() - Get partition information through the cache
+ *
+ * The result of @drv's get_info() for each partition number, present or
+ * not, is kept until the cache is invalidated.
+ *
+ * @dev_desc:	Block device descriptor
+ * @drv:	Partition driver for the device's table
+ * @part:	Partition number (1 = first)
+ * @info:	Returns partition information
+ * @return 0 if the partition exists, non-zero if not (as get_info())
+ */
+int part_cache_get_info(struct blk_desc *dev_desc, struct part_driver *drv,
+			int part, disk_partition_t *info);
+
+/**
+ * part_cache_get_table() - Get the table a partition driver has cached
+ *
+ * @dev_desc:	Block device descriptor
+ * @return the table passed to part_cache_set_table(), or NULL if none
+ */
+void *part_cache_get_table(struct blk_desc *dev_desc);
+
+/**
+ * part_cache_set_table() - Keep a validated partition table for a device
+ *
+ * This lets a driver avoid reading and checking its table again. On
+ * success the cache owns @table, which must come from malloc(), and frees
+ * it when invalidated.
+ *
+ * @dev_desc:	Block device descriptor
+ * @table:	Table in the driver's own format
+ * @size:	Size of @table in bytes
+ * @return 0 if OK, -ENOMEM if the cache could not be set up
+ */
+int part_cache_set_table(struct blk_desc *dev_desc, void *table,
+			 size_t size);
+
+/**
+ * part_cache_get_fstype() - Get the filesystem type found on a partition
+ *
+ * @dev_desc:	Block device descriptor
+ * @part:	Partition number (0 = whole disk)
+ * @return FS_TYPE_... set by part_cache_set_fstype(), or FS_TYPE_ANY if
+ *	not known
+ */
+int part_cache_get_fstype(struct blk_desc *dev_desc, int part);
+
+/**
+ * part_cache_set_fstype() - Remember the filesystem type on a partition
+ *
+ * Only the whole disk and the first few partitions are covered; for others
+ * this does nothing.
+ *
+ * @dev_desc:	Block device descriptor
+ * @part:	Partition number (0 = whole disk)
+ * @fstype:	FS_TYPE_... found, FS_TYPE_ANY to forget it
+ */
+void part_cache_set_fstype(struct blk_desc *dev_desc, int part, int fstype);
+
+/**
+ * part_cache_get_stats() - Get statistics of a device's partition cache
+ *
+ * @dev_desc:	Block device descriptor
+ * @stats:	Returns the statistics (zero if the cache was never used)
+ */
+void part_cache_get_stats(struct blk_desc *dev_desc,
+			  struct part_cache_stats *stats);
+#else
+static inline void *part_cache_get_table(struct blk_desc *dev_desc)
+{
+	return NULL;
+}
+
+static inline int part_cache_set_table(struct blk_desc *dev_desc,
+				       void *table, size_t size)
+{
+	return -ENOSYS;
+}
+
+static inline int part_cache_get_fstype(struct blk_desc *dev_desc, int part)
+{
+	return 0;	/* FS_TYPE_ANY */
+}
+
+static inline void part_cache_set_fstype(struct blk_desc *dev_desc, int part,
+					 int fstype) {}
+#endif
+
 #include <part_efi.h>
 
 #if CONFIG_IS_ENABLED(EFI_PARTITION)
@@ -0,0 +1,94 @@
+/*
+ * Statistical sampling profiler
+ *
+ * A periodic timer interrupt (or SIGPROF on sandbox) records the interrupted
+ * program counter and the return addresses found by walking the frame
+ * pointer chain. Unlike function tracing this needs no instrumentation, so
+ * the code being measured runs at full speed. See doc/README.trace.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __PROFILER_H
+#define __PROFILER_H
+
+/* Maximum number of addresses recorded for one sample */
+#define PROFILER_MAX_DEPTH	32
+
+#if CONFIG_IS_ENABLED(PROFILER)
+/**
+ * profiler_sample() - Record a sample
+ *
+ * This is called from the timer interrupt. The frame chain is only followed
+ * while it stays inside [@stack_lo, @stack_hi) and moves towards the top of
+ * the stack, so a corrupt or missing frame pointer ends the walk early
+ * rather than faulting.
+ *
+ * @pc:		Program counter at the point the timer fired
+ * @fp:		Frame pointer at that point
+ * @stack_lo:	Stack pointer at that point
+ * @stack_hi:	Top of the stack
+ */
+void profiler_sample(ulong pc, ulong fp, ulong stack_lo, ulong stack_hi);
+
+/**
+ * profiler_start() - Start taking samples
+ *
+ * Any samples from a previous run are discarded.
+ *
+ * @hz:		Number of samples to take per second
+ * @return 0 if OK, -EBUSY if already running, -ENOMEM if there is no
+ *	memory for the sample buffer, other -ve on error from the arch code
+ */
+int profiler_start(uint hz);
+
+/**
+ * profiler_stop() - Stop taking samples
+ *
+ * This is safe to call when the profiler is not running.
+ */
+void profiler_stop(void);
+
+/** profiler_print_stats() - Show the number of samples taken and dropped */
+void profiler_print_stats(void);
+
+/**
+ * profiler_save() - Write the samples in the format read by proftool
+ *
+ * The output is a struct trace_output_hdr of type TRACE_CHUNK_SAMPLES
+ * followed by one struct trace_sample per sample.
+ *
+ * @buff:	Buffer to write to
+ * @buff_size:	Size of buffer in bytes
+ * @needed:	Returns the number of bytes needed for the output
+ * @return 0 if OK, -ENOSPC if the buffer is too small
+ */
+int profiler_save(void *buff, int buff_size, int *needed);
+
+/**
+ * arch_profiler_start() - Start the periodic sampling interrupt
+ *
+ * The arch code calls profiler_sample() from the interrupt.
+ *
+ * @hz:		Number of interrupts per second
+ * @return 0 if OK, -ve on error
+ */
+int arch_profiler_start(uint hz);
+
+/** arch_profiler_stop() - Stop the periodic sampling interrupt */
+void arch_profiler_stop(void);
+
+struct pt_regs;
+
+/**
+ * arch_profiler_irq() - Handle an IRQ while profiling (arm64)
+ *
+ * @regs:	Registers saved on exception entry
+ * @return 0 if the IRQ was handled, -ENOENT if it was not the profiler's
+ */
+int arch_profiler_irq(struct pt_regs *regs);
+#else
+static inline void profiler_stop(void) {}
+#endif
+
+#endif
@@ -7,14 +7,74 @@
 #ifndef __SANDBOX_BLOCK_DEV__
 #define __SANDBOX_BLOCK_DEV__
 
+/* Flags for host_dev_bind() */
+#define HOST_BIND_MMAP	(1 << 0)	/* Map the backing file into memory */
+
+/**
+ * struct host_block_stats - Requests handled by a host block device
+ *
+ * @reads:		Number of read requests
+ * @read_blocks:	Number of blocks read
+ * @writes:		Number of write requests
+ * @write_blocks:	Number of blocks written
+ * @delay_ns:		Time the requests took under the latency model
+ */
+struct host_block_stats {
+	u64 reads;
+	u64 read_blocks;
+	u64 writes;
+	u64 write_blocks;
+	u64 delay_ns;
+};
+
+/**
+ * struct host_block_dev - A block device backed by a file on the host
+ *
+ * Each request can be made to take as long as it would on a slower device,
+ * so that the time loading takes on a board can be measured on the host:
+ * a request costs @overhead_ns plus the time to move its data at
+ * @bandwidth. With neither set, requests take as long as the host needs.
+ *
+ * @filename:		Name of the backing file
+ * @fd:			File descriptor of the backing file, -1 if none
+ * @map:		Backing file mapped into memory, or NULL when it is
+ *			accessed with pread() and pwrite()
+ * @size:		Size of the backing file in bytes
+ * @overhead_ns:	Time each request takes before any data moves
+ * @bandwidth:		Bytes moved per second, 0 for no limit
+ * @stats:		Requests handled since the device was bound
+ */
 struct host_block_dev {
 #ifndef CONFIG_BLK
 	struct blk_desc blk_dev;
 #endif
 	char *filename;
 	int fd;
+	void *map;
+	loff_t size;
+	u64 overhead_ns;
+	u64 bandwidth;
+	struct host_block_stats stats;
 };
 
-int host_dev_bind(int dev, char *filename);
+/**
+ * host_dev_bind() - Bind a host block device to a file
+ *
+ * @dev:	Host device number
+ * @filename:	Backing file, or NULL to unbind the device
+ * @flags:	HOST_BIND_... flags
+ * @return 0 if OK, non-zero on error
+ */
+int host_dev_bind(int dev, char *filename, int flags);
+
+/**
+ * host_get_host_dev() - Get the state of a bound host block device
+ *
+ * @dev:	Host device number
+ * @host_devp:	Returns the device state
+ * @return 0 if OK, -ENODEV if there is no such device, -ENOENT if it is not
+ * bound to a file
+ */
+int host_get_host_dev(int dev, struct host_block_dev **host_devp);
 
 #endif
@@ -62,6 +62,30 @@ struct hsearch_data {
  */
 	int (*change_ok)(const ENTRY *__item, const char *newval, enum env_op,
 		int flag);
+	/*
+	 * String pool of a table set up by himport_prebuilt_r(). Keys and
+	 * values inside it are not freed; they are replaced by heap copies
+	 * when changed.
+	 */
+	const char *prebuilt;
+	size_t prebuilt_size;
+};
+
+/* A slot of a hash table laid out at build time */
+struct hprebuilt_entry {
+	unsigned int idx;	/* index of the slot in the table */
+	int used;		/* 'used' value of the slot, -1 if deleted */
+	unsigned int key;	/* offset of the key in the string pool */
+	unsigned int data;	/* offset of the value in the string pool */
+};
+
+/* A hash table laid out at build time, see himport_prebuilt_r() */
+struct hprebuilt {
+	unsigned int size;	/* table size, as hcreate_r() would choose */
+	unsigned int count;	/* number of entries */
+	const struct hprebuilt_entry *entries;	/* in order of creation */
+	const char *strings;	/* pool of NUL-terminated keys and values */
+	unsigned int strings_size;
 };
 
 /* Create a new hash table which will contain at most "__nel" elements.  */
@@ -103,6 +127,14 @@ extern int himport_r(struct hsearch_data *__htab,
 		     int __flag, int __crlf_is_lf, int nvars,
 		     char * const vars[]);
 
+/*
+ * Set up a hash table from one laid out at build time. This gives the same
+ * result as himport_r() with the text the table was built from, without
+ * parsing, hashing or copying any strings.
+ */
+extern int himport_prebuilt_r(struct hsearch_data *__htab,
+			      const struct hprebuilt *__prebuilt, int __flag);
+
 /* Walk the whole table calling the callback on each element */
 extern int hwalk_r(struct hsearch_data *__htab, int (*callback)(ENTRY *));
 
@@ -105,6 +105,22 @@ struct dm_serial_ops {
 	 * @return 0 if OK, -ve on error
 	 */
 	int (*putc)(struct udevice *dev, const char ch);
+	/**
+	 * puts() - Write as many characters as fit without waiting
+	 *
+	 * This lets the uclass fill a transmit FIFO in one go instead of
+	 * checking for room before each character. No newline translation
+	 * is done.
+	 *
+	 * This method is optional.
+	 *
+	 * @dev: Device pointer
+	 * @s: Characters to write
+	 * @len: Number of characters to write
+	 * @return number of characters written, -EAGAIN if there is no room,
+	 * other -ve on error
+	 */
+	ssize_t (*puts)(struct udevice *dev, const char *s, size_t len);
 	/**
 	 * pending() - Check if input/output characters are waiting
 	 *
@@ -153,6 +169,9 @@ struct dm_serial_ops {
  * @buf:	Pointer to the RX buffer
  * @rd_ptr:	Read pointer in the RX buffer
  * @wr_ptr:	Write pointer in the RX buffer
+ *
+ * @tx_cr:	'\r' has been sent for the '\n' at the start of the buffered
+ *		console output
  */
 struct serial_dev_priv {
 	struct stdio_dev *sdev;
@@ -160,6 +179,8 @@ struct serial_dev_priv {
 	char *buf;
 	int rd_ptr;
 	int wr_ptr;
+
+	bool tx_cr;
 };
 
 /* Access the serial operations for a device */
@@ -0,0 +1,18 @@
+/*
+ * SquashFS filesystem implementation for U-Boot
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __U_BOOT_SQUASHFS_H__
+#define __U_BOOT_SQUASHFS_H__
+
+int sqfs_probe(struct blk_desc *fs_dev_desc, disk_partition_t *fs_partition);
+int sqfs_ls(const char *path);
+int sqfs_exists(const char *file);
+int sqfs_size(const char *file, loff_t *size);
+int sqfs_read(const char *file, void *buf, loff_t offset, loff_t len,
+	      loff_t *actread);
+void sqfs_close(void);
+
+#endif /* __U_BOOT_SQUASHFS_H__ */
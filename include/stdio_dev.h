@@ -35,6 +35,11 @@ struct stdio_dev {
 	void (*putc)(struct stdio_dev *dev, const char c);
 	/* To put a string (accelerator) */
 	void (*puts)(struct stdio_dev *dev, const char *s);
+	/*
+	 * To put as much of a string as the device takes without waiting,
+	 * returns the number of characters consumed (optional)
+	 */
+	int (*try_puts)(struct stdio_dev *dev, const char *s, int len);
 
 /* INPUT functions */
 
@@ -46,6 +51,9 @@ struct stdio_dev {
 
 	void *priv;			/* Private extensions			*/
 	struct list_head list;
+#if CONFIG_IS_ENABLED(CONSOLE_BUFFER)
+	struct membuff *outbuf;		/* Output waiting for the device	*/
+#endif
 };
 
 /*
@@ -29,6 +29,7 @@ enum {
 enum trace_chunk_type {
 	TRACE_CHUNK_FUNCS,
 	TRACE_CHUNK_CALLS,
+	TRACE_CHUNK_SAMPLES,
 };
 
 /* A trace record for a function, as written to the profile output file */
@@ -37,6 +38,17 @@ struct trace_output_func {
 	uint32_t call_count;		/* Number of times called */
 };
 
+/*
+ * A sample from the sampling profiler, as written to the profile output
+ * file. It holds @depth code offsets: the interrupted location followed by
+ * the return address into each caller, innermost first. Unlike the offsets
+ * in struct trace_call these are in bytes.
+ */
+struct trace_sample {
+	uint32_t depth;			/* Number of entries in addr[] */
+	uint32_t addr[];		/* Code offsets */
+};
+
 /* A header at the start of the trace output buffer */
 struct trace_output_hdr {
 	enum trace_chunk_type type;	/* Record type */
@@ -724,6 +724,11 @@ ZEXTERN int ZEXPORT inflateInit2_ OF((z_streamp strm, int  windowBits,
 extern void *gzalloc(void *, unsigned, unsigned);
 extern void gzfree(void *, void *, unsigned);
 
+#ifdef CONFIG_ZLIB_INFLATE_FAST
+/* Use the 64-bit inflate fast path; clear to use the original one */
+extern int zlib_inflate_fast64;
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -26,6 +26,10 @@
 
 #define tole(x) cpu_to_le32(x)
 
+#if defined(CONFIG_ARM64_CRC32) && !defined(USE_HOSTCC)
+#define CRC32_USE_ARM64
+#endif
+
 #ifdef DYNAMIC_CRC_TABLE
 
 local int crc_table_empty = 1;
@@ -78,7 +82,7 @@ local void make_crc_table()
   }
   crc_table_empty = 0;
 }
-#else
+#elif !defined(CRC32_USE_ARM64)
 /* ========================================================================
  * Table of CRC-32's of all single-byte values (made by make_crc_table)
  */
@@ -173,11 +177,59 @@ const uint32_t * ZEXPORT get_crc_table()
 
 /* ========================================================================= */
 
+#ifdef CRC32_USE_ARM64
+/*
+ * The ARMv8 CRC32 instructions use the same reflected polynomial as the
+ * table above and do no ones complement either, so they are a drop-in
+ * replacement that handles eight bytes per instruction.
+ */
+static uint32_t crc32_arm64(uint32_t crc, const uint8_t *p, uInt len)
+{
+	while (len && ((uintptr_t)p & 7)) {
+		asm("crc32b %w0, %w0, %w1" : "+r" (crc) : "r" (*p));
+		p++;
+		len--;
+	}
+
+	for (; len >= 32; len -= 32, p += 32) {
+		asm("crc32x %w0, %w0, %x1\n\t"
+		    "crc32x %w0, %w0, %x2\n\t"
+		    "crc32x %w0, %w0, %x3\n\t"
+		    "crc32x %w0, %w0, %x4"
+		    : "+r" (crc)
+		    : "r" (((const uint64_t *)p)[0]),
+		      "r" (((const uint64_t *)p)[1]),
+		      "r" (((const uint64_t *)p)[2]),
+		      "r" (((const uint64_t *)p)[3]));
+	}
+	for (; len >= 8; len -= 8, p += 8)
+		asm("crc32x %w0, %w0, %x1"
+		    : "+r" (crc) : "r" (*(const uint64_t *)p));
+	if (len & 4) {
+		asm("crc32w %w0, %w0, %w1"
+		    : "+r" (crc) : "r" (*(const uint32_t *)p));
+		p += 4;
+	}
+	if (len & 2) {
+		asm("crc32h %w0, %w0, %w1"
+		    : "+r" (crc) : "r" (*(const uint16_t *)p));
+		p += 2;
+	}
+	if (len & 1)
+		asm("crc32b %w0, %w0, %w1" : "+r" (crc) : "r" (*p));
+
+	return crc;
+}
+#endif
+
 /* No ones complement version. JFFS2 (and other things ?)
  * don't use ones compliment in their CRC calculations.
  */
 uint32_t ZEXPORT crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
 {
+#ifdef CRC32_USE_ARM64
+    return crc32_arm64(crc, buf, len);
+#else
     const uint32_t *tab = crc_table;
     const uint32_t *b =(const uint32_t *)buf;
     size_t rem_len;
@@ -215,6 +267,7 @@ uint32_t ZEXPORT crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
     }
 
     return le32_to_cpu(crc);
+#endif
 }
 #undef DO_CRC
 
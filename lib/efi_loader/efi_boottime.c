@@ -7,6 +7,7 @@
  */
 
 #include <common.h>
+#include <console.h>
 #include <div64.h>
 #include <efi_loader.h>
 #include <environment.h>
@@ -1508,6 +1509,7 @@ static efi_status_t EFIAPI efi_exit_boot_services(void *image_handle,
 	/* XXX Should persist EFI variables here */
 
 	board_quiesce_devices();
+	console_flush();
 
 	/* Fix up caches for EFI payloads if necessary */
 	efi_exit_caches();
@@ -0,0 +1,317 @@
+/*
+ * Lookup caches for the flat device tree
+ *
+ * fdt_node_offset_by_phandle() and fdt_path_offset() scan the blob on
+ * every call. Driver probe resolves clocks, resets, pinctrl, regulators
+ * and GPIOs by phandle many times over, so keep a phandle-to-offset table
+ * and a small table of recently used paths and aliases for the blob which
+ * was used last.
+ *
+ * The caches are dropped when a different blob is used or when the size of
+ * any block in the blob header changes. Every hit is also checked against
+ * the blob (the node must still carry that phandle, or it and each of its
+ * parents must still carry the names they had, and an alias must still
+ * give the same path), so in-place edits that leave the sizes alone are
+ * caught too. Anything which rewrites the blob should still call
+ * fdtdec_cache_invalidate().
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <fdtdec.h>
+#include <libfdt.h>
+#include <malloc.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Number of paths kept, must be a power of two */
+#define PATH_CACHE_SIZE		64
+
+/* Give up on the phandle table if it would be mostly empty */
+#define PHANDLE_SPARSE(max, count)	((max) > 4 * (count) + 64)
+
+/* Deepest node whose path is cached */
+#define PATH_CACHE_DEPTH	16
+
+/**
+ * struct path_ent - A cached path lookup
+ *
+ * @hash: Hash of the path
+ * @depth: Depth of the node the path resolved to, 0 for the root
+ * @offsets: Offsets of the nodes along the path below the root, ending
+ *	with the node itself
+ * @key: The path, followed by the name of each node in @offsets
+ * @alias: For a path starting with an alias, the path the alias gave,
+ *	stored after the names in @key; NULL for other paths
+ */
+struct path_ent {
+	u32 hash;
+	int depth;
+	int offsets[PATH_CACHE_DEPTH];
+	char *key;
+	const char *alias;
+};
+
+enum phandle_state {
+	PHANDLE_NONE,		/* table not built yet */
+	PHANDLE_TABLE,		/* table built */
+	PHANDLE_SPARSE,		/* phandles too sparse, do not cache */
+};
+
+static struct {
+	const void *blob;
+	u32 totalsize;
+	u32 off_dt_struct;
+	u32 size_dt_struct;
+	u32 size_dt_strings;
+
+	enum phandle_state phandle_state;
+	int *phandles;		/* offset for each phandle, or -1 */
+	u32 max_phandle;
+
+	struct path_ent paths[PATH_CACHE_SIZE];
+	struct fdtdec_cache_stats stats;
+} cache;
+
+static void cache_drop(void)
+{
+	int i;
+
+	free(cache.phandles);
+	cache.phandles = NULL;
+	cache.phandle_state = PHANDLE_NONE;
+	for (i = 0; i < PATH_CACHE_SIZE; i++) {
+		free(cache.paths[i].key);
+		cache.paths[i].key = NULL;
+	}
+	cache.blob = NULL;
+}
+
+/* Check that the cache can be used with @blob, dropping it if stale */
+static bool cache_check(const void *blob)
+{
+	/* The cache lives in BSS and uses malloc() */
+	if (!(gd->flags & GD_FLG_RELOC) || !blob)
+		return false;
+
+	if (blob == cache.blob &&
+	    fdt_totalsize(blob) == cache.totalsize &&
+	    fdt_off_dt_struct(blob) == cache.off_dt_struct &&
+	    fdt_size_dt_struct(blob) == cache.size_dt_struct &&
+	    fdt_size_dt_strings(blob) == cache.size_dt_strings)
+		return true;
+
+	if (fdt_check_header(blob))
+		return false;
+	if (cache.blob)
+		cache.stats.invalidations++;
+	cache_drop();
+	cache.blob = blob;
+	cache.totalsize = fdt_totalsize(blob);
+	cache.off_dt_struct = fdt_off_dt_struct(blob);
+	cache.size_dt_struct = fdt_size_dt_struct(blob);
+	cache.size_dt_strings = fdt_size_dt_strings(blob);
+
+	return true;
+}
+
+static void phandle_build(const void *blob)
+{
+	u32 phandle, max = 0;
+	int offset, count = 0;
+	int depth = 0;
+
+	cache.phandle_state = PHANDLE_SPARSE;
+	for (offset = 0; offset >= 0;
+	     offset = fdt_next_node(blob, offset, &depth)) {
+		phandle = fdt_get_phandle(blob, offset);
+		if (phandle && phandle != (u32)-1) {
+			max = max(max, phandle);
+			count++;
+		}
+	}
+	if (!count || PHANDLE_SPARSE(max, count))
+		return;
+
+	cache.phandles = malloc((max + 1) * sizeof(*cache.phandles));
+	if (!cache.phandles)
+		return;
+	memset(cache.phandles, 0xff, (max + 1) * sizeof(*cache.phandles));
+	for (offset = 0, depth = 0; offset >= 0;
+	     offset = fdt_next_node(blob, offset, &depth)) {
+		phandle = fdt_get_phandle(blob, offset);
+		if (phandle && phandle <= max && cache.phandles[phandle] < 0)
+			cache.phandles[phandle] = offset;
+	}
+	cache.max_phandle = max;
+	cache.phandle_state = PHANDLE_TABLE;
+	cache.stats.builds++;
+}
+
+int fdtdec_node_offset_by_phandle(const void *blob, uint32_t phandle)
+{
+	int offset;
+
+	if (!phandle || phandle == (u32)-1)
+		return -FDT_ERR_BADPHANDLE;
+	if (!cache_check(blob))
+		return fdt_node_offset_by_phandle(blob, phandle);
+
+	if (cache.phandle_state == PHANDLE_NONE)
+		phandle_build(blob);
+	if (cache.phandle_state == PHANDLE_TABLE &&
+	    phandle <= cache.max_phandle) {
+		offset = cache.phandles[phandle];
+		if (offset >= 0 && fdt_get_phandle(blob, offset) == phandle) {
+			cache.stats.hits++;
+			return offset;
+		}
+	}
+
+	cache.stats.misses++;
+	offset = fdt_node_offset_by_phandle(blob, phandle);
+	if (offset >= 0 && cache.phandle_state == PHANDLE_TABLE) {
+		/* The table is out of date, build it again next time */
+		free(cache.phandles);
+		cache.phandles = NULL;
+		cache.phandle_state = PHANDLE_NONE;
+	}
+
+	return offset;
+}
+
+static u32 path_hash(const char *path)
+{
+	u32 hash = 0;
+
+	while (*path)
+		hash = hash * 31 + *path++;
+
+	return hash;
+}
+
+/* Find the alias a path starts with, or NULL if it is not an alias */
+static const char *path_alias(const void *blob, const char *path)
+{
+	const char *end;
+
+	if (*path == '/')
+		return NULL;
+	end = strchrnul(path, '/');
+
+	return fdt_get_alias_namelen(blob, path, end - path);
+}
+
+/*
+ * Check that the nodes recorded for a path still carry the same names, so
+ * that a rename of the node or of any of its parents is noticed, and that
+ * an alias the path starts with still gives the same path, since /aliases
+ * may be rewritten in place
+ */
+static bool path_valid(const void *blob, struct path_ent *ent)
+{
+	const char *key = ent->key + strlen(ent->key) + 1;
+	const char *name, *alias;
+	int i, len;
+
+	for (i = 0; i < ent->depth; i++) {
+		name = fdt_get_name(blob, ent->offsets[i], &len);
+		if (!name || len != strlen(key) || memcmp(name, key, len))
+			return false;
+		key += len + 1;
+	}
+	if (ent->alias) {
+		alias = path_alias(blob, ent->key);
+		if (!alias || strcmp(alias, ent->alias))
+			return false;
+	}
+
+	return true;
+}
+
+/* Record where a path led; the parents are looked up once, on a miss */
+static void path_fill(const void *blob, struct path_ent *ent, u32 hash,
+		      const char *path, int offset)
+{
+	int depth, path_len, size, i, len;
+	const char *name, *alias;
+	char *key, *p;
+
+	free(ent->key);
+	ent->key = NULL;
+	ent->alias = NULL;
+	alias = path_alias(blob, path);
+	depth = fdt_node_depth(blob, offset);
+	if (depth < 0 || depth > PATH_CACHE_DEPTH)
+		return;
+	path_len = strlen(path);
+	size = path_len + 1;
+	for (i = 0; i < depth; i++) {
+		ent->offsets[i] = fdt_supernode_atdepth_offset(blob, offset,
+							       i + 1, NULL);
+		name = fdt_get_name(blob, ent->offsets[i], &len);
+		if (ent->offsets[i] < 0 || !name)
+			return;
+		size += len + 1;
+	}
+	if (alias)
+		size += strlen(alias) + 1;
+
+	key = malloc(size);
+	if (!key)
+		return;
+	memcpy(key, path, path_len + 1);
+	for (i = 0, p = key + path_len + 1; i < depth; i++, p += len + 1) {
+		name = fdt_get_name(blob, ent->offsets[i], &len);
+		memcpy(p, name, len);
+		p[len] = '\0';
+	}
+	if (alias) {
+		strcpy(p, alias);
+		ent->alias = p;
+	}
+	ent->key = key;
+	ent->hash = hash;
+	ent->depth = depth;
+}
+
+int fdtdec_path_offset(const void *blob, const char *path)
+{
+	struct path_ent *ent;
+	int offset;
+	u32 hash;
+
+	if (!cache_check(blob))
+		return fdt_path_offset(blob, path);
+
+	hash = path_hash(path);
+	ent = &cache.paths[hash & (PATH_CACHE_SIZE - 1)];
+	if (ent->key && ent->hash == hash && !strcmp(ent->key, path) &&
+	    path_valid(blob, ent)) {
+		cache.stats.hits++;
+		return ent->depth ? ent->offsets[ent->depth - 1] : 0;
+	}
+
+	cache.stats.misses++;
+	offset = fdt_path_offset(blob, path);
+	if (offset >= 0)
+		path_fill(blob, ent, hash, path, offset);
+
+	return offset;
+}
+
+void fdtdec_cache_invalidate(const void *blob)
+{
+	if (!(gd->flags & GD_FLG_RELOC) || !cache.blob)
+		return;
+	if (!blob || blob == cache.blob) {
+		cache_drop();
+		cache.stats.invalidations++;
+	}
+}
+
+void fdtdec_cache_get_stats(struct fdtdec_cache_stats *stats)
+{
+	*stats = cache.stats;
+}
@@ -14,6 +14,7 @@
 #include <memalign.h>
 #include <u-boot/zlib.h>
 #include <div64.h>
+#include <linux/sizes.h>
 
 #define HEADER0			'\x1f'
 #define HEADER1			'\x8b'
@@ -70,6 +71,72 @@ int gzip_parse_header(const unsigned char *src, unsigned long len)
 	return i;
 }
 
+#ifdef CONFIG_GZIP_VERIFY_CRC
+/*
+ * Inflate in chunks of this size and checksum each chunk while it is still
+ * in the cache. Every inflate() call also saves the last 32 KiB of output
+ * in the sliding window, so the chunk should not be much smaller than this.
+ */
+#define GUNZIP_CRC_CHUNK	SZ_256K
+
+static int zunzip_crc(void *dst, int dstlen, unsigned char *src,
+		      unsigned long *lenp, int offset)
+{
+	unsigned long avail = dstlen;
+	u32 crc = 0, trailer[2];
+	z_stream s;
+	int err = -1;
+	int r;
+
+	s.zalloc = gzalloc;
+	s.zfree = gzfree;
+
+	r = inflateInit2(&s, -MAX_WBITS);
+	if (r != Z_OK) {
+		printf("Error: inflateInit2() returned %d\n", r);
+		return -1;
+	}
+	s.next_in = src + offset;
+	s.avail_in = *lenp - offset;
+	s.next_out = dst;
+	do {
+		unsigned char *chunk = s.next_out;
+
+		s.avail_out = min_t(unsigned long, avail, GUNZIP_CRC_CHUNK);
+		avail -= s.avail_out;
+		r = inflate(&s, Z_NO_FLUSH);
+		avail += s.avail_out;
+		crc = crc32(crc, chunk, s.next_out - chunk);
+		if (r == Z_STREAM_END)
+			break;
+		if (r != Z_OK || !avail) {
+			printf("Error: inflate() returned %d\n", r);
+			goto out;
+		}
+	} while (1);
+
+	/* The raw deflate stream ends on a byte boundary before the trailer */
+	if (s.next_in - src + sizeof(trailer) > *lenp) {
+		puts("Error: gunzip out of data in trailer\n");
+		goto out;
+	}
+	memcpy(trailer, s.next_in, sizeof(trailer));
+	if (le32_to_cpu(trailer[0]) != crc ||
+	    le32_to_cpu(trailer[1]) != (u32)s.total_out) {
+		printf("Error: gunzip crc %08x/size %lx, expected %08x/%x\n",
+		       crc, s.total_out, le32_to_cpu(trailer[0]),
+		       le32_to_cpu(trailer[1]));
+		goto out;
+	}
+	err = 0;
+out:
+	*lenp = s.next_out - (unsigned char *)dst;
+	inflateEnd(&s);
+
+	return err;
+}
+#endif
+
 int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
 {
 	int offset = gzip_parse_header(src, *lenp);
@@ -77,7 +144,11 @@ int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
 	if (offset < 0)
 		return offset;
 
+#ifdef CONFIG_GZIP_VERIFY_CRC
+	return zunzip_crc(dst, dstlen, src, lenp, offset);
+#else
 	return zunzip(dst, dstlen, src, lenp, 1, offset);
+#endif
 }
 
 #ifdef CONFIG_CMD_UNZIP
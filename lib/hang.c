@@ -10,6 +10,7 @@
 
 #include <common.h>
 #include <bootstage.h>
+#include <console.h>
 
 /**
  * hang - stop processing by staying in an endless loop
@@ -24,6 +25,7 @@ void hang(void)
 #if !defined(CONFIG_SPL_BUILD) || (defined(CONFIG_SPL_LIBCOMMON_SUPPORT) && \
 		defined(CONFIG_SPL_SERIAL_SUPPORT))
 	puts("### ERROR ### Please RESET the board ###\n");
+	console_flush();
 #endif
 	bootstage_error(BOOTSTAGE_ID_NEED_RESET);
 	for (;;)
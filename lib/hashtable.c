@@ -66,6 +66,14 @@ typedef struct _ENTRY {
 static void _hdelete(const char *key, struct hsearch_data *htab, ENTRY *ep,
 	int idx);
 
+/* Free a key or value unless it is in the table's prebuilt string pool */
+static void hfree(struct hsearch_data *htab, const char *str)
+{
+	if (str >= htab->prebuilt && str < htab->prebuilt + htab->prebuilt_size)
+		return;
+	free((void *)str);
+}
+
 /*
  * hcreate()
  */
@@ -151,14 +159,16 @@ void hdestroy_r(struct hsearch_data *htab)
 		if (htab->table[i].used > 0) {
 			ENTRY *ep = &htab->table[i].entry;
 
-			free((void *)ep->key);
-			free(ep->data);
+			hfree(htab, ep->key);
+			hfree(htab, ep->data);
 		}
 	}
 	free(htab->table);
 
 	/* the sign for an existing table is an value != NULL in htable */
 	htab->table = NULL;
+	htab->prebuilt = NULL;
+	htab->prebuilt_size = 0;
 }
 
 /*
@@ -252,7 +262,7 @@ static inline int _compare_and_overwrite_entry(ENTRY item, ACTION action,
 				return 0;
 			}
 
-			free(htab->table[idx].entry.data);
+			hfree(htab, htab->table[idx].entry.data);
 			htab->table[idx].entry.data = strdup(item.data);
 			if (!htab->table[idx].entry.data) {
 				__set_errno(ENOMEM);
@@ -430,8 +440,8 @@ static void _hdelete(const char *key, struct hsearch_data *htab, ENTRY *ep,
 {
 	/* free used ENTRY */
 	debug("hdelete: DELETING key \"%s\"\n", key);
-	free((void *)ep->key);
-	free(ep->data);
+	hfree(htab, ep->key);
+	hfree(htab, ep->data);
 	ep->callback = NULL;
 	ep->flags = 0;
 	htab->table[idx].used = -1;
@@ -956,6 +966,83 @@ int himport_r(struct hsearch_data *htab,
 	return 1;		/* everything OK */
 }
 
+/*
+ * himport_prebuilt_r()
+ */
+
+/*
+ * The prebuilt table already holds every slot where himport_r() would
+ * have put it, so it is copied as it is and its strings are used in place.
+ * Callbacks and flags are bound for the whole table at once, then the
+ * change_ok() check and callbacks are applied to each entry in the order it
+ * was created, just as hsearch_r() does.
+ */
+int himport_prebuilt_r(struct hsearch_data *htab,
+		       const struct hprebuilt *prebuilt, int flag)
+{
+	unsigned int i;
+
+	if (htab == NULL || prebuilt == NULL) {
+		__set_errno(EINVAL);
+		return 0;
+	}
+
+	if (htab->table)
+		hdestroy_r(htab);
+
+	htab->table = calloc(prebuilt->size + 1, sizeof(_ENTRY));
+	if (htab->table == NULL) {
+		__set_errno(ENOMEM);
+		return 0;
+	}
+	htab->size = prebuilt->size;
+	htab->filled = 0;
+	htab->prebuilt = prebuilt->strings;
+	htab->prebuilt_size = prebuilt->strings_size;
+
+	for (i = 0; i < prebuilt->count; i++) {
+		const struct hprebuilt_entry *pe = &prebuilt->entries[i];
+		ENTRY *ep = &htab->table[pe->idx].entry;
+
+		htab->table[pe->idx].used = pe->used;
+		if (pe->used < 0)
+			continue;
+		ep->key = prebuilt->strings + pe->key;
+		/* The pool is read-only: values are replaced, never edited */
+		ep->data = (char *)prebuilt->strings + pe->data;
+		++htab->filled;
+	}
+
+	/* One pass over each attribute list rather than one per variable */
+	env_callback_init_table(htab);
+	env_flags_init_table(htab);
+
+	for (i = 0; i < prebuilt->count; i++) {
+		const struct hprebuilt_entry *pe = &prebuilt->entries[i];
+		ENTRY *ep = &htab->table[pe->idx].entry;
+
+		if (pe->used < 0)
+			continue;
+
+		if (htab->change_ok != NULL &&
+		    htab->change_ok(ep, ep->data, env_op_create, flag)) {
+			debug("change_ok() rejected setting variable "
+				"%s, skipping it!\n", ep->key);
+			_hdelete(ep->key, htab, ep, pe->idx);
+			continue;
+		}
+
+		if (ep->callback &&
+		    ep->callback(ep->key, ep->data, env_op_create, flag)) {
+			debug("callback() rejected setting variable "
+				"%s, skipping it!\n", ep->key);
+			_hdelete(ep->key, htab, ep, pe->idx);
+		}
+	}
+
+	return 1;
+}
+
 /*
  * hwalk_r()
  */
@@ -8,7 +8,9 @@
  */
 
 #include <common.h>
+#include <image.h>
 #include <lmb.h>
+#include <linux/sizes.h>
 
 #define LMB_ALLOC_ANYWHERE	0
 
@@ -344,3 +346,138 @@ __weak void arch_lmb_reserve(struct lmb *lmb)
 {
 	/* please define platform specific arch_lmb_reserve() */
 }
+
+#ifdef CONFIG_LMB_LOAD_MAP
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Number of loaded images to remember; the oldest is forgotten first */
+#define LMB_LOAD_MAX		8
+/* Stack space kept free below the initial stack pointer */
+#define LMB_LOAD_STACK_SIZE	SZ_1M
+
+struct lmb_load {
+	phys_addr_t base;
+	phys_size_t size;
+	char name[24];
+};
+
+/*
+ * Memory map shared by all loaders. 'fixed' holds RAM and the regions
+ * U-Boot itself uses, 'loads' the images loaded so far, oldest first.
+ */
+static struct {
+	struct lmb fixed;
+	int count;
+	struct lmb_load loads[LMB_LOAD_MAX];
+} load_map;
+
+/*
+ * Build the fixed part of the map. It is rebuilt on each use, so that
+ * changes to bootm_low and bootm_size take effect straight away.
+ */
+static struct lmb *lmb_load_fixed(void)
+{
+	struct lmb *lmb = &load_map.fixed;
+	phys_addr_t low = env_get_bootm_low();
+	phys_size_t size = env_get_bootm_size();
+	ulong sp = gd->start_addr_sp;
+
+	/* bootm_size may be set larger than the RAM U-Boot knows about */
+	if (gd->ram_top > low && size > gd->ram_top - low)
+		size = gd->ram_top - low;
+
+	lmb_init(lmb);
+	lmb_add(lmb, low, size);
+
+	/* Stack, global data, heap, FDT and code from here to the top */
+	if (sp > LMB_LOAD_STACK_SIZE && sp <= gd->ram_top)
+		lmb_reserve(lmb, sp - LMB_LOAD_STACK_SIZE,
+			    gd->ram_top - (sp - LMB_LOAD_STACK_SIZE));
+	arch_lmb_reserve(lmb);
+	board_lmb_reserve(lmb);
+
+	return lmb;
+}
+
+static void lmb_load_remove(int i)
+{
+	load_map.count--;
+	memmove(&load_map.loads[i], &load_map.loads[i + 1],
+		(load_map.count - i) * sizeof(load_map.loads[0]));
+}
+
+int lmb_load_check(phys_addr_t base, phys_size_t size, const char *name)
+{
+	struct lmb *lmb = lmb_load_fixed();
+	long i;
+
+	if (!size)
+		return 0;
+
+	i = lmb_overlaps_region(&lmb->reserved, base, size);
+	if (i < 0)
+		return 0;
+
+	printf("** Loading %s to 0x%llx-0x%llx would overwrite reserved memory at 0x%llx-0x%llx **\n",
+	       name, (unsigned long long)base,
+	       (unsigned long long)(base + size - 1),
+	       (unsigned long long)lmb->reserved.region[i].base,
+	       (unsigned long long)(lmb->reserved.region[i].base +
+				    lmb->reserved.region[i].size - 1));
+
+	return -EBUSY;
+}
+
+void lmb_load_add(phys_addr_t base, phys_size_t size, const char *name)
+{
+	struct lmb_load *load;
+	int i;
+
+	if (!size)
+		return;
+
+	for (i = 0; i < load_map.count;) {
+		load = &load_map.loads[i];
+		if (!lmb_addrs_overlap(base, size, load->base, load->size)) {
+			i++;
+			continue;
+		}
+		if (load->base != base)
+			printf("WARNING: %s at 0x%llx overwrites %s at 0x%llx\n",
+			       name, (unsigned long long)base, load->name,
+			       (unsigned long long)load->base);
+		lmb_load_remove(i);
+	}
+
+	if (load_map.count == LMB_LOAD_MAX)
+		lmb_load_remove(0);
+
+	load = &load_map.loads[load_map.count++];
+	load->base = base;
+	load->size = size;
+	strlcpy(load->name, name, sizeof(load->name));
+}
+
+void lmb_load_reserve(struct lmb *lmb)
+{
+	int i;
+
+	for (i = 0; i < load_map.count; i++)
+		lmb_reserve(lmb, load_map.loads[i].base,
+			    load_map.loads[i].size);
+}
+
+phys_addr_t lmb_load_alloc(phys_size_t size, ulong align)
+{
+	struct lmb lmb = *lmb_load_fixed();
+	int i;
+
+	for (i = 0; i < load_map.count; i++) {
+		if (lmb_reserve(&lmb, load_map.loads[i].base,
+				load_map.loads[i].size) < 0)
+			return 0;
+	}
+
+	return __lmb_alloc_base(&lmb, size, align, LMB_ALLOC_ANYWHERE);
+}
+#endif /* CONFIG_LMB_LOAD_MAP */
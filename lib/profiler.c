@@ -0,0 +1,149 @@
+/*
+ * Statistical sampling profiler
+ *
+ * Each sample is stored as a struct trace_sample: a depth followed by the
+ * code offsets of the interrupted location and of each return address found
+ * on the frame pointer chain. The buffer is allocated when profiling first
+ * starts and samples which do not fit are counted and dropped.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <malloc.h>
+#include <profiler.h>
+#include <trace.h>
+#include <asm/sections.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+static struct {
+	u32 *buf;		/* sample records */
+	uint size;		/* size of @buf in words */
+	uint used;		/* words used in @buf */
+	uint samples;		/* number of samples recorded */
+	uint dropped;		/* number of samples which did not fit */
+	uint hz;		/* sample rate */
+	ulong start_us;		/* time the current run started */
+	ulong run_us;		/* time spent sampling */
+	volatile bool running;
+} prof;
+
+/* Convert a code address to an offset from the start of U-Boot's text */
+static u32 profiler_offset(ulong addr)
+{
+#ifdef CONFIG_SANDBOX
+	addr -= (ulong)&_init;
+#else
+	if (gd->flags & GD_FLG_RELOC)
+		addr -= gd->relocaddr;
+	else
+		addr -= CONFIG_SYS_TEXT_BASE;
+#endif
+	return addr;
+}
+
+void profiler_sample(ulong pc, ulong fp, ulong stack_lo, ulong stack_hi)
+{
+	ulong *frame;
+	uint depth;
+	u32 *rec;
+
+	if (!prof.running)
+		return;
+	if (prof.used + 1 + PROFILER_MAX_DEPTH > prof.size) {
+		prof.dropped++;
+		return;
+	}
+
+	rec = prof.buf + prof.used;
+	depth = 0;
+	rec[++depth] = profiler_offset(pc);
+	while (depth < PROFILER_MAX_DEPTH) {
+		if (fp < stack_lo || fp > stack_hi - 2 * sizeof(ulong) ||
+		    (fp & (sizeof(ulong) - 1)))
+			break;
+
+		/* A frame record holds the caller's frame pointer and the LR */
+		frame = (ulong *)fp;
+		if (!frame[1])
+			break;
+		rec[++depth] = profiler_offset(frame[1]);
+		if (frame[0] <= fp)
+			break;
+		fp = frame[0];
+	}
+	rec[0] = depth;
+	prof.used += 1 + depth;
+	prof.samples++;
+}
+
+int profiler_start(uint hz)
+{
+	int ret;
+
+	if (prof.running)
+		return -EBUSY;
+	if (!prof.buf) {
+		prof.buf = malloc(CONFIG_PROFILER_BUFFER_SIZE);
+		if (!prof.buf)
+			return -ENOMEM;
+		prof.size = CONFIG_PROFILER_BUFFER_SIZE / sizeof(u32);
+	}
+	prof.used = 0;
+	prof.samples = 0;
+	prof.dropped = 0;
+	prof.run_us = 0;
+	prof.hz = hz;
+	prof.start_us = timer_get_us();
+	prof.running = true;
+
+	ret = arch_profiler_start(hz);
+	if (ret) {
+		prof.running = false;
+		return ret;
+	}
+
+	return 0;
+}
+
+void profiler_stop(void)
+{
+	if (!prof.running)
+		return;
+	arch_profiler_stop();
+	prof.running = false;
+	prof.run_us = timer_get_us() - prof.start_us;
+}
+
+void profiler_print_stats(void)
+{
+	ulong run_us = prof.run_us;
+
+	if (prof.running)
+		run_us = timer_get_us() - prof.start_us;
+	printf("%s, %u Hz, %lu.%03lu s\n",
+	       prof.running ? "Running" : "Stopped", prof.hz,
+	       run_us / 1000000, run_us / 1000 % 1000);
+	printf("%u samples, %u dropped\n", prof.samples, prof.dropped);
+	printf("Buffer %#x of %#x bytes used\n",
+	       (uint)(prof.used * sizeof(u32)), CONFIG_PROFILER_BUFFER_SIZE);
+}
+
+int profiler_save(void *buff, int buff_size, int *needed)
+{
+	struct trace_output_hdr *hdr = buff;
+	int size;
+
+	size = sizeof(*hdr) + prof.used * sizeof(u32);
+	*needed = size;
+	if (size > buff_size)
+		return -ENOSPC;
+
+	hdr->type = TRACE_CHUNK_SAMPLES;
+	hdr->rec_count = prof.samples;
+	memcpy(hdr + 1, prof.buf, prof.used * sizeof(u32));
+
+	return 0;
+}
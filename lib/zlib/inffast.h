@@ -9,3 +9,18 @@
  */
 
 void inflate_fast OF((z_streamp strm, unsigned start));
+
+/*
+ * U-Boot: minimum input and output space inflate_fast() needs on entry.
+ * When inflate_fast64() is built as well, both are called with the room
+ * it needs.
+ */
+#ifdef CONFIG_ZLIB_INFLATE_FAST
+void inflate_fast64 OF((z_streamp strm, unsigned start));
+
+#define INFLATE_FAST_MIN_HAVE	8
+#define INFLATE_FAST_MIN_LEFT	(258 + 16)
+#else
+#define INFLATE_FAST_MIN_HAVE	6
+#define INFLATE_FAST_MIN_LEFT	258
+#endif
@@ -0,0 +1,319 @@
+/* inffast64.c -- fast decoding with a 64-bit bit buffer
+ * Copyright (C) 1995-2004 Mark Adler
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ */
+
+/* U-Boot: this is an alternative to inffast.c, built with
+   CONFIG_ZLIB_INFLATE_FAST.  inflate() uses it while zlib_inflate_fast64
+   is set, which it is unless a test clears it to compare the two.  It
+   differs from the original in three ways:
+
+   - The bit buffer is refilled eight bytes at a time with a single
+     unaligned load, so one refill covers a full length/distance pair
+     (at most 48 bits) and the per-byte refill branches go away.
+   - Matches are copied eight bytes at a time, sixteen per loop, when the
+     distance allows it, and runs of a single byte are expanded with
+     eight-byte stores.  Copies may run up to 15 bytes past the end of
+     the match, so inflate() only calls us with INFLATE_FAST_MIN_LEFT
+     bytes of output space.
+   - Consecutive literals are decoded from the bits already in the buffer
+     without going back through the refill at the top of the loop.
+
+   Entry and exit conditions are the same as for the original, with
+   strm->avail_in >= INFLATE_FAST_MIN_HAVE and strm->avail_out >=
+   INFLATE_FAST_MIN_LEFT.
+ */
+
+#ifndef ASMINF
+
+static inline u64 inffast_load64(const unsigned char FAR *p)
+{
+    u64 v;
+
+    __builtin_memcpy(&v, p, sizeof(v));
+    return le64_to_cpu(v);
+}
+
+static inline void inffast_copy8(unsigned char FAR *dst,
+                                 const unsigned char FAR *src)
+{
+    __builtin_memcpy(dst, src, 8);
+}
+
+int zlib_inflate_fast64 = 1;
+
+void inflate_fast64(z_streamp strm, unsigned start)
+/* start: inflate()'s starting value for strm->avail_out */
+{
+    struct inflate_state FAR *state;
+    unsigned char FAR *in;      /* local strm->next_in */
+    unsigned char FAR *last;    /* while in < last, enough input available */
+    unsigned char FAR *out;     /* local strm->next_out */
+    unsigned char FAR *beg;     /* inflate()'s initial strm->next_out */
+    unsigned char FAR *end;     /* while out < end, enough space available */
+#ifdef INFLATE_STRICT
+    unsigned dmax;              /* maximum distance from zlib header */
+#endif
+    unsigned wsize;             /* window size or zero if not using window */
+    unsigned whave;             /* valid bytes in the window */
+    unsigned write;             /* window write index */
+    unsigned char FAR *window;  /* allocated sliding window, if wsize != 0 */
+    u64 hold;                   /* local strm->hold */
+    unsigned bits;              /* local strm->bits */
+    code const FAR *lcode;      /* local strm->lencode */
+    code const FAR *dcode;      /* local strm->distcode */
+    unsigned lmask;             /* mask for first level of length codes */
+    unsigned dmask;             /* mask for first level of distance codes */
+    code this;                  /* retrieved table entry */
+    unsigned op;                /* code bits, operation, extra bits, or */
+                                /*  window position, window bytes to copy */
+    unsigned len;               /* match length, unused bytes */
+    unsigned dist;              /* match distance */
+    unsigned char FAR *from;    /* where to copy match from */
+    unsigned char FAR *mend;    /* end of the match being copied */
+
+    /* copy state to local variables */
+    state = (struct inflate_state FAR *)strm->state;
+    in = strm->next_in;
+    last = in + (strm->avail_in - (INFLATE_FAST_MIN_HAVE - 1));
+    if (in > last && strm->avail_in > INFLATE_FAST_MIN_HAVE - 1) {
+        /*
+         * overflow detected, limit strm->avail_in to the
+         * max. possible size and recalculate last
+         */
+        strm->avail_in = 0xffffffff - (uintptr_t)in;
+        last = in + (strm->avail_in - (INFLATE_FAST_MIN_HAVE - 1));
+    }
+    out = strm->next_out;
+    beg = out - (start - strm->avail_out);
+    end = out + (strm->avail_out - (INFLATE_FAST_MIN_LEFT - 1));
+#ifdef INFLATE_STRICT
+    dmax = state->dmax;
+#endif
+    wsize = state->wsize;
+    whave = state->whave;
+    write = state->write;
+    window = state->window;
+    hold = state->hold;
+    bits = state->bits;
+    lcode = state->lencode;
+    dcode = state->distcode;
+    lmask = (1U << state->lenbits) - 1;
+    dmask = (1U << state->distbits) - 1;
+
+    /* decode literals and length/distances until end-of-block or not enough
+       input data or output space */
+    do {
+        /*
+         * Top up the bit buffer to at least 56 bits.  Bits above 'bits'
+         * may already hold the following input bytes; OR-ing the same
+         * bytes in again leaves them unchanged.
+         */
+        if (bits < 48) {
+            hold |= inffast_load64(in) << bits;
+            in += (63 - bits) >> 3;
+            bits |= 56;
+        }
+        this = lcode[hold & lmask];
+      dolen:
+        op = (unsigned)(this.bits);
+        hold >>= op;
+        bits -= op;
+        op = (unsigned)(this.op);
+        if (op == 0) {                          /* literal */
+            Tracevv((stderr, this.val >= 0x20 && this.val < 0x7f ?
+                    "inflate:         literal '%c'\n" :
+                    "inflate:         literal 0x%02x\n", this.val));
+            *out++ = (unsigned char)(this.val);
+            /* up to two more literals without a refill */
+            if (bits >= 15) {
+                this = lcode[hold & lmask];
+                if (this.op == 0) {
+                    hold >>= this.bits;
+                    bits -= this.bits;
+                    *out++ = (unsigned char)(this.val);
+                    if (bits >= 15) {
+                        this = lcode[hold & lmask];
+                        if (this.op == 0) {
+                            hold >>= this.bits;
+                            bits -= this.bits;
+                            *out++ = (unsigned char)(this.val);
+                        }
+                    }
+                }
+            }
+        }
+        else if (op & 16) {                     /* length base */
+            len = (unsigned)(this.val);
+            op &= 15;                           /* number of extra bits */
+            if (op) {
+                len += (unsigned)hold & ((1U << op) - 1);
+                hold >>= op;
+                bits -= op;
+            }
+            Tracevv((stderr, "inflate:         length %u\n", len));
+            this = dcode[hold & dmask];
+          dodist:
+            op = (unsigned)(this.bits);
+            hold >>= op;
+            bits -= op;
+            op = (unsigned)(this.op);
+            if (op & 16) {                      /* distance base */
+                dist = (unsigned)(this.val);
+                op &= 15;                       /* number of extra bits */
+                dist += (unsigned)hold & ((1U << op) - 1);
+#ifdef INFLATE_STRICT
+                if (dist > dmax) {
+                    strm->msg = (char *)"invalid distance too far back";
+                    state->mode = BAD;
+                    break;
+                }
+#endif
+                hold >>= op;
+                bits -= op;
+                Tracevv((stderr, "inflate:         distance %u\n", dist));
+                op = (unsigned)(out - beg);     /* max distance in output */
+                if (dist > op) {                /* see if copy from window */
+                    op = dist - op;             /* distance back in window */
+                    if (op > whave) {
+                        strm->msg = (char *)"invalid distance too far back";
+                        state->mode = BAD;
+                        break;
+                    }
+                    from = window;
+                    if (write == 0) {           /* very common case */
+                        from += wsize - op;
+                        if (op < len) {         /* some from window */
+                            len -= op;
+                            do {
+                                *out++ = *from++;
+                            } while (--op);
+                            from = out - dist;  /* rest from output */
+                        }
+                    }
+                    else if (write < op) {      /* wrap around window */
+                        from += wsize + write - op;
+                        op -= write;
+                        if (op < len) {         /* some from end of window */
+                            len -= op;
+                            do {
+                                *out++ = *from++;
+                            } while (--op);
+                            from = window;
+                            if (write < len) {  /* some from start of window */
+                                op = write;
+                                len -= op;
+                                do {
+                                    *out++ = *from++;
+                                } while (--op);
+                                from = out - dist;      /* rest from output */
+                            }
+                        }
+                    }
+                    else {                      /* contiguous in window */
+                        from += write - op;
+                        if (op < len) {         /* some from window */
+                            len -= op;
+                            do {
+                                *out++ = *from++;
+                            } while (--op);
+                            from = out - dist;  /* rest from output */
+                        }
+                    }
+                    while (len > 2) {
+                        *out++ = *from++;
+                        *out++ = *from++;
+                        *out++ = *from++;
+                        len -= 3;
+                    }
+                    if (len) {
+                        *out++ = *from++;
+                        if (len > 1)
+                            *out++ = *from++;
+                    }
+                }
+                else {
+                    from = out - dist;          /* copy direct from output */
+                    mend = out + len;
+                    if (dist >= 8) {
+                        /*
+                         * Every load is at least eight bytes behind the
+                         * store before it, so the overlap is harmless.
+                         */
+                        do {
+                            inffast_copy8(out, from);
+                            inffast_copy8(out + 8, from + 8);
+                            out += 16;
+                            from += 16;
+                        } while (out < mend);
+                    }
+                    else if (dist == 1) {       /* run of a single byte */
+                        u64 pat = 0x0101010101010101ULL * from[0];
+
+                        do {
+                            __builtin_memcpy(out, &pat, 8);
+                            __builtin_memcpy(out + 8, &pat, 8);
+                            out += 16;
+                        } while (out < mend);
+                    }
+                    else {                      /* minimum length is three */
+                        do {
+                            *out++ = *from++;
+                            *out++ = *from++;
+                            *out++ = *from++;
+                        } while (out < mend);
+                    }
+                    out = mend;
+                }
+            }
+            else if ((op & 64) == 0) {          /* 2nd level distance code */
+                this = dcode[this.val + (hold & ((1U << op) - 1))];
+                goto dodist;
+            }
+            else {
+                strm->msg = (char *)"invalid distance code";
+                state->mode = BAD;
+                break;
+            }
+        }
+        else if ((op & 64) == 0) {              /* 2nd level length code */
+            this = lcode[this.val + (hold & ((1U << op) - 1))];
+            goto dolen;
+        }
+        else if (op & 32) {                     /* end-of-block */
+            Tracevv((stderr, "inflate:         end of block\n"));
+            state->mode = TYPE;
+            break;
+        }
+        else {
+            strm->msg = (char *)"invalid literal/length code";
+            state->mode = BAD;
+            break;
+        }
+    } while (in < last && out < end);
+
+    /*
+     * return unused bytes: bits may be anything up to 63 here, but every
+     * whole byte left in the bit buffer was counted in by a refill, so in
+     * does not go back past where this call started
+     */
+    len = bits >> 3;
+    in -= len;
+    bits -= len << 3;
+    hold &= (1U << bits) - 1;
+
+    /* update state and return */
+    strm->next_in = in;
+    strm->next_out = out;
+    strm->avail_in = (unsigned)(in < last ?
+                                (INFLATE_FAST_MIN_HAVE - 1) + (last - in) :
+                                (INFLATE_FAST_MIN_HAVE - 1) - (in - last));
+    strm->avail_out = (unsigned)(out < end ?
+                                 (INFLATE_FAST_MIN_LEFT - 1) + (end - out) :
+                                 (INFLATE_FAST_MIN_LEFT - 1) - (out - end));
+    state->hold = hold;
+    state->bits = bits;
+    return;
+}
+
+#endif /* !ASMINF */
@@ -722,9 +722,14 @@ int ZEXPORT inflate(z_streamp strm, int flush)
             state->mode = LEN;
         case LEN:
 	    WATCHDOG_RESET();
-            if (have >= 6 && left >= 258) {
+            if (have >= INFLATE_FAST_MIN_HAVE && left >= INFLATE_FAST_MIN_LEFT) {
                 RESTORE();
-                inflate_fast(strm, out);
+#ifdef CONFIG_ZLIB_INFLATE_FAST
+                if (zlib_inflate_fast64)
+                    inflate_fast64(strm, out);
+                else
+#endif
+                    inflate_fast(strm, out);
                 LOAD();
                 break;
             }
@@ -26,6 +26,9 @@
 #include "inffast.h"
 #include "inffixed.h"
 #include "inffast.c"
+#ifdef CONFIG_ZLIB_INFLATE_FAST
+#include "inffast64.c"
+#endif
 #include "inftrees.c"
 #include "inflate.c"
 #include "zutil.c"
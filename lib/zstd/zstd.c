@@ -0,0 +1,47 @@
+/*
+ * Zstandard decompression for U-Boot
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <malloc.h>
+
+#define ZSTD_STATIC_LINKING_ONLY
+#include "zstd.h"
+#include "zstd_errors.h"
+
+int zstd_decompress(const void *src, size_t srcn, void *dst, size_t *dstn)
+{
+	size_t wsize, len, ret;
+	ZSTD_DCtx *dctx;
+	void *wksp;
+
+	/* Anything after the frame, such as padding, is ignored */
+	len = ZSTD_findFrameCompressedSize(src, srcn);
+	if (ZSTD_isError(len))
+		return -EINVAL;
+
+	wsize = ZSTD_estimateDCtxSize();
+	wksp = malloc(wsize);
+	if (!wksp)
+		return -ENOMEM;
+
+	dctx = ZSTD_initStaticDCtx(wksp, wsize);
+	if (!dctx) {
+		free(wksp);
+		return -ENOMEM;
+	}
+
+	ret = ZSTD_decompressDCtx(dctx, dst, *dstn, src, len);
+	free(wksp);
+	if (ZSTD_isError(ret)) {
+		debug("%s: %s\n", __func__, ZSTD_getErrorName(ret));
+		if (ZSTD_getErrorCode(ret) == ZSTD_error_dstSize_tooSmall)
+			return -ENOSPC;
+		return -EINVAL;
+	}
+	*dstn = ret;
+
+	return 0;
+}
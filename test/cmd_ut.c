@@ -44,6 +44,9 @@ static cmd_tbl_t cmd_ut_sub[] = {
 #if defined(CONFIG_UT_ENV)
 	U_BOOT_CMD_MKENT(env, CONFIG_SYS_MAXARGS, 1, do_ut_env, "", ""),
 #endif
+#ifdef CONFIG_MALLOC_SLAB
+	U_BOOT_CMD_MKENT(malloc, CONFIG_SYS_MAXARGS, 1, do_ut_malloc, "", ""),
+#endif
 #ifdef CONFIG_UT_OVERLAY
 	U_BOOT_CMD_MKENT(overlay, CONFIG_SYS_MAXARGS, 1, do_ut_overlay, "", ""),
 #endif
@@ -53,6 +56,7 @@ static cmd_tbl_t cmd_ut_sub[] = {
 #ifdef CONFIG_SANDBOX
 	U_BOOT_CMD_MKENT(compression, CONFIG_SYS_MAXARGS, 1, do_ut_compression,
 			 "", ""),
+	U_BOOT_CMD_MKENT(pgtable, CONFIG_SYS_MAXARGS, 1, do_ut_pgtable, "", ""),
 #endif
 };
 
@@ -100,6 +104,9 @@ static char ut_help_text[] =
 #ifdef CONFIG_UT_ENV
 	"ut env [test-name]\n"
 #endif
+#ifdef CONFIG_MALLOC_SLAB
+	"ut malloc - Test the slab front-end of malloc()\n"
+#endif
 #ifdef CONFIG_UT_OVERLAY
 	"ut overlay [test-name]\n"
 #endif
@@ -108,6 +115,7 @@ static char ut_help_text[] =
 #endif
 #ifdef CONFIG_SANDBOX
 	"ut compression - Test compressors and bootm decompression\n"
+	"ut pgtable - Test the arm64 page table code\n"
 #endif
 	;
 #endif
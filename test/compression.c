@@ -19,6 +19,7 @@
 #include <lzma/LzmaTools.h>
 
 #include <linux/lzo.h>
+#include <linux/sizes.h>
 #include <test/compression.h>
 #include <test/suites.h>
 #include <test/ut.h>
@@ -118,6 +119,23 @@ static const char lz4_compressed[] =
 	"\x9d\x12\x8c\x9d";
 static const unsigned long lz4_compressed_size = 276;
 
+/* zstd -19 -c /tmp/plain.txt > /tmp/plain.zst */
+static const char zstd_compressed[] =
+	"\x28\xb5\x2f\xfd\x64\x5e\x00\xad\x05\x00\x42\x4e\x26\x17\x90\x3b"
+	"\x07\x04\x5a\x13\x8b\xa7\x65\x34\x12\x21\x6d\xb0\x39\xbb\xae\xe8"
+	"\xba\xc9\xcd\x5e\x02\x49\xd0\x2b\xa9\xfa\x96\x92\xe7\x1f\x19\x19"
+	"\x7c\x8f\xf1\x9d\x54\x37\xfc\xd6\x0a\xf3\x0c\x93\x56\xc7\x52\x4f"
+	"\x0a\x62\x3e\xd1\xa5\x83\x17\x31\xab\x5d\x8f\x57\xf3\xcc\x3b\x58"
+	"\xf8\x91\x8c\xf1\x2a\x5c\x89\xdd\xf2\x9b\x15\xb7\x92\x5b\xbe\xba"
+	"\xab\xd5\xd1\x34\xdf\xf0\x02\x0e\x61\xcd\x7b\xd6\x01\xfc\xc2\xa7"
+	"\xd4\xd1\x3d\x26\x9c\x10\x49\xb8\x5b\xcd\xba\x7c\xf7\xac\x4b\xad"
+	"\xb7\x31\x1c\xbc\xf9\xcb\x62\x8e\x2e\x9b\x0f\xd3\x87\x57\x45\x12"
+	"\x16\xfa\x3a\x79\xde\x65\xf8\xcc\x48\xd5\x43\xa6\xbd\xc3\x91\x29"
+	"\x65\x29\xa7\x5b\x9a\x08\x08\x00\x60\x13\x00\x63\xa3\x8e\x28\x94"
+	"\x79\x41\x2a\x78\xc2\x91\x70\x9f\xaa\x6a\x21\x7a\xa1\xaa\x0c\xe4"
+	"\xf4\x6e\xfa";
+static const unsigned long zstd_compressed_size = 195;
+
 
 #define TEST_BUFFER_SIZE	512
 
@@ -293,6 +311,40 @@ static int uncompress_using_lz4(struct unit_test_state *uts,
 	return (ret != 0);
 }
 
+static int compress_using_zstd(struct unit_test_state *uts,
+			       void *in, unsigned long in_size,
+			       void *out, unsigned long out_max,
+			       unsigned long *out_size)
+{
+	/* There is no zstd compression in u-boot, so fake it. */
+	ut_asserteq(in_size, strlen(plain));
+	ut_asserteq(0, memcmp(plain, in, in_size));
+
+	if (zstd_compressed_size > out_max)
+		return -1;
+
+	memcpy(out, zstd_compressed, zstd_compressed_size);
+	if (out_size)
+		*out_size = zstd_compressed_size;
+
+	return 0;
+}
+
+static int uncompress_using_zstd(struct unit_test_state *uts,
+				 void *in, unsigned long in_size,
+				 void *out, unsigned long out_max,
+				 unsigned long *out_size)
+{
+	size_t output_size = out_max;
+	int ret;
+
+	ret = zstd_decompress(in, in_size, out, &output_size);
+	if (out_size)
+		*out_size = output_size;
+
+	return ret != 0;
+}
+
 #define errcheck(statement) if (!(statement)) { \
 	fprintf(stderr, "\tFailed: %s\n", #statement); \
 	ret = 1; \
@@ -437,6 +489,109 @@ static int compression_test_lz4(struct unit_test_state *uts)
 }
 COMPRESSION_TEST(compression_test_lz4, 0);
 
+static int compression_test_zstd(struct unit_test_state *uts)
+{
+	return run_test(uts, "zstd", compress_using_zstd,
+			uncompress_using_zstd);
+}
+COMPRESSION_TEST(compression_test_zstd, 0);
+
+#define BENCH_SIZE	SZ_2M
+
+/* Fill @buf with text interspersed with noise, so it compresses ~3:1 */
+static void fill_bench_data(unsigned char *buf, ulong size)
+{
+	ulong plain_len = strlen(plain);
+	u32 seed = 0x12345678;
+	ulong i;
+
+	for (i = 0; i < size; i++) {
+		seed = seed * 1103515245 + 12345;
+		if ((seed >> 24) < 16)
+			buf[i] = seed >> 16;
+		else
+			buf[i] = plain[i % plain_len];
+	}
+}
+
+static void print_rate(const char *name, ulong bytes, ulong us)
+{
+	if (!us)
+		us = 1;
+	printf("\t%-8s %7lu KiB in %7lu us: %5lu MB/s\n", name, bytes >> 10,
+	       us, bytes / us);
+}
+
+/*
+ * Report gunzip() and crc32() throughput on a couple of MiB of data. With
+ * CONFIG_ZLIB_INFLATE_FAST gunzip() is timed with both inflate fast paths.
+ * Run it on builds with and without CONFIG_GZIP_VERIFY_CRC and
+ * CONFIG_ARM64_CRC32 to compare those.
+ */
+static int compression_test_gzip_speed(struct unit_test_state *uts)
+{
+	unsigned char *orig, *comp, *unc;
+	ulong comp_size, unc_size, start;
+	u32 crc;
+	int ret;
+
+	orig = malloc(BENCH_SIZE);
+	comp = malloc(BENCH_SIZE);
+	unc = malloc(BENCH_SIZE);
+	ut_assertnonnull(orig);
+	ut_assertnonnull(comp);
+	ut_assertnonnull(unc);
+
+	fill_bench_data(orig, BENCH_SIZE);
+	memset(unc, '\0', BENCH_SIZE);
+	comp_size = BENCH_SIZE;
+	ut_assertok(gzip(comp, &comp_size, orig, BENCH_SIZE));
+	printf("\tcompressed %u KiB to %lu KiB\n", BENCH_SIZE >> 10,
+	       comp_size >> 10);
+
+	start = timer_get_us();
+	unc_size = comp_size;
+#ifdef CONFIG_ZLIB_INFLATE_FAST
+	zlib_inflate_fast64 = 0;
+#endif
+	ret = gunzip(unc, BENCH_SIZE, comp, &unc_size);
+	print_rate("gunzip", unc_size, timer_get_us() - start);
+	ut_assertok(ret);
+	ut_asserteq(BENCH_SIZE, unc_size);
+	ut_assertok(memcmp(orig, unc, BENCH_SIZE));
+
+#ifdef CONFIG_ZLIB_INFLATE_FAST
+	memset(unc, '\0', BENCH_SIZE);
+	start = timer_get_us();
+	unc_size = comp_size;
+	zlib_inflate_fast64 = 1;
+	ret = gunzip(unc, BENCH_SIZE, comp, &unc_size);
+	print_rate("gunzip64", unc_size, timer_get_us() - start);
+	ut_assertok(ret);
+	ut_asserteq(BENCH_SIZE, unc_size);
+	ut_assertok(memcmp(orig, unc, BENCH_SIZE));
+#endif
+
+	start = timer_get_us();
+	crc = crc32(0, orig, BENCH_SIZE);
+	print_rate("crc32", BENCH_SIZE, timer_get_us() - start);
+	ut_asserteq(crc, crc32(crc32(0, orig, 3), orig + 3, BENCH_SIZE - 3));
+
+	/* A corrupted trailer must be caught when checking is enabled */
+	if (IS_ENABLED(CONFIG_GZIP_VERIFY_CRC)) {
+		comp[comp_size - 8] ^= 0xff;
+		unc_size = comp_size;
+		ut_assert(gunzip(unc, BENCH_SIZE, comp, &unc_size));
+	}
+
+	free(unc);
+	free(comp);
+	free(orig);
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_gzip_speed, 0);
+
 static int compress_using_none(struct unit_test_state *uts,
 			       void *in, unsigned long in_size,
 			       void *out, unsigned long out_max,
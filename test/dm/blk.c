@@ -6,8 +6,15 @@
 
 #include <common.h>
 #include <dm.h>
+#include <fs.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <os.h>
+#include <sandboxblockdev.h>
 #include <usb.h>
 #include <asm/state.h>
+#include <asm/unaligned.h>
+#include <dm/device-internal.h>
 #include <dm/test.h>
 #include <test/ut.h>
 
@@ -168,3 +175,316 @@ static int dm_test_blk_get_from_parent(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_blk_get_from_parent, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+#define HOST_IMG_FILE		"blk_test.img"
+
+/*
+ * Bind host device 0 to a new backing file holding size bytes of img,
+ * with HOST_BIND_... flags
+ */
+static int host_bind_image(struct unit_test_state *uts, const void *img,
+			   int size, int flags, struct blk_desc **descp)
+{
+	int fd;
+
+	ut_assertok(host_dev_bind(0, NULL, 0));
+	os_unlink(HOST_IMG_FILE);
+	fd = os_open(HOST_IMG_FILE, OS_O_RDWR | OS_O_CREAT);
+	ut_assert(fd >= 0);
+	ut_asserteq(size, os_write(fd, img, size));
+	os_close(fd);
+	ut_assertok(host_dev_bind(0, HOST_IMG_FILE, flags));
+	ut_assertok(blk_get_device_by_str("host", "0", descp));
+
+	return 0;
+}
+
+/* Enough for the btrfs superblock at 64KiB */
+#define SNIFF_IMG_SIZE		0x20000
+
+/* Write an image to the host device and return what fs_sniff() finds */
+static int sniff_image(struct blk_desc *desc, const void *img)
+{
+	disk_partition_t part = {
+		.start	= 0,
+		.size	= desc->lba,
+		.blksz	= desc->blksz,
+	};
+
+	if (blk_dwrite(desc, 0, desc->lba, img) != desc->lba)
+		return -EIO;
+
+	return fs_sniff(desc, &part);
+}
+
+/* Test that each filesystem is recognised from its signature alone */
+static int dm_test_blk_fs_sniff(struct unit_test_state *uts)
+{
+	struct blk_desc *desc;
+	u8 *img;
+
+	img = calloc(1, SNIFF_IMG_SIZE);
+	ut_assertnonnull(img);
+	ut_assertok(host_bind_image(uts, img, SNIFF_IMG_SIZE, 0, &desc));
+
+	/* Nothing there */
+	ut_asserteq(FS_TYPE_ANY, sniff_image(desc, img));
+
+	if (IS_ENABLED(CONFIG_FS_FAT)) {
+		/* FAT12/16 boot sector */
+		img[0] = 0xeb;
+		memcpy(img + 0x36, "FAT16   ", 8);
+		put_unaligned_le16(0xaa55, img + 510);
+		ut_asserteq(FS_TYPE_FAT, sniff_image(desc, img));
+
+		/* The same without the boot signature is not FAT */
+		put_unaligned_le16(0, img + 510);
+		ut_asserteq(FS_TYPE_ANY, sniff_image(desc, img));
+
+		/* FAT32 boot sector */
+		memset(img, '\0', 512);
+		img[0] = 0xe9;
+		memcpy(img + 0x52, "FAT32   ", 8);
+		put_unaligned_le16(0xaa55, img + 510);
+		ut_asserteq(FS_TYPE_FAT, sniff_image(desc, img));
+
+		/* exFAT boot sector */
+		memset(img, '\0', 512);
+		memcpy(img, "\xeb\x76\x90" "EXFAT   ", 11);
+		put_unaligned_le16(0xaa55, img + 510);
+		ut_asserteq(FS_TYPE_FAT, sniff_image(desc, img));
+		memset(img, '\0', 512);
+	}
+
+	if (IS_ENABLED(CONFIG_FS_EXT4)) {
+		/* s_magic in the ext2/3/4 superblock */
+		put_unaligned_le16(0xef53, img + 1024 + 0x38);
+		ut_asserteq(FS_TYPE_EXT, sniff_image(desc, img));
+		put_unaligned_le16(0, img + 1024 + 0x38);
+	}
+
+	if (IS_ENABLED(CONFIG_FS_SQUASHFS)) {
+		memcpy(img, "hsqs", 4);
+		ut_asserteq(FS_TYPE_SQUASHFS, sniff_image(desc, img));
+		memset(img, '\0', 4);
+	}
+
+	if (IS_ENABLED(CONFIG_FS_BTRFS)) {
+		/* Magic in the superblock at 64KiB */
+		memcpy(img + 0x10040, "_BHRfS_M", 8);
+		ut_asserteq(FS_TYPE_BTRFS, sniff_image(desc, img));
+		memset(img + 0x10040, '\0', 8);
+
+		/* A partition too small to hold the superblock */
+		ut_assertok(host_bind_image(uts, img, 0x10000, 0, &desc));
+		ut_asserteq(FS_TYPE_ANY, sniff_image(desc, img));
+	}
+
+	/* Data which matches no signature */
+	memset(img, 0xa5, SNIFF_IMG_SIZE);
+	ut_asserteq(FS_TYPE_ANY, sniff_image(desc, img));
+
+	ut_assertok(host_dev_bind(0, NULL, 0));
+	os_unlink(HOST_IMG_FILE);
+	free(img);
+
+	return 0;
+}
+DM_TEST(dm_test_blk_fs_sniff, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+#ifdef CONFIG_FS_SQUASHFS
+#define SQFS_IMG_SIZE		4096
+#define SQFS_DATA_START		96
+
+/*
+ * Make an uncompressed SquashFS image whose root directory holds one file,
+ * with the given name and data. Images made with names and data of the
+ * same lengths have the same superblock.
+ */
+static void make_sqfs_image(u8 *img, const char *name, const char *data)
+{
+	int name_len = strlen(name), data_len = strlen(data);
+	int inodes = SQFS_DATA_START + data_len;
+	int dirs = inodes + 2 + 68;
+	int end = dirs + 2 + 20 + name_len;
+	u8 *p;
+
+	memset(img, '\0', SQFS_IMG_SIZE);
+
+	/* Superblock, with no fragment, xattr or export tables */
+	memcpy(img, "hsqs", 4);
+	put_unaligned_le32(2, img + 4);
+	put_unaligned_le32(4096, img + 12);
+	put_unaligned_le16(1, img + 20);
+	put_unaligned_le16(12, img + 22);
+	put_unaligned_le16(4, img + 28);
+	put_unaligned_le64(end, img + 40);
+	put_unaligned_le64(end, img + 48);
+	put_unaligned_le64(-1ULL, img + 56);
+	put_unaligned_le64(inodes, img + 64);
+	put_unaligned_le64(dirs, img + 72);
+	put_unaligned_le64(-1ULL, img + 80);
+	put_unaligned_le64(-1ULL, img + 88);
+
+	/* The file's data, in a single uncompressed block */
+	memcpy(img + SQFS_DATA_START, data, data_len);
+
+	/* Inode table: the root directory, then the file at offset 32 */
+	put_unaligned_le16(0x8000 | 68, img + inodes);
+	p = img + inodes + 2;
+	put_unaligned_le16(1, p);
+	put_unaligned_le16(0755, p + 2);
+	put_unaligned_le32(1, p + 12);
+	put_unaligned_le32(2, p + 20);
+	put_unaligned_le16(20 + name_len + 3, p + 24);
+	put_unaligned_le32(3, p + 28);
+	p += 32;
+	put_unaligned_le16(2, p);
+	put_unaligned_le16(0644, p + 2);
+	put_unaligned_le32(2, p + 12);
+	put_unaligned_le32(SQFS_DATA_START, p + 16);
+	put_unaligned_le32(0xffffffff, p + 20);
+	put_unaligned_le32(data_len, p + 28);
+	put_unaligned_le32(data_len | 1 << 24, p + 32);
+
+	/* Directory table: one header and the file's entry */
+	put_unaligned_le16(0x8000 | (20 + name_len), img + dirs);
+	p = img + dirs + 2;
+	put_unaligned_le32(2, p + 8);
+	put_unaligned_le16(32, p + 12);
+	put_unaligned_le16(2, p + 16);
+	put_unaligned_le16(name_len - 1, p + 18);
+	memcpy(p + 20, name, name_len);
+}
+
+/* Read a file from host device 0 into buf, returning its length */
+static loff_t read_sqfs_file(const char *name, char *buf)
+{
+	loff_t actread;
+
+	if (fs_set_blk_dev("host", "0", FS_TYPE_SQUASHFS) ||
+	    fs_read(name, map_to_sysmem(buf), 0, 0, &actread))
+		return -1;
+	buf[actread] = '\0';
+
+	return actread;
+}
+
+/* Test that SquashFS forgets what it cached from a device written to */
+static int dm_test_blk_squashfs_write(struct unit_test_state *uts)
+{
+	struct host_block_dev *host_dev;
+	struct blk_desc *desc;
+	int reads;
+	char *buf;
+	u8 *img;
+
+	img = malloc(SQFS_IMG_SIZE);
+	buf = malloc(SQFS_IMG_SIZE);
+	ut_assertnonnull(img);
+	ut_assertnonnull(buf);
+	make_sqfs_image(img, "old", "the old contents");
+	ut_assertok(host_bind_image(uts, img, SQFS_IMG_SIZE, 0, &desc));
+	ut_assertok(host_get_host_dev(0, &host_dev));
+	memset(&host_dev->stats, '\0', sizeof(host_dev->stats));
+	ut_asserteq(16, read_sqfs_file("/old", buf));
+	ut_asserteq_str("the old contents", buf);
+	reads = host_dev->stats.reads;
+
+	/* The metadata is still cached, as the superblock has not changed */
+	memset(&host_dev->stats, '\0', sizeof(host_dev->stats));
+	ut_asserteq(16, read_sqfs_file("/old", buf));
+	ut_assert(host_dev->stats.reads < reads);
+
+	/* A new image with the same superblock, written over the old one */
+	make_sqfs_image(img, "new", "the new contents");
+	ut_asserteq(SQFS_IMG_SIZE / 512,
+		    blk_dwrite(desc, 0, SQFS_IMG_SIZE / 512, img));
+	memset(&host_dev->stats, '\0', sizeof(host_dev->stats));
+	ut_asserteq(16, read_sqfs_file("/new", buf));
+	ut_asserteq_str("the new contents", buf);
+	ut_asserteq(reads, host_dev->stats.reads);
+	ut_asserteq(-1, read_sqfs_file("/old", buf));
+
+	ut_assertok(host_dev_bind(0, NULL, 0));
+	os_unlink(HOST_IMG_FILE);
+	free(buf);
+	free(img);
+
+	return 0;
+}
+DM_TEST(dm_test_blk_squashfs_write, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+#endif
+
+#define HOST_IMG_BLOCKS		64
+
+/* Read and write a host device bound with flags, checking its stats */
+static int host_check_io(struct unit_test_state *uts, int flags)
+{
+	struct host_block_dev *host_dev;
+	struct blk_desc *desc;
+	u8 *img, *buf;
+	int i, fd;
+
+	img = malloc(HOST_IMG_BLOCKS * 512);
+	buf = malloc(HOST_IMG_BLOCKS * 512);
+	ut_assertnonnull(img);
+	ut_assertnonnull(buf);
+	for (i = 0; i < HOST_IMG_BLOCKS * 512; i++)
+		img[i] = i / 512 + i % 251;
+	ut_assertok(host_bind_image(uts, img, HOST_IMG_BLOCKS * 512, flags,
+				    &desc));
+	ut_assertok(host_get_host_dev(0, &host_dev));
+	ut_asserteq(!(flags & HOST_BIND_MMAP), !host_dev->map);
+	ut_asserteq(HOST_IMG_BLOCKS, desc->lba);
+
+	/* Each request is counted, with the blocks it moved */
+	memset(&host_dev->stats, '\0', sizeof(host_dev->stats));
+	ut_asserteq(8, blk_dread(desc, 4, 8, buf));
+	ut_assertok(memcmp(img + 4 * 512, buf, 8 * 512));
+	ut_asserteq(1, blk_dread(desc, HOST_IMG_BLOCKS - 1, 1, buf));
+	ut_assertok(memcmp(img + (HOST_IMG_BLOCKS - 1) * 512, buf, 512));
+	ut_asserteq(2, host_dev->stats.reads);
+	ut_asserteq(9, host_dev->stats.read_blocks);
+
+	memset(buf, 0x5a, 2 * 512);
+	ut_asserteq(2, blk_dwrite(desc, 10, 2, buf));
+	ut_asserteq(1, host_dev->stats.writes);
+	ut_asserteq(2, host_dev->stats.write_blocks);
+
+	/* The write reaches the file, whichever way it is accessed */
+	fd = os_open(HOST_IMG_FILE, OS_O_RDONLY);
+	ut_assert(fd >= 0);
+	ut_asserteq(12 * 512, os_read(fd, img, 12 * 512));
+	os_close(fd);
+	ut_assertok(memcmp(buf, img + 10 * 512, 2 * 512));
+
+	ut_assertok(host_dev_bind(0, NULL, 0));
+	os_unlink(HOST_IMG_FILE);
+	free(buf);
+	free(img);
+
+	return 0;
+}
+
+/* Test host devices reading their file with pread() and through a mapping */
+static int dm_test_blk_host(struct unit_test_state *uts)
+{
+	struct udevice *blk;
+	int fd;
+
+	ut_assertok(host_check_io(uts, 0));
+	ut_assertok(host_check_io(uts, HOST_BIND_MMAP));
+
+	/* Removing a device with no file must not close stdin */
+	ut_assertok(blk_create_device(gd->dm_root, "sandbox_host_blk", "test",
+				      IF_TYPE_HOST, 1, 512, 2, &blk));
+	ut_assertok(device_probe(blk));
+	ut_assertok(device_remove(blk, DM_REMOVE_NORMAL));
+	fd = os_open("/dev/null", OS_O_RDONLY);
+	ut_assert(fd > 0);
+	os_close(fd);
+
+	return 0;
+}
+DM_TEST(dm_test_blk_host, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
@@ -0,0 +1,41 @@
+/*
+ * Tests for the serial console
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <console.h>
+#include <dm.h>
+#include <stdio_dev.h>
+#include <dm/test.h>
+#include <test/ut.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Test that the console can be flushed before stdio is set up */
+static int dm_test_serial_flush_early(struct unit_test_state *uts)
+{
+	struct list_head *head = stdio_get_list();
+	struct list_head save = *head;
+	ulong flags = gd->flags;
+
+	/* Before stdio_init() the device list is still zeroed BSS */
+	head->next = NULL;
+	head->prev = NULL;
+	gd->flags &= ~GD_FLG_DEVINIT;
+	console_flush();
+
+	/* Nothing is buffered before relocation either */
+	gd->flags = flags & ~GD_FLG_RELOC;
+	console_flush();
+
+	*head = save;
+	gd->flags = flags;
+
+	/* Now there is a list to walk */
+	console_flush();
+
+	return 0;
+}
+DM_TEST(dm_test_serial_flush_early, 0);
@@ -419,3 +419,134 @@ static int dm_test_first_next_ok_device(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_first_next_ok_device, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/* Lookups per second, given a count and a time in microseconds */
+static ulong lookup_rate(ulong count, ulong us)
+{
+	return us ? (u64)count * 1000000 / us : count;
+}
+
+/* Test the phandle and path lookup caches */
+static int dm_test_fdt_lookup_cache(struct unit_test_state *uts)
+{
+	static const char * const paths[] = {
+		"/aliases", "/chosen", "/some-bus/c-test@1", "/b-test",
+		"testfdt1", "testbus3/c-test@5", "/some-bus/c-test",
+	};
+	struct fdtdec_cache_stats before, after;
+	const void *blob = gd->fdt_blob;
+	ulong start, scan_us, cache_us;
+	u32 phandles[64], phandle;
+	int offset, depth, count;
+	int i, j, loops = 200;
+	void *copy;
+
+	/* Collect the phandles in the tree */
+	count = 0;
+	for (offset = 0, depth = 0; offset >= 0 && count < ARRAY_SIZE(phandles);
+	     offset = fdt_next_node(blob, offset, &depth)) {
+		phandle = fdt_get_phandle(blob, offset);
+		if (phandle)
+			phandles[count++] = phandle;
+	}
+	ut_assert(count > 0);
+
+	/* Cached lookups must give the same answers */
+	for (i = 0; i < count; i++)
+		ut_asserteq(fdt_node_offset_by_phandle(blob, phandles[i]),
+			    fdtdec_node_offset_by_phandle(blob, phandles[i]));
+	for (i = 0; i < ARRAY_SIZE(paths); i++) {
+		ut_asserteq(fdt_path_offset(blob, paths[i]),
+			    fdtdec_path_offset(blob, paths[i]));
+		ut_asserteq(fdt_path_offset(blob, paths[i]),
+			    fdtdec_path_offset(blob, paths[i]));
+	}
+	ut_asserteq(-FDT_ERR_NOTFOUND, fdtdec_path_offset(blob, "/no-such"));
+	ut_asserteq(-FDT_ERR_BADPHANDLE, fdtdec_node_offset_by_phandle(blob, 0));
+
+	/* Compare the speed of scanning and cached lookups */
+	start = timer_get_us();
+	for (j = 0; j < loops; j++)
+		for (i = 0; i < count; i++)
+			fdt_node_offset_by_phandle(blob, phandles[i]);
+	scan_us = timer_get_us() - start;
+
+	fdtdec_cache_get_stats(&before);
+	start = timer_get_us();
+	for (j = 0; j < loops; j++)
+		for (i = 0; i < count; i++)
+			fdtdec_node_offset_by_phandle(blob, phandles[i]);
+	cache_us = timer_get_us() - start;
+	fdtdec_cache_get_stats(&after);
+	if (IS_ENABLED(CONFIG_OF_CACHE)) {
+		ut_asserteq(loops * count, after.hits - before.hits);
+		ut_asserteq(0, after.builds - before.builds);
+	}
+	printf("phandle lookups/s: scan %lu, cached %lu\n",
+	       lookup_rate(loops * count, scan_us),
+	       lookup_rate(loops * count, cache_us));
+
+	start = timer_get_us();
+	for (j = 0; j < loops; j++)
+		for (i = 0; i < ARRAY_SIZE(paths); i++)
+			fdt_path_offset(blob, paths[i]);
+	scan_us = timer_get_us() - start;
+	start = timer_get_us();
+	for (j = 0; j < loops; j++)
+		for (i = 0; i < ARRAY_SIZE(paths); i++)
+			fdtdec_path_offset(blob, paths[i]);
+	cache_us = timer_get_us() - start;
+	printf("path lookups/s: scan %lu, cached %lu\n",
+	       lookup_rate(loops * ARRAY_SIZE(paths), scan_us),
+	       lookup_rate(loops * ARRAY_SIZE(paths), cache_us));
+
+	/* Adding a node moves the others, so the caches must be dropped */
+	copy = malloc(fdt_totalsize(blob) + 1024);
+	ut_assertnonnull(copy);
+	ut_assertok(fdt_open_into(blob, copy, fdt_totalsize(blob) + 1024));
+	ut_asserteq(fdt_path_offset(copy, "/b-test"),
+		    fdtdec_path_offset(copy, "/b-test"));
+	ut_asserteq(fdt_node_offset_by_phandle(copy, phandles[count - 1]),
+		    fdtdec_node_offset_by_phandle(copy, phandles[count - 1]));
+	ut_assert(fdt_add_subnode(copy, 0, "aaa-test") >= 0);
+	ut_asserteq(fdt_path_offset(copy, "/b-test"),
+		    fdtdec_path_offset(copy, "/b-test"));
+	ut_asserteq(fdt_node_offset_by_phandle(copy, phandles[count - 1]),
+		    fdtdec_node_offset_by_phandle(copy, phandles[count - 1]));
+
+	/* In-place edits leave the sizes alone but must still be seen */
+	offset = fdt_path_offset(copy, "/b-test");
+	ut_assertok(fdt_nop_node(copy, offset));
+	ut_asserteq(-FDT_ERR_NOTFOUND, fdtdec_path_offset(copy, "/b-test"));
+	ut_asserteq(fdt_path_offset(copy, "/some-bus/c-test@5"),
+		    fdtdec_path_offset(copy, "/some-bus/c-test@5"));
+	offset = fdt_path_offset(copy, "/some-bus");
+	ut_assertok(fdt_set_name(copy, offset, "some-bux"));
+	ut_asserteq(-FDT_ERR_NOTFOUND,
+		    fdtdec_path_offset(copy, "/some-bus/c-test@5"));
+	if (count > 1) {
+		ut_assertok(fdt_setprop_inplace_u32(copy,
+			fdt_node_offset_by_phandle(copy, phandles[0]),
+			"phandle", 0xdead));
+		ut_asserteq(-FDT_ERR_NOTFOUND,
+			    fdtdec_node_offset_by_phandle(copy, phandles[0]));
+		ut_asserteq(fdt_node_offset_by_phandle(copy, 0xdead),
+			    fdtdec_node_offset_by_phandle(copy, 0xdead));
+	}
+	ut_asserteq(fdt_path_offset(copy, "/a-test"),
+		    fdtdec_path_offset(copy, "testfdt8"));
+	offset = fdt_path_offset(copy, "/aliases");
+	ut_assertok(fdt_setprop_inplace(copy, offset, "testfdt8", "/e-test",
+					sizeof("/e-test")));
+	ut_asserteq(fdt_path_offset(copy, "/e-test"),
+		    fdtdec_path_offset(copy, "testfdt8"));
+	fdtdec_cache_invalidate(copy);
+	free(copy);
+
+	/* Going back to the control FDT rebuilds the caches */
+	ut_asserteq(fdt_path_offset(blob, "/b-test"),
+		    fdtdec_path_offset(blob, "/b-test"));
+
+	return 0;
+}
+DM_TEST(dm_test_fdt_lookup_cache, 0);
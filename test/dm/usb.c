@@ -7,10 +7,14 @@
 #include <common.h>
 #include <console.h>
 #include <dm.h>
+#include <g_dnl.h>
+#include <scsi.h>
 #include <usb.h>
+#include <usb_mass_storage.h>
 #include <asm/io.h>
 #include <asm/state.h>
 #include <asm/test.h>
+#include <asm/unaligned.h>
 #include <dm/device-internal.h>
 #include <dm/test.h>
 #include <dm/uclass-internal.h>
@@ -58,6 +62,46 @@ static int dm_test_usb_flash(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_usb_flash, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
 
+/*
+ * Test a read which takes many commands. Each command waits 5 ms after
+ * its CBW, unless CONFIG_USB_STORAGE_NO_CBW_DELAY stops that once the
+ * device has responded. The sandbox host controller does not give a
+ * transfer limit, so the storage driver sends 20 blocks per command.
+ */
+static int dm_test_usb_flash_cmds(struct unit_test_state *uts)
+{
+	const int cmds = 20;
+	struct blk_desc *dev_desc;
+	struct udevice *dev;
+	ulong start, us;
+	char *buf;
+
+	state_set_skip_delays(true);
+	ut_assertok(usb_init());
+	ut_assertok(uclass_get_device(UCLASS_MASS_STORAGE, 0, &dev));
+	ut_assertok(blk_get_device_by_str("usb", "0", &dev_desc));
+	buf = calloc(cmds * 20, dev_desc->blksz);
+	ut_assertnonnull(buf);
+
+	/* Only the read takes the delays, not the bus scan */
+	state_set_skip_delays(false);
+	start = timer_get_us();
+	ut_asserteq(cmds * 20, blk_dread(dev_desc, 0, cmds * 20, buf));
+	us = timer_get_us() - start;
+	state_set_skip_delays(true);
+	ut_assertok(strcmp(buf, "this is a test"));
+	if (IS_ENABLED(CONFIG_USB_STORAGE_NO_CBW_DELAY)) {
+		ut_assert(us < cmds / 2 * 5000);
+	} else {
+		ut_assert(us >= cmds * 5000);
+	}
+	free(buf);
+	ut_assertok(usb_stop());
+
+	return 0;
+}
+DM_TEST(dm_test_usb_flash_cmds, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
 /* test that we can handle multiple storage devices */
 static int dm_test_usb_multi(struct unit_test_state *uts)
 {
@@ -147,3 +191,189 @@ static int dm_test_usb_keyb(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_usb_keyb, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+#ifdef CONFIG_USB_GADGET_SANDBOX
+/* A RAM disk for the mass storage gadget, and a sector it cannot write */
+#define UMS_TEST_BUFLEN		CONFIG_USB_FUNCTION_MASS_STORAGE_BUFLEN
+#define UMS_TEST_SECTORS	(4 * UMS_TEST_BUFLEN / SECTOR_SIZE)
+
+static u8 *ums_test_disk;
+static ulong ums_test_bad_sector;
+static u32 ums_test_tag;
+
+static int ums_test_read(struct ums *ums_dev, ulong start, lbaint_t blkcnt,
+			 void *buf)
+{
+	memcpy(buf, ums_test_disk + start * SECTOR_SIZE, blkcnt * SECTOR_SIZE);
+
+	return blkcnt;
+}
+
+static int ums_test_write(struct ums *ums_dev, ulong start, lbaint_t blkcnt,
+			  const void *buf)
+{
+	if (ums_test_bad_sector >= start &&
+	    ums_test_bad_sector < start + blkcnt)
+		return 0;
+	memcpy(ums_test_disk + start * SECTOR_SIZE, buf, blkcnt * SECTOR_SIZE);
+
+	return blkcnt;
+}
+
+/*
+ * Run one SCSI command through the gadget, as a host would with the
+ * Bulk-Only transport: send the CBW and any data, then collect any data
+ * and the CSW. @len is the host's transfer length, which may be more than
+ * the command asks for.
+ */
+static int ums_test_cmd(struct unit_test_state *uts, const u8 *cdb,
+			int cdb_len, bool in, uint len, const void *data,
+			void *buf, struct umass_bbb_csw *csw)
+{
+	struct umass_bbb_cbw cbw;
+	int want, i;
+	u8 *host;
+
+	memset(&cbw, '\0', sizeof(cbw));
+	cbw.dCBWSignature = cpu_to_le32(CBWSIGNATURE);
+	cbw.dCBWTag = cpu_to_le32(++ums_test_tag);
+	cbw.dCBWDataTransferLength = cpu_to_le32(len);
+	cbw.bCBWFlags = in ? CBWFLAGS_IN : CBWFLAGS_OUT;
+	cbw.bCDBLength = cdb_len;
+	memcpy(cbw.CBWCDB, cdb, cdb_len);
+	ut_assertok(sandbox_udc_host_out(&cbw, UMASS_BBB_CBW_SIZE));
+	if (!in && len)
+		ut_assertok(sandbox_udc_host_out(data, len));
+
+	want = (in ? len : 0) + UMASS_BBB_CSW_SIZE;
+	host = malloc(want);
+	ut_assertnonnull(host);
+	sandbox_udc_host_in(host, want);
+	for (i = 0; i < 10; i++) {
+		usb_gadget_handle_interrupts(0);
+		if (sandbox_udc_host_in_len() == want)
+			break;
+		ut_assertok(fsg_main_thread(NULL));
+	}
+	ut_asserteq(want, sandbox_udc_host_in_len());
+
+	if (in)
+		memcpy(buf, host, len);
+	memcpy(csw, host + want - UMASS_BBB_CSW_SIZE, UMASS_BBB_CSW_SIZE);
+	free(host);
+	sandbox_udc_host_in(NULL, 0);
+	ut_asserteq(CSWSIGNATURE, le32_to_cpu(csw->dCSWSignature));
+	ut_asserteq(ums_test_tag, le32_to_cpu(csw->dCSWTag));
+
+	return 0;
+}
+
+static void ums_test_rw10(u8 *cdb, u8 op, ulong sector, uint count)
+{
+	memset(cdb, '\0', 10);
+	cdb[0] = op;
+	put_unaligned_be32(sector, &cdb[2]);
+	put_unaligned_be16(count, &cdb[7]);
+}
+
+/*
+ * Test the USB mass storage gadget on the sandbox device controller. The
+ * last chunk of a write is left until after its status is sent, so check
+ * that it reaches the disk before the next command, that it is not lost
+ * when the host sends more data than the command writes, that a failure
+ * to write it fails the next command, and that it is written when the
+ * session ends.
+ */
+static int dm_test_usb_gadget_ums(struct unit_test_state *uts)
+{
+	const uint len = 2 * UMS_TEST_BUFLEN + 4096;
+	const uint excess = 4 * UMS_TEST_BUFLEN;
+	const ulong sector = 8;
+	const uint count = len / SECTOR_SIZE;
+	struct umass_bbb_csw csw;
+	struct ums ums = {
+		.read_sector = ums_test_read,
+		.write_sector = ums_test_write,
+		.num_sectors = UMS_TEST_SECTORS,
+		.name = "UMS test",
+	};
+	u8 *disk, *data, *buf, cdb[10];
+	int i;
+
+	disk = calloc(UMS_TEST_SECTORS, SECTOR_SIZE);
+	data = malloc(len + excess);
+	buf = malloc(len);
+	ut_assertnonnull(disk);
+	ut_assertnonnull(data);
+	ut_assertnonnull(buf);
+	ums_test_disk = disk;
+	ums_test_bad_sector = ~0UL;
+	for (i = 0; i < len; i++)
+		data[i] = i * 7 + i / 4096;
+	memset(data + len, 0xee, excess);
+
+	ut_assertok(fsg_init(&ums, 1));
+	ut_assertok(g_dnl_register("usb_dnl_ums"));
+	ut_assertok(sandbox_udc_connect());
+	ut_assertok(fsg_main_thread(NULL));
+
+	/* The last 4 KiB are written after the status stage */
+	ums_test_rw10(cdb, SCSI_WRITE10, sector, count);
+	ut_assertok(ums_test_cmd(uts, cdb, 10, false, len, data, NULL, &csw));
+	ut_asserteq(CSWSTATUS_GOOD, csw.bCSWStatus);
+	ut_asserteq(0, le32_to_cpu(csw.dCSWDataResidue));
+	ut_assertok(memcmp(disk + sector * SECTOR_SIZE, data, len - 4096));
+	ut_assert(!disk[sector * SECTOR_SIZE + len - 1]);
+
+	/* ...and before the next command is handled */
+	ums_test_rw10(cdb, SCSI_READ10, sector, count);
+	ut_assertok(ums_test_cmd(uts, cdb, 10, true, len, NULL, buf, &csw));
+	ut_asserteq(CSWSTATUS_GOOD, csw.bCSWStatus);
+	ut_assertok(memcmp(buf, data, len));
+	ut_assertok(memcmp(disk + sector * SECTOR_SIZE, data, len));
+
+	/* Excess data from the host is thrown away, not written */
+	memset(disk, '\0', UMS_TEST_SECTORS * SECTOR_SIZE);
+	ums_test_rw10(cdb, SCSI_WRITE10, sector, count);
+	ut_assertok(ums_test_cmd(uts, cdb, 10, false, len + excess, data,
+				 NULL, &csw));
+	ut_asserteq(CSWSTATUS_GOOD, csw.bCSWStatus);
+	ut_asserteq(excess, le32_to_cpu(csw.dCSWDataResidue));
+	ut_assertok(memcmp(disk + sector * SECTOR_SIZE, data, len));
+
+	/* A failed deferred write fails the next command */
+	ums_test_bad_sector = sector + count - 1;
+	ut_assertok(ums_test_cmd(uts, cdb, 10, false, len, data, NULL, &csw));
+	ut_asserteq(CSWSTATUS_GOOD, csw.bCSWStatus);
+	memset(cdb, '\0', sizeof(cdb));
+	cdb[0] = SCSI_TST_U_RDY;
+	ut_assertok(ums_test_cmd(uts, cdb, 6, false, 0, NULL, NULL, &csw));
+	ut_asserteq(CSWSTATUS_FAILED, csw.bCSWStatus);
+	cdb[0] = SCSI_REQ_SENSE;
+	cdb[4] = 18;
+	ut_assertok(ums_test_cmd(uts, cdb, 6, true, 18, NULL, buf, &csw));
+	ut_asserteq(CSWSTATUS_GOOD, csw.bCSWStatus);
+	ut_asserteq(0xf1, buf[0]);	/* valid, deferred error */
+	ut_asserteq(3, buf[2]);		/* medium error */
+	ut_asserteq(ums_test_bad_sector - 7, get_unaligned_be32(&buf[3]));
+	ums_test_bad_sector = ~0UL;
+
+	/* The last chunk is written when the host goes away */
+	memset(disk, '\0', UMS_TEST_SECTORS * SECTOR_SIZE);
+	ums_test_rw10(cdb, SCSI_WRITE10, sector, count);
+	ut_assertok(ums_test_cmd(uts, cdb, 10, false, len, data, NULL, &csw));
+	ut_asserteq(CSWSTATUS_GOOD, csw.bCSWStatus);
+	ut_asserteq(-EIO, fsg_main_thread(NULL));
+	ut_assertok(memcmp(disk + sector * SECTOR_SIZE, data, len));
+
+	sandbox_udc_disconnect();
+	ut_assertok(fsg_main_thread(NULL));
+	g_dnl_unregister();
+	free(buf);
+	free(data);
+	free(disk);
+
+	return 0;
+}
+DM_TEST(dm_test_usb_gadget_ums, 0);
+#endif
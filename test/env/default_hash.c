@@ -0,0 +1,117 @@
+/*
+ * Tests for the prebuilt default environment
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <environment.h>
+#include <search.h>
+#include <test/env.h>
+#include <test/ut.h>
+
+static size_t default_env_size(void)
+{
+	const unsigned char *p = default_environment;
+
+	while (*p)
+		p += strlen((const char *)p) + 1;
+
+	return p - default_environment + 1;
+}
+
+static int find(struct hsearch_data *htab, const char *name, ENTRY **ep)
+{
+	ENTRY e;
+
+	e.key = name;
+	e.data = NULL;
+	e.callback = NULL;
+
+	return hsearch_r(e, FIND, ep, htab, 0);
+}
+
+/* The prebuilt table must match what himport_r() builds, slot for slot */
+static int env_test_default_hashed_layout(struct unit_test_state *uts)
+{
+	struct hsearch_data text = { .change_ok = env_flags_validate };
+	struct hsearch_data hashed = { .change_ok = env_flags_validate };
+	const char *p = (const char *)default_environment;
+	char name[64];
+
+	ut_assert(himport_r(&text, (char *)default_environment,
+			    default_env_size(), '\0', 0, 0, 0, NULL));
+	ut_assert(himport_prebuilt_r(&hashed, &env_default_hashed, 0));
+	ut_asserteq(text.size, hashed.size);
+	ut_asserteq(text.filled, hashed.filled);
+
+	for (; *p; p += strlen(p) + 1) {
+		ENTRY *tep, *hep;
+		int len = strcspn(p, "=");
+
+		ut_assert(len < sizeof(name));
+		strlcpy(name, p, len + 1);
+		ut_asserteq(find(&text, name, &tep), find(&hashed, name, &hep));
+		if (!tep) {
+			ut_asserteq_ptr(NULL, hep);
+			continue;
+		}
+		ut_assert(hep != NULL);
+		ut_asserteq_str(tep->data, hep->data);
+		ut_asserteq(tep->flags, hep->flags);
+		ut_asserteq_ptr(tep->callback, hep->callback);
+	}
+
+	hdestroy_r(&text);
+	hdestroy_r(&hashed);
+
+	return 0;
+}
+ENV_TEST(env_test_default_hashed_layout, 0);
+
+/* Strings in the prebuilt pool are replaced and deleted, never freed */
+static int env_test_default_hashed_update(struct unit_test_state *uts)
+{
+	struct hsearch_data htab = { .change_ok = env_flags_validate };
+	const char *p = (const char *)default_environment;
+	char name[64];
+	ENTRY e, *ep = NULL;
+
+	ut_assert(himport_prebuilt_r(&htab, &env_default_hashed, 0));
+
+	/* Use a plain variable, one without flags or a callback */
+	for (; *p; p += strlen(p) + 1) {
+		int len = strcspn(p, "=");
+
+		ut_assert(len < sizeof(name));
+		strlcpy(name, p, len + 1);
+		if (find(&htab, name, &ep) > 0 && !ep->flags && !ep->callback)
+			break;
+	}
+	ut_assert(*p);
+
+	e.key = name;
+	e.data = "updated";
+	e.callback = NULL;
+	ut_assert(hsearch_r(e, ENTER, &ep, &htab, 0) > 0);
+	ut_asserteq_str("updated", ep->data);
+	ut_assert(find(&htab, name, &ep) > 0);
+	ut_asserteq_str("updated", ep->data);
+
+	ut_assert(hdelete_r(name, &htab, 0));
+	ut_assert(find(&htab, name, &ep) <= 0);
+
+	e.data = "recreated";
+	ut_assert(hsearch_r(e, ENTER, &ep, &htab, 0) > 0);
+	ut_asserteq_str("recreated", ep->data);
+
+	/* Importing over a table which uses a prebuilt pool must also work */
+	ut_assert(himport_prebuilt_r(&htab, &env_default_hashed, 0));
+	ut_assert(find(&htab, name, &ep) > 0);
+	ut_assert(ep->data != NULL && strcmp(ep->data, "recreated"));
+	hdestroy_r(&htab);
+
+	return 0;
+}
+ENV_TEST(env_test_default_hashed_update, 0);
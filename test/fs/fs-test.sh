@@ -7,6 +7,7 @@
 
 # Invoke this test script from U-Boot base directory as ./test/fs/fs-test.sh
 # It currently tests the fs/sb and native commands for ext4 and fat partitions
+# and the fs commands for squashfs images, when mksquashfs is available
 # Expected results are as follows:
 # EXT4 tests:
 # fs-test.sb.ext4.out: Summary: PASS: 24 FAIL: 0
@@ -20,7 +21,12 @@
 # fs-test.sb.fat32.out: Summary: PASS: 24 FAIL: 0
 # fs-test.fat32.out: Summary: PASS: 21 FAIL: 3
 # fs-test.fs.fat32.out: Summary: PASS: 21 FAIL: 3
-# Total Summary: TOTAL PASS: 204 TOTAL FAIL: 12
+# SQUASHFS tests (read-only, so the write test cases are not checked):
+# fs-test.fs.squashfs.gzip.out: Summary: PASS: 18 FAIL: 0
+# fs-test.fs.squashfs.lzo.out: Summary: PASS: 18 FAIL: 0
+# fs-test.fs.squashfs.lz4.out: Summary: PASS: 18 FAIL: 0
+# fs-test.fs.squashfs.zstd.out: Summary: PASS: 18 FAIL: 0
+# Total Summary: TOTAL PASS: 276 TOTAL FAIL: 12
 
 # pre-requisite binaries list.
 PREREQ_BINS="md5sum mkfs mount umount dd fallocate mkdir"
@@ -55,6 +61,9 @@ OUT="${OUT_DIR}/fs-test"
 MB1="${MOUNT_DIR}/${SMALL_FILE}"
 GB2p5="${MOUNT_DIR}/${BIG_FILE}"
 
+# Squashfs images are made from the files in this directory
+SQUASHFS_DIR="${OUT_DIR}/squashfs"
+
 # ************************
 # * Functions start here *
 # ************************
@@ -176,6 +185,13 @@ function test_image() {
 		WRITE="write"
 		;;
 
+		squashfs*)
+		# squashfs has no commands of its own and cannot be written
+		FPATH="/"
+		PREFIX=""
+		WRITE="save"
+		;;
+
 		*)
 		echo "Unhandled filesystem $2. Exiting!"
 		exit
@@ -339,20 +355,15 @@ reset
 EOF
 }
 
-# 1st argument is the name of the image file.
+# 1st argument is the directory to create the files in.
 # 2nd argument is the file where we generate the md5s of the files
 # generated with the appropriate start and length that we use to test.
-# It creates the necessary files in the image to test.
-# $GB2p5 is the path of the big file (2.5 GB)
-# $MB1 is the path of the small file (1 MB)
-# $MOUNT_DIR is the path we can use to mount the image file.
-function create_files() {
-	# Mount the image so we can populate it.
-	mkdir -p "$MOUNT_DIR"
-	sudo mount -o loop,rw "$1" "$MOUNT_DIR"
+function populate_dir() {
+	GB2p5="$1/${BIG_FILE}"
+	MB1="$1/${SMALL_FILE}"
 
 	# Create a subdirectory.
-	sudo mkdir -p "$MOUNT_DIR/SUBDIR"
+	sudo mkdir -p "$1/SUBDIR"
 
 	# Create big file in this image.
 	# Note that we work only on the start 1MB, couple MBs in the 2GB range
@@ -401,12 +412,44 @@ function create_files() {
 	# One 1MB chunk crossing the 2GB boundary
 	dd if="${GB2p5}" bs=512K skip=4095 count=2 \
 		2> /dev/null | md5sum >> "$2"
+}
+
+# 1st argument is the name of the image file.
+# 2nd argument is the file where we generate the md5s of the files
+# generated with the appropriate start and length that we use to test.
+# It creates the necessary files in the image to test.
+# $MOUNT_DIR is the path we can use to mount the image file.
+function create_files() {
+	# Mount the image so we can populate it.
+	mkdir -p "$MOUNT_DIR"
+	sudo mount -o loop,rw "$1" "$MOUNT_DIR"
+
+	populate_dir "$MOUNT_DIR" "$2"
 
 	sync
 	sudo umount "$MOUNT_DIR"
 	rmdir "$MOUNT_DIR"
 }
 
+# 1st argument is the name of the image file.
+# 2nd argument is the compressor - gzip/lzo/lz4/zstd
+# 3rd argument is the file where we generate the md5s of the files
+# The files are created in $SQUASHFS_DIR, the same for every compressor,
+# and the image is made from them if not already present.
+function create_squashfs_image() {
+	mkdir -p "$SQUASHFS_DIR"
+	populate_dir "$SQUASHFS_DIR" "$3"
+
+	if [ ! -f "$1" ]; then
+		mksquashfs "$SQUASHFS_DIR" "$1" -comp $2 -noappend \
+			&> /dev/null
+		if [ $? -ne 0 ]; then
+			echo Could not create $2 squashfs image
+			exit $?
+		fi
+	fi
+}
+
 # 1st parameter is the text to print
 # if $? is 0 its a pass, else a fail
 # As a side effect it shall update env variable PASS and FAIL
@@ -451,7 +494,7 @@ check_md5() {
 # 2nd parameter is the name of the file containing the md5 expected
 # 3rd parameter is the name of the small file
 # 4th parameter is the name of the big file
-# 5th paramter is the name of the written file
+# 5th parameter is "ro" for read-only filesystems, to skip the write checks
 # This function checks the output file for correct results.
 function check_results() {
 	echo "** Start $1"
@@ -515,6 +558,11 @@ function check_results() {
 	grep -A5 "Test Case 10 " "$1" | grep -q "filesize=100000"
 	pass_fail "TC10: load 2MB from the last 1MB of $4 loads 1MB"
 
+	if [ "$5" = "ro" ]; then
+		echo "** End $1"
+		return
+	fi
+
 	# Check 1mb chunk write
 	grep -A2 "Test Case 11a " "$1" | grep -q '1048576 bytes written'
 	pass_fail "TC11: 1MB write to $3.w - write succeeded"
@@ -614,6 +662,29 @@ for fs in ext4 fat16 fat32; do
 	test_fs_nonfs fs
 done
 
+# Squashfs images are made rather than written to, and can only be read
+# with the fs commands.
+if [ -x "`which mksquashfs`" ]; then
+	for comp in gzip lzo lz4 zstd; do
+		fs=squashfs.${comp}
+		echo "Creating $fs image if not already present."
+		IMAGE=${IMG}.${fs}.img
+		MD5_FILE_FS="${MD5_FILE}.${fs}"
+		create_squashfs_image $IMAGE $comp $MD5_FILE_FS
+
+		OUT_FILE="${OUT}.fs.${fs}.out"
+		test_image $IMAGE $fs $SMALL_FILE $BIG_FILE fs "" \
+			> ${OUT_FILE} 2>&1
+		check_results $OUT_FILE $MD5_FILE_FS $SMALL_FILE $BIG_FILE ro
+		TOTAL_FAIL=$((TOTAL_FAIL + FAIL))
+		TOTAL_PASS=$((TOTAL_PASS + PASS))
+		echo "Summary: PASS: $PASS FAIL: $FAIL"
+		echo "--------------------------------------------"
+	done
+else
+	echo "Missing mksquashfs binary. Skipping squashfs tests."
+fi
+
 echo "Total Summary: TOTAL PASS: $TOTAL_PASS TOTAL FAIL: $TOTAL_FAIL"
 echo "--------------------------------------------"
 if [ $TOTAL_FAIL -eq 0 ]; then
@@ -182,6 +182,29 @@ static int log_test(int testnum)
 			return ret;
 		break;
 	}
+#ifdef CONFIG_LOG_RING
+	case 10: {
+		/* Check formatting of records in the binary ring */
+		enum log_category_t cat_list[] = { LOGC_BOARD, LOGC_END };
+
+		/* Keep the records off the console */
+		ret = log_add_filter("console", cat_list, LOGL_MAX, NULL);
+		if (ret < 0)
+			return ret;
+		log(LOGC_NONE, LOGL_INFO,
+		    "ring %d %s %lx %c%5.2s|%-4u|%llx %% %s\n", -3, "str",
+		    0x1234UL, 'z', "abc", 7U, 0x123456789abcULL, NULL);
+		/* This one cannot be stored in binary form */
+		log(LOGC_NONE, LOGL_INFO, "ring %*d|\n", 4, 5);
+		ret = log_remove_filter("console", ret);
+		if (ret < 0)
+			return ret;
+		ret = log_ring_dump();
+		if (ret < 0)
+			return ret;
+		break;
+	}
+#endif
 	}
 
 	return 0;
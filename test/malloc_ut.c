@@ -0,0 +1,261 @@
+/*
+ * Tests for the slab front-end of malloc()
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <test/suites.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+#define MALLOC_TEST(_name, _flags)	UNIT_TEST(_name, _flags, malloc_test)
+
+/* Tag which nothing else allocates with while the tests run */
+#define MALLOC_TEST_TAG		MALLOC_TAG_FS
+
+/* Heap use as seen by leak checks, which must be the same after a test */
+static ulong malloc_test_used(void)
+{
+	return mallinfo().uordblks;
+}
+
+/* Fill a block with a pattern which depends on @seed */
+static void malloc_test_fill(u8 *buf, uint size, uint seed)
+{
+	uint i;
+
+	for (i = 0; i < size; i++)
+		buf[i] = i + seed;
+}
+
+static int malloc_test_check(struct unit_test_state *uts, const u8 *buf,
+			     uint size, uint seed)
+{
+	uint i;
+
+	for (i = 0; i < size; i++)
+		ut_asserteq((u8)(i + seed), buf[i]);
+
+	return 0;
+}
+
+/* Test that a freed object is reused by the next allocation of its class */
+static int malloc_test_reuse(struct unit_test_state *uts)
+{
+	ulong used = malloc_test_used();
+	void *ptr, *other, *again;
+
+	ptr = malloc(40);
+	ut_assertnonnull(ptr);
+	ut_asserteq(48, malloc_slab_size(ptr));
+	ut_asserteq(48, malloc_usable_size(ptr));
+
+	/* Another class comes from another page */
+	other = malloc(100);
+	ut_assertnonnull(other);
+	ut_asserteq(128, malloc_slab_size(other));
+	ut_assert((ulong)other / 4096 != (ulong)ptr / 4096);
+
+	free(ptr);
+	again = malloc(33);
+	ut_asserteq_ptr(ptr, again);
+	free(again);
+	free(other);
+	ut_asserteq(used, malloc_test_used());
+
+	return 0;
+}
+MALLOC_TEST(malloc_test_reuse, 0);
+
+/*
+ * Test that pages are given back once their objects are freed, in any
+ * order, leaving one empty page for the class
+ */
+static int malloc_test_pages(struct unit_test_state *uts)
+{
+	const int count = 1000;
+	ulong used = malloc_test_used();
+	void **objs;
+	int i;
+
+	objs = malloc(count * sizeof(*objs));
+	ut_assertnonnull(objs);
+	for (i = 0; i < count; i++) {
+		objs[i] = malloc(16);
+		ut_assertnonnull(objs[i]);
+		ut_asserteq(16, malloc_slab_size(objs[i]));
+	}
+	for (i = 0; i < count; i += 2)
+		free(objs[i]);
+	for (i = 1; i < count; i += 2)
+		free(objs[i]);
+	free(objs);
+	ut_asserteq(used, malloc_test_used());
+
+	return 0;
+}
+MALLOC_TEST(malloc_test_pages, 0);
+
+/*
+ * Test realloc() within a class, to a larger class and out to dlmalloc,
+ * keeping the data and the tag of the original allocation
+ */
+static int malloc_test_realloc(struct unit_test_state *uts)
+{
+	struct malloc_tag_stats start, stats;
+	ulong used = malloc_test_used();
+	enum malloc_tag old;
+	u8 *ptr, *grown;
+
+	malloc_get_tag_stats(MALLOC_TEST_TAG, &start);
+	old = malloc_set_tag(MALLOC_TEST_TAG);
+	ptr = malloc(20);
+	malloc_set_tag(old);
+	ut_assertnonnull(ptr);
+	malloc_test_fill(ptr, 20, 1);
+
+	/* Still fits in its class */
+	grown = realloc(ptr, 30);
+	ut_asserteq_ptr(ptr, grown);
+
+	/* Moves to a larger class */
+	malloc_test_fill(ptr, 32, 2);
+	grown = realloc(ptr, 200);
+	ut_assertnonnull(grown);
+	ut_assert(grown != ptr);
+	ut_asserteq(256, malloc_slab_size(grown));
+	ut_assertok(malloc_test_check(uts, grown, 32, 2));
+	malloc_get_tag_stats(MALLOC_TEST_TAG, &stats);
+	ut_asserteq(start.cur + 256, stats.cur);
+	ut_asserteq(start.live + 1, stats.live);
+	ptr = grown;
+
+	/* Moves out to dlmalloc */
+	malloc_test_fill(ptr, 256, 3);
+	grown = realloc(ptr, 4000);
+	ut_assertnonnull(grown);
+	ut_asserteq(0, malloc_slab_size(grown));
+	ut_assert(malloc_usable_size(grown) >= 4000);
+	ut_assertok(malloc_test_check(uts, grown, 256, 3));
+	malloc_get_tag_stats(MALLOC_TEST_TAG, &stats);
+	ut_asserteq(start.cur + malloc_usable_size(grown), stats.cur);
+	ut_asserteq(start.live + 1, stats.live);
+	ptr = grown;
+
+	/* A dlmalloc block stays there when it shrinks */
+	grown = realloc(ptr, 64);
+	ut_assertnonnull(grown);
+	ut_asserteq(0, malloc_slab_size(grown));
+	ut_assertok(malloc_test_check(uts, grown, 64, 3));
+
+	free(grown);
+	malloc_get_tag_stats(MALLOC_TEST_TAG, &stats);
+	ut_asserteq(start.cur, stats.cur);
+	ut_asserteq(start.live, stats.live);
+	ut_asserteq(used, malloc_test_used());
+
+	return 0;
+}
+MALLOC_TEST(malloc_test_realloc, 0);
+
+/* Test that memalign() picks a class whose size is a multiple of the align */
+static int malloc_test_memalign(struct unit_test_state *uts)
+{
+	static const struct {
+		uint align;
+		uint size;
+		uint slab_size;
+	} cases[] = {
+		{ 16, 16, 16 },
+		{ 64, 40, 64 },
+		{ 32, 48, 64 },
+		{ 128, 100, 128 },
+		{ 256, 300, 512 },
+		{ 512, 16, 512 },
+		{ 1024, 100, 0 },
+		{ 64, 600, 0 },
+	};
+	ulong used = malloc_test_used();
+	void *ptr;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(cases); i++) {
+		ptr = memalign(cases[i].align, cases[i].size);
+		ut_assertnonnull(ptr);
+		ut_asserteq(0, (ulong)ptr & (cases[i].align - 1));
+		ut_asserteq(cases[i].slab_size, malloc_slab_size(ptr));
+		ut_assert(malloc_usable_size(ptr) >= cases[i].size);
+		free(ptr);
+	}
+	ut_asserteq(used, malloc_test_used());
+
+	return 0;
+}
+MALLOC_TEST(malloc_test_memalign, 0);
+
+/*
+ * Test that large blocks are accounted to their tag until freed, with
+ * enough of them to grow the table which records them
+ */
+static int malloc_test_large(struct unit_test_state *uts)
+{
+	const int count = 100;
+	struct malloc_tag_stats start, stats;
+	ulong used = malloc_test_used();
+	ulong bytes = 0, total;
+	enum malloc_tag old;
+	void **blocks;
+	int i;
+
+	blocks = calloc(count, sizeof(*blocks));
+	ut_assertnonnull(blocks);
+	malloc_get_tag_stats(MALLOC_TEST_TAG, &start);
+	old = malloc_set_tag(MALLOC_TEST_TAG);
+	for (i = 0; i < count; i++) {
+		blocks[i] = malloc(1000 + i * 64);
+		if (!blocks[i])
+			break;
+		bytes += malloc_usable_size(blocks[i]);
+	}
+	malloc_set_tag(old);
+	ut_asserteq(count, i);
+
+	malloc_get_tag_stats(MALLOC_TEST_TAG, &stats);
+	ut_asserteq(start.cur + bytes, stats.cur);
+	ut_asserteq(start.live + count, stats.live);
+	ut_asserteq(start.allocs + count, stats.allocs);
+	total = bytes;
+
+	/* Free them out of order */
+	for (i = count - 1; i >= 0; i -= 3) {
+		bytes -= malloc_usable_size(blocks[i]);
+		free(blocks[i]);
+		blocks[i] = NULL;
+	}
+	malloc_get_tag_stats(MALLOC_TEST_TAG, &stats);
+	ut_asserteq(start.cur + bytes, stats.cur);
+	for (i = 0; i < count; i++)
+		free(blocks[i]);
+	free(blocks);
+
+	malloc_get_tag_stats(MALLOC_TEST_TAG, &stats);
+	ut_asserteq(start.cur, stats.cur);
+	ut_asserteq(start.live, stats.live);
+	ut_assert(stats.peak >= start.cur + total);
+	ut_asserteq(used, malloc_test_used());
+
+	return 0;
+}
+MALLOC_TEST(malloc_test_large, 0);
+
+int do_ut_malloc(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
+{
+	struct unit_test *tests = ll_entry_start(struct unit_test,
+						 malloc_test);
+	const int n_ents = ll_entry_count(struct unit_test, malloc_test);
+
+	return cmd_ut_category("malloc", tests, n_ents, argc, argv);
+}
@@ -8,6 +8,8 @@
 #include <common.h>
 #include <command.h>
 #include <errno.h>
+#include <fdt_batch.h>
+#include <fdt_support.h>
 #include <malloc.h>
 
 #include <linux/sizes.h>
@@ -22,6 +24,10 @@
 extern u32 __dtb_test_fdt_base_begin;
 extern u32 __dtb_test_fdt_overlay_begin;
 extern u32 __dtb_test_fdt_overlay_stacked_begin;
+extern u32 __dtb_test_fdt_overlay_simple_begin;
+
+/* cmd_ut_category() runs the tests with its own state, so no uts->priv */
+static void *overlay_fdt;
 
 static int ut_fdt_getprop_u32_by_index(void *fdt, const char *path,
 				    const char *name, int index,
@@ -67,7 +73,7 @@ static int fdt_getprop_str(void *fdt, const char *path, const char *name,
 
 static int fdt_overlay_change_int_property(struct unit_test_state *uts)
 {
-	void *fdt = uts->priv;
+	void *fdt = overlay_fdt;
 	u32 val = 0;
 
 	ut_assertok(ut_fdt_getprop_u32(fdt, "/test-node", "test-int-property",
@@ -80,7 +86,7 @@ OVERLAY_TEST(fdt_overlay_change_int_property, 0);
 
 static int fdt_overlay_change_str_property(struct unit_test_state *uts)
 {
-	void *fdt = uts->priv;
+	void *fdt = overlay_fdt;
 	const char *val = NULL;
 
 	ut_assertok(fdt_getprop_str(fdt, "/test-node", "test-str-property",
@@ -93,7 +99,7 @@ OVERLAY_TEST(fdt_overlay_change_str_property, 0);
 
 static int fdt_overlay_add_str_property(struct unit_test_state *uts)
 {
-	void *fdt = uts->priv;
+	void *fdt = overlay_fdt;
 	const char *val = NULL;
 
 	ut_assertok(fdt_getprop_str(fdt, "/test-node", "test-str-property-2",
@@ -106,7 +112,7 @@ OVERLAY_TEST(fdt_overlay_add_str_property, 0);
 
 static int fdt_overlay_add_node_by_phandle(struct unit_test_state *uts)
 {
-	void *fdt = uts->priv;
+	void *fdt = overlay_fdt;
 	int off;
 
 	off = fdt_path_offset(fdt, "/test-node/new-node");
@@ -120,7 +126,7 @@ OVERLAY_TEST(fdt_overlay_add_node_by_phandle, 0);
 
 static int fdt_overlay_add_node_by_path(struct unit_test_state *uts)
 {
-	void *fdt = uts->priv;
+	void *fdt = overlay_fdt;
 	int off;
 
 	off = fdt_path_offset(fdt, "/new-node");
@@ -134,7 +140,7 @@ OVERLAY_TEST(fdt_overlay_add_node_by_path, 0);
 
 static int fdt_overlay_add_subnode_property(struct unit_test_state *uts)
 {
-	void *fdt = uts->priv;
+	void *fdt = overlay_fdt;
 	int off;
 
 	off = fdt_path_offset(fdt, "/test-node/sub-test-node");
@@ -150,7 +156,7 @@ OVERLAY_TEST(fdt_overlay_add_subnode_property, 0);
 static int fdt_overlay_local_phandle(struct unit_test_state *uts)
 {
 	uint32_t local_phandle;
-	void *fdt = uts->priv;
+	void *fdt = overlay_fdt;
 	u32 val = 0;
 	int off;
 
@@ -175,7 +181,7 @@ OVERLAY_TEST(fdt_overlay_local_phandle, 0);
 static int fdt_overlay_local_phandles(struct unit_test_state *uts)
 {
 	uint32_t local_phandle, test_phandle;
-	void *fdt = uts->priv;
+	void *fdt = overlay_fdt;
 	u32 val = 0;
 	int off;
 
@@ -205,7 +211,7 @@ OVERLAY_TEST(fdt_overlay_local_phandles, 0);
 
 static int fdt_overlay_stacked(struct unit_test_state *uts)
 {
-	void *fdt = uts->priv;
+	void *fdt = overlay_fdt;
 	u32 val = 0;
 
 	ut_assertok(ut_fdt_getprop_u32(fdt, "/new-local-node",
@@ -216,6 +222,191 @@ static int fdt_overlay_stacked(struct unit_test_state *uts)
 }
 OVERLAY_TEST(fdt_overlay_stacked, 0);
 
+static int fdt_overlay_simple(struct unit_test_state *uts)
+{
+	void *fdt = overlay_fdt;
+	const char *str;
+	u32 val = 0;
+
+	ut_assertok(ut_fdt_getprop_u32(fdt, "/test-node/sub-test-node",
+				       "sub-test-property", &val));
+	ut_asserteq(44, val);
+	ut_assertok(fdt_getprop_str(fdt, "/batch-node", "batch-str-property",
+				    &str));
+	ut_asserteq_str("batch", str);
+	ut_assertok(ut_fdt_getprop_u32(fdt, "/batch-node/batch-subnode",
+				       "batch-int-property", &val));
+	ut_asserteq(45, val);
+
+	/* The earlier overlays must have survived the rewrite */
+	ut_assertok(ut_fdt_getprop_u32(fdt, "/new-local-node",
+				       "stacked-test-int-property", &val));
+	ut_asserteq(43, val);
+
+	return CMD_RET_SUCCESS;
+}
+OVERLAY_TEST(fdt_overlay_simple, 0);
+
+/* Queue the edits checked by fdt_overlay_batch_check() */
+static int fdt_overlay_batch_queue(struct unit_test_state *uts,
+				   struct fdt_batch *batch)
+{
+	int node;
+
+	ut_assertok(fdt_batch_setprop_u32(batch, "/test-node",
+					  "test-int-property", 46));
+	ut_assertok(fdt_batch_setprop_string(batch, "/a/b", "name-b", "b"));
+	ut_assertok(fdt_batch_setprop_u32(batch, "/a", "val-a", 1));
+	ut_assertok(fdt_batch_setprop_u32(batch, "/a", "val-a", 2));
+	node = fdt_batch_path(batch, "/test-node/sub-test-node");
+	ut_assert(node > 0);
+	ut_assertok(fdt_batch_delprop_node(batch, node, "sub-test-property"));
+
+	return 0;
+}
+
+static int fdt_overlay_batch_check(struct unit_test_state *uts, void *fdt)
+{
+	const char *str;
+	int node, len;
+	u32 val = 0;
+
+	ut_assertok(fdt_check_header(fdt));
+	ut_asserteq(17, fdt_version(fdt));
+	ut_asserteq(FDT_COPY_SIZE, fdt_totalsize(fdt));
+	ut_assertok(ut_fdt_getprop_u32(fdt, "/test-node", "test-int-property",
+				       &val));
+	ut_asserteq(46, val);
+	ut_assertok(ut_fdt_getprop_u32(fdt, "/a", "val-a", &val));
+	ut_asserteq(2, val);
+	ut_assertok(fdt_getprop_str(fdt, "/a/b", "name-b", &str));
+	ut_asserteq_str("b", str);
+	node = fdt_path_offset(fdt, "/test-node/sub-test-node");
+	ut_assert(node > 0);
+	ut_assert(!fdt_getprop(fdt, node, "sub-test-property", &len));
+
+	/* Properties of a node still come before its subnodes */
+	ut_assertok(fdt_getprop_str(fdt, "/test-node", "test-str-property",
+				    &str));
+	ut_asserteq_str("foobar", str);
+
+	return 0;
+}
+
+static int fdt_overlay_batch(struct unit_test_state *uts)
+{
+	char fdt[FDT_COPY_SIZE];
+	struct fdt_batch batch;
+
+	/* Work on a copy so as not to upset the other tests */
+	ut_assertok(fdt_open_into(overlay_fdt, fdt, sizeof(fdt)));
+	fdt_batch_init(&batch, fdt);
+	ut_assertok(fdt_overlay_batch_queue(uts, &batch));
+	ut_asserteq(-FDT_ERR_BADPATH, fdt_batch_path(&batch, "a"));
+	/* Errors are sticky */
+	ut_asserteq(-FDT_ERR_BADPATH,
+		    fdt_batch_setprop_u32(&batch, "/a", "val-a", 3));
+	ut_asserteq(-FDT_ERR_BADPATH, fdt_batch_apply(&batch, fdt));
+
+	ut_assertok(fdt_overlay_batch_queue(uts, &batch));
+	ut_assertok(fdt_batch_apply(&batch, fdt));
+	fdt_batch_free(&batch);
+
+	return fdt_overlay_batch_check(uts, fdt);
+}
+OVERLAY_TEST(fdt_overlay_batch, 0);
+
+static int fdt_overlay_batch_v16(struct unit_test_state *uts)
+{
+	char fdt[FDT_COPY_SIZE];
+	struct fdt_batch batch;
+
+	/* A version 17 blob is a valid version 16 one, given the version */
+	ut_assertok(fdt_open_into(overlay_fdt, fdt, sizeof(fdt)));
+	fdt_set_version(fdt, 16);
+	fdt_batch_init(&batch, fdt);
+	ut_assertok(fdt_overlay_batch_queue(uts, &batch));
+	ut_assertok(fdt_batch_apply(&batch, fdt));
+	fdt_batch_free(&batch);
+
+	return fdt_overlay_batch_check(uts, fdt);
+}
+OVERLAY_TEST(fdt_overlay_batch_v16, 0);
+
+static int fdt_overlay_list(struct unit_test_state *uts)
+{
+	char fdt[FDT_COPY_SIZE];
+	char overlay[FDT_COPY_SIZE];
+	char stacked[FDT_COPY_SIZE];
+	void *fdtos[] = { overlay, stacked };
+	const char *str;
+	u32 val = 0;
+	int off;
+
+	ut_assertok(fdt_open_into(&__dtb_test_fdt_base_begin, fdt,
+				  sizeof(fdt)));
+	ut_assertok(fdt_open_into(&__dtb_test_fdt_overlay_begin, overlay,
+				  sizeof(overlay)));
+	ut_assertok(fdt_open_into(&__dtb_test_fdt_overlay_stacked_begin,
+				  stacked, sizeof(stacked)));
+	ut_assertok(fdt_overlay_apply_list(fdt, fdtos, ARRAY_SIZE(fdtos)));
+
+	ut_assertok(ut_fdt_getprop_u32(fdt, "/test-node", "test-int-property",
+				       &val));
+	ut_asserteq(43, val);
+	ut_assertok(fdt_getprop_str(fdt, "/test-node", "test-str-property",
+				    &str));
+	ut_asserteq_str("foobar", str);
+
+	/* A label from the first overlay, used by the second */
+	ut_assertok(fdt_getprop_str(fdt, "/__symbols__", "local", &str));
+	ut_asserteq_str("/new-local-node", str);
+	ut_assertok(ut_fdt_getprop_u32(fdt, "/new-local-node",
+				       "stacked-test-int-property", &val));
+	ut_asserteq(43, val);
+
+	/* Local and external phandle references */
+	off = fdt_path_offset(fdt, "/new-local-node");
+	ut_assert(off >= 0);
+	ut_assertok(ut_fdt_getprop_u32_by_index(fdt, "/", "test-phandle", 1,
+						&val));
+	ut_asserteq(fdt_get_phandle(fdt, off), val);
+	off = fdt_path_offset(fdt, "/test-node");
+	ut_assertok(ut_fdt_getprop_u32_by_index(fdt, "/", "test-phandle", 0,
+						&val));
+	ut_asserteq(fdt_get_phandle(fdt, off), val);
+
+	return CMD_RET_SUCCESS;
+}
+OVERLAY_TEST(fdt_overlay_list, 0);
+
+static int fdt_overlay_list_no_symbols(struct unit_test_state *uts)
+{
+	char fdt[FDT_COPY_SIZE];
+	char overlay[FDT_COPY_SIZE];
+	void *fdtos[] = { overlay };
+	u32 val = 0;
+	int off;
+
+	/* A base tree whose /__symbols__ node has no labels in it */
+	ut_assertok(fdt_open_into(&__dtb_test_fdt_base_begin, fdt,
+				  sizeof(fdt)));
+	off = fdt_path_offset(fdt, "/__symbols__");
+	ut_assert(off >= 0);
+	ut_assertok(fdt_del_node(fdt, off));
+	ut_assert(fdt_add_subnode(fdt, 0, "__symbols__") >= 0);
+
+	ut_assertok(fdt_open_into(&__dtb_test_fdt_overlay_simple_begin,
+				  overlay, sizeof(overlay)));
+	ut_assertok(fdt_overlay_apply_list(fdt, fdtos, ARRAY_SIZE(fdtos)));
+	ut_assertok(ut_fdt_getprop_u32(fdt, "/test-node/sub-test-node",
+				       "sub-test-property", &val));
+	ut_asserteq(44, val);
+
+	return CMD_RET_SUCCESS;
+}
+OVERLAY_TEST(fdt_overlay_list_no_symbols, 0);
+
 int do_ut_overlay(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	struct unit_test *tests = ll_entry_start(struct unit_test,
@@ -225,6 +416,7 @@ int do_ut_overlay(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	void *fdt_base = &__dtb_test_fdt_base_begin;
 	void *fdt_overlay = &__dtb_test_fdt_overlay_begin;
 	void *fdt_overlay_stacked = &__dtb_test_fdt_overlay_stacked_begin;
+	void *fdt_overlay_simple = &__dtb_test_fdt_overlay_simple_begin;
 	void *fdt_base_copy, *fdt_overlay_copy, *fdt_overlay_stacked_copy;
 	int ret = -ENOMEM;
 
@@ -239,6 +431,7 @@ int do_ut_overlay(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	if (!fdt_base_copy)
 		goto err1;
 	uts->priv = fdt_base_copy;
+	overlay_fdt = fdt_base_copy;
 
 	fdt_overlay_copy = malloc(FDT_COPY_SIZE);
 	if (!fdt_overlay_copy)
@@ -280,6 +473,10 @@ int do_ut_overlay(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	/* Apply the stacked overlay */
 	ut_assertok(fdt_overlay_apply(fdt_base_copy, fdt_overlay_stacked_copy));
 
+	/* Apply the overlay which needs no fixups, in a single batch */
+	ut_assertok(fdt_overlay_apply_verbose(fdt_base_copy,
+					      fdt_overlay_simple));
+
 	ret = cmd_ut_category("overlay", tests, n_ents, argc, argv);
 
 	free(fdt_overlay_stacked_copy);
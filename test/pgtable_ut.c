@@ -0,0 +1,252 @@
+/*
+ * Tests for the arm64 page table code, run on sandbox
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <armv8_pgtable.h>
+#include <command.h>
+#include <malloc.h>
+#include <test/suites.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+#define PGTABLE_TEST(_name, _flags)	UNIT_TEST(_name, _flags, pgtable_test)
+
+#define ATTR_DEVICE	PMD_ATTRINDX(MT_DEVICE_NGNRNE)
+#define ATTR_NORMAL	PMD_ATTRINDX(MT_NORMAL)
+#define ATTR_NC		PMD_ATTRINDX(MT_NORMAL_NC)
+
+#define SZ_4K		0x1000ULL
+#define SZ_2M		0x200000ULL
+#define SZ_1G		0x40000000ULL
+
+/* Page tables being tested, in allocated memory */
+static struct pgtable pgtable_test_pt;
+
+/* 4 GiB, so that the tables start at level 1 with 1 GiB blocks */
+static struct mm_region pgtable_test_map[] = {
+	{
+		.virt = 0,
+		.phys = 0,
+		.size = 2 * SZ_1G,
+		.attrs = ATTR_DEVICE | PTE_BLOCK_NON_SHARE |
+			 PTE_BLOCK_PXN | PTE_BLOCK_UXN,
+	}, {
+		.virt = 2 * SZ_1G,
+		.phys = 2 * SZ_1G,
+		.size = SZ_1G,
+		.attrs = ATTR_NORMAL | PTE_BLOCK_INNER_SHARE,
+	}, {
+		/* Carries on from the last one, so shares its blocks */
+		.virt = 3 * SZ_1G,
+		.phys = 3 * SZ_1G,
+		.size = SZ_1G,
+		.attrs = ATTR_NORMAL | PTE_BLOCK_INNER_SHARE,
+	}, {
+		/* List terminator */
+		0,
+	}
+};
+
+struct mm_region *mem_map = pgtable_test_map;
+
+/* Build the tables for pgtable_test_map in newly allocated memory */
+static int pgtable_test_setup(struct unit_test_state *uts)
+{
+	struct pgtable *pt = &pgtable_test_pt;
+
+	memset(pt, '\0', sizeof(*pt));
+	pt->size = get_page_table_size();
+	pt->addr = (ulong)memalign(SZ_4K, pt->size);
+	ut_assert(pt->addr);
+	pt->fillptr = pt->addr;
+	pgtable_setup(pt);
+
+	return 0;
+}
+
+static void pgtable_test_teardown(void)
+{
+	free((void *)pgtable_test_pt.addr);
+}
+
+/*
+ * Find the block or page which maps an address, walking the tables from
+ * level 1 as the 4 GiB map needs no level 0. Returns its level, or -1 if
+ * nothing maps it or the entry does not hold the address.
+ */
+static int pgtable_test_leaf(u64 addr, u64 *ptep)
+{
+	u64 *table = (u64 *)pgtable_test_pt.addr;
+	u64 pte, mask;
+	int level, shift;
+
+	for (level = 1; level < 4; level++) {
+		/* Each level translates 9 bits above the 12 of the page */
+		shift = 12 + 9 * (3 - level);
+		pte = table[(addr >> shift) & 0x1ff];
+		if ((pte & PTE_TYPE_MASK) == PTE_TYPE_FAULT)
+			return -1;
+		if (level == 3 || (pte & PTE_TYPE_MASK) == PTE_TYPE_BLOCK)
+			break;
+		table = (u64 *)(ulong)(pte & PTE_ADDR_MASK);
+	}
+	*ptep = pte;
+	mask = (1ULL << shift) - 1;
+	if ((pte & PTE_ADDR_MASK) != (addr & ~mask))
+		return -1;
+
+	return level;
+}
+
+/* Check the level and memory type of the entry which maps an address */
+static int pgtable_test_check(struct unit_test_state *uts, u64 addr,
+			      int level, u64 attrs)
+{
+	u64 pte;
+
+	ut_asserteq(level, pgtable_test_leaf(addr, &pte));
+	ut_asserteq(attrs, pte & PMD_ATTRINDX_MASK);
+
+	return 0;
+}
+
+/* Check the number of blocks and pages at each level */
+static int pgtable_test_blocks(struct unit_test_state *uts, uint blocks_1g,
+			       uint blocks_2m, uint pages)
+{
+	struct mmu_stats stats;
+
+	pgtable_get_stats(&pgtable_test_pt, &stats);
+	ut_asserteq(blocks_1g, stats.blocks[1]);
+	ut_asserteq(blocks_2m, stats.blocks[2]);
+	ut_asserteq(pages, stats.blocks[3]);
+
+	return 0;
+}
+
+/* Test that memory is mapped with the largest blocks that fit */
+static int pgtable_test_map_blocks(struct unit_test_state *uts)
+{
+	struct pgtable *pt = &pgtable_test_pt;
+	struct mmu_stats stats;
+
+	ut_assertok(pgtable_test_setup(uts));
+	pgtable_get_stats(pt, &stats);
+	ut_asserteq(SZ_4K, stats.table_bytes);
+	ut_assertok(pgtable_test_blocks(uts, 4, 0, 0));
+	ut_assertok(pgtable_test_check(uts, 0, 1, ATTR_DEVICE));
+	ut_assertok(pgtable_test_check(uts, 2 * SZ_1G, 1, ATTR_NORMAL));
+	ut_assertok(pgtable_test_check(uts, 4 * SZ_1G - SZ_4K, 1,
+				       ATTR_NORMAL));
+	ut_assert(pgtable_region_has_attrs(pt, 2 * SZ_1G, 2 * SZ_1G,
+					   ATTR_NORMAL));
+	ut_assert(!pgtable_region_has_attrs(pt, SZ_1G, 2 * SZ_1G,
+					    ATTR_NORMAL));
+	pgtable_test_teardown();
+
+	return 0;
+}
+PGTABLE_TEST(pgtable_test_map_blocks, 0);
+
+/*
+ * Test that a block is only split where a region partly covers it, and
+ * that the tables are merged back into blocks when it is set back
+ */
+static int pgtable_test_split_merge(struct unit_test_state *uts)
+{
+	struct pgtable *pt = &pgtable_test_pt;
+	u64 start = 4 * SZ_1G - SZ_2M / 2;
+	ulong fillptr;
+
+	ut_assertok(pgtable_test_setup(uts));
+
+	/* Setting the type a region has already splits nothing */
+	pgtable_set_region(pt, 2 * SZ_1G, SZ_1G + SZ_2M, ATTR_NORMAL, false);
+	ut_asserteq(0, pt->splits);
+	ut_assertok(pgtable_test_blocks(uts, 4, 0, 0));
+
+	/* The last 1 MiB splits a 1 GiB block, then a 2 MiB one */
+	pgtable_set_region(pt, start, SZ_2M / 2, ATTR_NC, false);
+	ut_asserteq(2, pt->splits);
+	ut_assertok(pgtable_test_blocks(uts, 3, 511, 512));
+	ut_assertok(pgtable_test_check(uts, start - SZ_2M, 2, ATTR_NORMAL));
+	ut_assertok(pgtable_test_check(uts, start - SZ_4K, 3, ATTR_NORMAL));
+	ut_assertok(pgtable_test_check(uts, start, 3, ATTR_NC));
+	ut_assertok(pgtable_test_check(uts, 4 * SZ_1G - SZ_4K, 3, ATTR_NC));
+	ut_assert(pgtable_region_has_attrs(pt, start, SZ_2M / 2, ATTR_NC));
+	ut_assert(!pgtable_region_has_attrs(pt, start - SZ_4K, SZ_4K,
+					    ATTR_NC));
+
+	/* Nothing can be merged while the types differ */
+	pgtable_merge_region(pt, start, SZ_2M / 2);
+	ut_asserteq(0, pt->merges);
+
+	/* Setting it back merges the pages, then the 2 MiB blocks */
+	pgtable_set_region(pt, start, SZ_2M / 2, ATTR_NORMAL, false);
+	pgtable_merge_region(pt, start, SZ_2M / 2);
+	ut_asserteq(2, pt->merges);
+	ut_assertok(pgtable_test_blocks(uts, 4, 0, 0));
+	ut_assertok(pgtable_test_check(uts, start, 1, ATTR_NORMAL));
+
+	/* A split after that reuses the merged tables */
+	fillptr = pt->fillptr;
+	pgtable_set_region(pt, start, SZ_2M / 2, ATTR_NC, false);
+	ut_asserteq(4, pt->splits);
+	ut_assert(pt->fillptr == fillptr);
+	ut_assertok(pgtable_test_check(uts, start, 3, ATTR_NC));
+	ut_assertok(pgtable_test_check(uts, start - SZ_4K, 3, ATTR_NORMAL));
+
+	/* A whole 2 MiB block over those pages changes each of them */
+	pgtable_set_region(pt, start - SZ_2M / 2, SZ_2M, ATTR_DEVICE, false);
+	pgtable_merge_region(pt, start - SZ_2M / 2, SZ_2M);
+	ut_asserteq(3, pt->merges);
+	ut_assertok(pgtable_test_blocks(uts, 3, 512, 0));
+	ut_assertok(pgtable_test_check(uts, start, 2, ATTR_DEVICE));
+	pgtable_test_teardown();
+
+	return 0;
+}
+PGTABLE_TEST(pgtable_test_split_merge, 0);
+
+/*
+ * Test changing more than the memory type, break-before-make, as
+ * mmu_change_region_attr() does. The region is set to fault first, then
+ * to its new attributes.
+ */
+static int pgtable_test_change_attrs(struct unit_test_state *uts)
+{
+	struct pgtable *pt = &pgtable_test_pt;
+	u64 start = 2 * SZ_1G + SZ_2M;
+	u64 attrs = ATTR_NORMAL | PTE_BLOCK_PXN | PTE_TYPE_VALID;
+	u64 pte;
+
+	ut_assertok(pgtable_test_setup(uts));
+
+	pgtable_set_region(pt, start, SZ_2M, PTE_TYPE_FAULT, true);
+	ut_asserteq(1, pt->splits);
+	ut_asserteq(-1, pgtable_test_leaf(start, &pte));
+	ut_assertok(pgtable_test_check(uts, start - SZ_2M, 2, ATTR_NORMAL));
+	ut_assertok(pgtable_test_check(uts, start + SZ_2M, 2, ATTR_NORMAL));
+	ut_assert(!pgtable_region_has_attrs(pt, start, SZ_2M, ATTR_NORMAL));
+
+	pgtable_set_region(pt, start, SZ_2M, attrs, true);
+	ut_asserteq(2, pgtable_test_leaf(start, &pte));
+	ut_assert((pte & PMD_ATTRMASK) == attrs);
+	ut_asserteq(1, pt->splits);
+	pgtable_test_teardown();
+
+	return 0;
+}
+PGTABLE_TEST(pgtable_test_change_attrs, 0);
+
+int do_ut_pgtable(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
+{
+	struct unit_test *tests = ll_entry_start(struct unit_test,
+						 pgtable_test);
+	const int n_ents = ll_entry_count(struct unit_test, pgtable_test);
+
+	return cmd_ut_category("pgtable", tests, n_ents, argc, argv);
+}
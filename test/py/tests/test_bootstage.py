@@ -0,0 +1,52 @@
+# SPDX-License-Identifier: GPL-2.0
+
+# Test the bootstage report, including the memory high-water marks kept as
+# size records.
+
+import re
+import pytest
+
+def get_sizes(output):
+    """Return the size records from a bootstage report as a dict."""
+
+    sizes = {}
+    section = output.replace('\r', '').split(
+        'Memory high-water marks in bytes:\n')
+    if len(section) < 2:
+        return sizes
+    for line in section[1].splitlines():
+        m = re.match(r'\s+([\d,]+)\s+(\w+)$', line)
+        if not m:
+            break
+        sizes[m.group(2)] = int(m.group(1).replace(',', ''))
+    return sizes
+
+@pytest.mark.buildconfigspec('cmd_bootstage')
+def test_bootstage_report(u_boot_console):
+    """Test that the report lists the main boot stages."""
+
+    output = u_boot_console.run_command('bootstage report')
+    assert 'Timer summary in microseconds' in output
+    assert 'reset' in output
+    assert 'board_init_f' in output
+    assert 'board_init_r' in output
+
+@pytest.mark.buildconfigspec('cmd_bootstage')
+@pytest.mark.buildconfigspec('mem_highwater')
+def test_bootstage_highwater(u_boot_console):
+    """Test that the heap and stack high-water marks are reported as sizes,
+    and that they agree with meminfo."""
+
+    cons = u_boot_console
+    sizes = get_sizes(cons.run_command('bootstage report'))
+    for name in ('heap_f', 'stack_f', 'heap_r', 'stack_r'):
+        assert sizes.get(name, 0) > 0
+    malloc_f_len = int(cons.config.buildconfig.get(
+        'config_sys_malloc_f_len', '0'), 16)
+    assert sizes['heap_f'] <= malloc_f_len
+    stack_size = int(cons.config.buildconfig.get(
+        'config_stack_paint_size', '0'), 16)
+    assert sizes['stack_r'] <= stack_size
+
+    output = cons.run_command('meminfo')
+    assert re.search(r'Heap \(pre-reloc\)\s+0x%x ' % sizes['heap_f'], output)
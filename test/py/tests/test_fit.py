@@ -171,7 +171,7 @@ def test_fit(u_boot_console):
             print >> fd, base_its % params
         return its
 
-    def make_fit(mkimage, params):
+    def make_fit(mkimage, params, args=[]):
         """Make a sample .fit file ready for loading
 
         This creates a .its script with the selected parameters and uses mkimage to
@@ -180,12 +180,13 @@ def test_fit(u_boot_console):
         Args:
             mkimage: Filename of 'mkimage' utility
             params: Dictionary containing parameters to embed in the %() strings
+            args: Extra arguments to pass to mkimage
         Return:
             Filename of .fit file created
         """
         fit = make_fname('test.fit')
         its = make_its(params)
-        util.run_and_log(cons, [mkimage, '-f', its, fit])
+        util.run_and_log(cons, [mkimage] + args + ['-f', its, fit])
         with open(make_fname('u-boot.dts'), 'w') as fd:
             print >> fd, base_fdt
         return fit
@@ -416,6 +417,53 @@ def test_fit(u_boot_console):
             check_equal(loadables2, loadables2_out,
                         'Loadables2 (ramdisk) not loaded')
 
+        # External data read a piece at a time, straight to each load address
+        if not cons.config.buildconfig.get('config_cmd_fitload'):
+            return
+        with cons.log.section('External data with fitload'):
+            fit = make_fit(mkimage, params, ['-E', '-B', '200'])
+            assert filesize(fit) % 0x200 == 0, 'FIT data not block-aligned'
+            cons.restart_uboot()
+            output = cons.run_command_list(cmd.replace(
+                'sb load hostfs 0', 'fitload hostfs -').splitlines())
+            line = find_matching(output, 'Data Start:   ')
+            assert int(line, 16) == params['kernel_addr'], (
+                   'Kernel not read to its load address')
+            check_equal(kernel, kernel_out, 'Kernel not loaded')
+            check_equal(control_dtb, fdt_out, 'FDT not loaded')
+            check_equal(ramdisk, ramdisk_out, 'Ramdisk not loaded')
+            check_equal(loadables1, loadables1_out,
+                        'Loadables1 (kernel) not loaded')
+            check_equal(loadables2, loadables2_out,
+                        'Loadables2 (ramdisk) not loaded')
+
+        # Another FIT loaded whole over that one must not use the images
+        # fitload read. The kernel is the same size and at the same
+        # position, so only the FIT structure differs
+        with cons.log.section('Another FIT over one read by fitload'):
+            kernel2 = make_kernel('test-kernel2.bin', 'lenrek')
+            params['kernel'] = kernel2
+            params['ramdisk_config'] = ''
+            fit = make_fit(mkimage, params, ['-E', '-B', '200'])
+            output = cons.run_command_list(cmd.splitlines())
+            check_equal(kernel2, kernel_out, 'Kernel from the old FIT used')
+
+        # An image whose load address is inside the FIT structure must be
+        # read after it instead, leaving the FIT intact
+        with cons.log.section('fitload with a load address in the FIT'):
+            params['loadables1_load'] = ('load = <%#x>;' %
+                                         (params['fit_addr'] + 0x100))
+            fit = make_fit(mkimage, params, ['-E', '-B', '200'])
+            cons.restart_uboot()
+            output = cons.run_command_list([
+                'fitload hostfs - %x %s; echo rc=$?' % (params['fit_addr'],
+                                                        fit),
+                'fdt addr %x' % params['fit_addr'],
+                'fdt list /images/kernel@2'])
+            assert 'rc=0' in output[0], 'fitload failed'
+            assert 'libfdt' not in output[1], 'FIT overwritten'
+            assert 'load = <0x00001100>' in output[2], 'FIT overwritten'
+
     cons = u_boot_console
     try:
         # We need to use our own device tree file. Remember to restore it
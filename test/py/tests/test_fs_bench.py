@@ -0,0 +1,432 @@
+# SPDX-License-Identifier: GPL-2.0
+
+# Benchmark filesystem reads and image decompression on sandbox.
+#
+# Each filesystem is put on an image file which is bound to host device 0.
+# The time U-Boot takes for each case is measured with the "time" command,
+# the number of device requests with "host stats", and the results are
+# recorded in a JSON file. A test fails when a result is worse than a
+# configured threshold, or has regressed too far from an earlier run.
+
+import json
+import os
+import os.path
+import random
+import re
+import shutil
+import zlib
+import pytest
+import u_boot_utils as util
+
+"""
+Note: The filesystem images are created with the host's mkfs tools and
+populated through a loop mount, which uses sudo. A filesystem whose tools
+are missing, or which the host cannot mount, is skipped. The results go to
+fs-bench.json in the result directory.
+
+All of the following boardenv_* settings are optional:
+
+# Number of times each case is run; the time is that of all runs together.
+env__fs_bench_iterations = 5
+
+# Make host device requests as slow as on a board, here an SD card with a
+# command overhead of 1000 us and a bandwidth of 25000 kB/s. See the
+# "host delay" command.
+env__fs_bench_delay = (1000, 25000)
+
+# Smallest acceptable results, by filesystem (or "decompress") and case.
+# Loads and decompression are in MB/s, lookups and small files per second.
+env__fs_bench_thresholds = {
+    'ext4': {'seq_load': 200, 'small_files': 2000},
+    'decompress': {'lz4': 300},
+}
+
+# Results of an earlier run to compare with, and how many percent slower a
+# case may become, or how many percent more device requests or blocks it
+# may read, before it counts as a regression.
+env__fs_bench_baseline = '/path/to/fs-bench.json'
+env__fs_bench_max_regression = 20
+"""
+
+# Filesystems: U-Boot config option, mkfs command line and mount type
+fs_types = {
+    'fat': ('fs_fat', ['mkfs.vfat', '-F', '32'], 'vfat'),
+    'exfat': ('fat_exfat', ['mkfs.exfat'], 'exfat'),
+    'ext4': ('fs_ext4', ['mkfs.ext4', '-F', '-q'], 'ext4'),
+    'btrfs': ('fs_btrfs', ['mkfs.btrfs', '-f', '-q'], 'btrfs'),
+}
+
+# Decompression: compression name in the FIT and host compression command
+compressions = {
+    'gzip': ['gzip', '-9', '-n', '-c'],
+    'lz4': ['lz4', '-9', '-c'],
+    'lzo': ['lzop', '-9', '-c'],
+}
+
+image_size = 128 << 20
+seq_size = 16 << 20
+frag_size = 8 << 20
+frag_chunk = 64 << 10
+small_count = 256
+small_size = 4 << 10
+deep_depth = 32
+deep_lookups = 100
+payload_size = 8 << 20
+
+# Load addresses, as offsets from the start of RAM
+load_offset = 0x1000000
+fit_offset = 0x3000000
+
+deep_path = '/deep' + '/d' * deep_depth + '/leaf'
+
+def tool_is_in_path(tool):
+    for path in os.environ['PATH'].split(os.pathsep):
+        fn = os.path.join(path, tool)
+        if os.path.isfile(fn) and os.access(fn, os.X_OK):
+            return True
+    return False
+
+def make_data(seed, size):
+    """Make size bytes of data, which compresses about as well as code.
+
+    Args:
+        seed: Seed for the random generator, so the data is reproducible.
+        size: Number of bytes to make.
+
+    Returns:
+        The data.
+    """
+    rnd = random.Random(seed)
+    words = [''.join(rnd.choice('abcdefghijklmnopqrstuvwxyz_{}();')
+                     for i in range(rnd.randint(2, 10))) for j in range(4096)]
+    data = []
+    length = 0
+    while length <= size:
+        word = rnd.choice(words)
+        data.append(word)
+        length += len(word) + 1
+    return ' '.join(data)[:size].encode('ascii')
+
+def write_file(fn, data):
+    with open(fn, 'wb') as fh:
+        fh.write(data)
+
+def populate(mnt):
+    """Put the files of each case on a mounted filesystem.
+
+    The file for the fragmented case is written last, into the gaps left by
+    removing every other file of a set that fills the filesystem, so that
+    it is fragmented whatever the filesystem's allocation policy.
+
+    Args:
+        mnt: Directory where the filesystem is mounted.
+    """
+    write_file(mnt + '/seq.bin', make_data(1, seq_size))
+
+    os.makedirs(os.path.dirname(mnt + deep_path))
+    write_file(mnt + deep_path, make_data(2, small_size))
+
+    os.mkdir(mnt + '/small')
+    for i in range(small_count):
+        write_file(mnt + '/small/%x' % i, make_data(100 + i, small_size))
+
+    os.mkdir(mnt + '/fill')
+    fill = make_data(3, frag_chunk)
+    count = 0
+    while True:
+        fn = mnt + '/fill/%x' % count
+        try:
+            write_file(fn, fill)
+        except (IOError, OSError):
+            if os.path.exists(fn):
+                os.unlink(fn)
+            break
+        count += 1
+    for i in range(0, count, 2):
+        os.unlink(mnt + '/fill/%x' % i)
+    size = min(frag_size, count // 2 * frag_chunk * 3 // 4)
+    write_file(mnt + '/frag.bin', make_data(4, size))
+
+class FsBenchImage(object):
+    """A filesystem image holding the files of the benchmark."""
+
+    def __init__(self, u_boot_console, fs_type):
+        """Create the image, unless there is an up-to-date one already.
+
+        Args:
+            u_boot_console: A U-Boot console.
+            fs_type: Filesystem to create, a key of fs_types.
+        """
+        cons = u_boot_console
+        mkfs, mount_type = fs_types[fs_type][1:]
+
+        if not tool_is_in_path(mkfs[0]):
+            pytest.skip('%s not found' % mkfs[0])
+
+        self.path = cons.config.persistent_data_dir + '/fs_bench_%s.img' % \
+            fs_type
+        with util.persistent_file_helper(cons.log, self.path):
+            if os.path.exists(self.path):
+                cons.log.action('Disk image file ' + self.path +
+                    ' already exists')
+                return
+
+            cons.log.action('Generating ' + self.path)
+            fd = os.open(self.path, os.O_RDWR | os.O_CREAT)
+            os.ftruncate(fd, image_size)
+            os.close(fd)
+            util.run_and_log(cons, mkfs + [self.path])
+
+            mnt = cons.config.persistent_data_dir + '/fs_bench_mnt'
+            if os.path.exists(mnt):
+                shutil.rmtree(mnt)
+            os.mkdir(mnt)
+            opts = 'loop'
+            if fs_type in ('fat', 'exfat'):
+                opts += ',uid=%d,gid=%d' % (os.getuid(), os.getgid())
+            try:
+                util.run_and_log(cons, ['sudo', 'mount', '-t', mount_type,
+                                        '-o', opts, self.path, mnt])
+            except Exception:
+                os.unlink(self.path)
+                pytest.skip('Cannot mount %s image' % fs_type)
+            try:
+                if fs_type not in ('fat', 'exfat'):
+                    util.run_and_log(cons, ['sudo', 'chown', str(os.getuid()),
+                                            mnt])
+                populate(mnt)
+            finally:
+                util.run_and_log(cons, ['sudo', 'umount', mnt])
+                os.rmdir(mnt)
+
+class FsBench(object):
+    """Runs the cases and collects their results."""
+
+    def __init__(self, u_boot_console, group):
+        """Set up a benchmark.
+
+        Args:
+            u_boot_console: A U-Boot console.
+            group: Name under which the results are recorded.
+        """
+        self.cons = u_boot_console
+        self.env = u_boot_console.config.env
+        self.group = group
+        self.iterations = self.env.get('env__fs_bench_iterations', 5)
+        self.results = {}
+        self.ram_base = util.find_ram_base(u_boot_console)
+
+    def addr(self, offset):
+        return '%x' % (self.ram_base + offset)
+
+    def bind(self, image):
+        """Bind host device 0 to an image and apply the latency model."""
+        cons = self.cons
+        cons.run_command('host bind 0 ' + image)
+        delay = self.env.get('env__fs_bench_delay', None)
+        if delay:
+            cons.run_command('host delay 0 %d %d' % delay)
+
+    def time(self, cmd):
+        """Run a command for each iteration and measure how long they take.
+
+        Args:
+            cmd: The U-Boot command, which may use $i, the iteration.
+
+        Returns:
+            A tuple: the time in seconds, and a tuple of the number of read
+            requests and blocks read from host device 0 per iteration, or
+            None if it is not bound.
+        """
+        cons = self.cons
+        cons.run_command('host stats 0 reset')
+        cons.run_command("setenv bench 'setenv i 0; while itest $i < %x; "
+                         "do %s; setexpr i $i + 1; done'" %
+                         (self.iterations, cmd))
+        output = cons.run_command('time run bench')
+        assert not re.search(r'\*\*|Failed|Cannot|ERROR', output)
+        m = re.search(r'time: (?:(\d+) minutes, )?(\d+)\.(\d+) seconds',
+                      output)
+        seconds = int(m.group(1) or 0) * 60 + int(m.group(2)) + \
+            int(m.group(3)) / 1000.0
+        cons.run_command('setenv bench')
+
+        reads = None
+        m = re.search(r'reads: +(\d+) \((\d+) blocks\)',
+                      cons.run_command('host stats 0'))
+        if m:
+            reads = (int(m.group(1)) // self.iterations,
+                     int(m.group(2)) // self.iterations)
+        return max(seconds, 0.001), reads
+
+    def record(self, case, value, unit, seconds, reads):
+        self.results[case] = {
+            'value': round(value, 2),
+            'unit': unit,
+            'seconds': seconds,
+            'iterations': self.iterations,
+        }
+        if reads:
+            self.results[case]['read_requests'] = reads[0]
+            self.results[case]['read_blocks'] = reads[1]
+        self.cons.log.info('%s %s: %.2f %s' % (self.group, case, value, unit))
+
+    def load(self, case, fn, size):
+        """Measure loading a whole file of size bytes."""
+        seconds, reads = self.time('load host 0 %s %s' %
+                                    (self.addr(load_offset), fn))
+        self.record(case, float(size) * self.iterations / seconds / 1e6,
+                    'MB/s', seconds, reads)
+
+    def check_crc(self, offset, data):
+        """Check that memory at offset from the start of RAM holds data."""
+        output = self.cons.run_command('crc32 %s %x' % (self.addr(offset),
+                                                        len(data)))
+        assert '%08x' % (zlib.crc32(data) & 0xffffffff) in output
+
+    def finish(self):
+        """Write the results and check them against thresholds."""
+        env = self.env
+        fn = self.cons.config.result_dir + '/fs-bench.json'
+        all_results = {}
+        if os.path.exists(fn):
+            with open(fn) as fh:
+                all_results = json.load(fh)
+        all_results.setdefault(self.group, {}).update(self.results)
+        with open(fn, 'w') as fh:
+            json.dump(all_results, fh, indent=4, sort_keys=True)
+
+        failures = []
+        thresholds = env.get('env__fs_bench_thresholds', {}).get(self.group,
+                                                                 {})
+        for case, minimum in thresholds.items():
+            if case in self.results and self.results[case]['value'] < minimum:
+                failures.append('%s: %.2f %s, below %.2f' %
+                                (case, self.results[case]['value'],
+                                 self.results[case]['unit'], minimum))
+
+        baseline_fn = env.get('env__fs_bench_baseline', None)
+        if baseline_fn:
+            with open(baseline_fn) as fh:
+                baseline = json.load(fh).get(self.group, {})
+            margin = env.get('env__fs_bench_max_regression', 20) / 100.0
+            for case, result in self.results.items():
+                base = baseline.get(case)
+                if not base:
+                    continue
+                if result['value'] < base['value'] * (1 - margin):
+                    failures.append('%s: %.2f %s, was %.2f' %
+                                    (case, result['value'], result['unit'],
+                                     base['value']))
+                for key in ('read_requests', 'read_blocks'):
+                    if key in result and key in base and \
+                            result[key] > base[key] * (1 + margin):
+                        failures.append('%s: %s %d, was %d' %
+                                        (case, key, result[key], base[key]))
+
+        assert not failures, '%s regressed: %s' % (self.group,
+                                                   '; '.join(failures))
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_fs_generic')
+@pytest.mark.buildconfigspec('cmd_itest')
+@pytest.mark.buildconfigspec('cmd_setexpr')
+@pytest.mark.buildconfigspec('cmd_time')
+@pytest.mark.parametrize('fs_type', sorted(fs_types.keys()))
+def test_fs_bench(u_boot_console, fs_type):
+    """Measure sequential and fragmented loads, path lookups in a deep
+    directory tree, and loads of many small files."""
+
+    cons = u_boot_console
+    if not cons.config.buildconfig.get('config_' + fs_types[fs_type][0]):
+        pytest.skip('%s not enabled' % fs_type)
+
+    image = FsBenchImage(cons, fs_type)
+    bench = FsBench(cons, fs_type)
+    bench.bind(image.path)
+    try:
+        bench.load('seq_load', '/seq.bin', seq_size)
+        bench.check_crc(load_offset, make_data(1, seq_size))
+
+        cons.run_command('size host 0 /frag.bin')
+        frag_len = int(cons.run_command('echo $filesize'), 16)
+        bench.load('frag_load', '/frag.bin', frag_len)
+        bench.check_crc(load_offset, make_data(4, frag_len))
+
+        seconds, reads = bench.time("setenv j 0; while itest $j < %x; "
+            "do size host 0 %s; setexpr j $j + 1; done" %
+            (deep_lookups, deep_path))
+        bench.record('deep_lookup', deep_lookups * bench.iterations / seconds,
+                     'lookups/s', seconds, reads)
+
+        seconds, reads = bench.time("setenv j 0; while itest $j < %x; "
+            "do load host 0 %s /small/$j; setexpr j $j + 1; done" %
+            (small_count, bench.addr(load_offset)))
+        bench.record('small_files', small_count * bench.iterations / seconds,
+                     'files/s', seconds, reads)
+    finally:
+        cons.run_command('host bind 0')
+
+    bench.finish()
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('fit')
+@pytest.mark.buildconfigspec('cmd_itest')
+@pytest.mark.buildconfigspec('cmd_setexpr')
+@pytest.mark.buildconfigspec('cmd_time')
+@pytest.mark.requiredtool('dtc')
+@pytest.mark.parametrize('comp', sorted(compressions.keys()))
+def test_fs_bench_decompress(u_boot_console, comp):
+    """Measure decompression of a kernel in a FIT by bootm."""
+
+    cons = u_boot_console
+    if not cons.config.buildconfig.get('config_' + comp):
+        pytest.skip('%s not enabled' % comp)
+    if not tool_is_in_path(compressions[comp][0]):
+        pytest.skip('%s not found' % compressions[comp][0])
+
+    payload = make_data(5, payload_size)
+    base = cons.config.result_dir + '/fs_bench_' + comp
+    write_file(base + '.bin', payload)
+    util.run_and_log(cons, ['sh', '-c', '%s %s.bin > %s.comp' %
+                            (' '.join(compressions[comp]), base, base)])
+
+    bench = FsBench(cons, 'decompress')
+    with open(base + '.its', 'w') as fh:
+        fh.write('''/dts-v1/;
+
+/ {
+	description = "Decompression benchmark";
+	#address-cells = <1>;
+
+	images {
+		kernel@1 {
+			data = /incbin/("%s.comp");
+			type = "kernel";
+			arch = "sandbox";
+			os = "linux";
+			compression = "%s";
+			load = <0x%s>;
+			entry = <0x%s>;
+		};
+	};
+	configurations {
+		default = "conf@1";
+		conf@1 {
+			kernel = "kernel@1";
+		};
+	};
+};
+''' % (base, comp, bench.addr(load_offset), bench.addr(load_offset)))
+    mkimage = cons.config.build_dir + '/tools/mkimage'
+    util.run_and_log(cons, [mkimage, '-f', base + '.its', base + '.fit'])
+
+    cons.run_command('host load hostfs - %s %s.fit' %
+                     (bench.addr(fit_offset), base))
+    seconds, reads = bench.time('bootm start %s; bootm loados' %
+                                 bench.addr(fit_offset))
+    bench.record(comp, float(payload_size) * bench.iterations / seconds / 1e6,
+                 'MB/s', seconds, reads)
+    bench.check_crc(load_offset, payload)
+
+    bench.finish()
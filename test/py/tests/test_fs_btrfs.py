@@ -0,0 +1,110 @@
+# SPDX-License-Identifier: GPL-2.0
+
+# Test listing and reading a btrfs directory which spans many tree leaves.
+#
+# The image is made without mounting it: mkfs.btrfs copies in a directory
+# tree. With small tree nodes the items of the big directory fill many
+# leaves below more than one level of nodes, so that listing it has to step
+# from leaf to leaf, and the second pass over it comes from the node cache.
+
+import os
+import os.path
+import re
+import shutil
+import pytest
+import u_boot_utils as util
+
+# Files in each directory, and the template of their names
+dirs = {
+    'small': (20, 'file-%04d'),
+    'big': (3000, 'entry-with-a-rather-long-name-%05d'),
+}
+
+def file_data(dirname, i):
+    return '%s %d\n' % (dirname, i)
+
+def make_image(cons):
+    """Make a btrfs image with a big directory, if not already done.
+
+    Args:
+        cons: A U-Boot console.
+
+    Returns:
+        The path of the image.
+    """
+    path = cons.config.persistent_data_dir + '/btrfs_dirs.img'
+    with util.persistent_file_helper(cons.log, path):
+        if os.path.exists(path):
+            cons.log.action('Disk image file ' + path + ' already exists')
+            return path
+
+        cons.log.action('Generating ' + path)
+        src = cons.config.persistent_data_dir + '/btrfs_src'
+        if os.path.exists(src):
+            shutil.rmtree(src)
+        for dirname, (count, name) in dirs.items():
+            os.makedirs(os.path.join(src, dirname))
+            for i in range(count):
+                with open(os.path.join(src, dirname, name % i), 'w') as fh:
+                    fh.write(file_data(dirname, i))
+        try:
+            with open(path, 'wb') as fh:
+                fh.truncate(128 << 20)
+            # Small nodes so that the big directory needs several levels
+            util.run_and_log(cons, ['mkfs.btrfs', '-q', '-f', '-n', '4096',
+                                    '-r', src, path])
+        except Exception:
+            if os.path.exists(path):
+                os.unlink(path)
+            raise
+        finally:
+            shutil.rmtree(src)
+
+    return path
+
+def check_ls(cons, dirname):
+    """Check that a directory lists each of its files once, with its size."""
+    count, name = dirs[dirname]
+    output = cons.run_command('ls host 0 /%s' % dirname)
+    found = re.findall(r'^<   > +(\d+) .*  (\S+)\s*$', output,
+                       re.MULTILINE)
+    assert len(found) == count
+    assert dict((fn, int(size)) for size, fn in found) == \
+        dict((name % i, len(file_data(dirname, i))) for i in range(count))
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('fs_btrfs')
+@pytest.mark.buildconfigspec('cmd_fs_generic')
+@pytest.mark.requiredtool('mkfs.btrfs')
+def test_fs_btrfs_dirs(u_boot_console):
+    """Test that a directory which spans many leaves is listed in full, also
+    when its nodes come from the cache, and that its files can be read."""
+
+    cons = u_boot_console
+    path = make_image(cons)
+    addr = util.find_ram_base(cons)
+
+    cons.run_command('host bind 0 %s' % path)
+    try:
+        for dirname, (count, name) in dirs.items():
+            # The second listing finds the nodes in the cache
+            check_ls(cons, dirname)
+            check_ls(cons, dirname)
+
+            # Both ends and a spread of names between
+            for i in sorted(set([0, count - 1] +
+                                list(range(7, count, max(count // 50, 1))))):
+                fn = '/%s/%s' % (dirname, name % i)
+                data = file_data(dirname, i)
+                output = cons.run_command('load host 0 %x %s' % (addr, fn))
+                assert '%d bytes read' % len(data) in output
+                output = cons.run_command('md.b %x %x' % (addr, len(data)))
+                assert data.strip() in output
+
+            for fn in (name % count, 'missing'):
+                output = cons.run_command('load host 0 %x /%s/%s; echo rc=$?'
+                                          % (addr, dirname, fn))
+                assert 'Cannot lookup file' in output
+                assert 'rc=1' in output
+    finally:
+        cons.run_command('host bind 0')
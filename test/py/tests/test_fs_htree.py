@@ -0,0 +1,120 @@
+# SPDX-License-Identifier: GPL-2.0
+
+# Test looking up files in ext4 directories with a hash tree index.
+#
+# The images are made without mounting them: mkfs.ext4 copies in a
+# directory tree and e2fsck -D then builds an index for each directory.
+# One directory fits its leaf blocks under the root index, the other
+# needs a level of index blocks below the root. An image is made for each
+# directory hash, which is set with tune2fs.
+
+import os
+import os.path
+import shutil
+import pytest
+import u_boot_utils as util
+
+# Files in each directory, and the template of their names
+dirs = {
+    'small': (200, 'file-%04d'),
+    'big': (6000, 'entry-with-a-rather-long-name-%05d'),
+}
+
+# Index levels below the root which e2fsck builds for each directory
+dir_levels = {
+    'small': 0,
+    'big': 1,
+}
+
+def tool_is_in_path(tool):
+    for path in os.environ['PATH'].split(os.pathsep):
+        fn = os.path.join(path, tool)
+        if os.path.isfile(fn) and os.access(fn, os.X_OK):
+            return True
+    return False
+
+def file_data(dirname, i):
+    return '%s %d\n' % (dirname, i)
+
+def make_image(cons, hash_alg):
+    """Make an ext4 image with indexed directories, if not already done.
+
+    Args:
+        cons: A U-Boot console.
+        hash_alg: Directory hash, as accepted by tune2fs -E hash_alg=.
+
+    Returns:
+        The path of the image.
+    """
+    for tool in ('mkfs.ext4', 'tune2fs', 'e2fsck', 'debugfs'):
+        if not tool_is_in_path(tool):
+            pytest.skip('%s not found' % tool)
+
+    path = cons.config.persistent_data_dir + '/htree_%s.img' % hash_alg
+    with util.persistent_file_helper(cons.log, path):
+        if os.path.exists(path):
+            cons.log.action('Disk image file ' + path + ' already exists')
+            return path
+
+        cons.log.action('Generating ' + path)
+        src = cons.config.persistent_data_dir + '/htree_src'
+        if os.path.exists(src):
+            shutil.rmtree(src)
+        for dirname, (count, name) in dirs.items():
+            os.makedirs(os.path.join(src, dirname))
+            for i in range(count):
+                with open(os.path.join(src, dirname, name % i), 'w') as fh:
+                    fh.write(file_data(dirname, i))
+        try:
+            # Small blocks so that the big directory needs two levels
+            util.run_and_log(cons, ['mkfs.ext4', '-q', '-F', '-b', '1024',
+                                    '-d', src, path, '32M'])
+            util.run_and_log(cons, ['tune2fs', '-E', 'hash_alg=' + hash_alg,
+                                    path])
+            # e2fsck exits with 1 when it has changed the filesystem
+            util.run_and_log(cons, ['e2fsck', '-f', '-y', '-D', path],
+                             ignore_errors=True)
+            for dirname, levels in dir_levels.items():
+                output = util.run_and_log(cons, ['debugfs', '-R',
+                                                 'htree /' + dirname, path])
+                assert 'Indirect levels: %d' % levels in output
+        except Exception:
+            if os.path.exists(path):
+                os.unlink(path)
+            raise
+        finally:
+            shutil.rmtree(src)
+
+    return path
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('fs_ext4')
+@pytest.mark.buildconfigspec('cmd_fs_generic')
+@pytest.mark.parametrize('hash_alg', ['legacy', 'half_md4', 'tea'])
+def test_fs_htree(u_boot_console, hash_alg):
+    """Test that files are found through the index of each directory, and
+    that names which are not there are reported as missing."""
+
+    cons = u_boot_console
+    path = make_image(cons, hash_alg)
+    addr = util.find_ram_base(cons)
+
+    cons.run_command('host bind 0 %s' % path)
+    try:
+        for dirname, (count, name) in dirs.items():
+            # Both ends and a spread of names between
+            for i in sorted(set([0, count - 1] +
+                                list(range(7, count, count // 20)))):
+                fn = '/%s/%s' % (dirname, name % i)
+                data = file_data(dirname, i)
+                output = cons.run_command('load host 0 %x %s' % (addr, fn))
+                assert '%d bytes read' % len(data) in output
+                output = cons.run_command('md.b %x %x' % (addr, len(data)))
+                assert data.strip() in output
+
+            for fn in (name % count, name % 99999, 'missing'):
+                output = cons.run_command('load host 0 %x /%s/%s' %
+                                          (addr, dirname, fn))
+                assert 'File not found' in output
+    finally:
+        cons.run_command('host bind 0')
@@ -174,3 +174,34 @@ def test_gpt_write(state_disk_image, u_boot_console):
     assert '0x00001000	0x00001bff	"second"' in output
     output = u_boot_console.run_command('gpt guid host 0')
     assert '375a56f7-d6c9-4e81-b5f0-09d41ca89efe' in output
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_gpt')
+@pytest.mark.buildconfigspec('cmd_gpt_rename')
+@pytest.mark.buildconfigspec('cmd_part')
+@pytest.mark.buildconfigspec('partition_cache')
+@pytest.mark.requiredtool('sgdisk')
+def test_gpt_part_cache(state_disk_image, u_boot_console):
+    """Test partition lookups through the partition cache."""
+
+    u_boot_console.run_command('host bind 0 ' + state_disk_image.path)
+    output = u_boot_console.run_command('part cache host 0')
+    assert 'hits: 0' in output
+    u_boot_console.run_command('part uuid host 0:1 uuid1')
+    output = u_boot_console.run_command('part number host 0 ${uuid1}')
+    assert output == '1'
+    output = u_boot_console.run_command('part start host 0 2')
+    assert output == '1000'
+    output = u_boot_console.run_command('part start host 0 2')
+    assert output == '1000'
+    output = u_boot_console.run_command('part cache host 0')
+    assert 'hits: 0' not in output
+    assert 'invalidations: 0' in output
+    assert 'entries: 2' in output
+
+    # Writing the table must drop the cache
+    u_boot_console.run_command('gpt rename host 0 1 cached')
+    output = u_boot_console.run_command('part cache host 0')
+    assert 'invalidations: 0' not in output
+    output = u_boot_console.run_command('part number host 0 cached')
+    assert output == '1'
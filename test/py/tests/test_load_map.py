@@ -0,0 +1,181 @@
+# SPDX-License-Identifier: GPL-2.0
+
+# Test the map of loaded images kept with CONFIG_LMB_LOAD_MAP.
+#
+# Loads which would overwrite U-Boot must be refused, 'load ... auto' must
+# place each file in free memory, and the device tree relocated by bootm
+# must be recorded at its sandbox address, so that a later load over it
+# is reported.
+
+import os
+import re
+import zlib
+import pytest
+import u_boot_utils as util
+
+# A FIT with a kernel and a device tree, which bootm relocates
+fit_its = '''
+/dts-v1/;
+
+/ {
+        description = "Kernel and FDT for the load map test";
+        #address-cells = <1>;
+
+        images {
+                kernel {
+                        data = /incbin/("%(kernel)s");
+                        type = "kernel";
+                        arch = "sandbox";
+                        os = "linux";
+                        compression = "none";
+                        load = <0x100000>;
+                        entry = <0x100000>;
+                };
+                fdt {
+                        data = /incbin/("%(fdt)s");
+                        type = "flat_dt";
+                        arch = "sandbox";
+                        compression = "none";
+                };
+        };
+        configurations {
+                default = "conf";
+                conf {
+                        kernel = "kernel";
+                        fdt = "fdt";
+                };
+        };
+};
+'''
+
+fdt_source = '''
+/dts-v1/;
+
+/ {
+        #address-cells = <1>;
+        #size-cells = <0>;
+        model = "Load map test";
+};
+'''
+
+# Alignment of images placed by 'load ... auto'
+auto_align = 0x200000
+
+# bootm places the device tree at the top of the boot map, which must fit
+# in sandbox's RAM
+bootm_size = 0x4000000
+fit_addr = 0x1000000
+
+def make_file(cons, leaf, size):
+    """Make a file of random data in the build directory
+
+    Args:
+        cons: U-Boot console
+        leaf: Leaf name of the file
+        size: Size of the file in bytes
+    Return:
+        Tuple: filename, CRC32 of the data
+    """
+    fname = os.path.join(cons.config.build_dir, leaf)
+    data = os.urandom(size)
+    with open(fname, 'wb') as fd:
+        fd.write(data)
+    return fname, zlib.crc32(data) & 0xffffffff
+
+def get_env_hex(cons, name):
+    output = cons.run_command('echo $%s' % name)
+    return int(output.strip(), 16)
+
+def load_ok(cons, cmd):
+    output = cons.run_command(cmd + '; echo rc=$?')
+    assert 'rc=0' in output, output
+    return output
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('lmb_load_map')
+def test_load_map_reserved(u_boot_console):
+    """Test that a load over U-Boot is refused and leaves memory alone"""
+    cons = u_boot_console
+    fname, crc = make_file(cons, 'load-map-small.bin', 0x1000)
+
+    output = cons.run_command('bdinfo')
+    ram_size = int(re.search(r'-> size\s*= (0x[0-9a-f]+)', output).group(1),
+                   16)
+    top = ram_size - 0x1000
+
+    cons.run_command('mw.b %x 55 1000' % top)
+    output = cons.run_command('load hostfs - %x %s; echo rc=$?' %
+                              (top, fname))
+    assert 'would overwrite reserved memory' in output
+    assert 'rc=1' in output
+    output = cons.run_command('crc32 %x 1000' % top)
+    assert ('%08x' % (zlib.crc32(b'\x55' * 0x1000) & 0xffffffff)) in output
+
+    # The same file can be loaded into free memory
+    load_ok(cons, 'load hostfs - %x %s' % (fit_addr, fname))
+    output = cons.run_command('crc32 %x 1000' % fit_addr)
+    assert ('%08x' % crc) in output
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('lmb_load_map')
+def test_load_map_auto(u_boot_console):
+    """Test that 'load ... auto' places files in free, aligned memory"""
+    cons = u_boot_console
+    files = [make_file(cons, 'load-map-%d.bin' % i, size)
+             for i, size in enumerate([0x300000, 0x1000, 0x12345])]
+
+    placed = []
+    for fname, crc in files:
+        load_ok(cons, 'load hostfs - auto %s' % fname)
+        addr = get_env_hex(cons, 'fileaddr')
+        size = get_env_hex(cons, 'filesize')
+        assert addr % auto_align == 0
+        assert size == os.path.getsize(fname)
+        for other, other_size in placed:
+            assert addr + size <= other or other + other_size <= addr
+        placed.append((addr, size))
+
+    # Each file is still intact once all of them are loaded
+    for (fname, crc), (addr, size) in zip(files, placed):
+        output = cons.run_command('crc32 %x %x' % (addr, size))
+        assert ('%08x' % crc) in output
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('lmb_load_map')
+@pytest.mark.buildconfigspec('fit')
+@pytest.mark.requiredtool('dtc')
+def test_load_map_bootm_fdt(u_boot_console):
+    """Test that the device tree relocated by bootm is recorded"""
+    cons = u_boot_console
+    kernel, _ = make_file(cons, 'load-map-kernel.bin', 0x1000)
+    src = os.path.join(cons.config.build_dir, 'load-map.dts')
+    fdt = os.path.join(cons.config.build_dir, 'load-map.dtb')
+    its = os.path.join(cons.config.build_dir, 'load-map.its')
+    fit = os.path.join(cons.config.build_dir, 'load-map.fit')
+    small, _ = make_file(cons, 'load-map-small.bin', 0x1000)
+
+    with open(src, 'w') as fd:
+        fd.write(fdt_source)
+    util.run_and_log(cons, ['dtc', src, '-O', 'dtb', '-o', fdt])
+    with open(its, 'w') as fd:
+        fd.write(fit_its % {'kernel': kernel, 'fdt': fdt})
+    mkimage = os.path.join(cons.config.build_dir, 'tools', 'mkimage')
+    util.run_and_log(cons, [mkimage, '-f', its, fit])
+
+    load_ok(cons, 'load hostfs - %x %s' % (fit_addr, fit))
+    old_size = cons.run_command('echo $bootm_size').strip()
+    cons.run_command('setenv bootm_size %x' % bootm_size)
+    load_ok(cons, 'bootm start %x' % fit_addr)
+    load_ok(cons, 'bootm loados')
+    output = load_ok(cons, 'bootm fdt')
+    assert 'Loading Device Tree' in output
+
+    # fdtaddr is the sandbox address of the copy, inside the boot map
+    fdt_addr = get_env_hex(cons, 'fdtaddr')
+    assert fdt_addr < bootm_size
+    output = cons.run_command('fdt header')
+    assert 'magic:\t\t\t0xd00dfeed' in output
+
+    output = load_ok(cons, 'load hostfs - %x %s' % (fdt_addr + 0x100, small))
+    assert 'overwrites fdt at 0x%x' % fdt_addr in output
+    cons.run_command('setenv bootm_size %s' % old_size)
@@ -87,6 +87,12 @@ def test_log(u_boot_console):
         lines = run_test(9)
         check_log_entries(lines, 3)
 
+    def test10():
+        lines = run_test(10)
+        dump = list(lines)
+        assert dump[-2].endswith('<6> ring -3 str 1234 z   ab|7   |123456789abc % <NULL>')
+        assert dump[-1].endswith('<6> ring    5|')
+
     # TODO(sjg@chromium.org): Consider structuring this as separate tests
     cons = u_boot_console
     test0()
@@ -99,3 +105,5 @@ def test_log(u_boot_console):
     test7()
     test8()
     test9()
+    if u_boot_console.config.buildconfig.get('config_log_ring'):
+        test10()
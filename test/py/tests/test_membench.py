@@ -0,0 +1,69 @@
+# SPDX-License-Identifier: GPL-2.0
+
+# Test the membench command, and keep its results in membench.csv in the
+# result directory so that they can be compared between runs.
+
+import os.path
+import pytest
+import u_boot_utils
+
+"""
+Note: The following boardenv_* setting is optional, to benchmark a larger
+region than the default one at the start of RAM, which must not hold U-Boot.
+
+# Address and size of the region to benchmark
+env__membench_region = (0x90000000, 0x4000000)
+"""
+
+@pytest.mark.buildconfigspec('cmd_membench')
+def test_membench(u_boot_console):
+    """Test that membench runs each test over each working set and offset
+    which fit the region, and prints one CSV row for each."""
+
+    cons = u_boot_console
+    ram_base = u_boot_utils.find_ram_base(cons)
+    output = cons.run_command('membench -s 1000 -o 0,3 %x 4000' % ram_base)
+    lines = output.replace('\r', '').splitlines()
+    assert lines[0] == ('test,cache,size,offset,reps,us,mb_per_s,' +
+                        'ns_per_access')
+
+    rows = [line.split(',') for line in lines[1:]]
+    expected = []
+    for test in ('read', 'write', 'copy', 'chase'):
+        for size in (0x1000, 0x2000, 0x4000):
+            for offset in (0, 3):
+                # Copy writes a second working set after the first
+                used = size * 2 if test == 'copy' else size
+                if used + offset <= 0x4000:
+                    expected.append((test, size, offset))
+    assert [(r[0], int(r[2]), int(r[3])) for r in rows] == expected
+
+    for row in rows:
+        assert row[1] == '-'
+        assert int(row[4]) > 0
+        # Chase measures latency only
+        if row[0] == 'chase':
+            assert row[6] == ''
+        else:
+            assert float(row[6]) > 0
+        assert float(row[7]) > 0
+
+@pytest.mark.buildconfigspec('cmd_membench')
+def test_membench_results(u_boot_console):
+    """Benchmark a larger region and save the results."""
+
+    cons = u_boot_console
+    region = cons.config.env.get('env__membench_region', None)
+    if region:
+        addr, size = region
+    else:
+        addr, size = u_boot_utils.find_ram_base(cons), 0x1000000
+    with cons.temporary_timeout(600000):
+        output = cons.run_command('membench %x %x' % (addr, size))
+    lines = output.replace('\r', '').splitlines()
+    assert lines[0].startswith('test,')
+    assert len(lines) > 1
+
+    fname = os.path.join(cons.config.result_dir, 'membench.csv')
+    with open(fname, 'w') as fd:
+        fd.write('\n'.join(lines) + '\n')
@@ -0,0 +1,57 @@
+# SPDX-License-Identifier: GPL-2.0
+
+# Test the sampling profiler and the layout of the samples it saves, which
+# is described in doc/README.trace.
+
+import re
+import pytest
+import u_boot_utils
+
+# Chunk type of the samples, from enum trace_chunk_type
+TRACE_CHUNK_SAMPLES = 2
+
+def read_words(cons, addr, count):
+    """Read 32-bit words from memory with md.l."""
+
+    words = []
+    output = cons.run_command('md.l %x %x' % (addr, count))
+    for line in output.replace('\r', '').splitlines():
+        # Drop the address and the ASCII column
+        hex_part = line.split(':', 1)[1].split('    ')[0]
+        words += [int(w, 16) for w in hex_part.split()]
+    return words[:count]
+
+@pytest.mark.buildconfigspec('cmd_profile')
+def test_profile(u_boot_console):
+    """Test that samples are taken while a command runs, and that the saved
+    chunk holds a header followed by one record per sample."""
+
+    cons = u_boot_console
+    ram_base = u_boot_utils.find_ram_base(cons)
+    save_addr = ram_base + 0x1000000
+
+    cons.run_command('profile start 1000')
+    for i in range(4):
+        cons.run_command('crc32 %x 1000000' % ram_base)
+    cons.run_command('profile stop')
+    output = cons.run_command('profile stats')
+    samples = int(re.search(r'(\d+) samples', output).group(1))
+    assert samples > 0
+
+    output = cons.run_command('profile save %x 100000' % save_addr)
+    size = int(re.search(r'size (0x[0-9a-f]+)', output).group(1), 16)
+    words = read_words(cons, save_addr, size // 4)
+
+    # Header: chunk type and sample count
+    assert words[0] == TRACE_CHUNK_SAMPLES
+    assert words[1] == samples
+
+    # Each record is a depth followed by that many code offsets, and the
+    # records fill the rest of the chunk. The depth is at most
+    # PROFILER_MAX_DEPTH
+    pos = 2
+    for i in range(samples):
+        depth = words[pos]
+        assert 0 < depth <= 32
+        pos += 1 + depth
+    assert pos == len(words)
@@ -22,7 +22,8 @@ For configuration verification:
 - Corrupt the signature
 - Check that image verification no-longer works
 
-Tests run with both SHA1 and SHA256 hashing.
+Tests run with both SHA1 and SHA256 hashing, and again with mkimage hashing
+and signing on a pool of threads.
 """
 
 import pytest
@@ -35,7 +36,8 @@ import u_boot_utils as util
 @pytest.mark.requiredtool('fdtget')
 @pytest.mark.requiredtool('fdtput')
 @pytest.mark.requiredtool('openssl')
-def test_vboot(u_boot_console):
+@pytest.mark.parametrize('jobs', [None, 4])
+def test_vboot(u_boot_console, jobs):
     """Test verified boot signing with mkimage and verification with 'bootm'.
 
     This works using sandbox only as it needs to update the device tree used
@@ -43,6 +45,9 @@ def test_vboot(u_boot_console):
 
     The SHA1 and SHA256 tests are combined into a single test since the
     key-generation process is quite slow and we want to avoid doing it twice.
+
+    Args:
+        jobs: Number of threads for mkimage -j, or None to run it without.
     """
     def dtc(dts):
         """Run the device tree compiler to compile a .dts file
@@ -89,7 +94,7 @@ def test_vboot(u_boot_console):
         Args:
             its: Filename containing .its source.
         """
-        util.run_and_log(cons, [mkimage, '-D', dtc_args, '-f',
+        util.run_and_log(cons, [mkimage] + jobs_args + ['-D', dtc_args, '-f',
                                 '%s%s' % (datadir, its), fit])
 
     def sign_fit(sha_algo):
@@ -103,8 +108,8 @@ def test_vboot(u_boot_console):
                     use.
         """
         cons.log.action('%s: Sign images' % sha_algo)
-        util.run_and_log(cons, [mkimage, '-F', '-k', tmpdir, '-K', dtb,
-                                '-r', fit])
+        util.run_and_log(cons, [mkimage] + jobs_args + ['-F', '-k', tmpdir,
+                                '-K', dtb, '-r', fit])
 
     def test_with_algo(sha_algo):
         """Test verified boot with the given hash algorithm.
@@ -169,6 +174,7 @@ def test_vboot(u_boot_console):
     datadir = cons.config.source_dir + '/test/py/tests/vboot/'
     fit = '%stest.fit' % tmpdir
     mkimage = cons.config.build_dir + '/tools/mkimage'
+    jobs_args = ['-j', str(jobs)] if jobs else []
     fit_check_sign = cons.config.build_dir + '/tools/fit_check_sign'
     dtc_args = '-I dts -O dtb -i %s' % tmpdir
     dtb = '%ssandbox-u-boot.dtb' % tmpdir
@@ -22,6 +22,8 @@
 #include <version.h>
 #include <u-boot/crc.h>
 
+#define ALIGN(x, a)	(((x) + (a) - 1) & ~((a) - 1))
+
 static image_header_t header;
 
 static int fit_add_file_data(struct image_tool_params *params, size_t size_inc,
@@ -57,10 +59,12 @@ static int fit_add_file_data(struct image_tool_params *params, size_t size_inc,
 	}
 
 	if (!ret) {
+		int jobs = params->jobs ? params->jobs : 1;
+
 		ret = fit_add_verification_data(params->keydir, dest_blob, ptr,
 						params->comment,
 						params->require_keys,
-						params->engine_id);
+						params->engine_id, jobs);
 	}
 
 	if (dest_blob) {
@@ -406,7 +410,8 @@ static int fit_extract_data(struct image_tool_params *params, const char *fname)
 {
 	void *buf;
 	int buf_ptr;
-	int fit_size, new_size;
+	int new_size;
+	int align_size;
 	int fd;
 	struct stat sbuf;
 	void *fdt;
@@ -414,17 +419,23 @@ static int fit_extract_data(struct image_tool_params *params, const char *fname)
 	int images;
 	int node;
 
+	/*
+	 * Each image, and the data as a whole, starts on a block boundary if
+	 * a block size is given, so it can be read straight from storage
+	 */
+	align_size = params->bl_len ? params->bl_len : 4;
+	if (params->external_offset % align_size) {
+		fprintf(stderr, "%s: External offset %x is not aligned to %x\n",
+			params->cmdname, params->external_offset, align_size);
+		return -EINVAL;
+	}
+
 	fd = mmap_fdt(params->cmdname, fname, 0, &fdt, &sbuf, false);
 	if (fd < 0)
 		return -EIO;
-	fit_size = fdt_totalsize(fdt);
 
-	/* Allocate space to hold the image data we will extract */
-	buf = malloc(fit_size);
-	if (!buf) {
-		ret = -ENOMEM;
-		goto err_munmap;
-	}
+	/* Space to hold the image data we extract grows as we go */
+	buf = NULL;
 	buf_ptr = 0;
 
 	images = fdt_path_offset(fdt, FIT_IMAGES_PATH);
@@ -440,10 +451,19 @@ static int fit_extract_data(struct image_tool_params *params, const char *fname)
 		const char *data;
 		int len;
 
+		void *new_buf;
+
 		data = fdt_getprop(fdt, node, "data", &len);
 		if (!data)
 			continue;
+		new_buf = realloc(buf, buf_ptr + ALIGN(len, align_size));
+		if (!new_buf) {
+			ret = -ENOMEM;
+			goto err_munmap;
+		}
+		buf = new_buf;
 		memcpy(buf + buf_ptr, data, len);
+		memset(buf + buf_ptr + len, '\0', ALIGN(len, align_size) - len);
 		debug("Extracting data size %x\n", len);
 
 		ret = fdt_delprop(fdt, node, "data");
@@ -460,16 +480,20 @@ static int fit_extract_data(struct image_tool_params *params, const char *fname)
 		}
 		fdt_setprop_u32(fdt, node, "data-size", len);
 
-		buf_ptr += (len + 3) & ~3;
+		buf_ptr += ALIGN(len, align_size);
 	}
 
-	/* Pack the FDT and place the data after it */
+	/*
+	 * Pack the FDT and place the data after it. The FDT takes up all the
+	 * space before the data, since data-offset counts from its end.
+	 */
 	fdt_pack(fdt);
 
-	debug("Size reduced from %x to %x\n", fit_size, fdt_totalsize(fdt));
+	debug("Size reduced to %x\n", fdt_totalsize(fdt));
 	debug("External data size %x\n", buf_ptr);
 	new_size = fdt_totalsize(fdt);
-	new_size = (new_size + 3) & ~3;
+	new_size = ALIGN(new_size, align_size);
+	fdt_set_totalsize(fdt, new_size);
 	munmap(fdt, sbuf.st_size);
 
 	if (ftruncate(fd, new_size)) {
@@ -560,14 +584,31 @@ static int fit_import_data(struct image_tool_params *params, const char *fname)
 		int buf_ptr;
 		int len;
 
-		buf_ptr = fdtdec_get_int(fdt, node, "data-offset", -1);
+		buf_ptr = fdtdec_get_int(fdt, node, "data-position", -1);
+		if (buf_ptr == -1) {
+			buf_ptr = fdtdec_get_int(fdt, node, "data-offset", -1);
+			if (buf_ptr != -1)
+				buf_ptr += data_base;
+		}
 		len = fdtdec_get_int(fdt, node, "data-size", -1);
 		if (buf_ptr == -1 || len == -1)
 			continue;
+		if (buf_ptr + len > sbuf.st_size) {
+			fprintf(stderr,
+				"%s: Image data is past the end of %s\n",
+				params->cmdname, fname);
+			ret = -EINVAL;
+			goto err_has_fd;
+		}
 		debug("Importing data size %x\n", len);
 
-		ret = fdt_setprop(fdt, node, "data", fdt + data_base + buf_ptr,
-				  len);
+		ret = fdt_setprop(fdt, node, "data", old_fdt + buf_ptr, len);
+		if (!ret)
+			ret = fdt_delprop(fdt, node, "data-size");
+		if (!ret && fdt_getprop(fdt, node, "data-position", NULL))
+			ret = fdt_delprop(fdt, node, "data-position");
+		if (!ret && fdt_getprop(fdt, node, "data-offset", NULL))
+			ret = fdt_delprop(fdt, node, "data-offset");
 		if (ret) {
 			debug("%s: Failed to write property: %s\n", __func__,
 			      fdt_strerror(ret));
@@ -673,17 +714,19 @@ static int fit_handle_file(struct image_tool_params *params)
 	 * Set hashes for images in the blob. Unfortunately we may need more
 	 * space in either FDT, so keep trying until we succeed.
 	 *
-	 * Note: this is pretty inefficient for signing, since we must
-	 * calculate the signature every time. It would be better to calculate
-	 * all the data and then store it in a separate step. However, this
-	 * would be considerably more complex to implement. Generally a few
-	 * steps of this loop is enough to sign with several keys.
+	 * Hashes and signatures of images are calculated once and kept from
+	 * one attempt to the next, but configurations must be signed again
+	 * each time. Generally a few steps of this loop is enough to sign
+	 * with several keys.
 	 */
 	for (size_inc = 0; size_inc < 64 * 1024; size_inc += 1024) {
 		ret = fit_add_file_data(params, size_inc, tmpfile);
 		if (!ret || ret != -ENOSPC)
 			break;
 	}
+	if (!ret && params->jobs && !params->quiet)
+		fit_print_verification_summary();
+	fit_free_verification_data();
 
 	if (ret) {
 		fprintf(stderr, "%s Can't add hashes to FIT blob: %d\n",
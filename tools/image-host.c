@@ -13,6 +13,306 @@
 #include <bootm.h>
 #include <image.h>
 #include <version.h>
+#include <pthread.h>
+
+/*
+ * Hashes and signatures are calculated up front, all at once on a pool of
+ * threads, then written into the FIT one by one. The FIT is written again
+ * each time it turns out to need more space; the data of its images does
+ * not change from one attempt to the next, so their hashes and signatures
+ * are kept, while configurations, which cover the hashes written, are
+ * signed again.
+ */
+
+/**
+ * struct fit_job - A hash or signature to calculate
+ *
+ * @path:		Path of the hash or signature node
+ * @info:		Algorithm, and for signatures what to sign with
+ * @region:		Data to hash or sign, NULL if there is none yet
+ * @region_count:	Number of regions in @region
+ * @region_prop:	Nodes hashed, for configurations
+ * @region_proplen:	Length of @region_prop
+ * @string_size:	Size of the strings hashed, for configurations
+ * @size:		Number of bytes hashed
+ * @value:		Hash or signature calculated
+ * @value_len:		Length of @value
+ * @ret:		0 if @value was calculated, else -ve error
+ * @done:		true once the job has run
+ * @usecs:		Time taken to run the job
+ */
+struct fit_job {
+	char *path;
+	struct image_sign_info info;
+	struct image_region *region;
+	int region_count;
+	char *region_prop;
+	int region_proplen;
+	int string_size;
+	size_t size;
+	uint8_t *value;
+	uint value_len;
+	int ret;
+	bool done;
+	uint64_t usecs;
+};
+
+static struct {
+	struct fit_job *job;
+	int count;
+	int threads;		/* Most threads used to run jobs */
+	uint64_t usecs[2];	/* Time taken by image and config jobs */
+	pthread_mutex_t lock;
+} fit_jobs = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static uint64_t fit_time_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static struct fit_job *fit_find_job(const void *fit, int noffset)
+{
+	char path[200];
+	int i;
+
+	if (fdt_get_path(fit, noffset, path, sizeof(path)))
+		return NULL;
+
+	for (i = 0; i < fit_jobs.count; i++) {
+		if (!strcmp(fit_jobs.job[i].path, path))
+			return &fit_jobs.job[i];
+	}
+
+	return NULL;
+}
+
+/* Drop the data and result of a job, so it can be queued again */
+static void fit_job_reset(struct fit_job *job)
+{
+	free(job->region);
+	free(job->region_prop);
+	free(job->value);
+	job->region = NULL;
+	job->region_prop = NULL;
+	job->value = NULL;
+	job->done = false;
+}
+
+static struct fit_job *fit_add_job(const void *fit, int noffset,
+				   const char *algo)
+{
+	struct fit_job *job;
+	char path[200];
+
+	job = fit_find_job(fit, noffset);
+	if (job) {
+		fit_job_reset(job);
+		return job;
+	}
+
+	if (fdt_get_path(fit, noffset, path, sizeof(path)))
+		return NULL;
+
+	job = realloc(fit_jobs.job, (fit_jobs.count + 1) * sizeof(*job));
+	if (!job)
+		return NULL;
+	fit_jobs.job = job;
+
+	job += fit_jobs.count;
+	memset(job, '\0', sizeof(*job));
+	job->path = strdup(path);
+	job->info.name = strdup(algo);
+	if (!job->path || !job->info.name) {
+		free(job->path);
+		free((char *)job->info.name);
+		return NULL;
+	}
+	fit_jobs.count++;
+
+	return job;
+}
+
+/*
+ * Set up a job to sign with the key named in a signature node. Problems are
+ * reported when the node is processed, so here they just leave the node
+ * without a job.
+ */
+static struct fit_job *fit_add_sig_job(const char *keydir, const void *fit,
+		int noffset, const char *require_keys, const char *engine_id)
+{
+	struct checksum_algo *checksum;
+	struct crypto_algo *crypto;
+	const char *keyname;
+	struct fit_job *job;
+	char *algo;
+
+	if (fit_image_hash_get_algo(fit, noffset, &algo))
+		return NULL;
+	checksum = image_get_checksum_algo(algo);
+	crypto = image_get_crypto_algo(algo);
+	if (!checksum || !crypto)
+		return NULL;
+
+	job = fit_add_job(fit, noffset, algo);
+	if (!job)
+		return NULL;
+
+	/* The FIT may be mapped elsewhere by the time the job runs */
+	keyname = fdt_getprop(fit, noffset, "key-name-hint", NULL);
+	if (keyname && !job->info.keyname)
+		job->info.keyname = strdup(keyname);
+	job->info.keydir = keydir;
+	job->info.checksum = checksum;
+	job->info.crypto = crypto;
+	job->info.require_keys = require_keys;
+	job->info.engine_id = engine_id;
+
+	return job;
+}
+
+static void fit_job_run(struct fit_job *job)
+{
+	uint64_t start = fit_time_us();
+	int value_len;
+
+	if (job->info.crypto) {
+		job->ret = job->info.crypto->sign(&job->info, job->region,
+						  job->region_count,
+						  &job->value,
+						  &job->value_len);
+	} else {
+		job->value = malloc(FIT_MAX_HASH_LEN);
+		if (!job->value) {
+			job->ret = -ENOMEM;
+		} else {
+			job->ret = calculate_hash(job->region->data,
+						  job->region->size,
+						  job->info.name, job->value,
+						  &value_len);
+			job->value_len = value_len;
+		}
+	}
+	job->usecs = fit_time_us() - start;
+}
+
+static void *fit_job_worker(void *arg)
+{
+	struct fit_job *job;
+	int i;
+
+	for (;;) {
+		job = NULL;
+		pthread_mutex_lock(&fit_jobs.lock);
+		for (i = 0; i < fit_jobs.count; i++) {
+			if (fit_jobs.job[i].region && !fit_jobs.job[i].done) {
+				job = &fit_jobs.job[i];
+				job->done = true;
+				break;
+			}
+		}
+		pthread_mutex_unlock(&fit_jobs.lock);
+		if (!job)
+			return NULL;
+		fit_job_run(job);
+	}
+}
+
+/**
+ * fit_run_jobs() - Run the queued jobs
+ *
+ * @max_threads:	Number of threads to run them on, at most
+ * @conf:		true if these are the jobs for configurations
+ */
+static void fit_run_jobs(int max_threads, bool conf)
+{
+	pthread_t *threads;
+	int pending = 0;
+	uint64_t start;
+	int i;
+
+	for (i = 0; i < fit_jobs.count; i++) {
+		if (fit_jobs.job[i].region && !fit_jobs.job[i].done)
+			pending++;
+	}
+	if (!pending)
+		return;
+
+	if (max_threads > pending)
+		max_threads = pending;
+	threads = calloc(max_threads, sizeof(*threads));
+	if (!threads)
+		max_threads = 1;
+
+	/* This thread is one of the workers; any that fail to start are not */
+	start = fit_time_us();
+	for (i = 1; i < max_threads; i++) {
+		if (pthread_create(&threads[i], NULL, fit_job_worker, NULL))
+			break;
+	}
+	fit_job_worker(NULL);
+	max_threads = i;
+	while (--i > 0)
+		pthread_join(threads[i], NULL);
+	free(threads);
+
+	fit_jobs.usecs[conf] = fit_time_us() - start;
+	if (max_threads > fit_jobs.threads)
+		fit_jobs.threads = max_threads;
+}
+
+/* Queue the hashes and signatures of the image nodes that do not have one */
+static void fit_image_add_jobs(const char *keydir, void *fit,
+		int images_noffset, int require_keys, const char *engine_id)
+{
+	int image_noffset, noffset;
+	struct fit_job *job;
+	const void *data;
+	size_t size;
+	char *algo;
+
+	fdt_for_each_subnode(image_noffset, fit, images_noffset) {
+		if (fit_image_get_data(fit, image_noffset, &data, &size))
+			continue;
+
+		fdt_for_each_subnode(noffset, fit, image_noffset) {
+			const char *node_name = fit_get_name(fit, noffset,
+							     NULL);
+
+			if (fit_find_job(fit, noffset))
+				continue;
+
+			job = NULL;
+			if (!strncmp(node_name, FIT_HASH_NODENAME,
+				     strlen(FIT_HASH_NODENAME))) {
+				if (!fit_image_hash_get_algo(fit, noffset,
+							     &algo))
+					job = fit_add_job(fit, noffset, algo);
+			} else if (IMAGE_ENABLE_SIGN && keydir &&
+				   !strncmp(node_name, FIT_SIG_NODENAME,
+					    strlen(FIT_SIG_NODENAME))) {
+				job = fit_add_sig_job(keydir, fit, noffset,
+						require_keys ? "image" : NULL,
+						engine_id);
+			}
+			if (!job)
+				continue;
+
+			job->region = calloc(1, sizeof(*job->region));
+			if (!job->region)
+				continue;
+			job->region->data = data;
+			job->region->size = size;
+			job->region_count = 1;
+			job->size = size;
+		}
+	}
+}
 
 /**
  * fit_set_hash_value - set hash value in requested has node
@@ -62,12 +362,22 @@ static int fit_image_process_hash(void *fit, const char *image_name,
 {
 	uint8_t value[FIT_MAX_HASH_LEN];
 	const char *node_name;
+	struct fit_job *job;
+	uint8_t *valuep;
 	int value_len;
 	char *algo;
 	int ret;
 
 	node_name = fit_get_name(fit, noffset, NULL);
 
+	/* Use the hash calculated by the job pool, if there is one */
+	job = fit_find_job(fit, noffset);
+	if (job && job->done && !job->ret) {
+		valuep = job->value;
+		value_len = job->value_len;
+		goto set;
+	}
+
 	if (fit_image_hash_get_algo(fit, noffset, &algo)) {
 		printf("Can't get hash algo property for '%s' hash node in '%s' image node\n",
 		       node_name, image_name);
@@ -79,8 +389,10 @@ static int fit_image_process_hash(void *fit, const char *image_name,
 		       algo, node_name, image_name);
 		return -EPROTONOSUPPORT;
 	}
+	valuep = value;
 
-	ret = fit_set_hash_value(fit, noffset, value, value_len);
+set:
+	ret = fit_set_hash_value(fit, noffset, valuep, value_len);
 	if (ret) {
 		printf("Can't set hash value for '%s' hash node in '%s' image node\n",
 		       node_name, image_name);
@@ -100,6 +412,9 @@ static int fit_image_process_hash(void *fit, const char *image_name,
  * @value: signature value to be set
  * @value_len: signature value length
  * @comment: Text comment to write (NULL for none)
+ * @region_prop: Nodes hashed (NULL for none)
+ * @region_proplen: Length of @region_prop
+ * @string_size: Size of the strings hashed, used with @region_prop
  *
  * returns
  *     0, on success
@@ -107,17 +422,10 @@ static int fit_image_process_hash(void *fit, const char *image_name,
  */
 static int fit_image_write_sig(void *fit, int noffset, uint8_t *value,
 		int value_len, const char *comment, const char *region_prop,
-		int region_proplen)
+		int region_proplen, int string_size)
 {
-	int string_size;
 	int ret;
 
-	/*
-	 * Get the current string size, before we update the FIT and add
-	 * more
-	 */
-	string_size = fdt_size_dt_strings(fit);
-
 	ret = fdt_setprop(fit, noffset, FIT_VALUE_PROP, value, value_len);
 	if (!ret) {
 		ret = fdt_setprop_string(fit, noffset, "signer-name",
@@ -206,6 +514,7 @@ static int fit_image_process_sig(const char *keydir, void *keydest,
 	struct image_sign_info info;
 	struct image_region region;
 	const char *node_name;
+	struct fit_job *job;
 	uint8_t *value;
 	uint value_len;
 	int ret;
@@ -215,9 +524,17 @@ static int fit_image_process_sig(const char *keydir, void *keydest,
 		return -1;
 
 	node_name = fit_get_name(fit, noffset, NULL);
-	region.data = data;
-	region.size = size;
-	ret = info.crypto->sign(&info, &region, 1, &value, &value_len);
+	job = fit_find_job(fit, noffset);
+	if (job && job->done) {
+		ret = job->ret;
+		value = job->value;
+		value_len = job->value_len;
+	} else {
+		region.data = data;
+		region.size = size;
+		ret = info.crypto->sign(&info, &region, 1, &value, &value_len);
+		job = NULL;
+	}
 	if (ret) {
 		printf("Failed to sign '%s' signature node in '%s' image node: %d\n",
 		       node_name, image_name, ret);
@@ -229,7 +546,9 @@ static int fit_image_process_sig(const char *keydir, void *keydest,
 	}
 
 	ret = fit_image_write_sig(fit, noffset, value, value_len, comment,
-			NULL, 0);
+			NULL, 0, 0);
+	if (!job)
+		free(value);
 	if (ret) {
 		if (ret == -FDT_ERR_NOSPACE)
 			return -ENOSPC;
@@ -237,7 +556,6 @@ static int fit_image_process_sig(const char *keydir, void *keydest,
 		       node_name, image_name, fdt_strerror(ret));
 		return -1;
 	}
-	free(value);
 
 	/* Get keyname again, as FDT has changed and invalidated our pointer */
 	info.keyname = fdt_getprop(fit, noffset, "key-name-hint", NULL);
@@ -571,6 +889,85 @@ static int fit_config_get_data(void *fit, int conf_noffset, int noffset,
 	return 0;
 }
 
+/* Queue the signatures of all configurations, replacing any from before */
+static void fit_config_add_jobs(const char *keydir, void *fit,
+		int confs_noffset, int require_keys, const char *engine_id)
+{
+	int conf_noffset, noffset, i;
+	struct fit_job *job;
+
+	fdt_for_each_subnode(conf_noffset, fit, confs_noffset) {
+		fdt_for_each_subnode(noffset, fit, conf_noffset) {
+			const char *node_name = fit_get_name(fit, noffset,
+							     NULL);
+
+			if (strncmp(node_name, FIT_SIG_NODENAME,
+				    strlen(FIT_SIG_NODENAME)))
+				continue;
+
+			job = fit_add_sig_job(keydir, fit, noffset,
+					      require_keys ? "conf" : NULL,
+					      engine_id);
+			if (!job)
+				continue;
+
+			job->string_size = fdt_size_dt_strings(fit);
+			if (fit_config_get_data(fit, conf_noffset, noffset,
+						&job->region,
+						&job->region_count,
+						&job->region_prop,
+						&job->region_proplen)) {
+				continue;
+			}
+			for (i = 0, job->size = 0; i < job->region_count; i++)
+				job->size += job->region[i].size;
+		}
+	}
+}
+
+void fit_print_verification_summary(void)
+{
+	uint64_t usecs = 0;
+	int i;
+
+	if (!fit_jobs.count)
+		return;
+
+	printf("%-44s %-16s %10s %9s\n", "Node", "Algo", "Bytes", "Seconds");
+	for (i = 0; i < fit_jobs.count; i++) {
+		struct fit_job *job = &fit_jobs.job[i];
+
+		if (!job->done)
+			continue;
+		printf("%-44s %-16s %10zu %9.3f\n", job->path, job->info.name,
+		       job->size, job->usecs / 1e6);
+		usecs += job->usecs;
+	}
+	printf("Total %.3f s on %d thread%s (%.3f s of work)\n",
+	       (fit_jobs.usecs[0] + fit_jobs.usecs[1]) / 1e6, fit_jobs.threads,
+	       fit_jobs.threads == 1 ? "" : "s", usecs / 1e6);
+}
+
+void fit_free_verification_data(void)
+{
+	int i;
+
+	for (i = 0; i < fit_jobs.count; i++) {
+		struct fit_job *job = &fit_jobs.job[i];
+
+		fit_job_reset(job);
+		free(job->path);
+		free((char *)job->info.name);
+		free((char *)job->info.keyname);
+	}
+	free(fit_jobs.job);
+	fit_jobs.job = NULL;
+	fit_jobs.count = 0;
+	fit_jobs.threads = 0;
+	fit_jobs.usecs[0] = 0;
+	fit_jobs.usecs[1] = 0;
+}
+
 static int fit_config_process_sig(const char *keydir, void *keydest,
 		void *fit, const char *conf_name, int conf_noffset,
 		int noffset, const char *comment, int require_keys,
@@ -582,22 +979,45 @@ static int fit_config_process_sig(const char *keydir, void *keydest,
 	char *region_prop;
 	int region_proplen;
 	int region_count;
+	int string_size;
+	struct fit_job *job;
 	uint8_t *value;
 	uint value_len;
 	int ret;
 
 	node_name = fit_get_name(fit, noffset, NULL);
-	if (fit_config_get_data(fit, conf_noffset, noffset, &region,
-				&region_count, &region_prop, &region_proplen))
-		return -1;
+	job = fit_find_job(fit, noffset);
+	if (job && job->done) {
+		region_prop = job->region_prop;
+		region_proplen = job->region_proplen;
+		string_size = job->string_size;
+	} else {
+		if (fit_config_get_data(fit, conf_noffset, noffset, &region,
+					&region_count, &region_prop,
+					&region_proplen))
+			return -1;
+
+		/*
+		 * Get the current string size, before we update the FIT and
+		 * add more
+		 */
+		string_size = fdt_size_dt_strings(fit);
+		job = NULL;
+	}
 
 	if (fit_image_setup_sig(&info, keydir, fit, conf_name, noffset,
 				require_keys ? "conf" : NULL, engine_id))
 		return -1;
 
-	ret = info.crypto->sign(&info, region, region_count, &value,
-				&value_len);
-	free(region);
+	if (job) {
+		ret = job->ret;
+		value = job->value;
+		value_len = job->value_len;
+	} else {
+		ret = info.crypto->sign(&info, region, region_count, &value,
+					&value_len);
+		free(region);
+	}
 	if (ret) {
 		printf("Failed to sign '%s' signature node in '%s' conf node\n",
 		       node_name, conf_name);
@@ -609,7 +1029,11 @@ static int fit_config_process_sig(const char *keydir, void *keydest,
 	}
 
 	ret = fit_image_write_sig(fit, noffset, value, value_len, comment,
-				region_prop, region_proplen);
+				region_prop, region_proplen, string_size);
+	if (!job) {
+		free(value);
+		free(region_prop);
+	}
 	if (ret) {
 		if (ret == -FDT_ERR_NOSPACE)
 			return -ENOSPC;
@@ -617,8 +1041,6 @@ static int fit_config_process_sig(const char *keydir, void *keydest,
 		       node_name, conf_name, fdt_strerror(ret));
 		return -1;
 	}
-	free(value);
-	free(region_prop);
 
 	/* Get keyname again, as FDT has changed and invalidated our pointer */
 	info.keyname = fdt_getprop(fit, noffset, "key-name-hint", NULL);
@@ -668,12 +1090,23 @@ static int fit_config_add_verification_data(const char *keydir, void *keydest,
 
 int fit_add_verification_data(const char *keydir, void *keydest, void *fit,
 			      const char *comment, int require_keys,
-			      const char *engine_id)
+			      const char *engine_id, int jobs)
 {
 	int images_noffset, confs_noffset;
 	int noffset;
 	int ret;
 
+	/*
+	 * Engines hold state of their own, as does OpenSSL before 1.1, so
+	 * only sign on one thread with them
+	 */
+#if IMAGE_ENABLE_SIGN && OPENSSL_VERSION_NUMBER < 0x10100000L
+	if (keydir)
+		jobs = 1;
+#endif
+	if (engine_id)
+		jobs = 1;
+
 	/* Find images parent node offset */
 	images_noffset = fdt_path_offset(fit, FIT_IMAGES_PATH);
 	if (images_noffset < 0) {
@@ -682,6 +1115,10 @@ int fit_add_verification_data(const char *keydir, void *keydest, void *fit,
 		return images_noffset;
 	}
 
+	fit_image_add_jobs(keydir, fit, images_noffset, require_keys,
+			   engine_id);
+	fit_run_jobs(jobs, false);
+
 	/* Process its subnodes, print out component images details */
 	for (noffset = fdt_first_subnode(fit, images_noffset);
 	     noffset >= 0;
@@ -708,6 +1145,10 @@ int fit_add_verification_data(const char *keydir, void *keydest, void *fit,
 		return -ENOENT;
 	}
 
+	fit_config_add_jobs(keydir, fit, confs_noffset, require_keys,
+			    engine_id);
+	fit_run_jobs(jobs, true);
+
 	/* Process its subnodes, print out component images details */
 	for (noffset = fdt_first_subnode(fit, confs_noffset);
 	     noffset >= 0;
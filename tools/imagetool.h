@@ -76,7 +76,9 @@ struct image_tool_params {
 	bool external_data;	/* Store data outside the FIT */
 	bool quiet;		/* Don't output text in normal operation */
 	unsigned int external_offset;	/* Add padding to external data */
+	unsigned int bl_len;	/* Block size to align external data to */
 	const char *engine_id;	/* Engine to use for signing */
+	int jobs;		/* Threads to hash on, 0 if not given */
 };
 
 /*
@@ -89,17 +89,20 @@ static void usage(const char *msg)
 		"          -x ==> set XIP (execute in place)\n",
 		params.cmdname);
 	fprintf(stderr,
-		"       %s [-D dtc_options] [-f fit-image.its|-f auto|-F] [-b <dtb> [-b <dtb>]] [-i <ramdisk.cpio.gz>] fit-image\n"
+		"       %s [-D dtc_options] [-f fit-image.its|-f auto|-F] [-b <dtb> [-b <dtb>]] [-i <ramdisk.cpio.gz>] [-j <jobs>] fit-image\n"
 		"           <dtb> file is used with -f auto, it may occur multiple times.\n",
 		params.cmdname);
 	fprintf(stderr,
 		"          -D => set all options for device tree compiler\n"
 		"          -f => input filename for FIT source\n"
-		"          -i => input filename for ramdisk file\n");
+		"          -i => input filename for ramdisk file\n"
+		"          -j => hash and sign on 'jobs' threads (0 for one per CPU)\n"
+		"                and show the time taken\n");
 #ifdef CONFIG_FIT_SIGNATURE
 	fprintf(stderr,
-		"Signing / verified boot options: [-E] [-k keydir] [-K dtb] [ -c <comment>] [-p addr] [-r] [-N engine]\n"
+		"Signing / verified boot options: [-E] [-B size] [-k keydir] [-K dtb] [ -c <comment>] [-p addr] [-r] [-N engine]\n"
 		"          -E => place data outside of the FIT structure\n"
+		"          -B => align external data to this block size (hex)\n"
 		"          -k => set directory containing private keys\n"
 		"          -K => write public keys to this .dtb file\n"
 		"          -c => add comment in signature node\n"
@@ -144,7 +147,7 @@ static void process_args(int argc, char **argv)
 	int opt;
 
 	while ((opt = getopt(argc, argv,
-			     "a:A:b:c:C:d:D:e:Ef:Fk:i:K:ln:N:p:O:rR:qsT:vVx")) != -1) {
+			     "a:A:b:B:c:C:d:D:e:Ef:Fj:k:i:K:ln:N:p:O:rR:qsT:vVx")) != -1) {
 		switch (opt) {
 		case 'a':
 			params.addr = strtoull(optarg, &ptr, 16);
@@ -161,6 +164,15 @@ static void process_args(int argc, char **argv)
 				usage("Invalid architecture");
 			}
 			break;
+		case 'B':
+			params.bl_len = strtoull(optarg, &ptr, 16);
+			if (*ptr || !params.bl_len ||
+			    (params.bl_len & (params.bl_len - 1))) {
+				fprintf(stderr, "%s: invalid block size %s\n",
+					params.cmdname, optarg);
+				exit(EXIT_FAILURE);
+			}
+			break;
 		case 'b':
 			if (add_content(IH_TYPE_FLATDT, optarg)) {
 				fprintf(stderr,
@@ -216,6 +228,18 @@ static void process_args(int argc, char **argv)
 		case 'k':
 			params.keydir = optarg;
 			break;
+		case 'j':
+			params.jobs = strtoul(optarg, &ptr, 0);
+			if (*ptr) {
+				fprintf(stderr, "%s: invalid job count %s\n",
+					params.cmdname, optarg);
+				exit(EXIT_FAILURE);
+			}
+			if (!params.jobs)
+				params.jobs = sysconf(_SC_NPROCESSORS_ONLN);
+			if (params.jobs < 1)
+				params.jobs = 1;
+			break;
 		case 'K':
 			params.keydest = optarg;
 			break;
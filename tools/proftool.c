@@ -32,6 +32,9 @@ struct func_info {
 	const char *name;
 	unsigned long code_size;
 	unsigned long call_count;
+	unsigned long self_samples;	/* samples taken in this function */
+	unsigned long total_samples;	/* samples with this function on stack */
+	int last_sample;		/* last sample counted in total_samples */
 	unsigned flags;
 	/* the section this function is in */
 	struct objsection_info *objsection;
@@ -56,6 +59,9 @@ struct func_info *func_list;
 int func_count;
 struct trace_call *call_list;
 int call_count;
+uint32_t *sample_list;	/* struct trace_sample records, back to back */
+int sample_words;	/* number of words in sample_list */
+int sample_count;	/* number of samples in sample_list */
 int verbose;	/* Verbosity level 0=none, 1=warn, 2=notice, 3=info, 4=debug */
 unsigned long text_offset;		/* text address of first function */
 
@@ -86,6 +92,8 @@ static void usage(void)
 		"\n"
 		"Commands\n"
 		"   dump-ftrace\t\tDump out textual data in ftrace format\n"
+		"   dump-folded\t\tDump samples as folded stacks (flame graph)\n"
+		"   dump-hist\t\tDump a histogram of samples by function\n"
 		"\n"
 		"Options:\n"
 		"   -m <map>\tSpecify Systen.map file\n"
@@ -227,6 +235,39 @@ static int read_calls(FILE *fin, int count)
 	return 0;
 }
 
+static int read_samples(FILE *fin, int count)
+{
+	uint32_t depth;
+	int alloced = 0;
+	int i;
+
+	notice("sample count: %d\n", count);
+	for (i = 0; i < count; i++) {
+		if (read_data(fin, &depth, sizeof(depth)))
+			return 1;
+		if (!depth || depth > 1024) {
+			error("Invalid sample depth %u\n", depth);
+			return 1;
+		}
+		if (sample_words + 1 + depth > alloced) {
+			alloced = (sample_words + 1 + depth) * 2;
+			sample_list = realloc(sample_list,
+					      alloced * sizeof(uint32_t));
+			if (!sample_list) {
+				error("Cannot allocate sample_list\n");
+				return -1;
+			}
+		}
+		sample_list[sample_words] = depth;
+		if (read_data(fin, &sample_list[sample_words + 1],
+			      depth * sizeof(uint32_t)))
+			return 1;
+		sample_words += 1 + depth;
+		sample_count++;
+	}
+	return 0;
+}
+
 static int read_profile(FILE *fin, int *not_found)
 {
 	struct trace_output_hdr hdr;
@@ -250,6 +291,11 @@ static int read_profile(FILE *fin, int *not_found)
 			if (read_calls(fin, hdr.rec_count))
 				return 1;
 			break;
+
+		case TRACE_CHUNK_SAMPLES:
+			if (read_samples(fin, hdr.rec_count))
+				return 1;
+			break;
 		}
 	}
 	return 0;
@@ -533,6 +579,204 @@ static int make_ftrace(void)
 	return 0;
 }
 
+/*
+ * This finds the function containing a byte offset from a sample. Return
+ * addresses may point just past the end of a call to a function which does
+ * not return, so these are looked up one byte earlier.
+ */
+static struct func_info *find_func_by_sample(uint32_t offset, int is_caller)
+{
+	int low, high;
+
+	if (is_caller && offset)
+		offset--;
+	low = 0;
+	high = func_count - 1;
+	if (high < 0 || offset < func_list[0].offset)
+		return NULL;
+	while (low < high) {
+		int mid = (low + high + 1) / 2;
+
+		if (func_list[mid].offset <= offset)
+			low = mid;
+		else
+			high = mid - 1;
+	}
+	if (func_list[low].code_size &&
+	    offset >= func_list[low].offset + func_list[low].code_size)
+		return NULL;
+
+	return &func_list[low];
+}
+
+static int h_cmp_str(const void *v1, const void *v2)
+{
+	return strcmp(*(char * const *)v1, *(char * const *)v2);
+}
+
+/*
+ * Write one line per distinct call stack, outermost function first, with
+ * the number of samples taken in it:
+ *
+ * board_init_r;run_main_loop;...;memcpy 12
+ *
+ * This is the input format of flamegraph.pl and similar tools.
+ */
+static int make_folded(void)
+{
+	struct func_info *func;
+	char **stacks;
+	char buf[40];
+	int i, j, n;
+
+	if (!sample_count) {
+		warn("No samples in profile data\n");
+		return 0;
+	}
+	stacks = calloc(sample_count, sizeof(*stacks));
+	if (!stacks) {
+		error("Cannot allocate stacks\n");
+		return -1;
+	}
+
+	for (i = 0, n = 0; n < sample_count; n++) {
+		uint32_t depth = sample_list[i];
+		uint32_t *addr = &sample_list[i + 1];
+		size_t len = 0, size = 256;
+		char *line = malloc(size);
+
+		if (!line) {
+			error("Cannot allocate stack\n");
+			return -1;
+		}
+		*line = '\0';
+		for (j = depth - 1; j >= 0; j--) {
+			const char *name;
+			size_t name_len;
+
+			func = find_func_by_sample(addr[j], j != 0);
+			if (func) {
+				name = func->name;
+			} else {
+				snprintf(buf, sizeof(buf), "%lx",
+					 text_offset + addr[j]);
+				name = buf;
+			}
+			name_len = strlen(name);
+			while (len + name_len + 2 > size) {
+				size *= 2;
+				line = realloc(line, size);
+				if (!line) {
+					error("Cannot allocate stack\n");
+					return -1;
+				}
+			}
+			if (len)
+				line[len++] = ';';
+			memcpy(line + len, name, name_len + 1);
+			len += name_len;
+		}
+		stacks[n] = line;
+		i += 1 + depth;
+	}
+
+	qsort(stacks, sample_count, sizeof(*stacks), h_cmp_str);
+	for (i = 0; i < sample_count; i = j) {
+		for (j = i + 1; j < sample_count; j++) {
+			if (strcmp(stacks[i], stacks[j]))
+				break;
+		}
+		printf("%s %d\n", stacks[i], j - i);
+	}
+	for (i = 0; i < sample_count; i++)
+		free(stacks[i]);
+	free(stacks);
+
+	return 0;
+}
+
+static int h_cmp_self(const void *v1, const void *v2)
+{
+	const struct func_info *f1 = *(struct func_info * const *)v1;
+	const struct func_info *f2 = *(struct func_info * const *)v2;
+
+	if (f1->self_samples != f2->self_samples)
+		return f1->self_samples < f2->self_samples ? 1 : -1;
+	if (f1->total_samples != f2->total_samples)
+		return f1->total_samples < f2->total_samples ? 1 : -1;
+
+	return strcmp(f1->name, f2->name);
+}
+
+/*
+ * Write a table of the functions seen in samples, with the number of
+ * samples taken in the function itself (self) and with the function
+ * anywhere on the call stack (total), most expensive first.
+ */
+static int make_hist(void)
+{
+	struct func_info *func, **list;
+	int unknown = 0;
+	int i, j, n, count;
+
+	if (!sample_count) {
+		warn("No samples in profile data\n");
+		return 0;
+	}
+	for (i = 0; i < func_count; i++)
+		func_list[i].last_sample = -1;
+	for (i = 0, n = 0; n < sample_count; n++) {
+		uint32_t depth = sample_list[i];
+		uint32_t *addr = &sample_list[i + 1];
+
+		for (j = 0; j < depth; j++) {
+			func = find_func_by_sample(addr[j], j != 0);
+			if (!func) {
+				if (!j)
+					unknown++;
+				continue;
+			}
+			if (!j)
+				func->self_samples++;
+			/* Count recursive functions once per sample */
+			if (func->last_sample != n) {
+				func->total_samples++;
+				func->last_sample = n;
+			}
+		}
+		i += 1 + depth;
+	}
+
+	list = calloc(func_count, sizeof(*list));
+	if (!list) {
+		error("Cannot allocate function list\n");
+		return -1;
+	}
+	for (i = 0, count = 0; i < func_count; i++) {
+		if (func_list[i].total_samples)
+			list[count++] = &func_list[i];
+	}
+	qsort(list, count, sizeof(*list), h_cmp_self);
+
+	printf("%d samples\n", sample_count);
+	printf("%8s %6s %8s %6s  %s\n", "Self", "%", "Total", "%",
+	       "Function");
+	for (i = 0; i < count; i++) {
+		func = list[i];
+		printf("%8lu %6.2f %8lu %6.2f  %s\n", func->self_samples,
+		       100.0 * func->self_samples / sample_count,
+		       func->total_samples,
+		       100.0 * func->total_samples / sample_count,
+		       func->name);
+	}
+	if (unknown)
+		printf("%8d %6.2f %8s %6s  %s\n", unknown,
+		       100.0 * unknown / sample_count, "", "", "(unknown)");
+	free(list);
+
+	return 0;
+}
+
 static int prof_tool(int argc, char * const argv[],
 		     const char *prof_fname, const char *map_fname,
 		     const char *trace_config_fname)
@@ -553,6 +797,10 @@ static int prof_tool(int argc, char * const argv[],
 
 		if (0 == strcmp(cmd, "dump-ftrace"))
 			err = make_ftrace();
+		else if (0 == strcmp(cmd, "dump-folded"))
+			err = make_folded();
+		else if (0 == strcmp(cmd, "dump-hist"))
+			err = make_hist();
 		else
 			warn("Unknown command '%s'\n", cmd);
 	}